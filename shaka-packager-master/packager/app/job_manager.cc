@@ -6,17 +6,27 @@
 
 #include "packager/app/job_manager.h"
 
+#include <algorithm>
+#include <deque>
+
 #include "packager/app/libcrypto_threading.h"
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/sys_info.h"
+#include "packager/media/base/closure_thread.h"
 #include "packager/media/origin/origin_handler.h"
 
 namespace shaka {
 namespace media {
 
+struct JobManager::WorkQueue {
+  base::Lock lock;
+  std::deque<Job*> jobs;
+};
+
 Job::Job(const std::string& name, std::shared_ptr<OriginHandler> work)
-    : SimpleThread(name),
-      work_(std::move(work)),
-      wait_(base::WaitableEvent::ResetPolicy::MANUAL,
-            base::WaitableEvent::InitialState::NOT_SIGNALED) {
+    : name_(name), work_(std::move(work)) {
   DCHECK(work_);
 }
 
@@ -24,16 +34,42 @@ void Job::Cancel() {
   work_->Cancel();
 }
 
-void Job::Run() {
-  status_ = work_->Run();
-  wait_.Signal();
+bool Job::RunStep() {
+  // Steps may run on different threads, so the CPU time is measured per step.
+  const bool measure_cpu_time = base::ThreadTicks::IsSupported();
+  const base::ThreadTicks start_time =
+      measure_cpu_time ? base::ThreadTicks::Now() : base::ThreadTicks();
+  // The origin handler has no input, so the time spent in it is the time
+  // spent running it.
+  HandlerCounters* counters = work_->counters();
+  const base::TimeTicks start_ticks =
+      counters ? base::TimeTicks::Now() : base::TimeTicks();
+  bool done = false;
+  status_ = work_->RunStep(&done);
+  if (measure_cpu_time)
+    cpu_time_ += base::ThreadTicks::Now() - start_time;
+  if (counters) {
+    counters->process_time_in_us +=
+        (base::TimeTicks::Now() - start_ticks).InMicroseconds();
+  }
+  return done;
+}
+
+bool Job::MayBlock() const {
+  return work_->MayBlock();
 }
 
+JobManager::JobManager(int num_threads)
+    : num_threads_(num_threads > 0 ? num_threads
+                                   : base::SysInfo::NumberOfProcessors()),
+      job_available_cv_(&lock_) {}
+
+JobManager::~JobManager() {}
+
 void JobManager::Add(const std::string& name,
                      std::shared_ptr<OriginHandler> handler) {
   // Stores Job entries for delayed construction of Job objects, to avoid
-  // setting up SimpleThread until we know all workers can be initialized
-  // successfully.
+  // setting up Job until we know all workers can be initialized successfully.
   job_entries_.push_back({name, std::move(handler)});
 }
 
@@ -51,51 +87,61 @@ Status JobManager::InitializeJobs() {
 }
 
 Status JobManager::RunJobs() {
-  // We need to store the jobs and the waits separately in order to use the
-  // |WaitMany| function. |WaitMany| takes an array of WaitableEvents but we
-  // need to access the jobs in order to join the thread and check the status.
-  // The indexes needs to be check in sync or else we won't be able to relate a
-  // WaitableEvent back to the job.
-  std::vector<Job*> active_jobs;
-  std::vector<base::WaitableEvent*> active_waits;
-
-  // Start every job and add it to the active jobs list so that we can wait
-  // on each one.
-  for (auto& job : jobs_) {
-    job->Start();
-
-    active_jobs.push_back(job.get());
-    active_waits.push_back(job->wait());
+  if (jobs_.empty())
+    return Status::OK;
+
+  // Jobs which may block on their input get a thread of their own, as they
+  // would hold up the other jobs of a worker while waiting.
+  std::vector<Job*> pooled_jobs;
+  std::vector<std::unique_ptr<ClosureThread>> blocking_job_threads;
+  for (const auto& job : jobs_) {
+    if (!job->MayBlock()) {
+      pooled_jobs.push_back(job.get());
+      continue;
+    }
+    blocking_job_threads.emplace_back(new ClosureThread(
+        job->name(), base::Bind(&JobManager::RunBlockingJob,
+                                base::Unretained(this), job.get())));
   }
 
-  // Wait for all jobs to complete or an error occurs.
-  Status status;
-  while (status.ok() && active_jobs.size()) {
-    // Wait for an event to finish and then update our status so that we can
-    // quit if something has gone wrong.
-    const size_t done =
-        base::WaitableEvent::WaitMany(active_waits.data(), active_waits.size());
-    Job* job = active_jobs[done];
-
-    job->Join();
-    status.Update(job->status());
-
-    // Remove the job and the wait from our tracking.
-    active_jobs.erase(active_jobs.begin() + done);
-    active_waits.erase(active_waits.begin() + done);
+  // There is no point having more workers than jobs.
+  const size_t num_workers =
+      std::min(static_cast<size_t>(num_threads_), pooled_jobs.size());
+  for (size_t i = 0; i < num_workers; ++i)
+    work_queues_.emplace_back(new WorkQueue);
+  // Spread the jobs over the workers. They are rebalanced by stealing.
+  for (size_t i = 0; i < pooled_jobs.size(); ++i)
+    work_queues_[i % num_workers]->jobs.push_back(pooled_jobs[i]);
+  {
+    base::AutoLock auto_lock(lock_);
+    num_queued_jobs_ = pooled_jobs.size();
+    num_unfinished_jobs_ = pooled_jobs.size();
   }
 
-  // If the main loop has exited and there are still jobs running,
-  // we need to cancel them and clean-up.
-  for (auto& job : active_jobs) {
-    job->Cancel();
+  for (auto& job_thread : blocking_job_threads)
+    job_thread->Start();
+  // The calling thread works as the first worker.
+  std::vector<std::unique_ptr<ClosureThread>> worker_threads;
+  for (size_t i = 1; i < num_workers; ++i) {
+    worker_threads.emplace_back(new ClosureThread(
+        "JobWorker" + base::SizeTToString(i),
+        base::Bind(&JobManager::RunWorker, base::Unretained(this), i)));
+    worker_threads.back()->Start();
   }
-
-  for (auto& job : active_jobs) {
-    job->Join();
+  if (num_workers > 0)
+    RunWorker(0);
+  for (auto& worker_thread : worker_threads)
+    worker_thread->Join();
+  for (auto& job_thread : blocking_job_threads)
+    job_thread->Join();
+
+  for (const auto& job : jobs_) {
+    LOG(INFO) << "Job '" << job->name() << "' used "
+              << job->cpu_time().InSecondsF() << " seconds of CPU time.";
   }
 
-  return status;
+  base::AutoLock auto_lock(lock_);
+  return status_;
 }
 
 void JobManager::CancelJobs() {
@@ -104,5 +150,91 @@ void JobManager::CancelJobs() {
   }
 }
 
+void JobManager::RunWorker(size_t worker_index) {
+  while (true) {
+    Job* job = TakeJob(worker_index);
+    if (!job) {
+      // All the unfinished jobs are being run by the other workers. Wait for
+      // one of them to be put back.
+      base::AutoLock auto_lock(lock_);
+      while (num_queued_jobs_ == 0 && num_unfinished_jobs_ > 0)
+        job_available_cv_.Wait();
+      if (num_unfinished_jobs_ == 0)
+        return;
+      continue;
+    }
+
+    if (job->RunStep())
+      OnJobDone(job);
+    else
+      PutJob(worker_index, job);
+  }
+}
+
+Job* JobManager::TakeJob(size_t worker_index) {
+  Job* job = nullptr;
+  {
+    WorkQueue* own_queue = work_queues_[worker_index].get();
+    base::AutoLock auto_lock(own_queue->lock);
+    if (!own_queue->jobs.empty()) {
+      job = own_queue->jobs.front();
+      own_queue->jobs.pop_front();
+    }
+  }
+  for (size_t i = 1; !job && i < work_queues_.size(); ++i) {
+    WorkQueue* victim_queue =
+        work_queues_[(worker_index + i) % work_queues_.size()].get();
+    base::AutoLock auto_lock(victim_queue->lock);
+    if (!victim_queue->jobs.empty()) {
+      job = victim_queue->jobs.back();
+      victim_queue->jobs.pop_back();
+    }
+  }
+  if (job) {
+    base::AutoLock auto_lock(lock_);
+    DCHECK_GT(num_queued_jobs_, 0u);
+    --num_queued_jobs_;
+  }
+  return job;
+}
+
+void JobManager::PutJob(size_t worker_index, Job* job) {
+  // |num_queued_jobs_| is updated together with the queue, so it never falls
+  // behind the number of jobs in the queues.
+  base::AutoLock auto_lock(lock_);
+  {
+    WorkQueue* own_queue = work_queues_[worker_index].get();
+    base::AutoLock queue_auto_lock(own_queue->lock);
+    own_queue->jobs.push_back(job);
+  }
+  ++num_queued_jobs_;
+  job_available_cv_.Signal();
+}
+
+void JobManager::OnJobDone(Job* job) {
+  base::AutoLock auto_lock(lock_);
+  DCHECK_GT(num_unfinished_jobs_, 0u);
+  --num_unfinished_jobs_;
+  UpdateStatus(*job);
+  if (num_unfinished_jobs_ == 0)
+    job_available_cv_.Broadcast();
+}
+
+void JobManager::RunBlockingJob(Job* job) {
+  while (!job->RunStep()) {
+  }
+  base::AutoLock auto_lock(lock_);
+  UpdateStatus(*job);
+}
+
+void JobManager::UpdateStatus(const Job& job) {
+  lock_.AssertAcquired();
+  if (!job.status().ok() && status_.ok()) {
+    status_ = job.status();
+    // Stop the other jobs as soon as possible.
+    CancelJobs();
+  }
+}
+
 }  // namespace media
 }  // namespace shaka
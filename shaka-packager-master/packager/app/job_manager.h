@@ -8,9 +8,12 @@
 #define PACKAGER_APP_JOB_MANAGER_H_
 
 #include <memory>
+#include <string>
 #include <vector>
 
-#include "packager/base/threading/simple_thread.h"
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/time/time.h"
 #include "packager/status.h"
 
 namespace shaka {
@@ -19,45 +22,63 @@ namespace media {
 class OriginHandler;
 
 // A job is a single line of work that is expected to run in parallel with
-// other jobs.
-class Job : public base::SimpleThread {
+// other jobs. The work is done in steps (see |OriginHandler::RunStep|), so a
+// job can be moved between threads in-between steps.
+class Job {
  public:
   Job(const std::string& name, std::shared_ptr<OriginHandler> work);
 
   // Request that the job stops executing. This is only a request and
-  // will not block. If you want to wait for the job to complete, use
-  // |wait|.
+  // will not block.
   void Cancel();
 
+  // Run a single step of the job. Returns true if the job is done, i.e. there
+  // are no more steps to run. Steps of the same job must not run concurrently.
+  bool RunStep();
+
+  // Returns true if a step of the job may wait on its input for an unbounded
+  // time. See |OriginHandler::MayBlock|.
+  bool MayBlock() const;
+
+  const std::string& name() const { return name_; }
+
   // Get the current status of the job. If the job failed to initialize
   // or encountered an error during execution this will return the error.
   const Status& status() const { return status_; }
 
-  // If you want to wait for this job to complete, this will return the
-  // WaitableEvent you can wait on.
-  base::WaitableEvent* wait() { return &wait_; }
+  // Get the CPU time used by the job so far, summed over all its steps.
+  base::TimeDelta cpu_time() const { return cpu_time_; }
 
  private:
   Job(const Job&) = delete;
   Job& operator=(const Job&) = delete;
 
-  void Run() override;
-
+  const std::string name_;
   std::shared_ptr<OriginHandler> work_;
   Status status_;
-
-  base::WaitableEvent wait_;
+  base::TimeDelta cpu_time_;
 };
 
 // Similar to a thread pool, JobManager manages multiple jobs that are expected
 // to run in parallel. It can be used to register, run, and stop a batch of
 // jobs.
+//
+// The jobs are run by a fixed number of worker threads. Each worker has its
+// own queue of jobs and runs them a step at a time in round robin. A worker
+// whose queue is empty steals jobs from the other workers, so the work is
+// spread evenly whether there are fewer or more jobs than workers. Jobs which
+// may block on their input, e.g. live network inputs, run in a thread of their
+// own instead, so they never hold up the jobs sharing the workers.
 class JobManager {
  public:
-  JobManager() = default;
+  // @param num_threads is the number of worker threads used to run the jobs
+  //        which do not block, including the thread calling |RunJobs|. If it
+  //        is 0, the number of processors is used.
+  explicit JobManager(int num_threads);
+  ~JobManager();
 
   // Create a new job entry by specifying the origin handler at the top of the
-  // chain and a name for the thread. This will only register the job. To start
+  // chain and a name for the job. This will only register the job. To start
   // the job, you need to call |RunJobs|.
   void Add(const std::string& name, std::shared_ptr<OriginHandler> handler);
 
@@ -68,7 +89,8 @@ class JobManager {
 
   // Run all registered jobs. Before calling this make sure that
   // |InitializedJobs| returned |Status::OK|. This call is blocking and will
-  // block until all jobs exit.
+  // block until all jobs exit. If a job fails, the other jobs are cancelled
+  // and the error of the failed job is returned.
   Status RunJobs();
 
   // Ask all jobs to stop running. This call is non-blocking and can be used to
@@ -83,9 +105,37 @@ class JobManager {
     std::string name;
     std::shared_ptr<OriginHandler> worker;
   };
+  struct WorkQueue;
+
+  // Runs in each worker thread until all jobs are done.
+  void RunWorker(size_t worker_index);
+  // Take a job from the front of the worker's own queue, or steal one from
+  // the back of the other queues. Returns nullptr if all queues are empty.
+  Job* TakeJob(size_t worker_index);
+  // Put a job which is not done yet back to the end of the worker's queue.
+  void PutJob(size_t worker_index, Job* job);
+  void OnJobDone(Job* job);
+  // Runs a job which may block in a thread of its own.
+  void RunBlockingJob(Job* job);
+  // Keeps the status of the first failed job and cancels the other jobs.
+  // |lock_| must be held.
+  void UpdateStatus(const Job& job);
+
+  const int num_threads_;
   // Stores Job entries for delayed construction of Job object.
   std::vector<JobEntry> job_entries_;
   std::vector<std::unique_ptr<Job>> jobs_;
+  std::vector<std::unique_ptr<WorkQueue>> work_queues_;
+
+  base::Lock lock_;
+  // Signaled when a job is put back to a queue or when all jobs are done.
+  base::ConditionVariable job_available_cv_;
+  // Number of jobs waiting in the queues.
+  size_t num_queued_jobs_ = 0;
+  // Number of jobs run by the workers that are not done yet.
+  size_t num_unfinished_jobs_ = 0;
+  // The status of the first failed job.
+  Status status_;
 };
 
 }  // namespace media
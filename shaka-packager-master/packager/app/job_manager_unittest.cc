@@ -0,0 +1,284 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/app/job_manager.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/base/threading/platform_thread.h"
+#include "packager/media/base/closure_thread.h"
+#include "packager/media/origin/origin_handler.h"
+#include "packager/status_test_util.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const int kNumSteps = 20;
+const int kNeverFail = -1;
+const int kRunForever = -1;
+
+// Keeps track of the number of steps running at the same time.
+class ConcurrencyTracker {
+ public:
+  void Enter() {
+    base::AutoLock auto_lock(lock_);
+    ++num_running_;
+    max_num_running_ = std::max(max_num_running_, num_running_);
+  }
+  void Leave() {
+    base::AutoLock auto_lock(lock_);
+    --num_running_;
+  }
+  int max_num_running() {
+    base::AutoLock auto_lock(lock_);
+    return max_num_running_;
+  }
+
+ private:
+  base::Lock lock_;
+  int num_running_ = 0;
+  int max_num_running_ = 0;
+};
+
+// An origin handler which runs |num_steps| steps, each taking a millisecond.
+class FakeOriginHandler : public OriginHandler {
+ public:
+  FakeOriginHandler(int num_steps,
+                    int fail_at_step,
+                    ConcurrencyTracker* tracker)
+      : num_steps_(num_steps),
+        fail_at_step_(fail_at_step),
+        tracker_(tracker) {}
+
+  Status Run() override {
+    Status status;
+    bool done = false;
+    while (!done)
+      status = RunStep(&done);
+    return status;
+  }
+
+  Status RunStep(bool* done) override {
+    *done = true;
+    {
+      base::AutoLock auto_lock(lock_);
+      if (cancelled_)
+        return Status(error::CANCELLED, "Cancelled.");
+    }
+    tracker_->Enter();
+    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(1));
+    tracker_->Leave();
+
+    if (num_steps_run_++ == fail_at_step_)
+      return Status(error::PARSER_FAILURE, "Failed to parse.");
+    *done = num_steps_run_ == num_steps_;
+    return Status::OK;
+  }
+
+  void Cancel() override {
+    base::AutoLock auto_lock(lock_);
+    cancelled_ = true;
+  }
+
+  bool MayBlock() const override { return false; }
+
+  int num_steps_run() const { return num_steps_run_; }
+
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+
+  const int num_steps_;
+  const int fail_at_step_;
+  ConcurrencyTracker* const tracker_;
+  int num_steps_run_ = 0;
+  base::Lock lock_;
+  bool cancelled_ = false;
+};
+
+// An origin handler which does all its work in |Run|.
+class RunOnlyOriginHandler : public OriginHandler {
+ public:
+  Status Run() override {
+    run_called_ = true;
+    return Status::OK;
+  }
+  void Cancel() override {}
+
+  bool run_called() const { return run_called_; }
+
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+
+  bool run_called_ = false;
+};
+
+// An origin handler which does all its work in |Run|, and may block: it waits
+// for |event| to be signaled.
+class BlockingOriginHandler : public OriginHandler {
+ public:
+  explicit BlockingOriginHandler(base::WaitableEvent* event) : event_(event) {}
+
+  Status Run() override {
+    if (!event_->TimedWait(base::TimeDelta::FromSeconds(10)))
+      return Status(error::TIME_OUT, "Not signaled.");
+    return Status::OK;
+  }
+  void Cancel() override {}
+
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+
+  base::WaitableEvent* const event_;
+};
+
+// A non blocking origin handler which signals |event| when it runs.
+class SignalingOriginHandler : public OriginHandler {
+ public:
+  explicit SignalingOriginHandler(base::WaitableEvent* event)
+      : event_(event) {}
+
+  Status Run() override {
+    event_->Signal();
+    return Status::OK;
+  }
+  void Cancel() override {}
+  bool MayBlock() const override { return false; }
+
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+
+  base::WaitableEvent* const event_;
+};
+
+void CancelJobsAfterDelay(JobManager* job_manager) {
+  base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(20));
+  job_manager->CancelJobs();
+}
+
+}  // namespace
+
+class JobManagerTest : public ::testing::Test {
+ protected:
+  std::shared_ptr<FakeOriginHandler> AddJob(JobManager* job_manager,
+                                            int num_steps,
+                                            int fail_at_step) {
+    std::shared_ptr<FakeOriginHandler> handler =
+        std::make_shared<FakeOriginHandler>(num_steps, fail_at_step, &tracker_);
+    job_manager->Add("FakeJob", handler);
+    return handler;
+  }
+
+  ConcurrencyTracker tracker_;
+};
+
+TEST_F(JobManagerTest, NoJobs) {
+  JobManager job_manager(2);
+  ASSERT_OK(job_manager.InitializeJobs());
+  ASSERT_OK(job_manager.RunJobs());
+}
+
+TEST_F(JobManagerTest, MoreJobsThanThreads) {
+  const int kNumThreads = 2;
+  const int kNumJobs = 5;
+  JobManager job_manager(kNumThreads);
+  std::vector<std::shared_ptr<FakeOriginHandler>> handlers;
+  for (int i = 0; i < kNumJobs; ++i)
+    handlers.push_back(AddJob(&job_manager, kNumSteps, kNeverFail));
+
+  ASSERT_OK(job_manager.InitializeJobs());
+  ASSERT_OK(job_manager.RunJobs());
+  for (const auto& handler : handlers)
+    EXPECT_EQ(kNumSteps, handler->num_steps_run());
+  EXPECT_LE(tracker_.max_num_running(), kNumThreads);
+}
+
+TEST_F(JobManagerTest, MoreThreadsThanJobs) {
+  JobManager job_manager(8);
+  std::shared_ptr<FakeOriginHandler> handler =
+      AddJob(&job_manager, kNumSteps, kNeverFail);
+
+  ASSERT_OK(job_manager.InitializeJobs());
+  ASSERT_OK(job_manager.RunJobs());
+  EXPECT_EQ(kNumSteps, handler->num_steps_run());
+  // Steps of the same job never run concurrently.
+  EXPECT_EQ(1, tracker_.max_num_running());
+}
+
+TEST_F(JobManagerTest, RunsHandlersWithoutSteps) {
+  JobManager job_manager(2);
+  std::shared_ptr<RunOnlyOriginHandler> handler =
+      std::make_shared<RunOnlyOriginHandler>();
+  job_manager.Add("RunOnlyJob", handler);
+
+  ASSERT_OK(job_manager.InitializeJobs());
+  ASSERT_OK(job_manager.RunJobs());
+  EXPECT_TRUE(handler->run_called());
+}
+
+TEST_F(JobManagerTest, RunsBlockingJobsInTheirOwnThreads) {
+  base::WaitableEvent event(base::WaitableEvent::ResetPolicy::MANUAL,
+                            base::WaitableEvent::InitialState::NOT_SIGNALED);
+  // With a single worker, the blocking jobs would wait forever for the job
+  // signaling them if they were run by the worker.
+  JobManager job_manager(1);
+  job_manager.Add("BlockingJob1",
+                  std::make_shared<BlockingOriginHandler>(&event));
+  job_manager.Add("BlockingJob2",
+                  std::make_shared<BlockingOriginHandler>(&event));
+  job_manager.Add("SignalingJob",
+                  std::make_shared<SignalingOriginHandler>(&event));
+
+  ASSERT_OK(job_manager.InitializeJobs());
+  ASSERT_OK(job_manager.RunJobs());
+}
+
+TEST_F(JobManagerTest, RecordsRunTimeOfOriginHandlers) {
+  JobManager job_manager(2);
+  std::shared_ptr<FakeOriginHandler> handler =
+      AddJob(&job_manager, kNumSteps, kNeverFail);
+  HandlerCounters* counters = handler->EnableCounters();
+
+  ASSERT_OK(job_manager.InitializeJobs());
+  ASSERT_OK(job_manager.RunJobs());
+  // Every step takes at least a millisecond.
+  EXPECT_GE(counters->process_time_in_us, kNumSteps * 1000);
+}
+
+TEST_F(JobManagerTest, ReturnsFirstErrorAndCancelsOtherJobs) {
+  const int kFailAtStep = 3;
+  JobManager job_manager(2);
+  std::shared_ptr<FakeOriginHandler> failing_handler =
+      AddJob(&job_manager, kNumSteps, kFailAtStep);
+  AddJob(&job_manager, kRunForever, kNeverFail);
+
+  ASSERT_OK(job_manager.InitializeJobs());
+  EXPECT_EQ(error::PARSER_FAILURE, job_manager.RunJobs().error_code());
+  EXPECT_EQ(kFailAtStep + 1, failing_handler->num_steps_run());
+}
+
+TEST_F(JobManagerTest, CancelJobs) {
+  JobManager job_manager(2);
+  AddJob(&job_manager, kRunForever, kNeverFail);
+  AddJob(&job_manager, kRunForever, kNeverFail);
+  AddJob(&job_manager, kRunForever, kNeverFail);
+  ASSERT_OK(job_manager.InitializeJobs());
+
+  ClosureThread cancel_thread(
+      "CancelThread",
+      base::Bind(&CancelJobsAfterDelay, base::Unretained(&job_manager)));
+  cancel_thread.Start();
+  EXPECT_EQ(error::CANCELLED, job_manager.RunJobs().error_code());
+}
+
+}  // namespace media
+}  // namespace shaka
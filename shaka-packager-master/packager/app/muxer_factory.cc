@@ -19,6 +19,7 @@ namespace media {
 
 MuxerFactory::MuxerFactory(const PackagingParams& packaging_params)
     : mp4_params_(packaging_params.mp4_output_params),
+      webm_params_(packaging_params.webm_output_params),
       temp_dir_(packaging_params.temp_dir) {}
 
 std::shared_ptr<Muxer> MuxerFactory::CreateMuxer(
@@ -26,6 +27,7 @@ std::shared_ptr<Muxer> MuxerFactory::CreateMuxer(
     const StreamDescriptor& stream) {
   MuxerOptions options;
   options.mp4_params = mp4_params_;
+  options.webm_params = webm_params_;
   options.temp_dir = temp_dir_;
   options.output_file_name = stream.output;
   options.segment_template = stream.segment_template;
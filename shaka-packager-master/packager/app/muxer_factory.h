@@ -12,6 +12,7 @@
 
 #include "packager/media/base/container_names.h"
 #include "packager/media/public/mp4_output_params.h"
+#include "packager/media/public/webm_output_params.h"
 
 namespace base {
 class Clock;
@@ -47,6 +48,7 @@ class MuxerFactory {
   MuxerFactory& operator=(const MuxerFactory&) = delete;
 
   Mp4OutputParams mp4_params_;
+  WebmOutputParams webm_params_;
   std::string temp_dir_;
   base::Clock* clock_ = nullptr;
 };
@@ -44,9 +44,46 @@ DEFINE_string(temp_dir,
 DEFINE_bool(mp4_include_pssh_in_stream,
             true,
             "MP4 only: include pssh in the encrypted stream.");
+DEFINE_bool(async_output,
+            false,
+            "If set, each output is muxed in its own thread, fed by a bounded "
+            "queue, so multiple outputs from the same input are muxed in "
+            "parallel.");
+DEFINE_int32(num_threads,
+             0,
+             "Number of worker threads used to run the packaging jobs (one "
+             "job per input). If 0, the number of processors is used. Inputs "
+             "that may block on reads, e.g. UDP inputs or pipes, are not "
+             "counted: each of them runs in a thread of its own.");
+DEFINE_double(stats_dump_interval,
+              0,
+              "If greater than 0, the pipeline stages and the writes to the "
+              "output files are timed, and their statistics are dumped at this "
+              "interval, in seconds, and once packaging is done.");
+DEFINE_string(stats_dump_output,
+              "",
+              "The file the statistics are dumped to, which is replaced on "
+              "every dump. The statistics are logged if it is not specified.");
+DEFINE_string(stats_dump_format,
+              "text",
+              "Format of the dumped statistics, 'text' or 'json'.");
 DEFINE_bool(mp4_use_decoding_timestamp_in_timeline,
             false,
             "If set, decoding timestamp instead of presentation timestamp will "
             "be used when generating media timeline, e.g. timestamps in sidx "
             "and mpd. This is to workaround a Chromium bug that decoding "
             "timestamp is used in buffered range, https://crbug.com/398130.");
+DEFINE_bool(mp4_reserve_header_space,
+            false,
+            "MP4 only, used with on-demand profile: if set, space for the "
+            "header is reserved at the start of the output file, so the media "
+            "data is written to the output directly instead of being copied "
+            "from a temporary file after packaging. Any unused space is left "
+            "in a 'free' box.");
+DEFINE_bool(webm_reserve_cues_space,
+            false,
+            "WebM only, used with on-demand profile: if set, space for the "
+            "Cues is reserved after the header of the output file, so the "
+            "clusters are written to the output directly instead of being "
+            "copied from a temporary file after packaging. Any unused space "
+            "is left in a Void element.");
@@ -20,5 +20,12 @@ DECLARE_int32(num_subsegments_per_sidx);
 DECLARE_string(temp_dir);
 DECLARE_bool(mp4_include_pssh_in_stream);
 DECLARE_bool(mp4_use_decoding_timestamp_in_timeline);
+DECLARE_bool(mp4_reserve_header_space);
+DECLARE_bool(webm_reserve_cues_space);
+DECLARE_bool(async_output);
+DECLARE_int32(num_threads);
+DECLARE_double(stats_dump_interval);
+DECLARE_string(stats_dump_output);
+DECLARE_string(stats_dump_format);
 
 #endif  // APP_MUXER_FLAGS_H_
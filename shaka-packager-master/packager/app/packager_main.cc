@@ -264,6 +264,24 @@ base::Optional<PackagingParams> GetPackagingParams() {
   PackagingParams packaging_params;
 
   packaging_params.temp_dir = FLAGS_temp_dir;
+  packaging_params.async_output = FLAGS_async_output;
+  packaging_params.num_threads = FLAGS_num_threads;
+
+  InstrumentationParams& instrumentation_params =
+      packaging_params.instrumentation_params;
+  if (FLAGS_stats_dump_interval > 0) {
+    instrumentation_params.enabled = true;
+    instrumentation_params.dump_interval_in_seconds = FLAGS_stats_dump_interval;
+    instrumentation_params.dump_output = FLAGS_stats_dump_output;
+    if (FLAGS_stats_dump_format == "json") {
+      instrumentation_params.dump_format =
+          InstrumentationParams::DumpFormat::kJson;
+    } else if (FLAGS_stats_dump_format != "text") {
+      LOG(ERROR) << "Unrecognized --stats_dump_format "
+                 << FLAGS_stats_dump_format << ", expecting text or json.";
+      return base::nullopt;
+    }
+  }
 
   AdCueGeneratorParams& ad_cue_generator_params =
       packaging_params.ad_cue_generator_params;
@@ -318,6 +336,7 @@ base::Optional<PackagingParams> GetPackagingParams() {
       widevine.content_id = FLAGS_content_id_bytes;
       widevine.policy = FLAGS_policy;
       widevine.group_id = FLAGS_group_id_bytes;
+      widevine.num_concurrent_key_requests = FLAGS_num_concurrent_key_requests;
       if (!GetWidevineSigner(&widevine.signer))
         return base::nullopt;
       break;
@@ -389,6 +408,10 @@ base::Optional<PackagingParams> GetPackagingParams() {
   mp4_params.use_decoding_timestamp_in_timeline =
       FLAGS_mp4_use_decoding_timestamp_in_timeline;
   mp4_params.include_pssh_in_stream = FLAGS_mp4_include_pssh_in_stream;
+  mp4_params.reserve_header_space = FLAGS_mp4_reserve_header_space;
+
+  packaging_params.webm_output_params.reserve_cues_space =
+      FLAGS_webm_reserve_cues_space;
 
   packaging_params.output_media_info = FLAGS_output_media_info;
 
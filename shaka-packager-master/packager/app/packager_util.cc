@@ -12,6 +12,7 @@
 #include "packager/file/file.h"
 #include "packager/media/base/media_handler.h"
 #include "packager/media/base/muxer_options.h"
+#include "packager/media/base/key_request_cache.h"
 #include "packager/media/base/playready_key_source.h"
 #include "packager/media/base/raw_key_source.h"
 #include "packager/media/base/request_signer.h"
@@ -25,6 +26,16 @@ namespace shaka {
 namespace media {
 namespace {
 
+// The number of key responses shared with the key sources which lag behind.
+const size_t kMaxCachedKeyResponses = 16;
+
+// Shares identical key requests between the packaging jobs of the process.
+KeyRequestCache* GetKeyRequestCache() {
+  static KeyRequestCache* key_request_cache =
+      new KeyRequestCache(kMaxCachedKeyResponses);
+  return key_request_cache;
+}
+
 std::unique_ptr<RequestSigner> CreateSigner(const WidevineSigner& signer) {
   std::unique_ptr<RequestSigner> request_signer;
   switch (signer.signing_key_type) {
@@ -61,6 +72,10 @@ std::unique_ptr<KeySource> CreateEncryptionKeySource(
         LOG(ERROR) << "'content_id' should not be empty.";
         return nullptr;
       }
+      if (widevine.num_concurrent_key_requests == 0) {
+        LOG(ERROR) << "'num_concurrent_key_requests' should be positive.";
+        return nullptr;
+      }
       std::unique_ptr<WidevineKeySource> widevine_key_source(
           new WidevineKeySource(widevine.key_server_url,
                                 widevine.include_common_pssh));
@@ -73,6 +88,9 @@ std::unique_ptr<KeySource> CreateEncryptionKeySource(
         widevine_key_source->set_signer(std::move(request_signer));
       }
       widevine_key_source->set_group_id(widevine.group_id);
+      widevine_key_source->set_num_concurrent_key_requests(
+          widevine.num_concurrent_key_requests);
+      widevine_key_source->set_key_request_cache(GetKeyRequestCache());
 
       Status status =
           widevine_key_source->FetchKeys(widevine.content_id, widevine.policy);
@@ -0,0 +1,262 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "packager/app/muxer_factory.h"
+#include "packager/base/time/time.h"
+#include "packager/file/file.h"
+#include "packager/file/memory_file.h"
+#include "packager/media/base/fourccs.h"
+#include "packager/media/base/muxer.h"
+#include "packager/media/base/raw_key_source.h"
+#include "packager/media/chunking/chunking_handler.h"
+#include "packager/media/crypto/encryption_handler.h"
+#include "packager/media/demuxer/demuxer.h"
+#include "packager/media/replicator/replicator.h"
+#include "packager/media/test/perf_counters.h"
+#include "packager/media/test/test_data_util.h"
+#include "packager/packager.h"
+#include "packager/status_test_util.h"
+#include "packager/testing/perf/perf_test.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const uint8_t kKeyId[] = {
+    0xe5, 0x00, 0x7e, 0x6e, 0x9d, 0xcd, 0x5a, 0xc0,
+    0x95, 0x20, 0x2e, 0xd3, 0x75, 0x83, 0x82, 0xcd,
+};
+const uint8_t kKey[] = {
+    0x6f, 0xc9, 0x6f, 0xe6, 0x28, 0xa2, 0x65, 0xb1,
+    0x3a, 0xed, 0xde, 0xc0, 0xbc, 0x42, 0x1f, 0x4d,
+};
+const double kSegmentDurationInSeconds = 1.0;
+// Renditions packaged from the same input, e.g. for different manifests.
+const size_t kNumOutputs = 2;
+const int kNumIterations = 20;
+
+struct PipelineConfig {
+  // Used as the modifier of the results.
+  const char* name;
+  // A file in media/test/data.
+  const char* input;
+  MediaContainerName output_format;
+  const char* segment_extension;
+  FourCC protection_scheme;
+};
+
+// Forwards the stream data to the next stage of the pipeline and measures the
+// time spent in that stage and the following ones.
+class StageTimer : public MediaHandler {
+ public:
+  base::TimeDelta elapsed() const { return elapsed_; }
+  int64_t num_samples() const { return num_samples_; }
+  int64_t num_sample_bytes() const { return num_sample_bytes_; }
+
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+
+  Status Process(std::unique_ptr<StreamData> stream_data) override {
+    if (stream_data->stream_data_type == StreamDataType::kMediaSample) {
+      ++num_samples_;
+      num_sample_bytes_ += stream_data->media_sample->data_size();
+    }
+    const base::TimeTicks start = base::TimeTicks::Now();
+    Status status = Dispatch(std::move(stream_data));
+    elapsed_ += base::TimeTicks::Now() - start;
+    return status;
+  }
+
+  Status OnFlushRequest(size_t input_stream_index) override {
+    const base::TimeTicks start = base::TimeTicks::Now();
+    Status status = FlushAllDownstreams();
+    elapsed_ += base::TimeTicks::Now() - start;
+    return status;
+  }
+
+  base::TimeDelta elapsed_;
+  int64_t num_samples_ = 0;
+  int64_t num_sample_bytes_ = 0;
+};
+
+// The time spent in every stage, accumulated over the iterations.
+struct PipelineStats {
+  base::TimeDelta demuxer;
+  base::TimeDelta chunking;
+  base::TimeDelta encryption;
+  base::TimeDelta replicator;
+  base::TimeDelta muxers;
+  base::TimeDelta total;
+  int64_t num_samples = 0;
+  int64_t num_sample_bytes = 0;
+};
+
+}  // namespace
+
+// Measures the throughput of the handler chains created by the packager:
+// Demuxer -> ChunkingHandler -> EncryptionHandler -> Replicator -> Muxers.
+// The input is loaded in memory and the outputs are written to memory files,
+// so that the results do not depend on the disk.
+class PipelinePerfTest : public testing::Test {
+ protected:
+  void TearDown() override { MemoryFile::DeleteAll(); }
+
+  void RunPipelineAndPrintResults(const PipelineConfig& config) {
+    const std::vector<uint8_t> input_contents =
+        ReadTestDataFile(config.input);
+    ASSERT_FALSE(input_contents.empty());
+    input_ = std::string(kMemoryFilePrefix) + config.input;
+    ASSERT_TRUE(File::WriteStringToFile(
+        input_.c_str(),
+        std::string(input_contents.begin(), input_contents.end())));
+
+    // Warms up the pools and the caches.
+    PipelineStats stats;
+    ASSERT_NO_FATAL_FAILURE(RunPipeline(config, &stats));
+
+    stats = PipelineStats();
+    const int64_t num_allocations_before = GetNumAllocations();
+    for (int i = 0; i < kNumIterations; ++i)
+      ASSERT_NO_FATAL_FAILURE(RunPipeline(config, &stats));
+    const int64_t num_allocations =
+        GetNumAllocations() - num_allocations_before;
+    ASSERT_GT(stats.num_samples, 0);
+
+    const std::string modifier = std::string("_") + config.name;
+    PrintTimePerSample(modifier, "demuxer", stats.demuxer, stats);
+    PrintTimePerSample(modifier, "chunking", stats.chunking, stats);
+    PrintTimePerSample(modifier, "encryption", stats.encryption, stats);
+    PrintTimePerSample(modifier, "replicator", stats.replicator, stats);
+    PrintTimePerSample(modifier, "muxers", stats.muxers, stats);
+    PrintTimePerSample(modifier, "total", stats.total, stats);
+    perf_test::PrintResult(
+        "throughput", modifier, "total",
+        stats.num_sample_bytes / stats.total.InSecondsF() / 1e6, "MB/s",
+        true);
+    perf_test::PrintResult(
+        "allocations_per_sample", modifier, "total",
+        static_cast<double>(num_allocations) / stats.num_samples,
+        "allocations", true);
+    perf_test::PrintResult("peak_rss", modifier, "process",
+                           GetPeakRssInBytes() / 1e6, "MB", true);
+  }
+
+ private:
+  void PrintTimePerSample(const std::string& modifier,
+                          const std::string& stage,
+                          base::TimeDelta elapsed,
+                          const PipelineStats& stats) {
+    perf_test::PrintResult(
+        "time_per_sample", modifier, stage,
+        elapsed.InMillisecondsF() * 1000000 / stats.num_samples, "ns", true);
+  }
+
+  std::shared_ptr<MediaHandler> CreateEncryptionHandler(
+      const PipelineConfig& config) {
+    RawKeyParams raw_key;
+    raw_key.key_map[""].key_id.assign(kKeyId, kKeyId + sizeof(kKeyId));
+    raw_key.key_map[""].key.assign(kKey, kKey + sizeof(kKey));
+    key_source_ = RawKeySource::Create(raw_key);
+    CHECK(key_source_);
+
+    EncryptionParams encryption_params;
+    encryption_params.key_provider = KeyProvider::kRawKey;
+    encryption_params.protection_scheme = config.protection_scheme;
+    encryption_params.stream_label_func =
+        [](const EncryptionParams::EncryptedStreamAttributes&) {
+          return std::string();
+        };
+    return std::make_shared<EncryptionHandler>(encryption_params,
+                                               key_source_.get());
+  }
+
+  // Packages the video stream of the input once, adding the time spent in
+  // every stage to |stats|.
+  void RunPipeline(const PipelineConfig& config, PipelineStats* stats) {
+    PackagingParams packaging_params;
+    ChunkingParams chunking_params;
+    chunking_params.segment_duration_in_seconds = kSegmentDurationInSeconds;
+    MuxerFactory muxer_factory(packaging_params);
+
+    std::shared_ptr<Demuxer> demuxer = std::make_shared<Demuxer>(input_);
+    auto chunking_timer = std::make_shared<StageTimer>();
+    auto encryption_timer = std::make_shared<StageTimer>();
+    auto replicator_timer = std::make_shared<StageTimer>();
+    std::vector<std::shared_ptr<StageTimer>> muxer_timers;
+
+    auto chunker = std::make_shared<ChunkingHandler>(chunking_params);
+    std::shared_ptr<MediaHandler> encryptor = CreateEncryptionHandler(config);
+    auto replicator = std::make_shared<Replicator>();
+    ASSERT_OK(demuxer->SetHandler("video", chunking_timer));
+    ASSERT_OK(chunking_timer->AddHandler(chunker));
+    ASSERT_OK(chunker->AddHandler(encryption_timer));
+    ASSERT_OK(encryption_timer->AddHandler(encryptor));
+    ASSERT_OK(encryptor->AddHandler(replicator_timer));
+    ASSERT_OK(replicator_timer->AddHandler(replicator));
+    for (size_t i = 0; i < kNumOutputs; ++i) {
+      const std::string output_prefix = std::string(kMemoryFilePrefix) +
+                                        config.name + "_" +
+                                        std::to_string(i);
+      StreamDescriptor stream;
+      stream.output = output_prefix + "_init." + config.segment_extension;
+      stream.segment_template =
+          output_prefix + "_$Number$." + config.segment_extension;
+      if (config.output_format == CONTAINER_MPEG2TS)
+        stream.output.clear();
+      std::shared_ptr<Muxer> muxer =
+          muxer_factory.CreateMuxer(config.output_format, stream);
+      ASSERT_TRUE(muxer);
+      muxer_timers.push_back(std::make_shared<StageTimer>());
+      ASSERT_OK(replicator->AddHandler(muxer_timers.back()));
+      ASSERT_OK(muxer_timers.back()->AddHandler(muxer));
+    }
+
+    const base::TimeTicks start = base::TimeTicks::Now();
+    ASSERT_OK(demuxer->Initialize());
+    ASSERT_OK(demuxer->Run());
+    const base::TimeDelta total = base::TimeTicks::Now() - start;
+
+    base::TimeDelta muxers;
+    for (const auto& muxer_timer : muxer_timers)
+      muxers += muxer_timer->elapsed();
+    stats->demuxer += total - chunking_timer->elapsed();
+    stats->chunking += chunking_timer->elapsed() - encryption_timer->elapsed();
+    stats->encryption +=
+        encryption_timer->elapsed() - replicator_timer->elapsed();
+    stats->replicator += replicator_timer->elapsed() - muxers;
+    stats->muxers += muxers;
+    stats->total += total;
+    stats->num_samples += chunking_timer->num_samples();
+    stats->num_sample_bytes += chunking_timer->num_sample_bytes();
+  }
+
+  std::string input_;
+  std::unique_ptr<KeySource> key_source_;
+};
+
+TEST_F(PipelinePerfTest, Mp4) {
+  RunPipelineAndPrintResults({"mp4", "bear-640x360.mp4", CONTAINER_MOV, "m4s",
+                              FOURCC_cenc});
+}
+
+TEST_F(PipelinePerfTest, Ts) {
+  RunPipelineAndPrintResults({"ts", "bear-640x360.ts", CONTAINER_MPEG2TS, "ts",
+                              kAppleSampleAesProtectionScheme});
+}
+
+TEST_F(PipelinePerfTest, WebM) {
+  RunPipelineAndPrintResults({"webm", "bear-640x360.webm", CONTAINER_WEBM,
+                              "webm", FOURCC_cenc});
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,241 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/app/pipeline_stats.h"
+
+#include <inttypes.h>
+
+#include <algorithm>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/json/json_writer.h"
+#include "packager/base/logging.h"
+#include "packager/base/strings/stringprintf.h"
+#include "packager/base/values.h"
+#include "packager/file/file.h"
+#include "packager/file/file_write_stats.h"
+#include "packager/media/base/closure_thread.h"
+#include "packager/media/base/media_handler.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+double MicrosecondsToSeconds(int64_t microseconds) {
+  return microseconds / 1e6;
+}
+
+}  // namespace
+
+PipelineStatsCollector::PipelineStatsCollector() {
+  FileWriteStatsRegistry::GetInstance()->EnableRecording();
+}
+
+PipelineStatsCollector::~PipelineStatsCollector() {
+  FileWriteStatsRegistry::GetInstance()->DisableRecording();
+}
+
+void PipelineStatsCollector::AddHandler(
+    const std::string& name,
+    std::shared_ptr<MediaHandler> handler) {
+  DCHECK(handler);
+  handler->EnableCounters();
+  handlers_.push_back({name, std::move(handler)});
+}
+
+void PipelineStatsCollector::Start() {
+  base::AutoLock auto_lock(lock_);
+  start_time_ = base::TimeTicks::Now();
+}
+
+PipelineStats PipelineStatsCollector::GetStats() const {
+  PipelineStats stats;
+  {
+    base::AutoLock auto_lock(lock_);
+    if (!start_time_.is_null()) {
+      stats.elapsed_time_in_seconds =
+          (base::TimeTicks::Now() - start_time_).InSecondsF();
+    }
+  }
+
+  for (const HandlerEntry& entry : handlers_) {
+    const HandlerCounters* counters = entry.handler->counters();
+    HandlerStats handler_stats;
+    handler_stats.name = entry.name;
+    handler_stats.num_samples = counters->num_samples;
+    handler_stats.num_bytes = counters->num_bytes;
+    if (stats.elapsed_time_in_seconds > 0) {
+      handler_stats.samples_per_second =
+          handler_stats.num_samples / stats.elapsed_time_in_seconds;
+      handler_stats.bytes_per_second =
+          handler_stats.num_bytes / stats.elapsed_time_in_seconds;
+    }
+    const int64_t process_time_in_us = counters->process_time_in_us;
+    const int64_t dispatch_time_in_us = counters->dispatch_time_in_us;
+    handler_stats.total_time_in_seconds =
+        MicrosecondsToSeconds(process_time_in_us);
+    // Handlers with a queue dispatch in another thread, so the time spent in
+    // the downstream handlers may exceed the time spent in the handler.
+    handler_stats.self_time_in_seconds = MicrosecondsToSeconds(
+        std::max<int64_t>(process_time_in_us - dispatch_time_in_us, 0));
+    handler_stats.queue_depth = counters->queue_depth;
+    stats.handlers.push_back(handler_stats);
+  }
+
+  for (const FileWriteStats& write_stats :
+       FileWriteStatsRegistry::GetInstance()->GetStats()) {
+    FileStats file_stats;
+    file_stats.file_name = write_stats.file_name;
+    file_stats.num_writes = write_stats.num_writes;
+    file_stats.num_bytes = write_stats.num_bytes;
+    file_stats.total_write_time_in_seconds =
+        write_stats.total_write_time.InSecondsF();
+    file_stats.max_write_time_in_seconds =
+        write_stats.max_write_time.InSecondsF();
+    file_stats.flush_time_in_seconds = write_stats.flush_time.InSecondsF();
+    stats.files.push_back(file_stats);
+  }
+  return stats;
+}
+
+PipelineStatsDumper::PipelineStatsDumper(
+    const PipelineStatsCollector* collector,
+    const InstrumentationParams& params)
+    : collector_(collector),
+      params_(params),
+      stop_event_(base::WaitableEvent::ResetPolicy::MANUAL,
+                  base::WaitableEvent::InitialState::NOT_SIGNALED) {
+  DCHECK(collector_);
+  DCHECK_GT(params_.dump_interval_in_seconds, 0);
+}
+
+PipelineStatsDumper::~PipelineStatsDumper() {
+  if (dump_thread_)
+    Stop();
+}
+
+void PipelineStatsDumper::Start() {
+  DCHECK(!dump_thread_);
+  stop_event_.Reset();
+  dump_thread_.reset(new ClosureThread(
+      "PipelineStatsDumper",
+      base::Bind(&PipelineStatsDumper::DumpPeriodically,
+                 base::Unretained(this))));
+  dump_thread_->Start();
+}
+
+void PipelineStatsDumper::Stop() {
+  DCHECK(dump_thread_);
+  stop_event_.Signal();
+  dump_thread_->Join();
+  dump_thread_.reset();
+  Dump();
+}
+
+void PipelineStatsDumper::DumpPeriodically() {
+  const base::TimeDelta interval =
+      base::TimeDelta::FromSecondsD(params_.dump_interval_in_seconds);
+  while (!stop_event_.TimedWait(interval))
+    Dump();
+}
+
+void PipelineStatsDumper::Dump() {
+  const PipelineStats stats = collector_->GetStats();
+  const std::string dump =
+      params_.dump_format == InstrumentationParams::DumpFormat::kJson
+          ? PipelineStatsToJson(stats)
+          : PipelineStatsToText(stats);
+  if (params_.dump_output.empty()) {
+    LOG(INFO) << "Pipeline statistics:\n" << dump;
+    return;
+  }
+  if (!File::WriteFileAtomically(params_.dump_output.c_str(), dump))
+    LOG(WARNING) << "Failed to dump the statistics to " << params_.dump_output;
+}
+
+std::string PipelineStatsToText(const PipelineStats& stats) {
+  std::string text = base::StringPrintf("elapsed_time: %.3fs\n",
+                                        stats.elapsed_time_in_seconds);
+  for (const HandlerStats& handler : stats.handlers) {
+    base::StringAppendF(
+        &text,
+        "handler %s: samples=%" PRId64 " bytes=%" PRId64
+        " samples/s=%.1f bytes/s=%.0f total_time=%.3fs self_time=%.3fs"
+        " queue_depth=%" PRId64 "\n",
+        handler.name.c_str(), handler.num_samples, handler.num_bytes,
+        handler.samples_per_second, handler.bytes_per_second,
+        handler.total_time_in_seconds, handler.self_time_in_seconds,
+        handler.queue_depth);
+  }
+  for (const FileStats& file : stats.files) {
+    const double average_write_time_in_seconds =
+        file.num_writes > 0
+            ? file.total_write_time_in_seconds / file.num_writes
+            : 0;
+    base::StringAppendF(
+        &text,
+        "file %s: writes=%" PRId64 " bytes=%" PRId64
+        " write_time=%.3fs average_write_time=%.3fms"
+        " max_write_time=%.3fms flush_time=%.3fs\n",
+        file.file_name.c_str(), file.num_writes, file.num_bytes,
+        file.total_write_time_in_seconds,
+        average_write_time_in_seconds * 1000,
+        file.max_write_time_in_seconds * 1000, file.flush_time_in_seconds);
+  }
+  return text;
+}
+
+std::string PipelineStatsToJson(const PipelineStats& stats) {
+  // The counters are written as doubles, as base::Value integers have 32
+  // bits.
+  base::DictionaryValue stats_dict;
+  stats_dict.SetDouble("elapsed_time_in_seconds",
+                       stats.elapsed_time_in_seconds);
+
+  std::unique_ptr<base::ListValue> handlers(new base::ListValue);
+  for (const HandlerStats& handler : stats.handlers) {
+    std::unique_ptr<base::DictionaryValue> handler_dict(
+        new base::DictionaryValue);
+    handler_dict->SetString("name", handler.name);
+    handler_dict->SetDouble("num_samples", handler.num_samples);
+    handler_dict->SetDouble("num_bytes", handler.num_bytes);
+    handler_dict->SetDouble("samples_per_second", handler.samples_per_second);
+    handler_dict->SetDouble("bytes_per_second", handler.bytes_per_second);
+    handler_dict->SetDouble("total_time_in_seconds",
+                            handler.total_time_in_seconds);
+    handler_dict->SetDouble("self_time_in_seconds",
+                            handler.self_time_in_seconds);
+    handler_dict->SetDouble("queue_depth", handler.queue_depth);
+    handlers->Append(std::move(handler_dict));
+  }
+  stats_dict.Set("handlers", std::move(handlers));
+
+  std::unique_ptr<base::ListValue> files(new base::ListValue);
+  for (const FileStats& file : stats.files) {
+    std::unique_ptr<base::DictionaryValue> file_dict(
+        new base::DictionaryValue);
+    file_dict->SetString("file_name", file.file_name);
+    file_dict->SetDouble("num_writes", file.num_writes);
+    file_dict->SetDouble("num_bytes", file.num_bytes);
+    file_dict->SetDouble("total_write_time_in_seconds",
+                         file.total_write_time_in_seconds);
+    file_dict->SetDouble("max_write_time_in_seconds",
+                         file.max_write_time_in_seconds);
+    file_dict->SetDouble("flush_time_in_seconds", file.flush_time_in_seconds);
+    files->Append(std::move(file_dict));
+  }
+  stats_dict.Set("files", std::move(files));
+
+  std::string json;
+  base::JSONWriter::WriteWithOptions(
+      stats_dict, base::JSONWriter::OPTIONS_OMIT_DOUBLE_TYPE_PRESERVATION,
+      &json);
+  return json;
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,98 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_APP_PIPELINE_STATS_H_
+#define PACKAGER_APP_PIPELINE_STATS_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/base/time/time.h"
+#include "packager/packager.h"
+
+namespace shaka {
+namespace media {
+
+class ClosureThread;
+class MediaHandler;
+
+// Collects the statistics of the handlers of a pipeline and the write
+// statistics of the files opened while it exists.
+class PipelineStatsCollector {
+ public:
+  PipelineStatsCollector();
+  ~PipelineStatsCollector();
+
+  // Enable the counters of |handler|, which are reported under |name|. It
+  // should be called after setting up the graph before running the graph.
+  void AddHandler(const std::string& name,
+                  std::shared_ptr<MediaHandler> handler);
+
+  // Start the clock the rates are averaged over. It should be called when the
+  // pipeline starts running.
+  void Start();
+
+  // Can be called from any thread.
+  PipelineStats GetStats() const;
+
+ private:
+  PipelineStatsCollector(const PipelineStatsCollector&) = delete;
+  PipelineStatsCollector& operator=(const PipelineStatsCollector&) = delete;
+
+  struct HandlerEntry {
+    std::string name;
+    std::shared_ptr<MediaHandler> handler;
+  };
+
+  // Not modified once the pipeline is running.
+  std::vector<HandlerEntry> handlers_;
+
+  mutable base::Lock lock_;
+  base::TimeTicks start_time_;
+};
+
+// Dumps the statistics of a pipeline periodically in its own thread.
+class PipelineStatsDumper {
+ public:
+  // |collector| must outlive the dumper. |params.dump_interval_in_seconds|
+  // must be greater than 0.
+  PipelineStatsDumper(const PipelineStatsCollector* collector,
+                      const InstrumentationParams& params);
+  ~PipelineStatsDumper();
+
+  // Start dumping the statistics periodically.
+  void Start();
+  // Stop dumping the statistics periodically and dump them a last time.
+  void Stop();
+
+ private:
+  PipelineStatsDumper(const PipelineStatsDumper&) = delete;
+  PipelineStatsDumper& operator=(const PipelineStatsDumper&) = delete;
+
+  // Runs in |dump_thread_| until |stop_event_| is signaled.
+  void DumpPeriodically();
+  void Dump();
+
+  const PipelineStatsCollector* const collector_;
+  const InstrumentationParams params_;
+  std::unique_ptr<ClosureThread> dump_thread_;
+  base::WaitableEvent stop_event_;
+};
+
+// Formats the statistics in a human readable text, one line per handler and
+// per file.
+std::string PipelineStatsToText(const PipelineStats& stats);
+
+// Formats the statistics in JSON.
+std::string PipelineStatsToJson(const PipelineStats& stats);
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_APP_PIPELINE_STATS_H_
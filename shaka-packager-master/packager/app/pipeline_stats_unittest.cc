@@ -0,0 +1,139 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/app/pipeline_stats.h"
+
+#include <gtest/gtest.h>
+
+#include "packager/base/json/json_reader.h"
+#include "packager/base/values.h"
+#include "packager/file/file.h"
+#include "packager/file/memory_file.h"
+#include "packager/media/base/media_handler.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const char kHandlerName[] = "muxer output.mp4";
+const char kFileName[] = "memory://output.mp4";
+const uint8_t kData[] = {1, 2, 3, 4};
+
+class NullMediaHandler : public MediaHandler {
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+  Status Process(std::unique_ptr<StreamData> stream_data) override {
+    return Status::OK;
+  }
+};
+
+PipelineStats GetTestStats() {
+  PipelineStats stats;
+  stats.elapsed_time_in_seconds = 2;
+  HandlerStats handler;
+  handler.name = kHandlerName;
+  handler.num_samples = 100;
+  handler.num_bytes = 5000000000LL;
+  handler.samples_per_second = 50;
+  handler.bytes_per_second = 2500000000.0;
+  handler.total_time_in_seconds = 1.5;
+  handler.self_time_in_seconds = 0.5;
+  handler.queue_depth = 3;
+  stats.handlers.push_back(handler);
+  FileStats file;
+  file.file_name = kFileName;
+  file.num_writes = 4;
+  file.num_bytes = 4096;
+  file.total_write_time_in_seconds = 0.004;
+  file.max_write_time_in_seconds = 0.002;
+  file.flush_time_in_seconds = 0.25;
+  stats.files.push_back(file);
+  return stats;
+}
+
+}  // namespace
+
+TEST(PipelineStatsCollectorTest, ReportsHandlersAndFiles) {
+  std::shared_ptr<MediaHandler> handler = std::make_shared<NullMediaHandler>();
+  PipelineStatsCollector collector;
+  collector.AddHandler(kHandlerName, handler);
+  ASSERT_TRUE(handler->counters());
+  handler->counters()->num_samples = 10;
+  handler->counters()->num_bytes = 1000;
+  handler->counters()->process_time_in_us = 3000;
+  handler->counters()->dispatch_time_in_us = 1000;
+  collector.Start();
+
+  // Files opened while the collector exists are recorded.
+  ASSERT_TRUE(File::WriteStringToFile(
+      kFileName, std::string(std::begin(kData), std::end(kData))));
+  MemoryFile::DeleteAll();
+
+  const PipelineStats stats = collector.GetStats();
+  ASSERT_EQ(1u, stats.handlers.size());
+  EXPECT_EQ(kHandlerName, stats.handlers[0].name);
+  EXPECT_EQ(10, stats.handlers[0].num_samples);
+  EXPECT_EQ(1000, stats.handlers[0].num_bytes);
+  EXPECT_DOUBLE_EQ(0.003, stats.handlers[0].total_time_in_seconds);
+  EXPECT_DOUBLE_EQ(0.002, stats.handlers[0].self_time_in_seconds);
+  EXPECT_GT(stats.handlers[0].samples_per_second, 0);
+
+  bool found_file = false;
+  for (const FileStats& file : stats.files) {
+    if (file.file_name != kFileName)
+      continue;
+    found_file = true;
+    EXPECT_EQ(1, file.num_writes);
+    EXPECT_EQ(static_cast<int64_t>(sizeof(kData)), file.num_bytes);
+  }
+  EXPECT_TRUE(found_file);
+}
+
+TEST(PipelineStatsTest, ToText) {
+  const std::string text = PipelineStatsToText(GetTestStats());
+  EXPECT_EQ(
+      "elapsed_time: 2.000s\n"
+      "handler muxer output.mp4: samples=100 bytes=5000000000 "
+      "samples/s=50.0 bytes/s=2500000000 total_time=1.500s self_time=0.500s "
+      "queue_depth=3\n"
+      "file memory://output.mp4: writes=4 bytes=4096 write_time=0.004s "
+      "average_write_time=1.000ms max_write_time=2.000ms flush_time=0.250s\n",
+      text);
+}
+
+TEST(PipelineStatsTest, ToJson) {
+  const std::string json = PipelineStatsToJson(GetTestStats());
+  std::unique_ptr<base::Value> value = base::JSONReader::Read(json);
+  ASSERT_TRUE(value) << json;
+  const base::DictionaryValue* stats_dict = nullptr;
+  ASSERT_TRUE(value->GetAsDictionary(&stats_dict));
+
+  double elapsed_time = 0;
+  ASSERT_TRUE(stats_dict->GetDouble("elapsed_time_in_seconds", &elapsed_time));
+  EXPECT_DOUBLE_EQ(2, elapsed_time);
+
+  const base::ListValue* handlers = nullptr;
+  ASSERT_TRUE(stats_dict->GetList("handlers", &handlers));
+  const base::DictionaryValue* handler_dict = nullptr;
+  ASSERT_TRUE(handlers->GetDictionary(0, &handler_dict));
+  std::string name;
+  ASSERT_TRUE(handler_dict->GetString("name", &name));
+  EXPECT_EQ(kHandlerName, name);
+  double num_bytes = 0;
+  ASSERT_TRUE(handler_dict->GetDouble("num_bytes", &num_bytes));
+  EXPECT_DOUBLE_EQ(5000000000.0, num_bytes);
+
+  const base::ListValue* files = nullptr;
+  ASSERT_TRUE(stats_dict->GetList("files", &files));
+  const base::DictionaryValue* file_dict = nullptr;
+  ASSERT_TRUE(files->GetDictionary(0, &file_dict));
+  std::string file_name;
+  ASSERT_TRUE(file_dict->GetString("file_name", &file_name));
+  EXPECT_EQ(kFileName, file_name);
+}
+
+}  // namespace media
+}  // namespace shaka
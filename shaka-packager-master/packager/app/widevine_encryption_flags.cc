@@ -64,6 +64,11 @@ DEFINE_int32(crypto_period_duration,
              "Crypto period duration in seconds. If it is non-zero, key "
              "rotation is enabled.");
 DEFINE_hex_bytes(group_id, "", "Identifier for a group of licenses (hex).");
+DEFINE_int32(num_concurrent_key_requests,
+             3,
+             "The number of key rotation requests sent to the key server at "
+             "the same time, i.e. the number of batches of crypto period keys "
+             "fetched ahead.");
 
 namespace shaka {
 namespace {
@@ -175,6 +180,10 @@ bool ValidateWidevineCryptoFlags() {
     PrintError("--crypto_period_duration should not be negative.");
     success = false;
   }
+  if (FLAGS_num_concurrent_key_requests <= 0) {
+    PrintError("--num_concurrent_key_requests must be positive.");
+    success = false;
+  }
   return success;
 }
 
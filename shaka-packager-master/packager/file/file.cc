@@ -17,10 +17,19 @@
 #include "packager/base/strings/stringprintf.h"
 #include "packager/file/callback_file.h"
 #include "packager/file/file_util.h"
+#include "packager/file/file_write_stats.h"
+#include "packager/file/instrumented_file.h"
 #include "packager/file/local_file.h"
 #include "packager/file/memory_file.h"
+#include "packager/file/mmap_file.h"
 #include "packager/file/threaded_io_file.h"
 #include "packager/file/udp_file.h"
+#include "packager/file/udp_options.h"
+
+#if !defined(OS_WIN)
+#include "packager/file/io_ring.h"
+#include "packager/file/io_ring_file.h"
+#endif  // !defined(OS_WIN)
 
 DEFINE_uint64(io_cache_size,
               32ULL << 20,
@@ -29,6 +38,19 @@ DEFINE_uint64(io_cache_size,
 DEFINE_uint64(io_block_size,
               2ULL << 20,
               "Size of the block size used for threaded I/O, in bytes.");
+DEFINE_bool(use_io_ring,
+            false,
+            "Write local output files through one I/O ring shared by all the "
+            "files, instead of with a thread per file. The ring uses io_uring "
+            "if available, or a small thread pool otherwise. Not supported on "
+            "Windows.");
+DEFINE_uint64(io_ring_buffer_size,
+              256ULL << 10,
+              "Size of the buffers of the I/O ring, in bytes.");
+DEFINE_uint64(io_ring_num_buffers,
+              128,
+              "Number of buffers of the I/O ring. The buffers are registered "
+              "with the kernel if possible.");
 
 // Needed for Windows weirdness which somewhere defines CopyFile as CopyFileW.
 #ifdef CopyFile
@@ -40,6 +62,7 @@ namespace shaka {
 const char* kCallbackFilePrefix = "callback://";
 const char* kLocalFilePrefix = "file://";
 const char* kMemoryFilePrefix = "memory://";
+const char* kMmapFilePrefix = "mmap://";
 const char* kUdpFilePrefix = "udp://";
 
 namespace {
@@ -104,6 +127,22 @@ bool DeleteMemoryFile(const char* file_name) {
   return true;
 }
 
+File* CreateMmapFile(const char* file_name, const char* mode) {
+  return new MmapFile(file_name, mode);
+}
+
+#if !defined(OS_WIN)
+// The I/O ring shared by all the files. It is never destroyed, like the
+// threads of the threaded I/O.
+IoRing* GetIoRing() {
+  static IoRing* io_ring =
+      IoRing::Create(IoRing::Backend::kIoUring, FLAGS_io_ring_num_buffers,
+                     FLAGS_io_ring_buffer_size)
+          .release();
+  return io_ring;
+}
+#endif  // !defined(OS_WIN)
+
 static const FileTypeInfo kFileTypeInfo[] = {
     {
         kLocalFilePrefix,
@@ -114,6 +153,7 @@ static const FileTypeInfo kFileTypeInfo[] = {
     {kUdpFilePrefix, &CreateUdpFile, nullptr, nullptr},
     {kMemoryFilePrefix, &CreateMemoryFile, &DeleteMemoryFile, nullptr},
     {kCallbackFilePrefix, &CreateCallbackFile, nullptr, nullptr},
+    {kMmapFilePrefix, &CreateMmapFile, &DeleteLocalFile, nullptr},
 };
 
 base::StringPiece GetFileTypePrefix(base::StringPiece file_name) {
@@ -138,16 +178,48 @@ const FileTypeInfo* GetFileTypeInfo(base::StringPiece file_name,
 }  // namespace
 
 File* File::Create(const char* file_name, const char* mode) {
+#if !defined(OS_WIN)
+  if (FLAGS_use_io_ring && (!strcmp(mode, "w") || !strcmp(mode, "a"))) {
+    base::StringPiece real_file_name;
+    const FileTypeInfo* file_type =
+        GetFileTypeInfo(file_name, &real_file_name);
+    if (file_type->factory_function == &CreateLocalFile)
+      return new IoRingFile(real_file_name.data(), mode, GetIoRing());
+  }
+#endif  // !defined(OS_WIN)
+
   std::unique_ptr<File, FileCloser> internal_file(
       CreateInternalFile(file_name, mode));
 
   base::StringPiece file_type_prefix = GetFileTypePrefix(file_name);
   if (file_type_prefix == kMemoryFilePrefix ||
-      file_type_prefix == kCallbackFilePrefix) {
-    // Disable caching for memory and callback files.
+      file_type_prefix == kCallbackFilePrefix ||
+      file_type_prefix == kMmapFilePrefix) {
+    // Disable caching for memory, callback and memory mapped files.
     return internal_file.release();
   }
 
+  if (file_type_prefix == kUdpFilePrefix && internal_file) {
+    // A UDP input with a jitter buffer is received in its own thread, which
+    // drops the datagrams instead of blocking when the buffer is full, so
+    // that the socket buffer does not overflow while the pipeline stalls.
+    std::unique_ptr<UdpOptions> options =
+        UdpOptions::ParseFromString(internal_file->file_name());
+    if (options &&
+        (options->jitter_buffer_ms() || options->jitter_buffer_size())) {
+      const uint64_t cache_size =
+          options->jitter_buffer_size()
+              ? options->jitter_buffer_size()
+              : std::max(FLAGS_io_cache_size, FLAGS_io_block_size);
+      ThreadedIoFile* file = new ThreadedIoFile(
+          std::move(internal_file), ThreadedIoFile::kLossyInputMode,
+          cache_size, FLAGS_io_block_size);
+      file->set_max_cached_duration(
+          base::TimeDelta::FromMilliseconds(options->jitter_buffer_ms()));
+      return file;
+    }
+  }
+
   if (FLAGS_io_cache_size) {
     // Enable threaded I/O for "r", "w", and "a" modes only.
     if (!strcmp(mode, "r")) {
@@ -177,6 +249,11 @@ File* File::Open(const char* file_name, const char* mode) {
   File* file = File::Create(file_name, mode);
   if (!file)
     return NULL;
+  FileWriteStatsRegistry* write_stats = FileWriteStatsRegistry::GetInstance();
+  if (write_stats->recording() && (!strcmp(mode, "w") || !strcmp(mode, "a"))) {
+    file = new InstrumentedFile(std::unique_ptr<File, FileCloser>(file),
+                                file_name, write_stats);
+  }
   if (!file->Open()) {
     delete file;
     return NULL;
@@ -20,12 +20,18 @@
         'file_util.cc',
         'file_util.h',
         'file_closer.h',
+        'file_write_stats.cc',
+        'file_write_stats.h',
+        'instrumented_file.cc',
+        'instrumented_file.h',
         'io_cache.cc',
         'io_cache.h',
         'local_file.cc',
         'local_file.h',
         'memory_file.cc',
         'memory_file.h',
+        'mmap_file.cc',
+        'mmap_file.h',
         'public/buffer_callback_params.h',
         'threaded_io_file.cc',
         'threaded_io_file.h',
@@ -38,6 +44,16 @@
         '../base/base.gyp:base',
         '../third_party/gflags/gflags.gyp:gflags',
       ],
+      'conditions': [
+        ['OS != "win"', {
+          'sources': [
+            'io_ring.cc',
+            'io_ring.h',
+            'io_ring_file.cc',
+            'io_ring_file.h',
+          ],
+        }],
+      ],
     },
     {
       'target_name': 'file_unittest',
@@ -46,8 +62,10 @@
         'callback_file_unittest.cc',
         'file_unittest.cc',
         'file_util_unittest.cc',
+        'file_write_stats_unittest.cc',
         'io_cache_unittest.cc',
         'memory_file_unittest.cc',
+        'mmap_file_unittest.cc',
         'udp_options_unittest.cc',
       ],
       'dependencies': [
@@ -57,6 +75,27 @@
         '../third_party/gflags/gflags.gyp:gflags',
         'file',
       ],
+      'conditions': [
+        ['OS != "win"', {
+          'sources': [
+            'io_ring_file_unittest.cc',
+            'udp_file_unittest.cc',
+          ],
+        }],
+      ],
+    },
+    {
+      'target_name': 'file_perftest',
+      'type': '<(gtest_target_type)',
+      'sources': [
+        'io_cache_perftest.cc',
+      ],
+      'dependencies': [
+        '../media/test/media_test.gyp:run_tests_with_atexit_manager',
+        '../testing/gtest.gyp:gtest',
+        '../testing/perf/perf_test.gyp:perf_test',
+        'file',
+      ],
     },
   ],
 }
@@ -9,6 +9,7 @@
 
 #include <stdint.h>
 
+#include <memory>
 #include <string>
 
 #include "packager/base/macros.h"
@@ -19,6 +20,7 @@ namespace shaka {
 extern const char* kCallbackFilePrefix;
 extern const char* kLocalFilePrefix;
 extern const char* kMemoryFilePrefix;
+extern const char* kMmapFilePrefix;
 extern const char* kUdpFilePrefix;
 const int64_t kWholeFile = -1;
 
@@ -89,6 +91,18 @@ class File {
   /// @return true on succcess, false otherwise.
   virtual bool Tell(uint64_t* position) = 0;
 
+  /// Get a view of the whole file contents in memory, for files which are
+  /// backed by memory, e.g. MmapFile. The view stays valid after the file is
+  /// closed, for as long as |data| is referenced.
+  /// @param data is a pointer to contain the file contents upon successful
+  ///        return.
+  /// @param size is a pointer to contain the size of the file contents upon
+  ///        successful return.
+  /// @return true on success, false if the file does not support views.
+  virtual bool GetView(std::shared_ptr<const uint8_t>* data, uint64_t* size) {
+    return false;
+  }
+
   /// @return The file name. Note that the file type prefix has been stripped
   ///         off.
   const std::string& file_name() const { return file_name_; }
@@ -173,6 +187,7 @@ class File {
   virtual bool Open() = 0;
 
  private:
+  friend class InstrumentedFile;
   friend class ThreadedIoFile;
 
   // This is a file factory method, it creates a proper file, e.g.
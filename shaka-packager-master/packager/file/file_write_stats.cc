@@ -0,0 +1,94 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/file_write_stats.h"
+
+#include "packager/base/logging.h"
+
+namespace shaka {
+namespace {
+
+const size_t kMaxNumFiles = 1024;
+
+}  // namespace
+
+FileWriteStatsRegistry::FileWriteStatsRegistry(size_t max_num_files)
+    : max_num_files_(max_num_files) {
+  DCHECK_GT(max_num_files_, 0u);
+}
+
+FileWriteStatsRegistry::~FileWriteStatsRegistry() {}
+
+// static
+FileWriteStatsRegistry* FileWriteStatsRegistry::GetInstance() {
+  static FileWriteStatsRegistry* registry =
+      new FileWriteStatsRegistry(kMaxNumFiles);
+  return registry;
+}
+
+void FileWriteStatsRegistry::EnableRecording() {
+  base::AutoLock auto_lock(lock_);
+  ++num_recording_users_;
+}
+
+void FileWriteStatsRegistry::DisableRecording() {
+  base::AutoLock auto_lock(lock_);
+  DCHECK_GT(num_recording_users_, 0);
+  --num_recording_users_;
+}
+
+bool FileWriteStatsRegistry::recording() const {
+  base::AutoLock auto_lock(lock_);
+  return num_recording_users_ > 0;
+}
+
+void FileWriteStatsRegistry::RecordWrite(const std::string& file_name,
+                                         int64_t size,
+                                         base::TimeDelta elapsed) {
+  base::AutoLock auto_lock(lock_);
+  FileWriteStats* stats = &GetEntry(file_name)->stats;
+  ++stats->num_writes;
+  stats->num_bytes += size;
+  stats->total_write_time += elapsed;
+  if (elapsed > stats->max_write_time)
+    stats->max_write_time = elapsed;
+}
+
+void FileWriteStatsRegistry::RecordFlush(const std::string& file_name,
+                                         base::TimeDelta elapsed) {
+  base::AutoLock auto_lock(lock_);
+  GetEntry(file_name)->stats.flush_time += elapsed;
+}
+
+std::vector<FileWriteStats> FileWriteStatsRegistry::GetStats() const {
+  std::vector<FileWriteStats> stats;
+  base::AutoLock auto_lock(lock_);
+  stats.reserve(entries_.size());
+  for (const auto& entry : entries_)
+    stats.push_back(entry.second.stats);
+  return stats;
+}
+
+FileWriteStatsRegistry::Entry* FileWriteStatsRegistry::GetEntry(
+    const std::string& file_name) {
+  auto iter = entries_.find(file_name);
+  if (iter == entries_.end()) {
+    if (entries_.size() >= max_num_files_) {
+      auto least_recently_used = entries_.begin();
+      for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->second.last_use < least_recently_used->second.last_use)
+          least_recently_used = it;
+      }
+      entries_.erase(least_recently_used);
+    }
+    iter = entries_.emplace(file_name, Entry()).first;
+    iter->second.stats.file_name = file_name;
+  }
+  iter->second.last_use = ++use_count_;
+  return &iter->second;
+}
+
+}  // namespace shaka
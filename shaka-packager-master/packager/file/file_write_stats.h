@@ -0,0 +1,89 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_FILE_WRITE_STATS_H_
+#define PACKAGER_FILE_FILE_WRITE_STATS_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "packager/base/macros.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/base/time/time.h"
+
+namespace shaka {
+
+/// Write statistics of a file.
+struct FileWriteStats {
+  std::string file_name;
+  int64_t num_writes = 0;
+  int64_t num_bytes = 0;
+  /// Time spent in File::Write.
+  base::TimeDelta total_write_time;
+  /// Longest File::Write call.
+  base::TimeDelta max_write_time;
+  /// Time spent in File::Flush and File::Close, which wait for the buffered
+  /// data to be written.
+  base::TimeDelta flush_time;
+};
+
+/// Collects the write statistics of the files opened for writing with
+/// File::Open while recording is enabled. It is thread safe.
+class FileWriteStatsRegistry {
+ public:
+  /// @param max_num_files is the maximum number of files with statistics.
+  ///        The statistics of the least recently written files are dropped
+  ///        beyond that, e.g. for the segments of a live stream.
+  explicit FileWriteStatsRegistry(size_t max_num_files);
+  ~FileWriteStatsRegistry();
+
+  /// @return the process wide registry, used by File::Open.
+  static FileWriteStatsRegistry* GetInstance();
+
+  /// Recording is enabled as long as EnableRecording() has been called more
+  /// times than DisableRecording(), so that users of the registry do not
+  /// disable each other.
+  void EnableRecording();
+  void DisableRecording();
+  bool recording() const;
+
+  /// Record a File::Write call of |size| bytes which took |elapsed|.
+  void RecordWrite(const std::string& file_name,
+                   int64_t size,
+                   base::TimeDelta elapsed);
+  /// Record a File::Flush or File::Close call which took |elapsed|.
+  void RecordFlush(const std::string& file_name, base::TimeDelta elapsed);
+
+  /// @return the statistics of the files, ordered by file name.
+  std::vector<FileWriteStats> GetStats() const;
+
+ private:
+  struct Entry {
+    FileWriteStats stats;
+    // Value of |use_count_| when the entry was last updated.
+    uint64_t last_use = 0;
+  };
+
+  // Returns the entry of |file_name|, adding it if needed. Called with |lock_|
+  // held.
+  Entry* GetEntry(const std::string& file_name);
+
+  const size_t max_num_files_;
+
+  mutable base::Lock lock_;
+  int num_recording_users_ = 0;
+  uint64_t use_count_ = 0;
+  std::map<std::string, Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileWriteStatsRegistry);
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_FILE_WRITE_STATS_H_
@@ -0,0 +1,93 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/file_write_stats.h"
+
+#include <gtest/gtest.h>
+
+#include "packager/file/file.h"
+#include "packager/file/memory_file.h"
+
+namespace shaka {
+namespace {
+
+const uint8_t kWriteBuffer[] = {1, 2, 3, 4, 5, 6, 7, 8};
+const int64_t kWriteBufferSize = sizeof(kWriteBuffer);
+const size_t kMaxNumFiles = 2;
+
+}  // namespace
+
+TEST(FileWriteStatsRegistryTest, RecordsWritesAndFlushes) {
+  FileWriteStatsRegistry registry(kMaxNumFiles);
+  registry.RecordWrite("file1", 10, base::TimeDelta::FromMilliseconds(3));
+  registry.RecordWrite("file1", 20, base::TimeDelta::FromMilliseconds(5));
+  registry.RecordFlush("file1", base::TimeDelta::FromMilliseconds(7));
+
+  const std::vector<FileWriteStats> stats = registry.GetStats();
+  ASSERT_EQ(1u, stats.size());
+  EXPECT_EQ("file1", stats[0].file_name);
+  EXPECT_EQ(2, stats[0].num_writes);
+  EXPECT_EQ(30, stats[0].num_bytes);
+  EXPECT_EQ(base::TimeDelta::FromMilliseconds(8), stats[0].total_write_time);
+  EXPECT_EQ(base::TimeDelta::FromMilliseconds(5), stats[0].max_write_time);
+  EXPECT_EQ(base::TimeDelta::FromMilliseconds(7), stats[0].flush_time);
+}
+
+TEST(FileWriteStatsRegistryTest, DropsLeastRecentlyWrittenFiles) {
+  FileWriteStatsRegistry registry(kMaxNumFiles);
+  registry.RecordWrite("file1", 1, base::TimeDelta());
+  registry.RecordWrite("file2", 1, base::TimeDelta());
+  registry.RecordWrite("file1", 1, base::TimeDelta());
+  registry.RecordWrite("file3", 1, base::TimeDelta());
+
+  const std::vector<FileWriteStats> stats = registry.GetStats();
+  ASSERT_EQ(2u, stats.size());
+  EXPECT_EQ("file1", stats[0].file_name);
+  EXPECT_EQ(2, stats[0].num_writes);
+  EXPECT_EQ("file3", stats[1].file_name);
+}
+
+TEST(FileWriteStatsRegistryTest, RecordingIsCounted) {
+  FileWriteStatsRegistry registry(kMaxNumFiles);
+  EXPECT_FALSE(registry.recording());
+  registry.EnableRecording();
+  registry.EnableRecording();
+  registry.DisableRecording();
+  EXPECT_TRUE(registry.recording());
+  registry.DisableRecording();
+  EXPECT_FALSE(registry.recording());
+}
+
+TEST(FileWriteStatsRegistryTest, RecordsFilesOpenedForWriting) {
+  FileWriteStatsRegistry* registry = FileWriteStatsRegistry::GetInstance();
+  registry->EnableRecording();
+  File* file = File::Open("memory://recorded_file", "w");
+  ASSERT_TRUE(file);
+  EXPECT_EQ(kWriteBufferSize, file->Write(kWriteBuffer, kWriteBufferSize));
+  EXPECT_TRUE(file->Close());
+  registry->DisableRecording();
+
+  // Files opened while not recording are not instrumented.
+  file = File::Open("memory://not_recorded_file", "w");
+  ASSERT_TRUE(file);
+  EXPECT_EQ(kWriteBufferSize, file->Write(kWriteBuffer, kWriteBufferSize));
+  EXPECT_TRUE(file->Close());
+  MemoryFile::DeleteAll();
+
+  // The process wide registry may have statistics of other files.
+  bool found_recorded_file = false;
+  for (const FileWriteStats& stats : registry->GetStats()) {
+    EXPECT_NE("memory://not_recorded_file", stats.file_name);
+    if (stats.file_name != "memory://recorded_file")
+      continue;
+    found_recorded_file = true;
+    EXPECT_EQ(1, stats.num_writes);
+    EXPECT_EQ(kWriteBufferSize, stats.num_bytes);
+  }
+  EXPECT_TRUE(found_recorded_file);
+}
+
+}  // namespace shaka
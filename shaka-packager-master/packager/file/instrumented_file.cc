@@ -0,0 +1,79 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/instrumented_file.h"
+
+#include "packager/base/logging.h"
+#include "packager/base/time/time.h"
+#include "packager/file/file_write_stats.h"
+
+namespace shaka {
+
+InstrumentedFile::InstrumentedFile(
+    std::unique_ptr<File, FileCloser> internal_file,
+    const std::string& file_name,
+    FileWriteStatsRegistry* registry)
+    : File(internal_file->file_name()),
+      internal_file_(std::move(internal_file)),
+      stats_file_name_(file_name),
+      registry_(registry) {
+  DCHECK(registry_);
+}
+
+InstrumentedFile::~InstrumentedFile() {}
+
+bool InstrumentedFile::Open() {
+  DCHECK(internal_file_);
+  return internal_file_->Open();
+}
+
+bool InstrumentedFile::Close() {
+  DCHECK(internal_file_);
+  const base::TimeTicks start = base::TimeTicks::Now();
+  const bool result = internal_file_.release()->Close();
+  registry_->RecordFlush(stats_file_name_, base::TimeTicks::Now() - start);
+  delete this;
+  return result;
+}
+
+int64_t InstrumentedFile::Read(void* buffer, uint64_t length) {
+  DCHECK(internal_file_);
+  return internal_file_->Read(buffer, length);
+}
+
+int64_t InstrumentedFile::Write(const void* buffer, uint64_t length) {
+  DCHECK(internal_file_);
+  const base::TimeTicks start = base::TimeTicks::Now();
+  const int64_t result = internal_file_->Write(buffer, length);
+  registry_->RecordWrite(stats_file_name_, result > 0 ? result : 0,
+                         base::TimeTicks::Now() - start);
+  return result;
+}
+
+int64_t InstrumentedFile::Size() {
+  DCHECK(internal_file_);
+  return internal_file_->Size();
+}
+
+bool InstrumentedFile::Flush() {
+  DCHECK(internal_file_);
+  const base::TimeTicks start = base::TimeTicks::Now();
+  const bool result = internal_file_->Flush();
+  registry_->RecordFlush(stats_file_name_, base::TimeTicks::Now() - start);
+  return result;
+}
+
+bool InstrumentedFile::Seek(uint64_t position) {
+  DCHECK(internal_file_);
+  return internal_file_->Seek(position);
+}
+
+bool InstrumentedFile::Tell(uint64_t* position) {
+  DCHECK(internal_file_);
+  return internal_file_->Tell(position);
+}
+
+}  // namespace shaka
@@ -0,0 +1,59 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_INSTRUMENTED_FILE_H_
+#define PACKAGER_FILE_INSTRUMENTED_FILE_H_
+
+#include <memory>
+#include <string>
+
+#include "packager/file/file.h"
+#include "packager/file/file_closer.h"
+
+namespace shaka {
+
+class FileWriteStatsRegistry;
+
+/// Forwards the calls to another file, timing the writes and the flushes.
+/// The statistics are recorded in a FileWriteStatsRegistry under the name the
+/// file was opened with.
+class InstrumentedFile : public File {
+ public:
+  /// @param internal_file is the file the calls are forwarded to. It is not
+  ///        opened yet.
+  /// @param registry records the statistics. It must outlive the file.
+  InstrumentedFile(std::unique_ptr<File, FileCloser> internal_file,
+                   const std::string& file_name,
+                   FileWriteStatsRegistry* registry);
+
+  /// @name File implementation overrides.
+  /// @{
+  bool Close() override;
+  int64_t Read(void* buffer, uint64_t length) override;
+  int64_t Write(const void* buffer, uint64_t length) override;
+  int64_t Size() override;
+  bool Flush() override;
+  bool Seek(uint64_t position) override;
+  bool Tell(uint64_t* position) override;
+  /// @}
+
+ protected:
+  ~InstrumentedFile() override;
+
+  bool Open() override;
+
+ private:
+  std::unique_ptr<File, FileCloser> internal_file_;
+  // The name including the file type prefix, e.g. "udp://".
+  const std::string stats_file_name_;
+  FileWriteStatsRegistry* const registry_;
+
+  DISALLOW_COPY_AND_ASSIGN(InstrumentedFile);
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_INSTRUMENTED_FILE_H_
@@ -14,22 +14,19 @@
 
 namespace shaka {
 
-using base::AutoLock;
-using base::AutoUnlock;
+// The positions are published with sequentially consistent stores and the
+// number of waiters is read afterwards. A blocking side increments
+// |num_waiters_| before checking the positions again, so either it sees the
+// update or the updating side sees it waiting and wakes it up.
 
 IoCache::IoCache(uint64_t cache_size)
     : cache_size_(cache_size),
-      read_event_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
-                  base::WaitableEvent::InitialState::NOT_SIGNALED),
-      write_event_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
-                   base::WaitableEvent::InitialState::NOT_SIGNALED),
-      // Make the buffer one byte larger than the cache so that when the
-      // condition r_ptr == w_ptr is unambiguous (buffer empty).
-      circular_buffer_(cache_size + 1),
-      end_ptr_(&circular_buffer_[0] + cache_size + 1),
-      r_ptr_(circular_buffer_.data()),
-      w_ptr_(circular_buffer_.data()),
-      closed_(false) {}
+      circular_buffer_(cache_size),
+      write_position_(0),
+      read_position_(0),
+      closed_(false),
+      state_changed_cv_(&lock_),
+      num_waiters_(0) {}
 
 IoCache::~IoCache() {
   Close();
@@ -38,28 +35,24 @@ IoCache::~IoCache() {
 uint64_t IoCache::Read(void* buffer, uint64_t size) {
   DCHECK(buffer);
 
-  AutoLock lock(lock_);
-  while (!closed_ && (BytesCachedInternal() == 0)) {
-    AutoUnlock unlock(lock_);
-    write_event_.Wait();
-  }
+  WaitUntil(&IoCache::HasDataOrClosed);
+
+  const uint64_t read_position = read_position_.load(std::memory_order_relaxed);
+  size = std::min(size, write_position_.load(std::memory_order_acquire) -
+                            read_position);
+  if (size == 0)
+    return 0;
 
-  size = std::min(size, BytesCachedInternal());
-  uint64_t first_chunk_size(
-      std::min(size, static_cast<uint64_t>(end_ptr_ - r_ptr_)));
-  memcpy(buffer, r_ptr_, first_chunk_size);
-  r_ptr_ += first_chunk_size;
-  DCHECK_GE(end_ptr_, r_ptr_);
-  if (r_ptr_ == end_ptr_)
-    r_ptr_ = &circular_buffer_[0];
-  uint64_t second_chunk_size(size - first_chunk_size);
+  const uint64_t offset = read_position % cache_size_;
+  const uint64_t first_chunk_size = std::min(size, cache_size_ - offset);
+  memcpy(buffer, &circular_buffer_[offset], first_chunk_size);
+  const uint64_t second_chunk_size = size - first_chunk_size;
   if (second_chunk_size) {
-    memcpy(static_cast<uint8_t*>(buffer) + first_chunk_size, r_ptr_,
-           second_chunk_size);
-    r_ptr_ += second_chunk_size;
-    DCHECK_GT(end_ptr_, r_ptr_);
+    memcpy(static_cast<uint8_t*>(buffer) + first_chunk_size,
+           circular_buffer_.data(), second_chunk_size);
   }
-  read_event_.Signal();
+  read_position_.store(read_position + size);
+  NotifyWaiters();
   return size;
 }
 
@@ -69,85 +62,114 @@ uint64_t IoCache::Write(const void* buffer, uint64_t size) {
   const uint8_t* r_ptr(static_cast<const uint8_t*>(buffer));
   uint64_t bytes_left(size);
   while (bytes_left) {
-    AutoLock lock(lock_);
-    while (!closed_ && (BytesFreeInternal() == 0)) {
-      AutoUnlock unlock(lock_);
-      read_event_.Wait();
-    }
+    WaitUntil(&IoCache::HasRoomOrClosed);
     if (closed_)
       return 0;
 
-    uint64_t write_size(std::min(bytes_left, BytesFreeInternal()));
-    uint64_t first_chunk_size(
-        std::min(write_size, static_cast<uint64_t>(end_ptr_ - w_ptr_)));
-    memcpy(w_ptr_, r_ptr, first_chunk_size);
-    w_ptr_ += first_chunk_size;
-    DCHECK_GE(end_ptr_, w_ptr_);
-    if (w_ptr_ == end_ptr_)
-      w_ptr_ = &circular_buffer_[0];
-    r_ptr += first_chunk_size;
-    uint64_t second_chunk_size(write_size - first_chunk_size);
-    if (second_chunk_size) {
-      memcpy(w_ptr_, r_ptr, second_chunk_size);
-      w_ptr_ += second_chunk_size;
-      DCHECK_GT(end_ptr_, w_ptr_);
-      r_ptr += second_chunk_size;
-    }
+    const uint64_t write_position =
+        write_position_.load(std::memory_order_relaxed);
+    const uint64_t bytes_free =
+        cache_size_ -
+        (write_position - read_position_.load(std::memory_order_acquire));
+    const uint64_t write_size = std::min(bytes_left, bytes_free);
+    CopyToBuffer(write_position, r_ptr, write_size);
+    r_ptr += write_size;
     bytes_left -= write_size;
-    write_event_.Signal();
+    write_position_.store(write_position + write_size);
+    NotifyWaiters();
   }
   return size;
 }
 
+bool IoCache::TryWrite(const void* buffer, uint64_t size) {
+  DCHECK(buffer);
+
+  if (closed_)
+    return false;
+
+  const uint64_t write_position =
+      write_position_.load(std::memory_order_relaxed);
+  const uint64_t bytes_free =
+      cache_size_ -
+      (write_position - read_position_.load(std::memory_order_acquire));
+  if (size > bytes_free)
+    return false;
+
+  CopyToBuffer(write_position, static_cast<const uint8_t*>(buffer), size);
+  write_position_.store(write_position + size);
+  NotifyWaiters();
+  return true;
+}
+
 void IoCache::Clear() {
-  AutoLock lock(lock_);
-  r_ptr_ = w_ptr_ = circular_buffer_.data();
+  read_position_.store(write_position_.load());
   // Let any writers know that there is room in the cache.
-  read_event_.Signal();
+  NotifyWaiters();
 }
 
 void IoCache::Close() {
-  AutoLock lock(lock_);
-  closed_ = true;
-  read_event_.Signal();
-  write_event_.Signal();
+  closed_.store(true);
+  NotifyWaiters();
 }
 
 void IoCache::Reopen() {
-  AutoLock lock(lock_);
   CHECK(closed_);
-  r_ptr_ = w_ptr_ = circular_buffer_.data();
-  closed_ = false;
-  read_event_.Reset();
-  write_event_.Reset();
+  write_position_.store(0);
+  read_position_.store(0);
+  closed_.store(false);
 }
 
 uint64_t IoCache::BytesCached() {
-  AutoLock lock(lock_);
-  return BytesCachedInternal();
+  const uint64_t read_position = read_position_.load();
+  return write_position_.load() - read_position;
 }
 
 uint64_t IoCache::BytesFree() {
-  AutoLock lock(lock_);
-  return BytesFreeInternal();
+  return cache_size_ - BytesCached();
 }
 
-uint64_t IoCache::BytesCachedInternal() {
-  return (r_ptr_ <= w_ptr_)
-             ? w_ptr_ - r_ptr_
-             : (end_ptr_ - r_ptr_) + (w_ptr_ - circular_buffer_.data());
+void IoCache::WaitUntilEmptyOrClosed() {
+  WaitUntil(&IoCache::EmptyOrClosed);
 }
 
-uint64_t IoCache::BytesFreeInternal() {
-  return cache_size_ - BytesCachedInternal();
+bool IoCache::HasDataOrClosed() const {
+  return closed_ || write_position_ != read_position_;
 }
 
-void IoCache::WaitUntilEmptyOrClosed() {
-  AutoLock lock(lock_);
-  while (!closed_ && BytesCachedInternal()) {
-    AutoUnlock unlock(lock_);
-    read_event_.Wait();
-  }
+bool IoCache::HasRoomOrClosed() const {
+  return closed_ || write_position_ - read_position_ < cache_size_;
+}
+
+bool IoCache::EmptyOrClosed() const {
+  return closed_ || write_position_ == read_position_;
+}
+
+void IoCache::WaitUntil(bool (IoCache::*condition)() const) {
+  if ((this->*condition)())
+    return;
+  base::AutoLock lock(lock_);
+  ++num_waiters_;
+  while (!(this->*condition)())
+    state_changed_cv_.Wait();
+  --num_waiters_;
+}
+
+void IoCache::NotifyWaiters() {
+  if (num_waiters_ == 0)
+    return;
+  base::AutoLock lock(lock_);
+  state_changed_cv_.Broadcast();
+}
+
+void IoCache::CopyToBuffer(uint64_t position,
+                           const uint8_t* data,
+                           uint64_t size) {
+  const uint64_t offset = position % cache_size_;
+  const uint64_t first_chunk_size = std::min(size, cache_size_ - offset);
+  memcpy(&circular_buffer_[offset], data, first_chunk_size);
+  const uint64_t second_chunk_size = size - first_chunk_size;
+  if (second_chunk_size)
+    memcpy(circular_buffer_.data(), data + first_chunk_size, second_chunk_size);
 }
 
 }  // namespace shaka
@@ -8,14 +8,20 @@
 #define PACKAGER_FILE_IO_CACHE_H_
 
 #include <stdint.h>
+#include <atomic>
 #include <vector>
 #include "packager/base/macros.h"
+#include "packager/base/synchronization/condition_variable.h"
 #include "packager/base/synchronization/lock.h"
-#include "packager/base/synchronization/waitable_event.h"
 
 namespace shaka {
 
 /// Declaration of class which implements a thread-safe circular buffer.
+///
+/// The buffer supports one reading thread and one writing thread. Read and
+/// Write do not take a lock: the reader and the writer only publish their
+/// positions. A lock and a condition variable are only used to block a side
+/// while the buffer is empty or full.
 class IoCache {
  public:
   explicit IoCache(uint64_t cache_size);
@@ -38,7 +44,15 @@ class IoCache {
   ///         closed.
   uint64_t Write(const void* buffer, uint64_t size);
 
-  /// Empties the cache.
+  /// Write data to the cache only if there is room for all of it. This
+  /// function never blocks.
+  /// @param buffer is a buffer containing the data to be written to the cache.
+  /// @param size is the size of the data to be written to the cache.
+  /// @return true if the data has been written, false if there is not enough
+  ///         room in the cache or the cache has been closed.
+  bool TryWrite(const void* buffer, uint64_t size);
+
+  /// Empties the cache. Must not be called concurrently with Read().
   void Clear();
 
   /// Close the cache. This will call any blocking calls to unblock, and the
@@ -48,7 +62,8 @@ class IoCache {
   /// @return true if the cache is closed, false otherwise.
   bool closed() { return closed_; }
 
-  /// Reopens the cache. Any data still in the cache will be lost.
+  /// Reopens the cache. Any data still in the cache will be lost. Must not be
+  /// called concurrently with Read() or Write().
   void Reopen();
 
   /// Returns the number of bytes in the cache.
@@ -63,18 +78,30 @@ class IoCache {
   void WaitUntilEmptyOrClosed();
 
  private:
-  uint64_t BytesCachedInternal();
-  uint64_t BytesFreeInternal();
+  bool HasDataOrClosed() const;
+  bool HasRoomOrClosed() const;
+  bool EmptyOrClosed() const;
+  // Blocks until |condition| is true.
+  void WaitUntil(bool (IoCache::*condition)() const);
+  // Wakes up the blocked side, if any.
+  void NotifyWaiters();
+  // Copies |size| bytes of |data| to the circular buffer at |position|. Only
+  // called by the writer.
+  void CopyToBuffer(uint64_t position, const uint8_t* data, uint64_t size);
 
   const uint64_t cache_size_;
-  base::Lock lock_;
-  base::WaitableEvent read_event_;
-  base::WaitableEvent write_event_;
   std::vector<uint8_t> circular_buffer_;
-  const uint8_t* end_ptr_;
-  uint8_t* r_ptr_;
-  uint8_t* w_ptr_;
-  bool closed_;
+  // The number of bytes written to and read from the cache since it was
+  // (re)opened. Only the writer advances |write_position_| and only the
+  // reader advances |read_position_|.
+  std::atomic<uint64_t> write_position_;
+  std::atomic<uint64_t> read_position_;
+  std::atomic<bool> closed_;
+
+  // Only used to block while the cache is empty or full.
+  base::Lock lock_;
+  base::ConditionVariable state_changed_cv_;
+  std::atomic<int> num_waiters_;
 
   DISALLOW_COPY_AND_ASSIGN(IoCache);
 };
@@ -0,0 +1,95 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+#include <sys/resource.h>
+
+#include <string>
+#include <vector>
+
+#include "packager/base/threading/simple_thread.h"
+#include "packager/base/time/time.h"
+#include "packager/file/io_cache.h"
+#include "packager/testing/perf/perf_test.h"
+
+namespace shaka {
+namespace {
+
+// The defaults of --io_cache_size and --io_block_size.
+const uint64_t kCacheSize = 32ULL << 20;
+const uint64_t kBlockSize = 2ULL << 20;
+// The size of the reads of a demuxer and of the writes of a muxer.
+const uint64_t kSmallChunkSize = 4096;
+const uint64_t kTotalSize = 1ULL << 30;
+
+// Reads all the data from the cache in chunks of |read_size|.
+class ReaderThread : public base::SimpleThread {
+ public:
+  ReaderThread(IoCache* cache, uint64_t read_size)
+      : base::SimpleThread("ReaderThread"),
+        cache_(cache),
+        read_size_(read_size) {}
+
+  void Run() override {
+    std::vector<uint8_t> buffer(read_size_);
+    while (cache_->Read(buffer.data(), buffer.size()) > 0) {
+    }
+  }
+
+ private:
+  IoCache* cache_;
+  const uint64_t read_size_;
+};
+
+int64_t NumContextSwitches() {
+  rusage usage;
+  EXPECT_EQ(0, getrusage(RUSAGE_SELF, &usage));
+  return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+// Passes |kTotalSize| bytes through an IoCache and reports the throughput and
+// the number of context switches.
+void RunIoCachePerfTest(uint64_t write_size,
+                        uint64_t read_size,
+                        const std::string& trace) {
+  IoCache cache(kCacheSize);
+  ReaderThread reader(&cache, read_size);
+  const std::vector<uint8_t> data(write_size, 0x23);
+
+  const int64_t context_switches_before = NumContextSwitches();
+  const base::TimeTicks start = base::TimeTicks::Now();
+  reader.Start();
+  for (uint64_t written = 0; written < kTotalSize; written += write_size)
+    ASSERT_EQ(write_size, cache.Write(data.data(), data.size()));
+  cache.Close();
+  reader.Join();
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  const int64_t context_switches =
+      NumContextSwitches() - context_switches_before;
+
+  perf_test::PrintResult("io_cache_throughput", "", trace,
+                         kTotalSize / elapsed.InSecondsF() / (1 << 20),
+                         "MiB/s", true);
+  perf_test::PrintResult("io_cache_context_switches", "", trace,
+                         static_cast<double>(context_switches), "count",
+                         true);
+}
+
+}  // namespace
+
+// ThreadedIoFile in output mode: the muxer writes small chunks, which the I/O
+// thread reads in blocks.
+TEST(IoCachePerfTest, OutputMode) {
+  RunIoCachePerfTest(kSmallChunkSize, kBlockSize, "output_mode");
+}
+
+// ThreadedIoFile in input mode: the I/O thread writes blocks, which the
+// demuxer reads in small chunks.
+TEST(IoCachePerfTest, InputMode) {
+  RunIoCachePerfTest(kBlockSize, kSmallChunkSize, "input_mode");
+}
+
+}  // namespace shaka
@@ -272,4 +272,30 @@ TEST_F(IoCacheTest, LargeRead) {
   cache_->Close();
 }
 
+TEST_F(IoCacheTest, TryWriteDoesNotBlock) {
+  std::vector<uint8_t> write_buffer;
+  GenerateTestBuffer(kCacheSize - kBlockSize, &write_buffer);
+  EXPECT_TRUE(cache_->TryWrite(write_buffer.data(), write_buffer.size()));
+
+  // Not enough room for two blocks. Nothing is written.
+  std::vector<uint8_t> two_blocks;
+  GenerateTestBuffer(2 * kBlockSize, &two_blocks);
+  EXPECT_FALSE(cache_->TryWrite(two_blocks.data(), two_blocks.size()));
+  EXPECT_EQ(kCacheSize - kBlockSize, cache_->BytesCached());
+
+  // Wraps around the end of the circular buffer once some data is read.
+  std::vector<uint8_t> read_buffer(kCacheSize - kBlockSize);
+  EXPECT_EQ(read_buffer.size(),
+            cache_->Read(read_buffer.data(), read_buffer.size()));
+  EXPECT_EQ(write_buffer, read_buffer);
+  EXPECT_TRUE(cache_->TryWrite(two_blocks.data(), two_blocks.size()));
+  read_buffer.resize(two_blocks.size());
+  EXPECT_EQ(read_buffer.size(),
+            cache_->Read(read_buffer.data(), read_buffer.size()));
+  EXPECT_EQ(two_blocks, read_buffer);
+
+  cache_->Close();
+  EXPECT_FALSE(cache_->TryWrite(two_blocks.data(), two_blocks.size()));
+}
+
 }  // namespace shaka
@@ -0,0 +1,509 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/io_ring.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// io_uring is only used if the kernel headers define it, which needs Linux
+// 5.1 headers. Otherwise only the thread pool is available.
+#if defined(OS_LINUX) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup)
+#define IO_RING_HAS_IO_URING
+// Added in Linux 5.4.
+#if !defined(IORING_FEAT_SINGLE_MMAP)
+#define IORING_FEAT_SINGLE_MMAP (1U << 0)
+#endif  // !defined(IORING_FEAT_SINGLE_MMAP)
+#endif  // defined(__NR_io_uring_setup)
+#endif  // __has_include(<linux/io_uring.h>)
+#endif  // defined(OS_LINUX) && defined(__has_include)
+
+#include <algorithm>
+
+#include "packager/base/atomicops.h"
+#include "packager/base/logging.h"
+#include "packager/base/threading/simple_thread.h"
+
+namespace shaka {
+namespace {
+
+// The number of queued writes which triggers a submission.
+const size_t kSubmitBatchSize = 8;
+const size_t kNumThreadPoolThreads = 4;
+const size_t kBufferAlignment = 4096;
+
+// Writes all of |data| at |offset|, retrying on partial writes.
+// Returns the number of bytes written or a negative errno.
+int64_t WriteFully(int fd, const uint8_t* data, size_t size, uint64_t offset) {
+  size_t bytes_written = 0;
+  while (bytes_written < size) {
+    const ssize_t result = pwrite(fd, data + bytes_written,
+                                  size - bytes_written, offset + bytes_written);
+    if (result < 0) {
+      if (errno == EINTR)
+        continue;
+      return -errno;
+    }
+    if (result == 0)
+      return -EIO;
+    bytes_written += result;
+  }
+  return bytes_written;
+}
+
+// Falls back to positioned writes on a small pool of threads.
+class ThreadPoolIoRing : public IoRing,
+                         public base::DelegateSimpleThread::Delegate {
+ public:
+  ThreadPoolIoRing(size_t num_buffers, size_t buffer_size)
+      : IoRing(Backend::kThreadPool, num_buffers, buffer_size),
+        work_cv_(&lock_) {
+    for (size_t i = 0; i < kNumThreadPoolThreads; ++i) {
+      threads_.emplace_back(
+          new base::DelegateSimpleThread(this, "IoRingThread"));
+      threads_.back()->Start();
+    }
+  }
+
+  ~ThreadPoolIoRing() override {
+    {
+      base::AutoLock auto_lock(lock_);
+      stop_requested_ = true;
+      work_cv_.Broadcast();
+    }
+    for (auto& thread : threads_)
+      thread->Join();
+  }
+
+  // base::DelegateSimpleThread::Delegate implementation.
+  void Run() override {
+    while (true) {
+      Request* request = nullptr;
+      {
+        base::AutoLock auto_lock(lock_);
+        while (submitted_requests_ == 0 && !stop_requested_)
+          work_cv_.Wait();
+        if (submitted_requests_ == 0)
+          return;
+        request = queued_requests_.front();
+        queued_requests_.pop_front();
+        --submitted_requests_;
+        ++in_flight_requests_;
+      }
+      OnWriteDone(request, WriteFully(request->fd, request->buffer->data(),
+                                      request->size, request->offset));
+    }
+  }
+
+ protected:
+  void SubmitLocked() override {
+    if (submitted_requests_ == queued_requests_.size())
+      return;
+    submitted_requests_ = queued_requests_.size();
+    work_cv_.Broadcast();
+  }
+
+ private:
+  std::vector<std::unique_ptr<base::DelegateSimpleThread>> threads_;
+  // Signaled when writes are submitted, or on stop.
+  base::ConditionVariable work_cv_;
+  // The number of requests at the front of |queued_requests_| which the
+  // threads may take.
+  size_t submitted_requests_ = 0;
+  bool stop_requested_ = false;
+};
+
+#if defined(IO_RING_HAS_IO_URING)
+
+// The number of submission queue entries. The completion queue is twice as
+// large.
+const uint32_t kIoUringEntries = 256;
+// The user data of the request which stops the completion thread.
+const uint64_t kStopUserData = 0;
+
+uint32_t LoadAcquire(const unsigned* ptr) {
+  return static_cast<uint32_t>(base::subtle::Acquire_Load(
+      reinterpret_cast<const volatile base::subtle::Atomic32*>(ptr)));
+}
+
+void StoreRelease(unsigned* ptr, uint32_t value) {
+  base::subtle::Release_Store(
+      reinterpret_cast<volatile base::subtle::Atomic32*>(ptr),
+      static_cast<base::subtle::Atomic32>(value));
+}
+
+// Uses the io_uring system calls directly, so there is no dependency on
+// liburing. The writes are submitted by the writing threads. A single thread
+// reaps the completions.
+class IoUringIoRing : public IoRing,
+                      public base::DelegateSimpleThread::Delegate {
+ public:
+  IoUringIoRing(size_t num_buffers, size_t buffer_size)
+      : IoRing(Backend::kIoUring, num_buffers, buffer_size) {}
+
+  ~IoUringIoRing() override {
+    if (completion_thread_) {
+      {
+        base::AutoLock auto_lock(lock_);
+        DCHECK(queued_requests_.empty());
+        DCHECK_EQ(0u, in_flight_requests_);
+        io_uring_sqe* sqe = NextSqeLocked();
+        DCHECK(sqe);
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = kStopUserData;
+        EnterLocked();
+      }
+      completion_thread_->Join();
+    }
+    if (sqes_ != MAP_FAILED)
+      munmap(sqes_, sqes_size_);
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_)
+      munmap(cq_ring_, cq_ring_size_);
+    if (sq_ring_ != MAP_FAILED)
+      munmap(sq_ring_, sq_ring_size_);
+    if (ring_fd_ >= 0)
+      close(ring_fd_);
+  }
+
+  // Sets up the ring and registers the buffers.
+  // Returns false if io_uring is not available.
+  bool Initialize() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = syscall(__NR_io_uring_setup, kIoUringEntries, &params);
+    if (ring_fd_ < 0) {
+      PLOG(WARNING) << "Failed to set up io_uring";
+      return false;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap)
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+      PLOG(WARNING) << "Failed to map io_uring submission queue";
+      return false;
+    }
+    cq_ring_ = single_mmap ? sq_ring_
+                           : mmap(nullptr, cq_ring_size_,
+                                  PROT_READ | PROT_WRITE,
+                                  MAP_SHARED | MAP_POPULATE, ring_fd_,
+                                  IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      PLOG(WARNING) << "Failed to map io_uring completion queue";
+      return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+      PLOG(WARNING) << "Failed to map io_uring submission queue entries";
+      return false;
+    }
+
+    uint8_t* sq = static_cast<uint8_t*>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sq_entries_ = params.sq_entries;
+    uint8_t* cq = static_cast<uint8_t*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    cq_entries_ = params.cq_entries;
+
+    // Registration fails if the buffers exceed RLIMIT_MEMLOCK. The buffers
+    // are then written with vectored writes.
+    std::vector<iovec> iovecs(num_buffers());
+    for (size_t i = 0; i < iovecs.size(); ++i) {
+      iovecs[i].iov_base = pool_buffers() + i * buffer_size();
+      iovecs[i].iov_len = buffer_size();
+    }
+    if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS,
+                iovecs.data(), iovecs.size()) == 0) {
+      buffers_registered_ = true;
+    } else {
+      PLOG(WARNING) << "Failed to register io_uring buffers";
+    }
+
+    completion_thread_.reset(
+        new base::DelegateSimpleThread(this, "IoRingCompletionThread"));
+    completion_thread_->Start();
+    return true;
+  }
+
+  // base::DelegateSimpleThread::Delegate implementation.
+  void Run() override {
+    while (true) {
+      const int result =
+          syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS,
+                  nullptr, 0);
+      if (result < 0 && errno != EINTR)
+        PLOG(ERROR) << "Failed to wait for io_uring completions";
+
+      // This is the only thread consuming the completion queue.
+      uint32_t head = *cq_head_;
+      const uint32_t tail = LoadAcquire(cq_tail_);
+      bool stop = false;
+      for (; head != tail; ++head) {
+        const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        if (cqe.user_data == kStopUserData) {
+          stop = true;
+          continue;
+        }
+        Request* request = reinterpret_cast<Request*>(cqe.user_data);
+        const int32_t request_result = cqe.res;
+        // Free the completion queue entry before the request is completed,
+        // which may submit more requests.
+        StoreRelease(cq_head_, head + 1);
+        OnWriteDone(request, request_result);
+      }
+      StoreRelease(cq_head_, head);
+      if (stop)
+        return;
+    }
+  }
+
+ protected:
+  void SubmitLocked() override {
+    // Keep the in-flight requests within the completion queue, so that no
+    // completion is dropped.
+    while (!queued_requests_.empty() && in_flight_requests_ < cq_entries_) {
+      io_uring_sqe* sqe = NextSqeLocked();
+      if (!sqe)
+        break;
+      Request* request = queued_requests_.front();
+      queued_requests_.pop_front();
+      ++in_flight_requests_;
+
+      const int buffer_index = request->buffer->index();
+      if (buffers_registered_ && buffer_index >= 0) {
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->addr = reinterpret_cast<uint64_t>(request->buffer->data());
+        sqe->len = request->size;
+        sqe->buf_index = buffer_index;
+      } else {
+        request->iov.iov_base = request->buffer->data();
+        request->iov.iov_len = request->size;
+        sqe->opcode = IORING_OP_WRITEV;
+        sqe->addr = reinterpret_cast<uint64_t>(&request->iov);
+        sqe->len = 1;
+      }
+      sqe->fd = request->fd;
+      sqe->off = request->offset;
+      sqe->user_data = reinterpret_cast<uint64_t>(request);
+    }
+    EnterLocked();
+  }
+
+ private:
+  // Returns a cleared submission queue entry, or NULL if the submission queue
+  // is full.
+  io_uring_sqe* NextSqeLocked() {
+    const uint32_t tail = *sq_tail_;
+    if (tail - LoadAcquire(sq_head_) >= sq_entries_)
+      return nullptr;
+    const uint32_t index = tail & sq_mask_;
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    StoreRelease(sq_tail_, tail + 1);
+    ++unsubmitted_entries_;
+    return sqe;
+  }
+
+  // Submits the filled submission queue entries in one system call. The
+  // entries which are not consumed are submitted in the next call.
+  void EnterLocked() {
+    while (unsubmitted_entries_ > 0) {
+      const int result = syscall(__NR_io_uring_enter, ring_fd_,
+                                 unsubmitted_entries_, 0, 0, nullptr, 0);
+      if (result < 0) {
+        if (errno == EINTR)
+          continue;
+        PLOG(ERROR) << "Failed to submit io_uring requests";
+        return;
+      }
+      unsubmitted_entries_ -= std::min<uint32_t>(result, unsubmitted_entries_);
+      if (result == 0)
+        return;
+    }
+  }
+
+  int ring_fd_ = -1;
+  void* sq_ring_ = MAP_FAILED;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = MAP_FAILED;
+  size_t cq_ring_size_ = 0;
+  void* sqes_ = MAP_FAILED;
+  size_t sqes_size_ = 0;
+
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  uint32_t sq_mask_ = 0;
+  uint32_t sq_entries_ = 0;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  io_uring_cqe* cqes_ = nullptr;
+  uint32_t cq_mask_ = 0;
+  uint32_t cq_entries_ = 0;
+
+  bool buffers_registered_ = false;
+  // The submission queue entries which are not consumed by the kernel yet.
+  uint32_t unsubmitted_entries_ = 0;
+  std::unique_ptr<base::DelegateSimpleThread> completion_thread_;
+};
+
+#endif  // defined(IO_RING_HAS_IO_URING)
+
+}  // namespace
+
+void IoRing::FreeDeleter::operator()(uint8_t* ptr) const {
+  free(ptr);
+}
+
+IoRing::IoRing(Backend backend, size_t num_buffers, size_t buffer_size)
+    : backend_(backend),
+      num_buffers_(num_buffers),
+      buffer_size_(buffer_size),
+      write_done_cv_(&lock_) {
+  DCHECK_GT(buffer_size, 0u);
+  void* pool_buffers = nullptr;
+  if (num_buffers > 0 &&
+      posix_memalign(&pool_buffers, kBufferAlignment,
+                     num_buffers * buffer_size) != 0) {
+    LOG(FATAL) << "Failed to allocate " << num_buffers << " I/O buffers of "
+               << buffer_size << " bytes.";
+  }
+  pool_buffers_.reset(static_cast<uint8_t*>(pool_buffers));
+  for (size_t i = 0; i < num_buffers; ++i) {
+    buffers_.emplace_back(
+        new Buffer(pool_buffers_.get() + i * buffer_size, static_cast<int>(i)));
+    free_buffers_.push_back(buffers_.back().get());
+  }
+}
+
+IoRing::~IoRing() {
+  DCHECK(queued_requests_.empty());
+  DCHECK_EQ(0u, in_flight_requests_);
+}
+
+// static
+std::unique_ptr<IoRing> IoRing::Create(Backend backend,
+                                       size_t num_buffers,
+                                       size_t buffer_size) {
+#if defined(IO_RING_HAS_IO_URING)
+  if (backend == Backend::kIoUring) {
+    std::unique_ptr<IoUringIoRing> io_ring(
+        new IoUringIoRing(num_buffers, buffer_size));
+    if (io_ring->Initialize())
+      return std::move(io_ring);
+    LOG(WARNING) << "io_uring is not available. Falling back to a thread pool.";
+  }
+#endif  // defined(IO_RING_HAS_IO_URING)
+  return std::unique_ptr<IoRing>(
+      new ThreadPoolIoRing(num_buffers, buffer_size));
+}
+
+IoRing::Buffer* IoRing::AcquireBuffer() {
+  base::AutoLock auto_lock(lock_);
+  while (free_buffers_.empty()) {
+    SubmitLocked();
+    if (queued_requests_.empty() && in_flight_requests_ == 0) {
+      // All the buffers are held by files, so none will be freed.
+      std::unique_ptr<uint8_t[]> storage(new uint8_t[buffer_size_]);
+      buffers_.emplace_back(new Buffer(storage.get(), -1));
+      buffers_.back()->storage_ = std::move(storage);
+      return buffers_.back().get();
+    }
+    write_done_cv_.Wait();
+  }
+  Buffer* buffer = free_buffers_.back();
+  free_buffers_.pop_back();
+  return buffer;
+}
+
+void IoRing::ReleaseBuffer(Buffer* buffer) {
+  DCHECK(buffer);
+  base::AutoLock auto_lock(lock_);
+  free_buffers_.push_back(buffer);
+  write_done_cv_.Broadcast();
+}
+
+void IoRing::QueueWrite(int fd,
+                        Buffer* buffer,
+                        size_t size,
+                        uint64_t offset,
+                        WriteGroup* group) {
+  DCHECK(buffer);
+  DCHECK_LE(size, buffer_size_);
+  DCHECK(group);
+  base::AutoLock auto_lock(lock_);
+  queued_requests_.push_back(
+      new Request{fd, buffer, size, offset, group, iovec()});
+  ++group->pending_writes_;
+  if (queued_requests_.size() >= kSubmitBatchSize)
+    SubmitLocked();
+}
+
+void IoRing::Submit() {
+  base::AutoLock auto_lock(lock_);
+  SubmitLocked();
+}
+
+bool IoRing::Wait(WriteGroup* group) {
+  DCHECK(group);
+  base::AutoLock auto_lock(lock_);
+  SubmitLocked();
+  while (group->pending_writes_ > 0)
+    write_done_cv_.Wait();
+  return !group->failed_.exchange(false, std::memory_order_acq_rel);
+}
+
+bool IoRing::Ok(const WriteGroup& group) {
+  return !group.failed_.load(std::memory_order_acquire);
+}
+
+void IoRing::OnWriteDone(Request* request, int64_t result) {
+  if (result >= 0 && static_cast<size_t>(result) < request->size) {
+    const int64_t remaining_result =
+        WriteFully(request->fd, request->buffer->data() + result,
+                   request->size - result, request->offset + result);
+    result = remaining_result < 0 ? remaining_result : request->size;
+  }
+  if (result < 0) {
+    LOG(ERROR) << "Failed to write " << request->size << " bytes at offset "
+               << request->offset << ": " << strerror(-result);
+  }
+
+  // Set before taking the lock, so Ok() sees the failure as early as possible.
+  if (result < 0)
+    request->group->failed_.store(true, std::memory_order_release);
+
+  base::AutoLock auto_lock(lock_);
+  --request->group->pending_writes_;
+  free_buffers_.push_back(request->buffer);
+  --in_flight_requests_;
+  delete request;
+  SubmitLocked();
+  write_done_cv_.Broadcast();
+}
+
+}  // namespace shaka
@@ -0,0 +1,183 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_IO_RING_H_
+#define PACKAGER_FILE_IO_RING_H_
+
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/base/synchronization/lock.h"
+
+namespace shaka {
+
+/// IoRing writes the data of many output files asynchronously, using one
+/// submission ring shared by all the files instead of a thread per file.
+///
+/// The data is written from a pool of fixed size buffers, which are
+/// registered with the kernel if possible, so the kernel does not need to map
+/// them for every write. The writes are queued and submitted in batches.
+///
+/// On Linux, the ring is backed by io_uring. If io_uring is not available, it
+/// falls back to a small pool of threads doing positioned writes.
+///
+/// This class is thread safe.
+class IoRing {
+ public:
+  enum class Backend {
+    kIoUring,
+    kThreadPool,
+  };
+
+  /// A buffer of the pool.
+  class Buffer {
+   public:
+    uint8_t* data() { return data_; }
+    /// @return The index of the buffer in the pool allocation, or -1 if the
+    ///         buffer was allocated after the pool.
+    int index() const { return index_; }
+
+   private:
+    friend class IoRing;
+
+    Buffer(uint8_t* data, int index) : data_(data), index_(index) {}
+
+    uint8_t* const data_;
+    const int index_;
+    // Only set if the buffer is not part of the pool allocation.
+    std::unique_ptr<uint8_t[]> storage_;
+  };
+
+  /// Tracks the writes of one file. It is only accessed by IoRing.
+  class WriteGroup {
+   private:
+    friend class IoRing;
+
+    // The number of queued or in-flight writes. Guarded by |lock_|.
+    int pending_writes_ = 0;
+    // Set when a write fails. Cleared by Wait(). Atomic so that Ok() does not
+    // need |lock_|, which is shared by all the files.
+    std::atomic<bool> failed_{false};
+  };
+
+  virtual ~IoRing();
+
+  /// Create an IoRing.
+  /// @param backend is the preferred backend. kIoUring falls back to
+  ///        kThreadPool if io_uring is not available.
+  /// @param num_buffers is the number of buffers in the pool. More buffers
+  ///        are allocated if all of them are held by files and none is being
+  ///        written, but only the first |num_buffers| are registered.
+  /// @param buffer_size is the size of each buffer.
+  /// @return The IoRing, never NULL.
+  static std::unique_ptr<IoRing> Create(Backend backend,
+                                        size_t num_buffers,
+                                        size_t buffer_size);
+
+  /// Acquire a buffer from the pool. Blocks while all the buffers are in use
+  /// and some of them are being written.
+  /// @return The buffer, which is owned by the ring.
+  Buffer* AcquireBuffer();
+
+  /// Return a buffer which is not going to be written to the pool.
+  void ReleaseBuffer(Buffer* buffer);
+
+  /// Queue a write. The write is submitted with the next batch, at the latest
+  /// in the next Submit() or Wait() call.
+  /// @param fd is the file descriptor to write to.
+  /// @param buffer is the buffer to write. It is released to the pool once
+  ///        written.
+  /// @param size is the number of bytes to write from |buffer|.
+  /// @param offset is the file offset to write at.
+  /// @param group is the group of the write.
+  void QueueWrite(int fd,
+                  Buffer* buffer,
+                  size_t size,
+                  uint64_t offset,
+                  WriteGroup* group);
+
+  /// Submit the queued writes.
+  void Submit();
+
+  /// Submit the queued writes and wait for the writes of a group.
+  /// @return false if a write of |group| failed since the last Wait() call,
+  ///         true otherwise.
+  bool Wait(WriteGroup* group);
+
+  /// Does not take the lock of the ring, so it is cheap enough to be called
+  /// for every write.
+  /// @return false if a write of |group| failed since the last Wait() call,
+  ///         true otherwise.
+  bool Ok(const WriteGroup& group);
+
+  /// @return The backend in use.
+  Backend backend() const { return backend_; }
+
+  /// @return The size of the buffers.
+  size_t buffer_size() const { return buffer_size_; }
+
+ protected:
+  /// A write of a buffer.
+  struct Request {
+    int fd;
+    Buffer* buffer;
+    size_t size;
+    uint64_t offset;
+    WriteGroup* group;
+    // Used by the backends which write with vectored writes.
+    iovec iov;
+  };
+
+  IoRing(Backend backend, size_t num_buffers, size_t buffer_size);
+
+  /// Submit the writes in |queued_requests_| to the backend. Called with
+  /// |lock_| held.
+  virtual void SubmitLocked() = 0;
+
+  /// Called by the backends when a write is done. Completes a short write
+  /// synchronously.
+  /// @param request is the request, which is deleted.
+  /// @param result is the number of bytes written, or a negative errno.
+  void OnWriteDone(Request* request, int64_t result);
+
+  /// @return The pool allocation, which has |num_buffers()| buffers of
+  ///         |buffer_size()| bytes.
+  uint8_t* pool_buffers() { return pool_buffers_.get(); }
+  size_t num_buffers() const { return num_buffers_; }
+
+  base::Lock lock_;
+  /// Queued writes which are not submitted to the backend yet.
+  std::deque<Request*> queued_requests_;
+  /// The number of writes submitted to the backend which are not done yet.
+  size_t in_flight_requests_ = 0;
+
+ private:
+  IoRing(const IoRing&) = delete;
+  IoRing& operator=(const IoRing&) = delete;
+
+  struct FreeDeleter {
+    void operator()(uint8_t* ptr) const;
+  };
+
+  const Backend backend_;
+  const size_t num_buffers_;
+  const size_t buffer_size_;
+  std::unique_ptr<uint8_t, FreeDeleter> pool_buffers_;
+  std::vector<std::unique_ptr<Buffer>> buffers_;
+  std::vector<Buffer*> free_buffers_;
+  // Signaled when a write is done.
+  base::ConditionVariable write_done_cv_;
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_IO_RING_H_
@@ -0,0 +1,137 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/io_ring_file.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "packager/base/logging.h"
+
+namespace shaka {
+
+IoRingFile::IoRingFile(const char* file_name,
+                       const char* mode,
+                       IoRing* io_ring)
+    : File(file_name), mode_(mode), io_ring_(io_ring) {
+  DCHECK(io_ring_);
+}
+
+IoRingFile::~IoRingFile() {}
+
+bool IoRingFile::Close() {
+  bool result = true;
+  if (fd_ >= 0) {
+    result = Flush();
+    if (close(fd_) != 0) {
+      PLOG(ERROR) << "Failed to close file '" << file_name() << "'";
+      result = false;
+    }
+  }
+  delete this;
+  return result;
+}
+
+int64_t IoRingFile::Read(void* buffer, uint64_t length) {
+  NOTIMPLEMENTED() << "IoRingFile is write only.";
+  return -1;
+}
+
+int64_t IoRingFile::Write(const void* buffer, uint64_t length) {
+  DCHECK(buffer);
+  DCHECK_GE(fd_, 0);
+  if (!io_ring_->Ok(write_group_))
+    return -1;
+
+  const uint8_t* data = static_cast<const uint8_t*>(buffer);
+  uint64_t bytes_left = length;
+  while (bytes_left > 0) {
+    if (!buffer_)
+      buffer_ = io_ring_->AcquireBuffer();
+    const size_t bytes_to_copy = static_cast<size_t>(
+        std::min<uint64_t>(bytes_left, io_ring_->buffer_size() - buffer_size_));
+    memcpy(buffer_->data() + buffer_size_, data, bytes_to_copy);
+    buffer_size_ += bytes_to_copy;
+    data += bytes_to_copy;
+    bytes_left -= bytes_to_copy;
+    if (buffer_size_ == io_ring_->buffer_size())
+      QueueBuffer();
+  }
+  size_ = std::max(size_, position_ + buffer_size_);
+  return length;
+}
+
+int64_t IoRingFile::Size() {
+  DCHECK_GE(fd_, 0);
+  return size_;
+}
+
+bool IoRingFile::Flush() {
+  DCHECK_GE(fd_, 0);
+  QueueBuffer();
+  return io_ring_->Wait(&write_group_);
+}
+
+bool IoRingFile::Seek(uint64_t position) {
+  // Writes at different offsets may overlap, so the pending writes are
+  // completed first.
+  if (!Flush())
+    return false;
+  position_ = position;
+  return true;
+}
+
+bool IoRingFile::Tell(uint64_t* position) {
+  DCHECK(position);
+  *position = position_ + buffer_size_;
+  return true;
+}
+
+bool IoRingFile::Open() {
+  int flags = O_WRONLY | O_CREAT;
+  if (mode_ == "w") {
+    flags |= O_TRUNC;
+  } else if (mode_ != "a") {
+    NOTIMPLEMENTED() << "File mode " << mode_
+                     << " not supported by IoRingFile";
+    return false;
+  }
+  // Not opened with O_APPEND, which would ignore the write offsets.
+  fd_ = open(file_name().c_str(), flags, 0666);
+  if (fd_ < 0) {
+    PLOG(ERROR) << "Failed to open file '" << file_name() << "'";
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd_, &file_stat) != 0) {
+    PLOG(ERROR) << "Failed to get the size of file '" << file_name() << "'";
+    close(fd_);
+    fd_ = -1;
+    return false;
+  }
+  size_ = file_stat.st_size;
+  position_ = mode_ == "a" ? size_ : 0;
+  return true;
+}
+
+void IoRingFile::QueueBuffer() {
+  if (!buffer_)
+    return;
+  if (buffer_size_ == 0) {
+    io_ring_->ReleaseBuffer(buffer_);
+  } else {
+    io_ring_->QueueWrite(fd_, buffer_, buffer_size_, position_, &write_group_);
+    position_ += buffer_size_;
+  }
+  buffer_ = nullptr;
+  buffer_size_ = 0;
+}
+
+}  // namespace shaka
@@ -0,0 +1,67 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_IO_RING_FILE_H_
+#define PACKAGER_FILE_IO_RING_FILE_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "packager/file/file.h"
+#include "packager/file/io_ring.h"
+
+namespace shaka {
+
+/// Implements a write only local File which writes through an IoRing. The
+/// data is collected in buffers of the ring, which are written
+/// asynchronously. Flush() waits for the pending writes.
+class IoRingFile : public File {
+ public:
+  /// @param file_name C string containing the name of the local file.
+  /// @param mode C string containing the file access mode. Only "w" and "a"
+  ///        are supported.
+  /// @param io_ring is the ring to write through. It must outlive the file.
+  IoRingFile(const char* file_name, const char* mode, IoRing* io_ring);
+
+  /// @name File implementation overrides.
+  /// @{
+  bool Close() override;
+  int64_t Read(void* buffer, uint64_t length) override;
+  int64_t Write(const void* buffer, uint64_t length) override;
+  int64_t Size() override;
+  bool Flush() override;
+  bool Seek(uint64_t position) override;
+  bool Tell(uint64_t* position) override;
+  /// @}
+
+ protected:
+  ~IoRingFile() override;
+  bool Open() override;
+
+ private:
+  friend class IoRingFileTest;
+
+  IoRingFile(const IoRingFile&) = delete;
+  IoRingFile& operator=(const IoRingFile&) = delete;
+
+  // Queues the write of |buffer_|, if any.
+  void QueueBuffer();
+
+  const std::string mode_;
+  IoRing* const io_ring_;
+  int fd_ = -1;
+  IoRing::WriteGroup write_group_;
+  // The buffer being filled, which is written at |position_|.
+  IoRing::Buffer* buffer_ = nullptr;
+  size_t buffer_size_ = 0;
+  uint64_t position_ = 0;
+  uint64_t size_ = 0;
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_IO_RING_FILE_H_
@@ -0,0 +1,196 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/io_ring_file.h"
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "packager/base/files/file_path.h"
+#include "packager/base/files/file_util.h"
+#include "packager/file/file_closer.h"
+#include "packager/file/io_ring.h"
+#include "packager/file/threaded_io_file.h"
+
+DECLARE_bool(use_io_ring);
+
+namespace shaka {
+namespace {
+
+const size_t kNumBuffers = 4;
+const size_t kBufferSize = 100;
+const size_t kDataSize = 1000;
+
+}  // namespace
+
+class IoRingFileTest : public testing::TestWithParam<IoRing::Backend> {
+ protected:
+  void SetUp() override {
+    io_ring_ = IoRing::Create(GetParam(), kNumBuffers, kBufferSize);
+    ASSERT_TRUE(base::CreateNewTempDirectory(base::FilePath::StringType(),
+                                             &temp_dir_));
+    for (size_t i = 0; i < kDataSize; ++i)
+      data_.push_back(static_cast<char>(i % 251));
+  }
+
+  void TearDown() override {
+    io_ring_.reset();
+    base::DeleteFile(temp_dir_, true);
+  }
+
+  std::string FilePath(const std::string& name) {
+    return temp_dir_.AppendASCII(name).AsUTF8Unsafe();
+  }
+
+  std::unique_ptr<File, FileCloser> OpenFile(const std::string& path,
+                                             const char* mode) {
+    IoRingFile* file = new IoRingFile(path.c_str(), mode, io_ring_.get());
+    if (!file->Open()) {
+      file->Close();
+      return nullptr;
+    }
+    return std::unique_ptr<File, FileCloser>(file);
+  }
+
+  std::string ReadFile(const std::string& path) {
+    std::string content;
+    EXPECT_TRUE(base::ReadFileToString(base::FilePath::FromUTF8Unsafe(path),
+                                       &content));
+    return content;
+  }
+
+  std::unique_ptr<IoRing> io_ring_;
+  base::FilePath temp_dir_;
+  std::string data_;
+};
+
+TEST_P(IoRingFileTest, Write) {
+  const std::string path = FilePath("a");
+  std::unique_ptr<File, FileCloser> file = OpenFile(path, "w");
+  ASSERT_TRUE(file);
+  // Chunks which are not aligned with the buffers.
+  const size_t kChunkSize = 37;
+  for (size_t offset = 0; offset < kDataSize; offset += kChunkSize) {
+    const size_t size = std::min(kChunkSize, kDataSize - offset);
+    EXPECT_EQ(static_cast<int64_t>(size),
+              file->Write(data_.data() + offset, size));
+  }
+  uint64_t position = 0;
+  ASSERT_TRUE(file->Tell(&position));
+  EXPECT_EQ(kDataSize, position);
+  EXPECT_EQ(static_cast<int64_t>(kDataSize), file->Size());
+  ASSERT_TRUE(file.release()->Close());
+  EXPECT_EQ(data_, ReadFile(path));
+}
+
+TEST_P(IoRingFileTest, FlushWritesPendingData) {
+  const std::string path = FilePath("a");
+  std::unique_ptr<File, FileCloser> file = OpenFile(path, "w");
+  ASSERT_TRUE(file);
+  ASSERT_EQ(250, file->Write(data_.data(), 250));
+  ASSERT_TRUE(file->Flush());
+  EXPECT_EQ(data_.substr(0, 250), ReadFile(path));
+  ASSERT_TRUE(file.release()->Close());
+}
+
+TEST_P(IoRingFileTest, SeekAndOverwrite) {
+  const std::string path = FilePath("a");
+  std::unique_ptr<File, FileCloser> file = OpenFile(path, "w");
+  ASSERT_TRUE(file);
+  ASSERT_EQ(static_cast<int64_t>(kDataSize),
+            file->Write(data_.data(), kDataSize));
+
+  const char kOverwrite[] = "overwrite";
+  const size_t kOverwriteSize = sizeof(kOverwrite) - 1;
+  const uint64_t kOverwritePosition = 95;
+  ASSERT_TRUE(file->Seek(kOverwritePosition));
+  ASSERT_EQ(static_cast<int64_t>(kOverwriteSize),
+            file->Write(kOverwrite, kOverwriteSize));
+  uint64_t position = 0;
+  ASSERT_TRUE(file->Tell(&position));
+  EXPECT_EQ(kOverwritePosition + kOverwriteSize, position);
+  EXPECT_EQ(static_cast<int64_t>(kDataSize), file->Size());
+  ASSERT_TRUE(file.release()->Close());
+
+  std::string expected = data_;
+  expected.replace(kOverwritePosition, kOverwriteSize, kOverwrite);
+  EXPECT_EQ(expected, ReadFile(path));
+}
+
+TEST_P(IoRingFileTest, Append) {
+  const std::string path = FilePath("a");
+  std::unique_ptr<File, FileCloser> file = OpenFile(path, "w");
+  ASSERT_TRUE(file);
+  ASSERT_EQ(150, file->Write(data_.data(), 150));
+  ASSERT_TRUE(file.release()->Close());
+
+  file = OpenFile(path, "a");
+  ASSERT_TRUE(file);
+  EXPECT_EQ(150, file->Size());
+  ASSERT_EQ(200, file->Write(data_.data() + 150, 200));
+  ASSERT_TRUE(file.release()->Close());
+  EXPECT_EQ(data_.substr(0, 350), ReadFile(path));
+}
+
+// Every file holds a buffer, so the buffers of the pool run out.
+TEST_P(IoRingFileTest, MoreFilesThanBuffers) {
+  const size_t kNumFiles = kNumBuffers * 2;
+  std::vector<std::unique_ptr<File, FileCloser>> files;
+  for (size_t i = 0; i < kNumFiles; ++i) {
+    files.push_back(OpenFile(FilePath(std::to_string(i)), "w"));
+    ASSERT_TRUE(files.back());
+    ASSERT_EQ(50, files.back()->Write(data_.data() + i, 50));
+  }
+  for (size_t i = 0; i < kNumFiles; ++i)
+    ASSERT_TRUE(files[i].release()->Close());
+  for (size_t i = 0; i < kNumFiles; ++i)
+    EXPECT_EQ(data_.substr(i, 50), ReadFile(FilePath(std::to_string(i))));
+}
+
+TEST_P(IoRingFileTest, OpenFailure) {
+  EXPECT_FALSE(OpenFile(FilePath("not_exist/a"), "w"));
+  EXPECT_FALSE(OpenFile(FilePath("a"), "r"));
+}
+
+INSTANTIATE_TEST_CASE_P(Backends,
+                        IoRingFileTest,
+                        testing::Values(IoRing::Backend::kIoUring,
+                                        IoRing::Backend::kThreadPool));
+
+TEST(IoRingFileFlagTest, FileOpen) {
+  base::FilePath temp_file_path;
+  ASSERT_TRUE(base::CreateTemporaryFile(&temp_file_path));
+  const std::string file_name =
+      std::string(kLocalFilePrefix) + temp_file_path.AsUTF8Unsafe();
+
+  google::FlagSaver flag_saver;
+  FLAGS_use_io_ring = true;
+  std::unique_ptr<File, FileCloser> file(File::Open(file_name.c_str(), "w"));
+  ASSERT_TRUE(file);
+  EXPECT_TRUE(dynamic_cast<IoRingFile*>(file.get()));
+  const std::string kContent = "content";
+  EXPECT_EQ(static_cast<int64_t>(kContent.size()),
+            file->Write(kContent.data(), kContent.size()));
+  ASSERT_TRUE(file.release()->Close());
+
+  std::string content;
+  EXPECT_TRUE(base::ReadFileToString(temp_file_path, &content));
+  EXPECT_EQ(kContent, content);
+
+  FLAGS_use_io_ring = false;
+  file.reset(File::Open(file_name.c_str(), "w"));
+  ASSERT_TRUE(file);
+  EXPECT_TRUE(dynamic_cast<ThreadedIoFile*>(file.get()));
+  file.reset();
+  base::DeleteFile(temp_file_path, false);
+}
+
+}  // namespace shaka
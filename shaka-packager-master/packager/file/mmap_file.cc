@@ -0,0 +1,105 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/mmap_file.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "packager/base/files/file_path.h"
+#include "packager/base/files/file_util.h"
+#include "packager/base/files/memory_mapped_file.h"
+#include "packager/base/logging.h"
+
+namespace shaka {
+
+MmapFile::MmapFile(const char* file_name, const char* mode)
+    : File(file_name), mode_(mode) {}
+
+MmapFile::~MmapFile() {}
+
+bool MmapFile::Close() {
+  delete this;
+  return true;
+}
+
+int64_t MmapFile::Read(void* buffer, uint64_t length) {
+  DCHECK(buffer);
+  DCHECK_LE(position_, size_);
+  const uint64_t bytes_to_read = std::min(length, size_ - position_);
+  if (bytes_to_read == 0)
+    return 0;
+  memcpy(buffer, data_.get() + position_, bytes_to_read);
+  position_ += bytes_to_read;
+  return bytes_to_read;
+}
+
+int64_t MmapFile::Write(const void* buffer, uint64_t length) {
+  NOTIMPLEMENTED() << "MmapFile is read only.";
+  return -1;
+}
+
+int64_t MmapFile::Size() {
+  return size_;
+}
+
+bool MmapFile::Flush() {
+  return true;
+}
+
+bool MmapFile::Seek(uint64_t position) {
+  if (position > size_)
+    return false;
+  position_ = position;
+  return true;
+}
+
+bool MmapFile::Tell(uint64_t* position) {
+  *position = position_;
+  return true;
+}
+
+bool MmapFile::GetView(std::shared_ptr<const uint8_t>* data, uint64_t* size) {
+  DCHECK(data);
+  DCHECK(size);
+  *data = data_;
+  *size = size_;
+  return true;
+}
+
+bool MmapFile::Open() {
+  if (mode_ != "r") {
+    NOTIMPLEMENTED() << "File mode " << mode_ << " not supported by MmapFile";
+    return false;
+  }
+
+  const base::FilePath file_path = base::FilePath::FromUTF8Unsafe(file_name());
+  int64_t file_size = 0;
+  if (!base::GetFileSize(file_path, &file_size)) {
+    LOG(ERROR) << "Failed to get the size of file '" << file_name() << "'.";
+    return false;
+  }
+  position_ = 0;
+  if (file_size == 0) {
+    // An empty file cannot be mapped.
+    size_ = 0;
+    return true;
+  }
+
+  std::shared_ptr<base::MemoryMappedFile> mapped_file(
+      new base::MemoryMappedFile);
+  if (!mapped_file->Initialize(file_path)) {
+    LOG(ERROR) << "Failed to memory map file '" << file_name() << "'.";
+    return false;
+  }
+  size_ = mapped_file->length();
+  // Share the ownership of the mapping with the views.
+  data_ = std::shared_ptr<const uint8_t>(mapped_file, mapped_file->data());
+  return true;
+}
+
+}  // namespace shaka
@@ -0,0 +1,58 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_FILE_MMAP_FILE_H_
+#define PACKAGER_FILE_MMAP_FILE_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "packager/file/file.h"
+
+namespace shaka {
+
+/// Implements a read-only File backed by a memory mapping of a local file.
+/// Besides Read, which copies the data like other files, the mapped contents
+/// can be accessed directly through GetView.
+class MmapFile : public File {
+ public:
+  /// @param file_name C string containing the name of the local file.
+  /// @param mode C string containing the file access mode. Only "r" is
+  ///        supported.
+  MmapFile(const char* file_name, const char* mode);
+
+  /// @name File implementation overrides.
+  /// @{
+  bool Close() override;
+  int64_t Read(void* buffer, uint64_t length) override;
+  int64_t Write(const void* buffer, uint64_t length) override;
+  int64_t Size() override;
+  bool Flush() override;
+  bool Seek(uint64_t position) override;
+  bool Tell(uint64_t* position) override;
+  bool GetView(std::shared_ptr<const uint8_t>* data, uint64_t* size) override;
+  /// @}
+
+ protected:
+  ~MmapFile() override;
+  bool Open() override;
+
+ private:
+  std::string mode_;
+  // The mapped file contents. The mapping is released when the last view of
+  // it is released, which may be after the file is closed.
+  std::shared_ptr<const uint8_t> data_;
+  uint64_t size_ = 0;
+  uint64_t position_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(MmapFile);
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_FILE_MMAP_FILE_H_
@@ -0,0 +1,113 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/mmap_file.h"
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <memory>
+
+#include "packager/base/files/file_util.h"
+#include "packager/file/file.h"
+#include "packager/file/file_closer.h"
+
+namespace shaka {
+namespace {
+
+const uint8_t kData[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+const int kDataSize = sizeof(kData);
+
+}  // namespace
+
+class MmapFileTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(base::CreateTemporaryFile(&test_file_path_));
+    mmap_file_name_ = kMmapFilePrefix + test_file_path_.AsUTF8Unsafe();
+  }
+
+  void TearDown() override { base::DeleteFile(test_file_path_, false); }
+
+  void WriteTestFile(const uint8_t* data, int size) {
+    ASSERT_EQ(size, base::WriteFile(test_file_path_,
+                                    reinterpret_cast<const char*>(data), size));
+  }
+
+  base::FilePath test_file_path_;
+  std::string mmap_file_name_;
+};
+
+TEST_F(MmapFileTest, ReadNotExist) {
+  ASSERT_TRUE(base::DeleteFile(test_file_path_, false));
+  EXPECT_FALSE(File::Open(mmap_file_name_.c_str(), "r"));
+}
+
+TEST_F(MmapFileTest, WriteNotSupported) {
+  EXPECT_FALSE(File::Open(mmap_file_name_.c_str(), "w"));
+}
+
+TEST_F(MmapFileTest, Read) {
+  WriteTestFile(kData, kDataSize);
+  std::unique_ptr<File, FileCloser> file(
+      File::Open(mmap_file_name_.c_str(), "r"));
+  ASSERT_TRUE(file);
+  EXPECT_EQ(kDataSize, file->Size());
+
+  uint8_t buffer[kDataSize];
+  EXPECT_EQ(3, file->Read(buffer, 3));
+  EXPECT_EQ(0, memcmp(kData, buffer, 3));
+  EXPECT_EQ(kDataSize - 3, file->Read(buffer, kDataSize));
+  EXPECT_EQ(0, memcmp(kData + 3, buffer, kDataSize - 3));
+  EXPECT_EQ(0, file->Read(buffer, kDataSize));
+}
+
+TEST_F(MmapFileTest, SeekAndTell) {
+  WriteTestFile(kData, kDataSize);
+  std::unique_ptr<File, FileCloser> file(
+      File::Open(mmap_file_name_.c_str(), "r"));
+  ASSERT_TRUE(file);
+
+  uint64_t position = 0;
+  ASSERT_TRUE(file->Seek(5));
+  ASSERT_TRUE(file->Tell(&position));
+  EXPECT_EQ(5u, position);
+  uint8_t value = 0;
+  EXPECT_EQ(1, file->Read(&value, 1));
+  EXPECT_EQ(kData[5], value);
+
+  EXPECT_FALSE(file->Seek(kDataSize + 1));
+}
+
+TEST_F(MmapFileTest, ViewOutlivesFile) {
+  WriteTestFile(kData, kDataSize);
+  File* file = File::Open(mmap_file_name_.c_str(), "r");
+  ASSERT_TRUE(file);
+
+  std::shared_ptr<const uint8_t> view;
+  uint64_t view_size = 0;
+  ASSERT_TRUE(file->GetView(&view, &view_size));
+  ASSERT_TRUE(file->Close());
+
+  ASSERT_EQ(static_cast<uint64_t>(kDataSize), view_size);
+  EXPECT_EQ(0, memcmp(kData, view.get(), kDataSize));
+}
+
+TEST_F(MmapFileTest, EmptyFile) {
+  std::unique_ptr<File, FileCloser> file(
+      File::Open(mmap_file_name_.c_str(), "r"));
+  ASSERT_TRUE(file);
+  EXPECT_EQ(0, file->Size());
+
+  uint8_t buffer[kDataSize];
+  EXPECT_EQ(0, file->Read(buffer, kDataSize));
+  std::shared_ptr<const uint8_t> view;
+  uint64_t view_size = kDataSize;
+  ASSERT_TRUE(file->GetView(&view, &view_size));
+  EXPECT_EQ(0u, view_size);
+}
+
+}  // namespace shaka
@@ -6,6 +6,8 @@
 
 #include "packager/file/threaded_io_file.h"
 
+#include <algorithm>
+
 #include "packager/base/bind.h"
 #include "packager/base/bind_helpers.h"
 #include "packager/base/location.h"
@@ -33,7 +35,9 @@ ThreadedIoFile::ThreadedIoFile(std::unique_ptr<File, FileCloser> internal_file,
                             base::WaitableEvent::InitialState::NOT_SIGNALED),
       internal_file_error_(0),
       task_exit_event_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
-                       base::WaitableEvent::InitialState::NOT_SIGNALED) {
+                       base::WaitableEvent::InitialState::NOT_SIGNALED),
+      num_bytes_dropped_(0),
+      num_reads_dropped_(0) {
   DCHECK(internal_file_);
 }
 
@@ -65,6 +69,11 @@ bool ThreadedIoFile::Close() {
   cache_.Close();
   task_exit_event_.Wait();
 
+  LOG_IF(WARNING, num_bytes_dropped_ > 0)
+      << "Dropped " << num_bytes_dropped_ << " bytes in "
+      << num_reads_dropped_ << " reads of " << file_name()
+      << " because it was not consumed fast enough.";
+
   result &= internal_file_.release()->Close();
   delete this;
   return result;
@@ -72,7 +81,7 @@ bool ThreadedIoFile::Close() {
 
 int64_t ThreadedIoFile::Read(void* buffer, uint64_t length) {
   DCHECK(internal_file_);
-  DCHECK_EQ(kInputMode, mode_);
+  DCHECK_NE(kOutputMode, mode_);
 
   if (NoBarrier_Load(&eof_) && !cache_.BytesCached())
     return 0;
@@ -162,6 +171,8 @@ bool ThreadedIoFile::Tell(uint64_t* position) {
 void ThreadedIoFile::TaskHandler() {
   if (mode_ == kInputMode)
     RunInInputMode();
+  else if (mode_ == kLossyInputMode)
+    RunInLossyInputMode();
   else
     RunInOutputMode();
   task_exit_event_.Signal();
@@ -186,6 +197,55 @@ void ThreadedIoFile::RunInInputMode() {
   }
 }
 
+void ThreadedIoFile::RunInLossyInputMode() {
+  DCHECK(internal_file_);
+  DCHECK_EQ(kLossyInputMode, mode_);
+
+  uint64_t bytes_received = 0;
+  base::TimeTicks first_read_time;
+  while (true) {
+    int64_t read_result =
+        internal_file_->Read(&io_buffer_[0], io_buffer_.size());
+    if (read_result <= 0) {
+      NoBarrier_Store(&eof_, read_result == 0);
+      NoBarrier_Store(&internal_file_error_, read_result);
+      cache_.Close();
+      return;
+    }
+    if (cache_.closed())
+      return;
+
+    const base::TimeTicks now = base::TimeTicks::Now();
+    if (first_read_time.is_null())
+      first_read_time = now;
+    bytes_received += read_result;
+
+    // The whole read is dropped, so that the data stays aligned on the
+    // datagrams of the internal file.
+    if (cache_.BytesCached() + read_result <=
+            GetMaxBytesCached(bytes_received, now - first_read_time) &&
+        cache_.TryWrite(&io_buffer_[0], read_result)) {
+      continue;
+    }
+    LOG_IF(WARNING, num_reads_dropped_ == 0)
+        << file_name() << " is not consumed fast enough. Dropping data. The "
+        << "amount of data dropped is reported when it is closed.";
+    num_bytes_dropped_ += read_result;
+    ++num_reads_dropped_;
+  }
+}
+
+uint64_t ThreadedIoFile::GetMaxBytesCached(uint64_t bytes_received,
+                                           base::TimeDelta elapsed) {
+  const uint64_t cache_size = cache_.BytesCached() + cache_.BytesFree();
+  if (max_cached_duration_.is_zero() || elapsed < max_cached_duration_)
+    return cache_size;
+  const double max_bytes_cached = bytes_received *
+                                  max_cached_duration_.InSecondsF() /
+                                  elapsed.InSecondsF();
+  return std::min(cache_size, static_cast<uint64_t>(max_bytes_cached));
+}
+
 void ThreadedIoFile::RunInOutputMode() {
   DCHECK(internal_file_);
   DCHECK_EQ(kOutputMode, mode_);
@@ -7,9 +7,11 @@
 #ifndef PACKAGER_FILE_THREADED_IO_FILE_H_
 #define PACKAGER_FILE_THREADED_IO_FILE_H_
 
+#include <atomic>
 #include <memory>
 #include "packager/base/atomicops.h"
 #include "packager/base/synchronization/waitable_event.h"
+#include "packager/base/time/time.h"
 #include "packager/file/file.h"
 #include "packager/file/file_closer.h"
 #include "packager/file/io_cache.h"
@@ -19,7 +21,14 @@ namespace shaka {
 /// Declaration of class which implements a thread-safe circular buffer.
 class ThreadedIoFile : public File {
  public:
-  enum Mode { kInputMode, kOutputMode };
+  enum Mode {
+    kInputMode,
+    kOutputMode,
+    // Input mode for live inputs, e.g. UDP streams, which must be read as
+    // fast as they deliver data. The data read while the cache is full is
+    // dropped instead of blocking the reading thread.
+    kLossyInputMode,
+  };
 
   ThreadedIoFile(std::unique_ptr<File, FileCloser> internal_file,
                  Mode mode,
@@ -37,17 +46,36 @@ class ThreadedIoFile : public File {
   bool Tell(uint64_t* position) override;
   /// @}
 
+  /// Limits the data cached in kLossyInputMode to the data received in
+  /// @a duration, estimated from the average rate of the input once it has
+  /// been read for @a duration. Must be called before Open().
+  void set_max_cached_duration(base::TimeDelta duration) {
+    max_cached_duration_ = duration;
+  }
+
+  /// @return the number of bytes dropped because the cache was full. Only
+  ///         data is dropped in kLossyInputMode.
+  uint64_t num_bytes_dropped() const { return num_bytes_dropped_; }
+  /// @return the number of reads of the internal file which were dropped.
+  uint64_t num_reads_dropped() const { return num_reads_dropped_; }
+
  protected:
   ~ThreadedIoFile() override;
 
   bool Open() override;
 
  private:
-  // Internal task handler implementation. Will dispatch to either
-  // |RunInInputMode| or |RunInOutputMode| depending on |mode_|.
+  // Internal task handler implementation. Will dispatch to
+  // |RunInInputMode|, |RunInOutputMode| or |RunInLossyInputMode| depending on
+  // |mode_|.
   void TaskHandler();
   void RunInInputMode();
   void RunInOutputMode();
+  void RunInLossyInputMode();
+  // Returns the maximum number of bytes cached in kLossyInputMode, given that
+  // |bytes_received| bytes were received in |elapsed|.
+  uint64_t GetMaxBytesCached(uint64_t bytes_received,
+                             base::TimeDelta elapsed);
 
   std::unique_ptr<File, FileCloser> internal_file_;
   const Mode mode_;
@@ -61,6 +89,9 @@ class ThreadedIoFile : public File {
   base::subtle::Atomic32 internal_file_error_;
   // Signalled when thread task exits.
   base::WaitableEvent task_exit_event_;
+  base::TimeDelta max_cached_duration_;
+  std::atomic<uint64_t> num_bytes_dropped_;
+  std::atomic<uint64_t> num_reads_dropped_;
 
   DISALLOW_COPY_AND_ASSIGN(ThreadedIoFile);
 };
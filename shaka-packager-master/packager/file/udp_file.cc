@@ -16,6 +16,7 @@
 
 #include <arpa/inet.h>
 #include <errno.h>
+#include <string.h>
 #include <strings.h>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -27,9 +28,16 @@
 #define IP_MULTICAST_ALL      49
 #endif
 
+// SO_RXQ_OVFL has been supported since kernel version 2.6.33.
+#if defined(__linux__) && !defined(SO_RXQ_OVFL)
+#define SO_RXQ_OVFL 40
+#endif
+
 #endif  // defined(OS_WIN)
 
+#include <algorithm>
 #include <limits>
+#include <vector>
 
 #include "packager/base/logging.h"
 #include "packager/file/udp_options.h"
@@ -38,14 +46,37 @@ namespace shaka {
 
 namespace {
 
+// Large enough for any UDP datagram.
+const size_t kMaxDatagramSize = 65535;
+
 bool IsIpv4MulticastAddress(const struct in_addr& addr) {
   return (ntohl(addr.s_addr) & 0xf0000000) == 0xe0000000;
 }
 
 }  // anonymous namespace
 
+struct UdpFile::BatchReceiveState {
+#if defined(__linux__)
+  explicit BatchReceiveState(unsigned batch_size)
+      : messages(batch_size),
+        iovecs(batch_size),
+        control_size(CMSG_SPACE(sizeof(uint32_t))),
+        control(batch_size * control_size) {}
+
+  std::vector<struct mmsghdr> messages;
+  std::vector<struct iovec> iovecs;
+  // Receives the SO_RXQ_OVFL drop counter of each message.
+  const size_t control_size;
+  std::vector<uint8_t> control;
+#endif  // defined(__linux__)
+};
+
 UdpFile::UdpFile(const char* file_name)
-    : File(file_name), socket_(INVALID_SOCKET) {}
+    : File(file_name),
+      socket_(INVALID_SOCKET),
+      batch_size_(1),
+      num_datagrams_received_(0),
+      num_datagrams_dropped_(0) {}
 
 UdpFile::~UdpFile() {}
 
@@ -54,6 +85,10 @@ bool UdpFile::Close() {
     close(socket_);
     socket_ = INVALID_SOCKET;
   }
+  LOG_IF(WARNING, num_datagrams_dropped_ > 0)
+      << "UDP socket " << file_name() << " dropped "
+      << num_datagrams_dropped_ << " datagrams, received "
+      << num_datagrams_received_ << " datagrams.";
   delete this;
   return true;
 }
@@ -66,15 +101,86 @@ int64_t UdpFile::Read(void* buffer, uint64_t length) {
   if (socket_ == INVALID_SOCKET)
     return -1;
 
+  if (batch_state_)
+    return ReadBatch(reinterpret_cast<uint8_t*>(buffer), length);
+
   int64_t result;
   do {
     result =
         recvfrom(socket_, reinterpret_cast<char*>(buffer), length, 0, NULL, 0);
   } while ((result == -1) && (errno == EINTR));
 
+  if (result >= 0)
+    ++num_datagrams_received_;
   return result;
 }
 
+int64_t UdpFile::ReadBatch(uint8_t* buffer, uint64_t length) {
+#if defined(__linux__)
+  // Each datagram is received in a slot large enough for any datagram, then
+  // moved right after the previous one, so the number of datagrams received
+  // per call is also limited by |length|.
+  const size_t num_slots = static_cast<size_t>(std::max<uint64_t>(
+      1, std::min<uint64_t>(batch_size_, length / kMaxDatagramSize)));
+  const size_t slot_size = static_cast<size_t>(
+      std::min<uint64_t>(length, kMaxDatagramSize));
+  for (size_t i = 0; i < num_slots; ++i) {
+    struct iovec& iov = batch_state_->iovecs[i];
+    iov.iov_base = buffer + i * slot_size;
+    iov.iov_len = slot_size;
+    struct msghdr& header = batch_state_->messages[i].msg_hdr;
+    memset(&header, 0, sizeof(header));
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+    header.msg_control =
+        batch_state_->control.data() + i * batch_state_->control_size;
+    header.msg_controllen = batch_state_->control_size;
+  }
+
+  // Block until the first datagram is received, then take the datagrams
+  // already queued without blocking.
+  int num_messages;
+  do {
+    num_messages = recvmmsg(socket_, batch_state_->messages.data(),
+                            num_slots, MSG_WAITFORONE, NULL);
+  } while ((num_messages == -1) && (errno == EINTR));
+  if (num_messages < 0)
+    return -1;
+
+  uint64_t bytes_received = 0;
+  for (int i = 0; i < num_messages; ++i) {
+    struct mmsghdr& message = batch_state_->messages[i];
+    const size_t size = message.msg_len;
+    LOG_IF(WARNING, message.msg_hdr.msg_flags & MSG_TRUNC)
+        << "UDP datagram truncated to " << size << " bytes.";
+    if (bytes_received != i * slot_size)
+      memmove(buffer + bytes_received, buffer + i * slot_size, size);
+    bytes_received += size;
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message.msg_hdr); cmsg;
+         cmsg = CMSG_NXTHDR(&message.msg_hdr, cmsg)) {
+      if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_RXQ_OVFL)
+        continue;
+      // The number of datagrams dropped since the socket was created.
+      uint32_t num_dropped;
+      memcpy(&num_dropped, CMSG_DATA(cmsg), sizeof(num_dropped));
+      if (num_dropped > num_datagrams_dropped_) {
+        LOG_IF(WARNING, num_datagrams_dropped_ == 0)
+            << "UDP socket " << file_name()
+            << " is dropping datagrams. Consider increasing its buffer_size."
+            << " The drops are reported when it is closed.";
+        num_datagrams_dropped_ = num_dropped;
+      }
+    }
+  }
+  num_datagrams_received_ += num_messages;
+  return bytes_received;
+#else
+  NOTREACHED();
+  return -1;
+#endif  // defined(__linux__)
+}
+
 int64_t UdpFile::Write(const void* buffer, uint64_t length) {
   NOTIMPLEMENTED();
   return -1;
@@ -247,6 +353,47 @@ bool UdpFile::Open() {
     }
   }
 
+  if (options->buffer_size() != 0) {
+    const int buffer_size = static_cast<int>(std::min<unsigned>(
+        options->buffer_size(), std::numeric_limits<int>::max()));
+    if (setsockopt(new_socket.get(), SOL_SOCKET, SO_RCVBUF,
+                   reinterpret_cast<const char*>(&buffer_size),
+                   sizeof(buffer_size)) < 0) {
+      LOG(ERROR) << "Failed to set socket receive buffer size.";
+      return false;
+    }
+#if defined(__linux__)
+    // Linux doubles the size for its bookkeeping and silently caps it to
+    // net.core.rmem_max.
+    int actual_buffer_size = 0;
+    socklen_t optlen = sizeof(actual_buffer_size);
+    if (getsockopt(new_socket.get(), SOL_SOCKET, SO_RCVBUF,
+                   &actual_buffer_size, &optlen) == 0 &&
+        actual_buffer_size / 2 < buffer_size) {
+      LOG(WARNING) << "UDP socket receive buffer size is capped to "
+                   << actual_buffer_size / 2
+                   << " bytes. Consider increasing net.core.rmem_max.";
+    }
+#endif  // defined(__linux__)
+  }
+
+  if (options->batch_size() > 1) {
+#if defined(__linux__)
+    // Report the datagrams dropped by the kernel with every message.
+    const int optval = 1;
+    if (setsockopt(new_socket.get(), SOL_SOCKET, SO_RXQ_OVFL, &optval,
+                   sizeof(optval)) < 0) {
+      LOG(WARNING) << "Failed to enable SO_RXQ_OVFL. Dropped UDP datagrams "
+                      "are not counted.";
+    }
+    batch_size_ = options->batch_size();
+    batch_state_.reset(new BatchReceiveState(batch_size_));
+#else
+    LOG(WARNING) << "Receiving UDP datagrams in batches is only supported on "
+                    "Linux. Receiving one datagram at a time.";
+#endif  // defined(__linux__)
+  }
+
   socket_ = new_socket.release();
   return true;
 }
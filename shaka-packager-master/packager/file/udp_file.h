@@ -9,6 +9,7 @@
 
 #include <stdint.h>
 
+#include <memory>
 #include <string>
 
 #include "packager/base/compiler_specific.h"
@@ -40,13 +41,32 @@ class UdpFile : public File {
   bool Tell(uint64_t* position) override;
   /// @}
 
+  /// @return the number of datagrams received so far.
+  uint64_t num_datagrams_received() const { return num_datagrams_received_; }
+  /// @return the number of datagrams dropped by the kernel so far because the
+  ///         socket receive buffer was full. Only counted when receiving in
+  ///         batches on Linux.
+  uint64_t num_datagrams_dropped() const { return num_datagrams_dropped_; }
+
  protected:
   ~UdpFile() override;
 
   bool Open() override;
 
  private:
+  struct BatchReceiveState;
+
+  // Receives up to |batch_size_| datagrams with a single system call and
+  // stores them back to back in |buffer|.
+  int64_t ReadBatch(uint8_t* buffer, uint64_t length);
+
   SOCKET socket_;
+  // Maximum number of datagrams received per Read() call.
+  unsigned batch_size_;
+  // Preallocated message headers for ReadBatch().
+  std::unique_ptr<BatchReceiveState> batch_state_;
+  uint64_t num_datagrams_received_;
+  uint64_t num_datagrams_dropped_;
 
   DISALLOW_COPY_AND_ASSIGN(UdpFile);
 };
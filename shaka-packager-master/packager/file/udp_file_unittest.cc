@@ -0,0 +1,158 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/file/udp_file.h"
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "packager/base/strings/stringprintf.h"
+#include "packager/base/threading/platform_thread.h"
+#include "packager/base/time/time.h"
+#include "packager/file/file.h"
+#include "packager/file/file_closer.h"
+#include "packager/file/threaded_io_file.h"
+
+namespace shaka {
+namespace {
+
+const char kLocalAddress[] = "127.0.0.1";
+const size_t kDatagramSize = 1316;
+const size_t kNumDatagrams = 5;
+// Holds the first 3 datagrams sent.
+const size_t kJitterBufferSize = 3 * kDatagramSize;
+const uint64_t kReadBufferSize = 0x200000;
+// One second, so that a failing test does not block.
+const unsigned kTimeoutUs = 1000000;
+
+struct sockaddr_in LocalAddress(uint16_t port) {
+  struct sockaddr_in address = {0};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  inet_pton(AF_INET, kLocalAddress, &address.sin_addr);
+  return address;
+}
+
+// Sends |kNumDatagrams| datagrams of different sizes and contents to |port|.
+// Returns the data sent.
+std::vector<uint8_t> SendDatagrams(uint16_t port) {
+  std::vector<uint8_t> data_sent;
+  const int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  EXPECT_GE(sock, 0);
+  const struct sockaddr_in address = LocalAddress(port);
+  for (size_t i = 0; i < kNumDatagrams; ++i) {
+    const std::vector<uint8_t> datagram(kDatagramSize - i,
+                                        static_cast<uint8_t>(i));
+    EXPECT_EQ(static_cast<ssize_t>(datagram.size()),
+              sendto(sock, datagram.data(), datagram.size(), 0,
+                     reinterpret_cast<const struct sockaddr*>(&address),
+                     sizeof(address)));
+    data_sent.insert(data_sent.end(), datagram.begin(), datagram.end());
+  }
+  close(sock);
+  return data_sent;
+}
+
+// Returns a port which is not in use, or 0 on failure.
+uint16_t GetUnusedPort() {
+  const int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0)
+    return 0;
+  struct sockaddr_in address = LocalAddress(0);
+  socklen_t address_size = sizeof(address);
+  uint16_t port = 0;
+  if (bind(sock, reinterpret_cast<struct sockaddr*>(&address),
+           sizeof(address)) == 0 &&
+      getsockname(sock, reinterpret_cast<struct sockaddr*>(&address),
+                  &address_size) == 0) {
+    port = ntohs(address.sin_port);
+  }
+  close(sock);
+  return port;
+}
+
+}  // namespace
+
+class UdpFileTest : public testing::TestWithParam<unsigned> {
+ protected:
+  void SetUp() override {
+    port_ = GetUnusedPort();
+    ASSERT_NE(0u, port_);
+    const std::string file_name =
+        base::StringPrintf("udp://%s:%u?timeout=%u&batch=%u", kLocalAddress,
+                           port_, kTimeoutUs, GetParam());
+    udp_file_.reset(
+        static_cast<UdpFile*>(File::OpenWithNoBuffering(file_name.c_str(),
+                                                        "r")));
+    ASSERT_TRUE(udp_file_);
+  }
+
+  uint16_t port_ = 0;
+  std::unique_ptr<UdpFile, FileCloser> udp_file_;
+};
+
+TEST_P(UdpFileTest, ReceivesDatagramsBackToBack) {
+  const std::vector<uint8_t> data_sent = SendDatagrams(port_);
+
+  std::vector<uint8_t> buffer(kReadBufferSize);
+  std::vector<uint8_t> data_received;
+  size_t num_reads = 0;
+  while (data_received.size() < data_sent.size()) {
+    const int64_t size = udp_file_->Read(buffer.data(), buffer.size());
+    ASSERT_GT(size, 0);
+    data_received.insert(data_received.end(), buffer.begin(),
+                         buffer.begin() + size);
+    ++num_reads;
+  }
+  EXPECT_EQ(data_sent, data_received);
+  // The datagrams queued on the loopback interface are received at once when
+  // receiving in batches.
+  EXPECT_EQ(GetParam() > 1 ? 1u : kNumDatagrams, num_reads);
+  EXPECT_EQ(kNumDatagrams, udp_file_->num_datagrams_received());
+  EXPECT_EQ(0u, udp_file_->num_datagrams_dropped());
+}
+
+INSTANTIATE_TEST_CASE_P(BatchSizes, UdpFileTest, testing::Values(1u, 64u));
+
+TEST(UdpFileJitterBufferTest, DropsDatagramsWhenFull) {
+  const uint16_t port = GetUnusedPort();
+  ASSERT_NE(0u, port);
+  const std::string file_name = base::StringPrintf(
+      "udp://%s:%u?timeout=%u&jitter_buffer_size=%zu", kLocalAddress, port,
+      kTimeoutUs, kJitterBufferSize);
+  std::unique_ptr<ThreadedIoFile, FileCloser> file(
+      static_cast<ThreadedIoFile*>(File::Open(file_name.c_str(), "r")));
+  ASSERT_TRUE(file);
+
+  // The datagrams are received in the receive thread while not being read.
+  const std::vector<uint8_t> data_sent = SendDatagrams(port);
+  const size_t kNumDatagramsDropped = kNumDatagrams - 3;
+  const base::TimeTicks deadline =
+      base::TimeTicks::Now() + base::TimeDelta::FromMicroseconds(kTimeoutUs);
+  while (file->num_reads_dropped() < kNumDatagramsDropped &&
+         base::TimeTicks::Now() < deadline) {
+    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(1));
+  }
+  EXPECT_EQ(kNumDatagramsDropped, file->num_reads_dropped());
+
+  // The datagrams received while the buffer was full are dropped.
+  const size_t kBytesKept = 3 * kDatagramSize - 3;
+  EXPECT_EQ(data_sent.size() - kBytesKept, file->num_bytes_dropped());
+  std::vector<uint8_t> buffer(kReadBufferSize);
+  ASSERT_EQ(static_cast<int64_t>(kBytesKept),
+            file->Read(buffer.data(), buffer.size()));
+  EXPECT_EQ(std::vector<uint8_t>(data_sent.begin(),
+                                 data_sent.begin() + kBytesKept),
+            std::vector<uint8_t>(buffer.begin(), buffer.begin() + kBytesKept));
+}
+
+}  // namespace shaka
@@ -25,6 +25,10 @@ enum FieldType {
   kReuseField,
   kInterfaceAddressField,
   kTimeoutField,
+  kBatchSizeField,
+  kBufferSizeField,
+  kJitterBufferMsField,
+  kJitterBufferSizeField,
 };
 
 struct FieldNameToTypeMapping {
@@ -37,8 +41,15 @@ const FieldNameToTypeMapping kFieldNameTypeMappings[] = {
     {"interface", kInterfaceAddressField},
     {"source", kInterfaceAddressField},
     {"timeout", kTimeoutField},
+    {"batch", kBatchSizeField},
+    {"buffer_size", kBufferSizeField},
+    {"jitter_buffer_ms", kJitterBufferMsField},
+    {"jitter_buffer_size", kJitterBufferSizeField},
 };
 
+// The maximum number of messages received by a recvmmsg call (UIO_MAXIOV).
+const unsigned kMaxBatchSize = 1024;
+
 FieldType GetFieldType(const std::string& field_name) {
   for (size_t idx = 0; idx < arraysize(kFieldNameTypeMappings); ++idx) {
     if (field_name == kFieldNameTypeMappings[idx].field_name)
@@ -105,6 +116,36 @@ std::unique_ptr<UdpOptions> UdpOptions::ParseFromString(
             return nullptr;
           }
           break;
+        case kBatchSizeField:
+          if (!base::StringToUint(pair.second, &options->batch_size_) ||
+              options->batch_size_ == 0 ||
+              options->batch_size_ > kMaxBatchSize) {
+            LOG(ERROR) << "Invalid udp option for batch field " << pair.second;
+            return nullptr;
+          }
+          break;
+        case kBufferSizeField:
+          if (!base::StringToUint(pair.second, &options->buffer_size_)) {
+            LOG(ERROR) << "Invalid udp option for buffer_size field "
+                       << pair.second;
+            return nullptr;
+          }
+          break;
+        case kJitterBufferMsField:
+          if (!base::StringToUint(pair.second, &options->jitter_buffer_ms_)) {
+            LOG(ERROR) << "Invalid udp option for jitter_buffer_ms field "
+                       << pair.second;
+            return nullptr;
+          }
+          break;
+        case kJitterBufferSizeField:
+          if (!base::StringToUint(pair.second,
+                                  &options->jitter_buffer_size_)) {
+            LOG(ERROR) << "Invalid udp option for jitter_buffer_size field "
+                       << pair.second;
+            return nullptr;
+          }
+          break;
         default:
           LOG(ERROR) << "Unknown field in udp options (\"" << pair.first
                      << "\").";
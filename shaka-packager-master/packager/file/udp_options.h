@@ -26,6 +26,10 @@ class UdpOptions {
   bool reuse() const { return reuse_; }
   const std::string& interface_address() const { return interface_address_; }
   unsigned timeout_us() const { return timeout_us_; }
+  unsigned batch_size() const { return batch_size_; }
+  unsigned buffer_size() const { return buffer_size_; }
+  unsigned jitter_buffer_ms() const { return jitter_buffer_ms_; }
+  unsigned jitter_buffer_size() const { return jitter_buffer_size_; }
 
  private:
   UdpOptions() = default;
@@ -39,6 +43,16 @@ class UdpOptions {
   std::string interface_address_ = "0.0.0.0";
   /// Timeout in microseconds. 0 to indicate unlimited timeout.
   unsigned timeout_us_ = 0;
+  /// Maximum number of datagrams received per system call.
+  unsigned batch_size_ = 1;
+  /// Size of the socket receive buffer in bytes. 0 to use the system default.
+  unsigned buffer_size_ = 0;
+  /// Maximum duration of the data buffered between the receive thread and the
+  /// demuxer, in milliseconds. 0 for no limit in time.
+  unsigned jitter_buffer_ms_ = 0;
+  /// Size of the buffer between the receive thread and the demuxer in bytes.
+  /// 0 for the default size.
+  unsigned jitter_buffer_size_ = 0;
 };
 
 }  // namespace shaka
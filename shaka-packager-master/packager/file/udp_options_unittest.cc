@@ -27,6 +27,10 @@ TEST_F(UdpOptionsTest, AddressAndPort) {
   EXPECT_FALSE(options->reuse());
   EXPECT_EQ("0.0.0.0", options->interface_address());
   EXPECT_EQ(0u, options->timeout_us());
+  EXPECT_EQ(1u, options->batch_size());
+  EXPECT_EQ(0u, options->buffer_size());
+  EXPECT_EQ(0u, options->jitter_buffer_ms());
+  EXPECT_EQ(0u, options->jitter_buffer_size());
 }
 
 TEST_F(UdpOptionsTest, MissingPort) {
@@ -95,4 +99,39 @@ TEST_F(UdpOptionsTest, InvalidTimeout) {
       "224.1.2.30:88?source=10.11.12.13&timeout=1a9"));
 }
 
+TEST_F(UdpOptionsTest, BatchSizeAndBufferSize) {
+  auto options = UdpOptions::ParseFromString(
+      "224.1.2.30:88?batch=64&buffer_size=8388608");
+  ASSERT_TRUE(options);
+  EXPECT_EQ("224.1.2.30", options->address());
+  EXPECT_EQ(88u, options->port());
+  EXPECT_EQ(64u, options->batch_size());
+  EXPECT_EQ(8388608u, options->buffer_size());
+}
+
+TEST_F(UdpOptionsTest, InvalidBatchSize) {
+  ASSERT_FALSE(UdpOptions::ParseFromString("224.1.2.30:88?batch=0"));
+  ASSERT_FALSE(UdpOptions::ParseFromString("224.1.2.30:88?batch=1025"));
+  ASSERT_FALSE(UdpOptions::ParseFromString("224.1.2.30:88?batch=1a"));
+}
+
+TEST_F(UdpOptionsTest, InvalidBufferSize) {
+  ASSERT_FALSE(UdpOptions::ParseFromString("224.1.2.30:88?buffer_size=-1"));
+}
+
+TEST_F(UdpOptionsTest, JitterBuffer) {
+  auto options = UdpOptions::ParseFromString(
+      "224.1.2.30:88?jitter_buffer_ms=500&jitter_buffer_size=4194304");
+  ASSERT_TRUE(options);
+  EXPECT_EQ(500u, options->jitter_buffer_ms());
+  EXPECT_EQ(4194304u, options->jitter_buffer_size());
+}
+
+TEST_F(UdpOptionsTest, InvalidJitterBuffer) {
+  ASSERT_FALSE(
+      UdpOptions::ParseFromString("224.1.2.30:88?jitter_buffer_ms=1s"));
+  ASSERT_FALSE(
+      UdpOptions::ParseFromString("224.1.2.30:88?jitter_buffer_size=-1"));
+}
+
 }  // namespace shaka
@@ -407,15 +407,15 @@ void MediaPlaylist::AddEncryptionInfo(MediaPlaylist::EncryptionMethod method,
     // Insert discontinuity tag only for the first EXT-X-KEY, only if there
     // are non-encrypted media segments.
     if (!entries_.empty())
-      entries_.emplace_back(new DiscontinuityEntry());
+      AddEntry(std::unique_ptr<HlsEntry>(new DiscontinuityEntry()));
     inserted_discontinuity_tag_ = true;
   }
-  entries_.emplace_back(new EncryptionInfoEntry(
-      method, url, key_id, iv, key_format, key_format_versions));
+  AddEntry(std::unique_ptr<HlsEntry>(new EncryptionInfoEntry(
+      method, url, key_id, iv, key_format, key_format_versions)));
 }
 
 void MediaPlaylist::AddPlacementOpportunity() {
-  entries_.emplace_back(new PlacementOpportunityEntry());
+  AddEntry(std::unique_ptr<HlsEntry>(new PlacementOpportunityEntry()));
 }
 
 bool MediaPlaylist::WriteToFile(const std::string& file_path) {
@@ -437,9 +437,7 @@ bool MediaPlaylist::WriteToFile(const std::string& file_path) {
   std::string content = CreatePlaylistHeader(
       media_info_, target_duration_, playlist_type_, stream_type_,
       media_sequence_number_, discontinuity_sequence_number_);
-
-  for (const auto& entry : entries_)
-    base::StringAppendF(&content, "%s\n", entry->ToString().c_str());
+  content += entries_content_;
 
   if (playlist_type_ == HlsPlaylistType::kVod) {
     content += "#EXT-X-ENDLIST\n";
@@ -510,6 +508,12 @@ bool MediaPlaylist::GetDisplayResolution(uint32_t* width,
   return false;
 }
 
+void MediaPlaylist::AddEntry(std::unique_ptr<HlsEntry> entry) {
+  entries_content_ += entry->ToString();
+  entries_content_ += '\n';
+  entries_.push_back(std::move(entry));
+}
+
 void MediaPlaylist::AddSegmentInfoEntry(const std::string& segment_file_name,
                                         uint64_t start_time,
                                         uint64_t duration,
@@ -519,9 +523,9 @@ void MediaPlaylist::AddSegmentInfoEntry(const std::string& segment_file_name,
     LOG(WARNING) << "Timescale is not set and the duration for " << duration
                  << " cannot be calculated. The output will be wrong.";
 
-    entries_.emplace_back(new SegmentInfoEntry(
+    AddEntry(std::unique_ptr<HlsEntry>(new SegmentInfoEntry(
         segment_file_name, 0.0, 0.0, use_byte_range_, start_byte_offset, size,
-        previous_segment_end_offset_));
+        previous_segment_end_offset_)));
     return;
   }
 
@@ -535,9 +539,10 @@ void MediaPlaylist::AddSegmentInfoEntry(const std::string& segment_file_name,
   const int kBitsInByte = 8;
   const uint64_t bitrate = kBitsInByte * size / segment_duration_seconds;
   max_bitrate_ = std::max(max_bitrate_, bitrate);
-  entries_.emplace_back(new SegmentInfoEntry(
+  AddEntry(std::unique_ptr<HlsEntry>(new SegmentInfoEntry(
       segment_file_name, start_time_seconds, segment_duration_seconds,
-      use_byte_range_, start_byte_offset, size, previous_segment_end_offset_));
+      use_byte_range_, start_byte_offset, size,
+      previous_segment_end_offset_)));
   previous_segment_end_offset_ = start_byte_offset + size - 1;
   SlideWindow();
 }
@@ -572,8 +577,20 @@ void MediaPlaylist::SlideWindow() {
 
   std::list<std::unique_ptr<HlsEntry>>::iterator last = entries_.begin();
   size_t num_segments_removed = 0;
+  // Size of the text of the removed entries at the start of
+  // |entries_content_|.
+  size_t removed_content_size = 0;
   for (; last != entries_.end(); ++last) {
     HlsEntry::EntryType entry_type = last->get()->type();
+    if (entry_type == HlsEntry::EntryType::kExtInf) {
+      const SegmentInfoEntry* segment_info =
+          reinterpret_cast<SegmentInfoEntry*>(last->get());
+      const double last_segment_end_time =
+          segment_info->start_time() + segment_info->duration();
+      if (timeshift_limit < last_segment_end_time)
+        break;
+    }
+    removed_content_size += last->get()->ToString().size() + 1;
     if (entry_type == HlsEntry::EntryType::kExtKey) {
       if (prev_entry_type != HlsEntry::EntryType::kExtKey)
         ext_x_keys.clear();
@@ -582,18 +599,16 @@ void MediaPlaylist::SlideWindow() {
       ++discontinuity_sequence_number_;
     } else {
       DCHECK_EQ(entry_type, HlsEntry::EntryType::kExtInf);
-      const SegmentInfoEntry* segment_info =
-          reinterpret_cast<SegmentInfoEntry*>(last->get());
-      const double last_segment_end_time =
-          segment_info->start_time() + segment_info->duration();
-      if (timeshift_limit < last_segment_end_time)
-        break;
       ++num_segments_removed;
     }
     prev_entry_type = entry_type;
   }
   entries_.erase(entries_.begin(), last);
   // Add key entries back.
+  std::string ext_x_keys_content;
+  for (const auto& entry : ext_x_keys)
+    ext_x_keys_content += entry->ToString() + '\n';
+  entries_content_.replace(0, removed_content_size, ext_x_keys_content);
   entries_.insert(entries_.begin(), std::make_move_iterator(ext_x_keys.begin()),
                   std::make_move_iterator(ext_x_keys.end()));
   media_sequence_number_ += num_segments_removed;
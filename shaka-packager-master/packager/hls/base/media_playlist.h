@@ -179,6 +179,9 @@ class MediaPlaylist {
   virtual bool GetDisplayResolution(uint32_t* width, uint32_t* height) const;
 
  private:
+  // Add |entry| to |entries_| and its text to |entries_content_|.
+  void AddEntry(std::unique_ptr<HlsEntry> entry);
+
   // Add a SegmentInfoEntry (#EXTINF).
   void AddSegmentInfoEntry(const std::string& segment_file_name,
                            uint64_t start_time,
@@ -218,6 +221,9 @@ class MediaPlaylist {
   uint32_t target_duration_ = 0;
 
   std::list<std::unique_ptr<HlsEntry>> entries_;
+  // The text of |entries_|, which is appended as entries are added so that
+  // writing the playlist does not format all the entries again.
+  std::string entries_content_;
 
   // Used by kVideoIFrameOnly playlists to track the i-frames (key frames).
   struct KeyFrameInfo {
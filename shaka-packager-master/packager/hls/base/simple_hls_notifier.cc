@@ -313,6 +313,7 @@ bool SimpleHlsNotifier::NotifyNewStream(const MediaInfo& media_info,
   *stream_id = sequence_number_.GetNext();
   base::AutoLock auto_lock(lock_);
   media_playlists_.push_back(media_playlist.get());
+  master_playlist_dirty_ = true;
   stream_map_[*stream_id].reset(
       new StreamEntry{std::move(media_playlist), encryption_method});
   return true;
@@ -333,8 +334,11 @@ bool SimpleHlsNotifier::NotifyNewSegment(uint32_t stream_id,
   auto& media_playlist = stream_iterator->second->media_playlist;
   const std::string& segment_url = GenerateSegmentUrl(
       segment_name, prefix_, output_dir_, media_playlist->file_name());
+  const uint64_t previous_bitrate = media_playlist->Bitrate();
   media_playlist->AddSegment(segment_url, start_time, duration,
                              start_byte_offset, size);
+  if (media_playlist->Bitrate() != previous_bitrate)
+    master_playlist_dirty_ = true;
 
   // Update target duration.
   uint32_t longest_segment_duration =
@@ -359,10 +363,14 @@ bool SimpleHlsNotifier::NotifyNewSegment(uint32_t stream_id,
       if (!WriteMediaPlaylist(output_dir_, media_playlist.get()))
         return false;
     }
-    if (!master_playlist_->WriteMasterPlaylist(prefix_, output_dir_,
-                                               media_playlists_)) {
-      LOG(ERROR) << "Failed to write master playlist.";
-      return false;
+    // The other variant attributes do not change once the stream is added.
+    if (master_playlist_dirty_) {
+      if (!master_playlist_->WriteMasterPlaylist(prefix_, output_dir_,
+                                                 media_playlists_)) {
+        LOG(ERROR) << "Failed to write master playlist.";
+        return false;
+      }
+      master_playlist_dirty_ = false;
     }
   }
   return true;
@@ -472,6 +480,7 @@ bool SimpleHlsNotifier::Flush() {
     LOG(ERROR) << "Failed to write master playlist.";
     return false;
   }
+  master_playlist_dirty_ = false;
   return true;
 }
 
@@ -91,6 +91,10 @@ class SimpleHlsNotifier : public HlsNotifier {
   // Maps to unique_ptr because StreamEntry also holds unique_ptr
   std::map<uint32_t, std::unique_ptr<StreamEntry>> stream_map_;
   std::list<MediaPlaylist*> media_playlists_;
+  // Whether the variants in the master playlist changed since it was last
+  // written, i.e. a stream was added or the bitrate of a stream changed. In
+  // live mode, the master playlist is only written when this is set.
+  bool master_playlist_dirty_ = true;
 
   base::AtomicSequenceNumber sequence_number_;
 
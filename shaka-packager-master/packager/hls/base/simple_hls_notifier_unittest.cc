@@ -1023,10 +1023,25 @@ TEST_P(LiveOrEventSimpleHlsNotifierTest, NotifyNewSegmentsWithMultipleStreams) {
                       .Append(base::FilePath::FromUTF8Unsafe("playlist2.m3u8"))
                       .AsUTF8Unsafe())))
       .WillOnce(Return(true));
+  // Not updating the master playlist as the variants do not change.
   EXPECT_CALL(*mock_master_playlist_ptr, WriteMasterPlaylist(_, _, _))
-      .WillOnce(Return(true));
+      .Times(0);
   EXPECT_TRUE(notifier.NotifyNewSegment(stream_id2, "segment_name", kStartTime,
                                         kDuration, 0, kSize));
+
+  const uint64_t kBitrate = 1000000;
+  EXPECT_CALL(*mock_media_playlist1, Bitrate()).WillOnce(Return(0));
+  EXPECT_CALL(*mock_media_playlist1, AddSegment(_, _, _, _, _)).Times(1);
+  EXPECT_CALL(*mock_media_playlist1, Bitrate()).WillOnce(Return(kBitrate));
+  EXPECT_CALL(*mock_media_playlist1, GetLongestSegmentDuration())
+      .WillOnce(Return(kLongestSegmentDuration));
+  EXPECT_CALL(*mock_media_playlist1, WriteToFile(_)).WillOnce(Return(true));
+  // The master playlist is updated as the bitrate of a variant changes.
+  EXPECT_CALL(*mock_master_playlist_ptr, WriteMasterPlaylist(_, _, _))
+      .WillOnce(Return(true));
+  EXPECT_TRUE(notifier.NotifyNewSegment(stream_id1, "segment_name",
+                                        kStartTime + kDuration, kDuration, 0,
+                                        kSize));
 }
 
 INSTANTIATE_TEST_CASE_P(PlaylistTypes,
@@ -6,6 +6,7 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <memory>
 
 #include "packager/base/logging.h"
@@ -253,6 +254,39 @@ TEST_F(AesCtrEncryptorTest, UnsupportedIV) {
   ASSERT_FALSE(encryptor_.InitializeWithIv(key_, iv));
 }
 
+TEST_F(AesCtrEncryptorTest, PortableAndHardwarePathsMatch) {
+  // Large enough to cover several batches of kNumParallelBlocks blocks, with
+  // a partial block at the end.
+  const size_t kTextSize =
+      AesCtrKeystream::kNumParallelBlocks * kAesBlockSize * 5 + 7;
+  std::vector<uint8_t> text(kTextSize);
+  for (size_t i = 0; i < text.size(); ++i)
+    text[i] = static_cast<uint8_t>(i * 31);
+
+  // Start at the 64-bit counter boundary so the counter wraps inside the
+  // first batch.
+  std::vector<uint8_t> iv_max64(kIv128Max64,
+                                kIv128Max64 + arraysize(kIv128Max64));
+  ASSERT_TRUE(encryptor_.InitializeWithIv(key_, iv_max64));
+  std::vector<uint8_t> encrypted;
+  ASSERT_TRUE(encryptor_.Crypt(text, &encrypted));
+
+  ASSERT_TRUE(decryptor_.InitializeWithIv(key_, iv_max64));
+  decryptor_.DisableHardwareForTesting();
+  // Decrypt in uneven chunks to exercise the partial block carry over.
+  std::vector<uint8_t> decrypted(encrypted.size());
+  const size_t kChunkSizes[] = {3, 13, 16, 29, 200};
+  for (size_t offset = 0, i = 0; offset < encrypted.size(); ++i) {
+    const size_t size = std::min(kChunkSizes[i % arraysize(kChunkSizes)],
+                                 encrypted.size() - offset);
+    ASSERT_TRUE(
+        decryptor_.Crypt(&encrypted[offset], size, &decrypted[offset]));
+    offset += size;
+    EXPECT_EQ(offset % kAesBlockSize, decryptor_.block_offset());
+  }
+  EXPECT_EQ(text, decrypted);
+}
+
 class AesCtrEncryptorSubsampleTest
     : public AesCtrEncryptorTest,
       public ::testing::WithParamInterface<SubsampleTestCase> {};
@@ -0,0 +1,290 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/aes_ctr_keystream.h"
+
+#include <openssl/aes.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "packager/base/logging.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+#define AES_CTR_KEYSTREAM_USE_AESNI 1
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif  // defined(_MSC_VER)
+#endif  // x86 family
+
+#if defined(AES_CTR_KEYSTREAM_USE_AESNI) && defined(__GNUC__)
+// Allows AES-NI intrinsics in the functions below without compiling the whole
+// target with -maes. The functions are only called after a runtime check.
+#define AESNI_TARGET __attribute__((target("aes,sse2")))
+#else
+#define AESNI_TARGET
+#endif
+
+namespace shaka {
+namespace media {
+namespace {
+
+const size_t kBlockSize = AES_BLOCK_SIZE;
+
+uint64_t LoadBigEndian64(const uint8_t* p) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i)
+    value = (value << 8) | p[i];
+  return value;
+}
+
+void StoreBigEndian64(uint64_t value, uint8_t* p) {
+  for (int i = 7; i >= 0; --i) {
+    p[i] = static_cast<uint8_t>(value);
+    value >>= 8;
+  }
+}
+
+// Fill |num_blocks| counter blocks starting from |counter_low|, with the first
+// 8 bytes copied from |counter_high|.
+void FillCounterBlocks(const uint8_t* counter_high,
+                       uint64_t counter_low,
+                       size_t num_blocks,
+                       uint8_t* blocks) {
+  for (size_t i = 0; i < num_blocks; ++i) {
+    memcpy(blocks + i * kBlockSize, counter_high, 8);
+    // The 64 bit counter wraps around silently as required by the CENC spec.
+    StoreBigEndian64(counter_low + i, blocks + i * kBlockSize + 8);
+  }
+}
+
+// XOR |size| bytes, a word at a time. |size| is a multiple of 8.
+void XorWords(const uint8_t* in,
+              const uint8_t* keystream,
+              size_t size,
+              uint8_t* out) {
+  DCHECK_EQ(0u, size % sizeof(uint64_t));
+  for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+    uint64_t text;
+    uint64_t key;
+    // memcpy is used to avoid unaligned access; it compiles to a single move.
+    memcpy(&text, in + i, sizeof(text));
+    memcpy(&key, keystream + i, sizeof(key));
+    text ^= key;
+    memcpy(out + i, &text, sizeof(text));
+  }
+}
+
+#if defined(AES_CTR_KEYSTREAM_USE_AESNI)
+
+bool HasAesNi() {
+  unsigned int ecx = 0;
+  unsigned int edx = 0;
+#if defined(_MSC_VER)
+  int registers[4] = {};
+  __cpuid(registers, 1);
+  ecx = static_cast<unsigned int>(registers[2]);
+  edx = static_cast<unsigned int>(registers[3]);
+#else
+  unsigned int eax = 0;
+  unsigned int ebx = 0;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    return false;
+#endif  // defined(_MSC_VER)
+  const unsigned int kSse2Bit = 1u << 26;  // EDX.
+  const unsigned int kAesBit = 1u << 25;   // ECX.
+  return (edx & kSse2Bit) && (ecx & kAesBit);
+}
+
+// SubWord(RotWord(|word|)) if |rotate| is true, SubWord(|word|) otherwise.
+AESNI_TARGET uint32_t SubWord(uint32_t word, bool rotate) {
+  // AESKEYGENASSIST computes SubWord on dwords 1 and 3 and places them in
+  // dwords 0 and 2, and RotWord(SubWord()) in dwords 1 and 3.
+  const __m128i x =
+      _mm_shuffle_epi32(_mm_cvtsi32_si128(static_cast<int>(word)), 0);
+  const __m128i result = _mm_aeskeygenassist_si128(x, 0);
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(
+      rotate ? _mm_shuffle_epi32(result, 0x55) : result));
+}
+
+// Key expansion as specified in FIPS-197 section 5.2. The round keys are kept
+// in byte order, so they can be loaded directly into SSE registers.
+AESNI_TARGET void ExpandKey(const std::vector<uint8_t>& key,
+                            int num_rounds,
+                            uint8_t* round_keys) {
+  const size_t nk = key.size() / 4;
+  const size_t total_words = 4 * (num_rounds + 1);
+  uint32_t words[15 * 4];
+  memcpy(words, key.data(), key.size());
+  uint32_t rcon = 1;
+  for (size_t i = nk; i < total_words; ++i) {
+    uint32_t temp = words[i - 1];
+    if (i % nk == 0) {
+      // Rcon goes to the first byte of the word, which is the least
+      // significant byte on x86.
+      temp = SubWord(temp, true) ^ rcon;
+      rcon = (rcon << 1) ^ ((rcon & 0x80) ? 0x11b : 0);
+    } else if (nk > 6 && i % nk == 4) {
+      temp = SubWord(temp, false);
+    }
+    words[i] = words[i - nk] ^ temp;
+  }
+  memcpy(round_keys, words, total_words * 4);
+}
+
+// Encrypt |kNumBlocks| counter blocks starting at |counter_low| and XOR the
+// result into |out|. The blocks go through the AES rounds interleaved, so the
+// pipelined AESENC units are kept busy.
+template <size_t kNumBlocks>
+AESNI_TARGET void CryptBlocksAesNi(const __m128i* round_keys,
+                                   int num_rounds,
+                                   const uint8_t* counter_high,
+                                   uint64_t counter_low,
+                                   const uint8_t* in,
+                                   uint8_t* out) {
+  uint8_t counters[kNumBlocks * kBlockSize];
+  FillCounterBlocks(counter_high, counter_low, kNumBlocks, counters);
+
+  __m128i blocks[kNumBlocks];
+  for (size_t i = 0; i < kNumBlocks; ++i) {
+    blocks[i] = _mm_xor_si128(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(counters) + i),
+        round_keys[0]);
+  }
+  for (int round = 1; round < num_rounds; ++round) {
+    for (size_t i = 0; i < kNumBlocks; ++i)
+      blocks[i] = _mm_aesenc_si128(blocks[i], round_keys[round]);
+  }
+  for (size_t i = 0; i < kNumBlocks; ++i) {
+    blocks[i] = _mm_aesenclast_si128(blocks[i], round_keys[num_rounds]);
+    const __m128i text =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in) + i);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out) + i,
+                     _mm_xor_si128(text, blocks[i]));
+  }
+}
+
+AESNI_TARGET void CryptAesNi(const uint8_t* round_key_bytes,
+                             int num_rounds,
+                             const uint8_t* in,
+                             size_t num_blocks,
+                             uint8_t* counter,
+                             uint8_t* out) {
+  const size_t kNumParallelBlocks = AesCtrKeystream::kNumParallelBlocks;
+  __m128i round_keys[15];
+  for (int i = 0; i <= num_rounds; ++i) {
+    round_keys[i] =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(round_key_bytes) + i);
+  }
+
+  uint64_t counter_low = LoadBigEndian64(counter + 8);
+  for (; num_blocks >= kNumParallelBlocks; num_blocks -= kNumParallelBlocks) {
+    CryptBlocksAesNi<kNumParallelBlocks>(round_keys, num_rounds, counter,
+                                         counter_low, in, out);
+    counter_low += kNumParallelBlocks;
+    in += kNumParallelBlocks * kBlockSize;
+    out += kNumParallelBlocks * kBlockSize;
+  }
+  for (; num_blocks > 0; --num_blocks) {
+    CryptBlocksAesNi<1>(round_keys, num_rounds, counter, counter_low, in, out);
+    ++counter_low;
+    in += kBlockSize;
+    out += kBlockSize;
+  }
+  StoreBigEndian64(counter_low, counter + 8);
+}
+
+#endif  // defined(AES_CTR_KEYSTREAM_USE_AESNI)
+
+}  // namespace
+
+const size_t AesCtrKeystream::kNumParallelBlocks;
+
+AesCtrKeystream::AesCtrKeystream()
+    : aes_key_(nullptr), use_hardware_(false), num_rounds_(0) {}
+
+AesCtrKeystream::~AesCtrKeystream() {}
+
+void AesCtrKeystream::SetKey(const std::vector<uint8_t>& key,
+                             const AES_KEY* aes_key) {
+  DCHECK(aes_key);
+  aes_key_ = aes_key;
+  use_hardware_ = false;
+#if defined(AES_CTR_KEYSTREAM_USE_AESNI)
+  if (!IsHardwareSupported())
+    return;
+  // Nr = Nk + 6 as specified in FIPS-197.
+  num_rounds_ = static_cast<int>(key.size() / 4) + 6;
+  DCHECK(num_rounds_ == 10 || num_rounds_ == 12 || num_rounds_ == 14);
+  ExpandKey(key, num_rounds_, round_keys_);
+  use_hardware_ = true;
+#endif  // defined(AES_CTR_KEYSTREAM_USE_AESNI)
+}
+
+void AesCtrKeystream::CryptBlocks(const uint8_t* in,
+                                  size_t num_blocks,
+                                  uint8_t* counter,
+                                  uint8_t* out) const {
+  DCHECK(aes_key_);
+#if defined(AES_CTR_KEYSTREAM_USE_AESNI)
+  if (use_hardware_) {
+    CryptAesNi(round_keys_, num_rounds_, in, num_blocks, counter, out);
+    return;
+  }
+#endif  // defined(AES_CTR_KEYSTREAM_USE_AESNI)
+  CryptBlocksPortable(in, num_blocks, counter, out);
+}
+
+void AesCtrKeystream::GenerateBlock(uint8_t* counter,
+                                    uint8_t* keystream) const {
+  DCHECK(aes_key_);
+  // Running zeros through the cipher gives the raw keystream.
+  uint8_t zeros[kBlockSize] = {};
+  CryptBlocks(zeros, 1, counter, keystream);
+}
+
+// static
+bool AesCtrKeystream::IsHardwareSupported() {
+#if defined(AES_CTR_KEYSTREAM_USE_AESNI)
+  static const bool has_aesni = HasAesNi();
+  return has_aesni;
+#else
+  return false;
+#endif  // defined(AES_CTR_KEYSTREAM_USE_AESNI)
+}
+
+void AesCtrKeystream::CryptBlocksPortable(const uint8_t* in,
+                                          size_t num_blocks,
+                                          uint8_t* counter,
+                                          uint8_t* out) const {
+  uint8_t counters[kNumParallelBlocks * kBlockSize];
+  uint8_t keystream[kNumParallelBlocks * kBlockSize];
+
+  uint64_t counter_low = LoadBigEndian64(counter + 8);
+  while (num_blocks > 0) {
+    const size_t batch_blocks = std::min(num_blocks, kNumParallelBlocks);
+    FillCounterBlocks(counter, counter_low, batch_blocks, counters);
+    for (size_t i = 0; i < batch_blocks; ++i) {
+      AES_encrypt(counters + i * kBlockSize, keystream + i * kBlockSize,
+                  aes_key_);
+    }
+    XorWords(in, keystream, batch_blocks * kBlockSize, out);
+
+    counter_low += batch_blocks;
+    num_blocks -= batch_blocks;
+    in += batch_blocks * kBlockSize;
+    out += batch_blocks * kBlockSize;
+  }
+  StoreBigEndian64(counter_low, counter + 8);
+}
+
+}  // namespace media
+}  // namespace shaka
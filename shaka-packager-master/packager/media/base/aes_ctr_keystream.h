@@ -0,0 +1,89 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_AES_CTR_KEYSTREAM_H_
+#define PACKAGER_MEDIA_BASE_AES_CTR_KEYSTREAM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "packager/base/macros.h"
+
+struct aes_key_st;
+typedef struct aes_key_st AES_KEY;
+
+namespace shaka {
+namespace media {
+
+/// Block-wise AES-CTR keystream engine. It generates keystream for many
+/// counter blocks per call and XORs the keystream a word at a time. The AES
+/// instructions of the CPU, pipelined kNumParallelBlocks blocks at a time, are
+/// used if they are available; otherwise it falls back to openssl AES_encrypt.
+///
+/// The counter follows ISO/IEC 23001-7:2016 CENC spec, i.e. only bytes 8 to 15
+/// of the 16 byte counter block are incremented, as a 64 bit unsigned integer
+/// in network byte order.
+class AesCtrKeystream {
+ public:
+  /// Number of counter blocks encrypted together in one batch.
+  static const size_t kNumParallelBlocks = 8;
+
+  AesCtrKeystream();
+  ~AesCtrKeystream();
+
+  /// Set up the key schedule for the hardware path. It is a NOP if the CPU
+  /// does not have AES instructions.
+  /// @param key is the AES key, which should be 16, 24 or 32 bytes.
+  /// @param aes_key is the openssl key expanded from @a key. It is used when
+  ///        the hardware path is not available.
+  void SetKey(const std::vector<uint8_t>& key, const AES_KEY* aes_key);
+
+  /// Encrypt or decrypt @a num_blocks full 16-byte blocks.
+  /// @param counter is the 16 byte counter block. It is advanced by
+  ///        @a num_blocks on return.
+  /// @param in and @a out can point to the same address for in place
+  ///        encryption/decryption.
+  void CryptBlocks(const uint8_t* in,
+                   size_t num_blocks,
+                   uint8_t* counter,
+                   uint8_t* out) const;
+
+  /// Generate one block of keystream from @a counter and advance it by one.
+  void GenerateBlock(uint8_t* counter, uint8_t* keystream) const;
+
+  /// @return true if the AES instructions of the CPU are used.
+  bool use_hardware() const { return use_hardware_; }
+
+  /// Disable the hardware path. Used in tests and benchmarks to compare
+  /// against the portable path.
+  void DisableHardwareForTesting() { use_hardware_ = false; }
+
+  /// @return true if the CPU has AES instructions.
+  static bool IsHardwareSupported();
+
+ private:
+  void CryptBlocksPortable(const uint8_t* in,
+                           size_t num_blocks,
+                           uint8_t* counter,
+                           uint8_t* out) const;
+
+  const AES_KEY* aes_key_;
+  bool use_hardware_;
+  // Number of AES rounds for the hardware path: 10, 12 or 14.
+  int num_rounds_;
+  // Expanded round keys for the hardware path, in byte order, i.e. directly
+  // loadable as 128-bit round keys. Up to 15 round keys for AES-256.
+  uint8_t round_keys_[15 * 16];
+
+  DISALLOW_COPY_AND_ASSIGN(AesCtrKeystream);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_AES_CTR_KEYSTREAM_H_
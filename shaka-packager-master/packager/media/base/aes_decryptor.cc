@@ -96,8 +96,9 @@ bool AesCbcDecryptor::CryptInternal(const uint8_t* ciphertext,
     AES_cbc_encrypt(ciphertext, plaintext, cbc_size, aes_key(),
                     internal_iv_.data(), AES_DECRYPT);
 
-    // The residual block is not encrypted.
-    memcpy(plaintext + cbc_size, ciphertext + cbc_size, residual_block_size);
+    // The residual block is not encrypted. |ciphertext| and |plaintext| are
+    // the same for in place decryption.
+    memmove(plaintext + cbc_size, ciphertext + cbc_size, residual_block_size);
     return true;
   } else if (padding_scheme_ != kCtsPadding) {
     LOG(ERROR) << "Expecting cipher text size to be multiple of "
@@ -108,7 +109,7 @@ bool AesCbcDecryptor::CryptInternal(const uint8_t* ciphertext,
   DCHECK_EQ(padding_scheme_, kCtsPadding);
   if (ciphertext_size < AES_BLOCK_SIZE) {
     // Don't have a full block, leave unencrypted.
-    memcpy(plaintext, ciphertext, ciphertext_size);
+    memmove(plaintext, ciphertext, ciphertext_size);
     return true;
   }
 
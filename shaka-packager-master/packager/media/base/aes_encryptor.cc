@@ -12,16 +12,6 @@
 
 namespace {
 
-// Increment an 8-byte counter by 1. Return true if overflowed.
-bool Increment64(uint8_t* counter) {
-  DCHECK(counter);
-  for (int i = 7; i >= 0; --i) {
-    if (++counter[i] != 0)
-      return false;
-  }
-  return true;
-}
-
 // AES defines three key sizes: 128, 192 and 256 bits.
 bool IsKeySizeValidForAes(size_t key_size) {
   return key_size == 16 || key_size == 24 || key_size == 32;
@@ -57,6 +47,13 @@ AesCtrEncryptor::AesCtrEncryptor()
 
 AesCtrEncryptor::~AesCtrEncryptor() {}
 
+bool AesCtrEncryptor::InitializeWithIv(const std::vector<uint8_t>& key,
+                                       const std::vector<uint8_t>& iv) {
+  if (!AesEncryptor::InitializeWithIv(key, iv))
+    return false;
+  keystream_.SetKey(key, aes_key());
+  return true;
+}
 
 bool AesCtrEncryptor::CryptInternal(const uint8_t* plaintext,
                                     size_t plaintext_size,
@@ -74,19 +71,35 @@ bool AesCtrEncryptor::CryptInternal(const uint8_t* plaintext,
   }
   *ciphertext_size = plaintext_size;
 
-  for (size_t i = 0; i < plaintext_size; ++i) {
-    if (block_offset_ == 0) {
-      AES_encrypt(&counter_[0], &encrypted_counter_[0], aes_key());
-      // As mentioned in ISO/IEC 23001-7:2016 CENC spec, of the 16 byte counter
-      // block, bytes 8 to 15 (i.e. the least significant bytes) are used as a
-      // simple 64 bit unsigned integer that is incremented by one for each
-      // subsequent block of sample data processed and is kept in network byte
-      // order.
-      Increment64(&counter_[8]);
-    }
+  // As mentioned in ISO/IEC 23001-7:2016 CENC spec, of the 16 byte counter
+  // block, bytes 8 to 15 (i.e. the least significant bytes) are used as a
+  // simple 64 bit unsigned integer that is incremented by one for each
+  // subsequent block of sample data processed and is kept in network byte
+  // order. |keystream_| takes care of the increment.
+  size_t i = 0;
+
+  // Consume what is left of the partial block from the previous call.
+  for (; block_offset_ != 0 && i < plaintext_size; ++i) {
     ciphertext[i] = plaintext[i] ^ encrypted_counter_[block_offset_];
     block_offset_ = (block_offset_ + 1) % AES_BLOCK_SIZE;
   }
+
+  // Full blocks are handled in batches by the keystream engine.
+  const size_t num_blocks = (plaintext_size - i) / AES_BLOCK_SIZE;
+  if (num_blocks > 0) {
+    keystream_.CryptBlocks(plaintext + i, num_blocks, &counter_[0],
+                           ciphertext + i);
+    i += num_blocks * AES_BLOCK_SIZE;
+  }
+
+  // The trailing partial block. The rest of its keystream is kept in
+  // |encrypted_counter_| for the next call.
+  if (i < plaintext_size) {
+    DCHECK_EQ(0u, block_offset_);
+    keystream_.GenerateBlock(&counter_[0], &encrypted_counter_[0]);
+    for (; i < plaintext_size; ++i)
+      ciphertext[i] = plaintext[i] ^ encrypted_counter_[block_offset_++];
+  }
   return true;
 }
 
@@ -133,8 +146,9 @@ bool AesCbcEncryptor::CryptInternal(const uint8_t* plaintext,
     AES_cbc_encrypt(plaintext, ciphertext, cbc_size, aes_key(),
                     internal_iv_.data(), AES_ENCRYPT);
   } else if (padding_scheme_ == kCtsPadding) {
-    // Don't have a full block, leave unencrypted.
-    memcpy(ciphertext, plaintext, plaintext_size);
+    // Don't have a full block, leave unencrypted. |plaintext| and
+    // |ciphertext| are the same for in place encryption.
+    memmove(ciphertext, plaintext, plaintext_size);
     return true;
   }
   if (residual_block_size == 0 && padding_scheme_ != kPkcs5Padding) {
@@ -144,7 +158,7 @@ bool AesCbcEncryptor::CryptInternal(const uint8_t* plaintext,
 
   if (padding_scheme_ == kNoPadding) {
     // The residual block is left unencrypted.
-    memcpy(ciphertext + cbc_size, plaintext + cbc_size, residual_block_size);
+    memmove(ciphertext + cbc_size, plaintext + cbc_size, residual_block_size);
     return true;
   }
 
@@ -14,6 +14,7 @@
 
 #include "packager/base/macros.h"
 #include "packager/media/base/aes_cryptor.h"
+#include "packager/media/base/aes_ctr_keystream.h"
 
 namespace shaka {
 namespace media {
@@ -44,8 +45,18 @@ class AesCtrEncryptor : public AesEncryptor {
   AesCtrEncryptor();
   ~AesCtrEncryptor() override;
 
+  /// Initialize the encryptor with specified key and IV.
+  /// @return true on successful initialization, false otherwise.
+  bool InitializeWithIv(const std::vector<uint8_t>& key,
+                        const std::vector<uint8_t>& iv) override;
+
   uint32_t block_offset() const { return block_offset_; }
 
+  /// Disable the AES instructions of the CPU and use the portable keystream
+  /// path. Used in tests and benchmarks. It should be called after
+  /// InitializeWithIv.
+  void DisableHardwareForTesting() { keystream_.DisableHardwareForTesting(); }
+
  private:
   bool CryptInternal(const uint8_t* plaintext,
                      size_t plaintext_size,
@@ -57,8 +68,10 @@ class AesCtrEncryptor : public AesEncryptor {
   uint32_t block_offset_;
   // Current AES-CTR counter.
   std::vector<uint8_t> counter_;
-  // Encrypted counter.
+  // Encrypted counter, i.e. keystream for the current partial block.
   std::vector<uint8_t> encrypted_counter_;
+  // Block-wise keystream generator.
+  AesCtrKeystream keystream_;
 
   DISALLOW_COPY_AND_ASSIGN(AesCtrEncryptor);
 };
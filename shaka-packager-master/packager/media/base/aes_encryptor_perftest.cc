@@ -0,0 +1,115 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+#include <openssl/aes.h>
+
+#include <string>
+#include <vector>
+
+#include "packager/base/logging.h"
+#include "packager/base/time/time.h"
+#include "packager/media/base/aes_encryptor.h"
+#include "packager/testing/perf/perf_test.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const uint8_t kKey[] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                        0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+const uint8_t kIv[] = {0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7};
+
+// A typical 4K video sample.
+const size_t kSampleSize = 256 * 1024;
+const int kNumIterations = 200;
+
+// The per-block, byte-wise AES-CTR loop that AesCtrEncryptor used before the
+// block-wise keystream engine, kept here as the baseline.
+void ByteWiseCtrCrypt(const AES_KEY& aes_key,
+                      const uint8_t* text,
+                      size_t text_size,
+                      uint8_t* counter,
+                      uint8_t* crypt_text) {
+  uint8_t encrypted_counter[AES_BLOCK_SIZE];
+  size_t block_offset = 0;
+  for (size_t i = 0; i < text_size; ++i) {
+    if (block_offset == 0) {
+      AES_encrypt(counter, encrypted_counter, &aes_key);
+      for (int j = AES_BLOCK_SIZE - 1; j >= 8; --j) {
+        if (++counter[j] != 0)
+          break;
+      }
+    }
+    crypt_text[i] = text[i] ^ encrypted_counter[block_offset];
+    block_offset = (block_offset + 1) % AES_BLOCK_SIZE;
+  }
+}
+
+void PrintThroughput(const std::string& trace, base::TimeDelta elapsed) {
+  const double total_megabytes =
+      static_cast<double>(kSampleSize) * kNumIterations / (1024 * 1024);
+  perf_test::PrintResult("aes_ctr_throughput", "", trace,
+                         total_megabytes / elapsed.InSecondsF(), "MB/s", true);
+}
+
+class AesCtrEncryptorPerfTest : public testing::Test {
+ public:
+  void SetUp() override {
+    key_.assign(kKey, kKey + arraysize(kKey));
+    iv_.assign(kIv, kIv + arraysize(kIv));
+    sample_.resize(kSampleSize);
+    for (size_t i = 0; i < sample_.size(); ++i)
+      sample_[i] = static_cast<uint8_t>(i);
+  }
+
+ protected:
+  base::TimeDelta TimeEncryptor(bool use_hardware) {
+    AesCtrEncryptor encryptor;
+    EXPECT_TRUE(encryptor.InitializeWithIv(key_, iv_));
+    if (!use_hardware)
+      encryptor.DisableHardwareForTesting();
+
+    const base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kNumIterations; ++i)
+      EXPECT_TRUE(encryptor.Crypt(sample_.data(), sample_.size(), &sample_[0]));
+    return base::TimeTicks::Now() - start;
+  }
+
+  std::vector<uint8_t> key_;
+  std::vector<uint8_t> iv_;
+  std::vector<uint8_t> sample_;
+};
+
+TEST_F(AesCtrEncryptorPerfTest, ByteWiseBaseline) {
+  AES_KEY aes_key;
+  ASSERT_EQ(0, AES_set_encrypt_key(key_.data(), key_.size() * 8, &aes_key));
+  std::vector<uint8_t> counter(iv_);
+  counter.resize(AES_BLOCK_SIZE, 0);
+
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumIterations; ++i) {
+    ByteWiseCtrCrypt(aes_key, sample_.data(), sample_.size(), counter.data(),
+                     &sample_[0]);
+  }
+  PrintThroughput("byte_wise", base::TimeTicks::Now() - start);
+}
+
+TEST_F(AesCtrEncryptorPerfTest, BlockWisePortable) {
+  PrintThroughput("block_wise_portable", TimeEncryptor(false));
+}
+
+TEST_F(AesCtrEncryptorPerfTest, BlockWiseHardware) {
+  if (!AesCtrKeystream::IsHardwareSupported()) {
+    LOG(INFO) << "AES instructions are not available. Skipped.";
+    return;
+  }
+  PrintThroughput("block_wise_hardware", TimeEncryptor(true));
+}
+
+}  // namespace
+}  // namespace media
+}  // namespace shaka
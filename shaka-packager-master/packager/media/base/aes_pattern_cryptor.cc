@@ -55,8 +55,9 @@ bool AesPatternCryptor::CryptInternal(const uint8_t* text,
       if (!cryptor_->Crypt(text, crypt_byte_size, crypt_text))
         return false;
     } else {
-      // If there is not enough data, just keep it in clear.
-      memcpy(crypt_text, text, text_size);
+      // If there is not enough data, just keep it in clear. |text| and
+      // |crypt_text| are the same for in place encryption.
+      memmove(crypt_text, text, text_size);
       return true;
     }
     text += crypt_byte_size;
@@ -65,7 +66,7 @@ bool AesPatternCryptor::CryptInternal(const uint8_t* text,
 
     const size_t skip_byte_size = std::min(
         static_cast<size_t>(skip_byte_block_ * AES_BLOCK_SIZE), text_size);
-    memcpy(crypt_text, text, skip_byte_size);
+    memmove(crypt_text, text, skip_byte_size);
     text += skip_byte_size;
     text_size -= skip_byte_size;
     crypt_text += skip_byte_size;
@@ -135,6 +135,10 @@ TEST_P(AesPatternCryptorVerificationTest, PatternTest) {
   std::vector<uint8_t> crypt_text;
   ASSERT_TRUE(pattern_cryptor_.Crypt(text, &crypt_text));
   EXPECT_EQ(expected_crypt_text, crypt_text);
+
+  // In place.
+  ASSERT_TRUE(pattern_cryptor_.Crypt(text, &text));
+  EXPECT_EQ(expected_crypt_text, text);
 }
 
 INSTANTIATE_TEST_CASE_P(PatternTestCases,
@@ -0,0 +1,139 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/async_handler.h"
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/media/base/closure_thread.h"
+
+namespace shaka {
+namespace media {
+
+namespace {
+// The async handler only supports a single input and a single output.
+const size_t kStreamIndex = 0;
+}  // namespace
+
+AsyncHandler::AsyncHandler(size_t queue_capacity)
+    : queue_capacity_(queue_capacity),
+      not_empty_cv_(&lock_),
+      not_full_cv_(&lock_) {
+  DCHECK_GT(queue_capacity_, 0u);
+}
+
+AsyncHandler::~AsyncHandler() {
+  if (!worker_thread_)
+    return;
+  {
+    base::AutoLock auto_lock(lock_);
+    stop_requested_ = true;
+    not_empty_cv_.Signal();
+  }
+  worker_thread_->Join();
+}
+
+Status AsyncHandler::InitializeInternal() {
+  if (num_input_streams() != 1 || next_output_stream_index() != 1) {
+    return Status(error::INVALID_ARGUMENT,
+                  "Expects exactly one input and output.");
+  }
+  return Status::OK;
+}
+
+Status AsyncHandler::Process(std::unique_ptr<StreamData> stream_data) {
+  StartWorkerIfNeeded();
+
+  base::AutoLock auto_lock(lock_);
+  while (queue_.size() >= queue_capacity_ && status_.ok())
+    not_full_cv_.Wait();
+  if (!status_.ok())
+    return status_;
+
+  queue_.push_back(std::move(stream_data));
+  UpdateQueueDepth();
+  not_empty_cv_.Signal();
+  return Status::OK;
+}
+
+Status AsyncHandler::OnFlushRequest(size_t input_stream_index) {
+  DCHECK_EQ(input_stream_index, kStreamIndex);
+  if (!worker_thread_) {
+    // Nothing has been queued; flush downstream directly.
+    return FlushDownstream(kStreamIndex);
+  }
+
+  {
+    base::AutoLock auto_lock(lock_);
+    // The flush request is queued regardless of the capacity, so it does not
+    // block the upstream thread.
+    queue_.push_back(nullptr);
+    UpdateQueueDepth();
+    not_empty_cv_.Signal();
+  }
+  // The worker thread exits after handling the flush request. It is restarted
+  // if there is more stream data.
+  worker_thread_->Join();
+  worker_thread_.reset();
+
+  base::AutoLock auto_lock(lock_);
+  // The worker thread may have exited on an error before reaching the flush
+  // request.
+  queue_.clear();
+  UpdateQueueDepth();
+  return status_;
+}
+
+void AsyncHandler::StartWorkerIfNeeded() {
+  if (worker_thread_)
+    return;
+  worker_thread_.reset(new ClosureThread(
+      "AsyncHandler",
+      base::Bind(&AsyncHandler::ProcessQueue, base::Unretained(this))));
+  worker_thread_->Start();
+}
+
+void AsyncHandler::ProcessQueue() {
+  while (true) {
+    std::unique_ptr<StreamData> stream_data;
+    {
+      base::AutoLock auto_lock(lock_);
+      while (queue_.empty() && !stop_requested_)
+        not_empty_cv_.Wait();
+      if (stop_requested_)
+        return;
+      stream_data = std::move(queue_.front());
+      queue_.pop_front();
+      UpdateQueueDepth();
+      not_full_cv_.Signal();
+    }
+
+    // Everything queued before the flush request has been dispatched by now.
+    const bool is_flush_request = !stream_data;
+    Status status = is_flush_request ? FlushDownstream(kStreamIndex)
+                                     : Dispatch(std::move(stream_data));
+    if (is_flush_request || !status.ok()) {
+      base::AutoLock auto_lock(lock_);
+      status_.Update(status);
+      if (!status_.ok()) {
+        // Drop the pending stream data and unblock the upstream thread, which
+        // gets the error in its next call.
+        queue_.clear();
+        UpdateQueueDepth();
+        not_full_cv_.Broadcast();
+      }
+      return;
+    }
+  }
+}
+
+void AsyncHandler::UpdateQueueDepth() {
+  if (counters())
+    counters()->queue_depth = queue_.size();
+}
+
+}  // namespace media
+}  // namespace shaka
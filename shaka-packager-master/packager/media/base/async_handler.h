@@ -0,0 +1,82 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_ASYNC_HANDLER_H_
+#define PACKAGER_MEDIA_BASE_ASYNC_HANDLER_H_
+
+#include <deque>
+#include <memory>
+
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/media/base/media_handler.h"
+
+namespace shaka {
+namespace media {
+
+class ClosureThread;
+
+/// AsyncHandler is a single input single output pass-through handler which
+/// forwards the stream data to the downstream handlers in its own thread, i.e.
+/// it decouples the downstream handlers from the upstream thread.
+///
+/// The stream data is held in a bounded queue. Process() blocks when the queue
+/// is full, which applies back-pressure to the upstream handlers.
+///
+/// A flush request is queued behind the pending stream data. OnFlushRequest()
+/// returns after all the pending stream data and the flush request have been
+/// handled by the downstream handlers.
+///
+/// The first error returned by the downstream handlers is returned to the
+/// upstream handlers in the following Process() or OnFlushRequest() calls.
+class AsyncHandler : public MediaHandler {
+ public:
+  /// @param queue_capacity is the maximum number of stream data pending in the
+  ///        queue. Must be greater than 0.
+  explicit AsyncHandler(size_t queue_capacity);
+  ~AsyncHandler() override;
+
+ protected:
+  /// @name MediaHandler implementation overrides.
+  /// @{
+  Status InitializeInternal() override;
+  Status Process(std::unique_ptr<StreamData> stream_data) override;
+  Status OnFlushRequest(size_t input_stream_index) override;
+  /// @}
+
+ private:
+  AsyncHandler(const AsyncHandler&) = delete;
+  AsyncHandler& operator=(const AsyncHandler&) = delete;
+
+  // Starts |worker_thread_| if it is not running yet.
+  void StartWorkerIfNeeded();
+  // Runs in |worker_thread_|. Forwards the queued stream data downstream until
+  // a flush request is handled, an error occurs or it is stopped.
+  void ProcessQueue();
+  // Reports the size of |queue_| to the counters, if they are enabled. Called
+  // with |lock_| held.
+  void UpdateQueueDepth();
+
+  const size_t queue_capacity_;
+  // |worker_thread_| is only accessed from the upstream thread.
+  std::unique_ptr<ClosureThread> worker_thread_;
+
+  base::Lock lock_;
+  // Signaled when stream data or a flush request is queued, or on stop.
+  base::ConditionVariable not_empty_cv_;
+  // Signaled when there is spare capacity in the queue, or on error.
+  base::ConditionVariable not_full_cv_;
+  // Pending stream data. A null entry is a flush request.
+  std::deque<std::unique_ptr<StreamData>> queue_;
+  // The first error returned by the downstream handlers.
+  Status status_;
+  bool stop_requested_ = false;
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_ASYNC_HANDLER_H_
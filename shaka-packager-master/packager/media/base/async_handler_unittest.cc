@@ -0,0 +1,229 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/async_handler.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/bind_helpers.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/media/base/closure_thread.h"
+#include "packager/media/base/media_handler_test_base.h"
+#include "packager/status_test_util.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const size_t kInputCount = 1;
+const size_t kOutputCount = 1;
+const size_t kInputIndex = 0;
+const size_t kOutputIndex = 0;
+const size_t kStreamIndex = 0;
+const size_t kQueueCapacity = 2;
+
+const uint32_t kTimescale = 1000u;
+const int64_t kDuration = 10;
+const bool kKeyFrame = true;
+const bool kEncrypted = true;
+
+// An output handler which blocks in Process() until it is released, and fails
+// the sample at |fail_at_sample_index| if it is set.
+class BlockingOutputHandler : public MediaHandler {
+ public:
+  BlockingOutputHandler()
+      : release_event_(base::WaitableEvent::ResetPolicy::MANUAL,
+                       base::WaitableEvent::InitialState::SIGNALED) {}
+
+  void Block() { release_event_.Reset(); }
+  void Release() { release_event_.Signal(); }
+  void set_fail_at_sample_index(int index) { fail_at_sample_index_ = index; }
+
+  int num_processed() const { return num_processed_; }
+  int num_flushes() const { return num_flushes_; }
+
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+
+  Status Process(std::unique_ptr<StreamData> stream_data) override {
+    release_event_.Wait();
+    if (num_processed_++ == fail_at_sample_index_)
+      return Status(error::MUXER_FAILURE, "Failed to write sample.");
+    return Status::OK;
+  }
+
+  Status OnFlushRequest(size_t input_stream_index) override {
+    ++num_flushes_;
+    return Status::OK;
+  }
+
+  base::WaitableEvent release_event_;
+  int fail_at_sample_index_ = -1;
+  int num_processed_ = 0;
+  int num_flushes_ = 0;
+};
+
+}  // namespace
+
+class AsyncHandlerTest : public MediaHandlerTestBase {
+ public:
+  AsyncHandlerTest()
+      : dispatched_event_(base::WaitableEvent::ResetPolicy::MANUAL,
+                          base::WaitableEvent::InitialState::NOT_SIGNALED) {}
+
+  // Dispatches |num_samples| samples and signals |dispatched_event_|. It is
+  // run in a separate thread in some tests.
+  void DispatchSamples(int num_samples) {
+    for (int i = 0; i < num_samples; ++i)
+      dispatch_status_.Update(DispatchSample(i * kDuration));
+    dispatched_event_.Signal();
+  }
+
+ protected:
+  void SetUpAndInitializeGraph() {
+    ASSERT_OK(MediaHandlerTestBase::SetUpAndInitializeGraph(
+        std::make_shared<AsyncHandler>(kQueueCapacity), kInputCount,
+        kOutputCount));
+  }
+
+  // Set up input -> AsyncHandler -> |output_handler_|.
+  void SetUpGraphWithBlockingOutput() {
+    input_handler_.reset(new FakeInputMediaHandler);
+    output_handler_.reset(new BlockingOutputHandler);
+    async_handler_ = std::make_shared<AsyncHandler>(kQueueCapacity);
+    ASSERT_OK(input_handler_->AddHandler(async_handler_));
+    ASSERT_OK(async_handler_->AddHandler(output_handler_));
+    ASSERT_OK(input_handler_->Initialize());
+  }
+
+  Status DispatchSample(int64_t timestamp) {
+    return input_handler_->Dispatch(StreamData::FromMediaSample(
+        kStreamIndex, GetMediaSample(timestamp, kDuration, kKeyFrame)));
+  }
+
+  std::shared_ptr<FakeInputMediaHandler> input_handler_;
+  std::shared_ptr<MediaHandler> async_handler_;
+  std::shared_ptr<BlockingOutputHandler> output_handler_;
+  Status dispatch_status_;
+  base::WaitableEvent dispatched_event_;
+};
+
+TEST_F(AsyncHandlerTest, RejectsMultipleOutputs) {
+  EXPECT_FALSE(MediaHandlerTestBase::SetUpAndInitializeGraph(
+                   std::make_shared<AsyncHandler>(kQueueCapacity), kInputCount,
+                   2 * kOutputCount)
+                   .ok());
+}
+
+TEST_F(AsyncHandlerTest, FlushWithoutStreamData) {
+  SetUpAndInitializeGraph();
+
+  EXPECT_CALL(*Output(kOutputIndex), OnFlush(kStreamIndex));
+  ASSERT_OK(Input(kInputIndex)->FlushAllDownstreams());
+}
+
+TEST_F(AsyncHandlerTest, ForwardsStreamDataInOrderBeforeFlush) {
+  const int kNumSamples = 10;
+  SetUpAndInitializeGraph();
+
+  {
+    testing::InSequence s;
+    EXPECT_CALL(*Output(kOutputIndex),
+                OnProcess(IsStreamInfo(kStreamIndex, kTimescale, !kEncrypted)));
+    for (int i = 0; i < kNumSamples; ++i) {
+      EXPECT_CALL(*Output(kOutputIndex),
+                  OnProcess(IsMediaSample(kStreamIndex, i * kDuration,
+                                          kDuration, !kEncrypted)));
+    }
+    EXPECT_CALL(*Output(kOutputIndex), OnFlush(kStreamIndex));
+  }
+
+  ASSERT_OK(Input(kInputIndex)
+                ->Dispatch(StreamData::FromStreamInfo(
+                    kStreamIndex, GetVideoStreamInfo(kTimescale))));
+  for (int i = 0; i < kNumSamples; ++i) {
+    ASSERT_OK(Input(kInputIndex)
+                  ->Dispatch(StreamData::FromMediaSample(
+                      kStreamIndex,
+                      GetMediaSample(i * kDuration, kDuration, kKeyFrame))));
+  }
+  ASSERT_OK(Input(kInputIndex)->FlushAllDownstreams());
+}
+
+TEST_F(AsyncHandlerTest, ProcessAfterFlush) {
+  SetUpGraphWithBlockingOutput();
+
+  ASSERT_OK(DispatchSample(0));
+  ASSERT_OK(input_handler_->FlushAllDownstreams());
+  EXPECT_EQ(1, output_handler_->num_processed());
+  EXPECT_EQ(1, output_handler_->num_flushes());
+
+  ASSERT_OK(DispatchSample(kDuration));
+  ASSERT_OK(input_handler_->FlushAllDownstreams());
+  EXPECT_EQ(2, output_handler_->num_processed());
+  EXPECT_EQ(2, output_handler_->num_flushes());
+}
+
+TEST_F(AsyncHandlerTest, BlocksWhenQueueIsFull) {
+  // One sample is held by the output handler and |kQueueCapacity| samples are
+  // queued, so the last one has to wait.
+  const int kNumSamples = kQueueCapacity + 2;
+  SetUpGraphWithBlockingOutput();
+  output_handler_->Block();
+
+  ClosureThread upstream_thread(
+      "UpstreamThread",
+      base::Bind(&AsyncHandlerTest::DispatchSamples, base::Unretained(this),
+                 kNumSamples));
+  upstream_thread.Start();
+  // The upstream thread should not be able to dispatch all the samples while
+  // the output handler is blocked.
+  EXPECT_FALSE(
+      dispatched_event_.TimedWait(base::TimeDelta::FromMilliseconds(100)));
+
+  output_handler_->Release();
+  dispatched_event_.Wait();
+  upstream_thread.Join();
+  ASSERT_OK(dispatch_status_);
+  ASSERT_OK(input_handler_->FlushAllDownstreams());
+  EXPECT_EQ(kNumSamples, output_handler_->num_processed());
+}
+
+TEST_F(AsyncHandlerTest, PropagatesDownstreamError) {
+  const int kNumSamples = 10;
+  SetUpGraphWithBlockingOutput();
+  output_handler_->set_fail_at_sample_index(1);
+
+  DispatchSamples(kNumSamples);
+  EXPECT_EQ(error::MUXER_FAILURE,
+            input_handler_->FlushAllDownstreams().error_code());
+  // The error is kept after the flush.
+  EXPECT_EQ(error::MUXER_FAILURE, DispatchSample(0).error_code());
+  // Stream data after the error is dropped and the flush is not forwarded.
+  EXPECT_EQ(2, output_handler_->num_processed());
+  EXPECT_EQ(0, output_handler_->num_flushes());
+}
+
+TEST_F(AsyncHandlerTest, ReportsQueueDepth) {
+  SetUpGraphWithBlockingOutput();
+  HandlerCounters* counters = async_handler_->EnableCounters();
+  output_handler_->Block();
+
+  // The first sample is held by the output handler, so the following ones
+  // stay in the queue.
+  DispatchSamples(kQueueCapacity + 1);
+  ASSERT_OK(dispatch_status_);
+  EXPECT_EQ(static_cast<int64_t>(kQueueCapacity), counters->queue_depth);
+
+  output_handler_->Release();
+  ASSERT_OK(input_handler_->FlushAllDownstreams());
+  EXPECT_EQ(0, counters->queue_depth);
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,109 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/buffer_pool.h"
+
+#include "packager/base/logging.h"
+#include "packager/media/base/slab_allocator.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const size_t kMinBufferSize = 64;
+// The largest size class holds 16 MiB buffers. Larger buffers are not pooled.
+const size_t kNumSizeClasses = 19;
+const size_t kMaxCachedBytes = 64 * 1024 * 1024;
+
+size_t GetBufferSize(size_t size_class) {
+  return kMinBufferSize << size_class;
+}
+
+// Returns the smallest size class holding |size| bytes, or kNumSizeClasses if
+// |size| is too large to be pooled.
+size_t GetSizeClass(size_t size) {
+  size_t size_class = 0;
+  while (size_class < kNumSizeClasses && GetBufferSize(size_class) < size)
+    ++size_class;
+  return size_class;
+}
+
+}  // namespace
+
+class BufferPool::Deleter {
+ public:
+  Deleter(BufferPool* pool, size_t size_class)
+      : pool_(pool), size_class_(size_class) {}
+
+  void operator()(uint8_t* buffer) const {
+    pool_->Release(buffer, size_class_);
+  }
+
+ private:
+  BufferPool* pool_;
+  size_t size_class_;
+};
+
+BufferPool::BufferPool(size_t max_cached_bytes)
+    : max_cached_bytes_(max_cached_bytes), free_buffers_(kNumSizeClasses) {}
+
+BufferPool::~BufferPool() {
+  for (const std::vector<uint8_t*>& buffers : free_buffers_) {
+    for (uint8_t* buffer : buffers)
+      delete[] buffer;
+  }
+}
+
+// static
+BufferPool* BufferPool::GetInstance() {
+  static BufferPool* buffer_pool = new BufferPool(kMaxCachedBytes);
+  return buffer_pool;
+}
+
+std::shared_ptr<uint8_t> BufferPool::Allocate(size_t size) {
+  const size_t size_class = GetSizeClass(size);
+  if (size_class == kNumSizeClasses) {
+    return std::shared_ptr<uint8_t>(new uint8_t[size],
+                                    std::default_delete<uint8_t[]>(),
+                                    SlabStlAllocator<uint8_t>());
+  }
+
+  uint8_t* buffer = nullptr;
+  {
+    base::AutoLock auto_lock(lock_);
+    std::vector<uint8_t*>& buffers = free_buffers_[size_class];
+    if (!buffers.empty()) {
+      buffer = buffers.back();
+      buffers.pop_back();
+      cached_bytes_ -= GetBufferSize(size_class);
+    }
+  }
+  if (!buffer)
+    buffer = new uint8_t[GetBufferSize(size_class)];
+  return std::shared_ptr<uint8_t>(buffer, Deleter(this, size_class),
+                                  SlabStlAllocator<uint8_t>());
+}
+
+size_t BufferPool::cached_bytes() const {
+  base::AutoLock auto_lock(lock_);
+  return cached_bytes_;
+}
+
+void BufferPool::Release(uint8_t* buffer, size_t size_class) {
+  const size_t buffer_size = GetBufferSize(size_class);
+  {
+    base::AutoLock auto_lock(lock_);
+    if (cached_bytes_ + buffer_size <= max_cached_bytes_) {
+      free_buffers_[size_class].push_back(buffer);
+      cached_bytes_ += buffer_size;
+      return;
+    }
+  }
+  delete[] buffer;
+}
+
+}  // namespace media
+}  // namespace shaka
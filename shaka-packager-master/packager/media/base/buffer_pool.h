@@ -0,0 +1,64 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_BUFFER_POOL_H_
+#define PACKAGER_MEDIA_BASE_BUFFER_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "packager/base/macros.h"
+#include "packager/base/synchronization/lock.h"
+
+namespace shaka {
+namespace media {
+
+/// A pool of buffers for sample payloads. Buffer sizes are rounded up to a
+/// power of two and the buffers released by their last owner, e.g. a muxer
+/// done with a sample, are kept for the following allocations of the same
+/// size class, up to a maximum number of cached bytes. It is thread safe.
+class BufferPool {
+ public:
+  /// @param max_cached_bytes is the maximum number of bytes kept in the pool
+  ///        by released buffers.
+  explicit BufferPool(size_t max_cached_bytes);
+  ~BufferPool();
+
+  /// @return the process wide buffer pool.
+  static BufferPool* GetInstance();
+
+  /// Allocates a buffer. The pool must outlive the buffer.
+  /// @param size is the size of the buffer in bytes.
+  /// @return a buffer of at least |size| bytes, which is returned to the pool
+  ///         when released.
+  std::shared_ptr<uint8_t> Allocate(size_t size);
+
+  /// @return the number of bytes kept in the pool by released buffers.
+  size_t cached_bytes() const;
+
+ private:
+  class Deleter;
+
+  // Returns |buffer| of size class |size_class| to the pool.
+  void Release(uint8_t* buffer, size_t size_class);
+
+  const size_t max_cached_bytes_;
+
+  mutable base::Lock lock_;
+  size_t cached_bytes_ = 0;
+  // Released buffers indexed by size class.
+  std::vector<std::vector<uint8_t*>> free_buffers_;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferPool);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_BUFFER_POOL_H_
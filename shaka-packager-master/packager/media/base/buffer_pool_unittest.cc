@@ -0,0 +1,75 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/media/base/buffer_pool.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const size_t kMaxCachedBytes = 4096;
+
+}  // namespace
+
+TEST(BufferPoolTest, ReusesReleasedBuffer) {
+  BufferPool pool(kMaxCachedBytes);
+  std::shared_ptr<uint8_t> buffer = pool.Allocate(100);
+  const uint8_t* buffer_data = buffer.get();
+  // The buffer is writable.
+  memset(buffer.get(), 0xff, 100);
+  buffer.reset();
+  EXPECT_EQ(128u, pool.cached_bytes());
+
+  // Buffers of the same size class are reused.
+  buffer = pool.Allocate(120);
+  EXPECT_EQ(buffer_data, buffer.get());
+  EXPECT_EQ(0u, pool.cached_bytes());
+}
+
+TEST(BufferPoolTest, DifferentSizeClasses) {
+  BufferPool pool(kMaxCachedBytes);
+  std::shared_ptr<uint8_t> buffer = pool.Allocate(100);
+  buffer.reset();
+
+  std::shared_ptr<uint8_t> larger_buffer = pool.Allocate(200);
+  EXPECT_EQ(128u, pool.cached_bytes());
+  larger_buffer.reset();
+  EXPECT_EQ(128u + 256u, pool.cached_bytes());
+}
+
+TEST(BufferPoolTest, MaxCachedBytes) {
+  BufferPool pool(kMaxCachedBytes);
+  std::shared_ptr<uint8_t> first_buffer = pool.Allocate(kMaxCachedBytes);
+  std::shared_ptr<uint8_t> second_buffer = pool.Allocate(kMaxCachedBytes);
+  first_buffer.reset();
+  second_buffer.reset();
+  EXPECT_EQ(kMaxCachedBytes, pool.cached_bytes());
+}
+
+TEST(BufferPoolTest, LargeBufferNotPooled) {
+  const size_t kLargeBufferSize = 32 * 1024 * 1024;
+  BufferPool pool(kLargeBufferSize * 2);
+  std::shared_ptr<uint8_t> buffer = pool.Allocate(kLargeBufferSize);
+  buffer.get()[kLargeBufferSize - 1] = 1;
+  buffer.reset();
+  EXPECT_EQ(0u, pool.cached_bytes());
+}
+
+TEST(BufferPoolTest, SharedBuffer) {
+  BufferPool pool(kMaxCachedBytes);
+  std::shared_ptr<uint8_t> buffer = pool.Allocate(100);
+  std::shared_ptr<uint8_t> shared_buffer = buffer;
+  buffer.reset();
+  // The buffer is only returned to the pool by its last owner.
+  EXPECT_EQ(0u, pool.cached_bytes());
+  shared_buffer.reset();
+  EXPECT_EQ(128u, pool.cached_bytes());
+}
+
+}  // namespace media
+}  // namespace shaka
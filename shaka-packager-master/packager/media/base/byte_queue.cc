@@ -4,6 +4,8 @@
 
 #include "packager/media/base/byte_queue.h"
 
+#include <string.h>
+
 #include "packager/base/logging.h"
 
 namespace shaka {
@@ -12,6 +14,9 @@ namespace media {
 // Default starting size for the queue.
 enum { kDefaultQueueSize = 1024 };
 
+// See Push().
+const size_t kMinRoomPerMovedByte = 4;
+
 ByteQueue::ByteQueue()
     : buffer_(new uint8_t[kDefaultQueueSize]),
       size_(kDefaultQueueSize),
@@ -32,28 +37,37 @@ void ByteQueue::Push(const uint8_t* data, int size) {
 
   size_t size_needed = used_ + size;
 
-  // Check to see if we need a bigger buffer.
-  if (size_needed > size_) {
-    size_t new_size = 2 * size_;
-    while (size_needed > new_size && new_size > size_)
-      new_size *= 2;
-
-    // Sanity check to make sure we didn't overflow.
-    CHECK_GT(new_size, size_);
-
-    std::unique_ptr<uint8_t[]> new_buffer(new uint8_t[new_size]);
-
-    // Copy the data from the old buffer to the start of the new one.
-    if (used_ > 0)
-      memcpy(new_buffer.get(), front(), used_);
-
-    buffer_.reset(new_buffer.release());
-    size_ = new_size;
-    offset_ = 0;
-  } else if ((offset_ + used_ + size) > size_) {
-    // The buffer is big enough, but we need to move the data in the queue.
-    memmove(buffer_.get(), front(), used_);
+  if (offset_ + size_needed > size_) {
+    // There is not enough room at the end of the buffer. Moving the queued
+    // data to the start of the buffer is only worth it if that frees enough
+    // room for the pushes that follow, otherwise the buffer grows. This
+    // bounds the bytes moved by compaction to 1 / kMinRoomPerMovedByte of the
+    // bytes pushed. The bytes moved by growth are bounded by the buffer size.
+    const bool compact =
+        size_needed <= size_ &&
+        kMinRoomPerMovedByte * static_cast<size_t>(used_) <=
+            size_ - size_needed;
+    if (compact) {
+      memmove(buffer_.get(), front(), used_);
+    } else {
+      size_t new_size = 2 * size_;
+      while (size_needed > new_size && new_size > size_)
+        new_size *= 2;
+
+      // Sanity check to make sure we didn't overflow.
+      CHECK_GT(new_size, size_);
+
+      std::unique_ptr<uint8_t[]> new_buffer(new uint8_t[new_size]);
+
+      // Copy the data from the old buffer to the start of the new one.
+      if (used_ > 0)
+        memcpy(new_buffer.get(), front(), used_);
+
+      buffer_.reset(new_buffer.release());
+      size_ = new_size;
+    }
     offset_ = 0;
+    bytes_moved_ += used_;
   }
 
   memcpy(front() + used_, data, size);
@@ -73,11 +87,10 @@ void ByteQueue::Pop(int count) {
   offset_ += count;
   used_ -= count;
 
-  // Move the offset back to 0 if we have reached the end of the buffer.
-  if (offset_ == size_) {
-    DCHECK_EQ(used_, 0);
+  // Move the offset back to 0 if the queue is empty, so the whole buffer is
+  // available to the next Push() without moving any data.
+  if (used_ == 0)
     offset_ = 0;
-  }
 }
 
 uint8_t* ByteQueue::front() const {
@@ -18,7 +18,11 @@ namespace media {
 /// Data is added to the end of the queue via an Push() and removed via Pop().
 /// The contents of the queue can be observed via the Peek() method. This class
 /// manages the underlying storage of the queue and tries to minimize the
-/// number of buffer copies when data is appended and removed.
+/// number of buffer copies when data is appended and removed. The queue is
+/// kept in one contiguous buffer for Peek(), so queued data is still moved
+/// when the buffer is compacted or grown. Compaction only happens when the
+/// queued data is small compared to the room it frees, otherwise the buffer
+/// grows, and an emptied queue restarts at the start of the buffer.
 class ByteQueue {
  public:
   ByteQueue();
@@ -38,6 +42,10 @@ class ByteQueue {
   /// @param count specifies number of bytes to be popped.
   void Pop(int count);
 
+  /// @return The total number of queued bytes moved within or between
+  ///         buffers by Push(), to keep the queue contiguous.
+  uint64_t bytes_moved() const { return bytes_moved_; }
+
  private:
   // Returns a pointer to the front of the queue.
   uint8_t* front() const;
@@ -53,6 +61,9 @@ class ByteQueue {
   // Number of bytes stored in the queue.
   int used_;
 
+  // Number of bytes moved so far, see bytes_moved().
+  uint64_t bytes_moved_ = 0;
+
   DISALLOW_COPY_AND_ASSIGN(ByteQueue);
 };
 
@@ -0,0 +1,147 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "packager/base/logging.h"
+#include "packager/media/base/byte_queue.h"
+#include "packager/testing/perf/perf_test.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const uint64_t kBytesPerGigabyte = 1024 * 1024 * 1024;
+// The parsers push the data of each 64 KB read.
+const int kReadSize = 64 * 1024;
+const int kTsPacketSize = 188;
+
+// The ByteQueue growth policy before queued data was only moved when small,
+// kept here as the baseline: it moved the queued data whenever there was no
+// room at the end of the buffer.
+class LegacyByteQueue {
+ public:
+  void Push(const uint8_t* data, int size) {
+    const size_t size_needed = used_ + size;
+    if (size_needed > buffer_.size()) {
+      size_t new_size = 2 * buffer_.size();
+      while (size_needed > new_size)
+        new_size *= 2;
+      std::vector<uint8_t> new_buffer(new_size);
+      memcpy(new_buffer.data(), buffer_.data() + offset_, used_);
+      buffer_.swap(new_buffer);
+      offset_ = 0;
+      bytes_moved_ += used_;
+    } else if (offset_ + size_needed > buffer_.size()) {
+      memmove(buffer_.data(), buffer_.data() + offset_, used_);
+      offset_ = 0;
+      bytes_moved_ += used_;
+    }
+    memcpy(buffer_.data() + offset_ + used_, data, size);
+    used_ += size;
+  }
+
+  void Peek(const uint8_t** data, int* size) const {
+    *data = buffer_.data() + offset_;
+    *size = static_cast<int>(used_);
+  }
+
+  void Pop(int count) {
+    offset_ += count;
+    used_ -= count;
+    if (offset_ == buffer_.size())
+      offset_ = 0;
+  }
+
+  uint64_t bytes_moved() const { return bytes_moved_; }
+
+ private:
+  std::vector<uint8_t> buffer_ = std::vector<uint8_t>(1024);
+  size_t offset_ = 0;
+  size_t used_ = 0;
+  uint64_t bytes_moved_ = 0;
+};
+
+// How much of the queued data a parser consumes after each push.
+enum class Consumer {
+  // Whole TS packets, leaving a partial packet queued.
+  kTsPackets,
+  // Whole frames of 5 KB to 200 KB, e.g. an elementary stream parser.
+  kFrames,
+  // Everything but a partial element of up to 16 KB, e.g. the WebM parser.
+  kPartialElements,
+};
+
+template <typename Queue>
+uint64_t RunConsumer(Consumer consumer, Queue* queue) {
+  std::mt19937 generator(4321);
+  std::uniform_int_distribution<int> frame_size_distribution(5 * 1024,
+                                                             200 * 1024);
+  std::uniform_int_distribution<int> partial_size_distribution(0, 16 * 1024);
+  std::vector<uint8_t> read_buffer(kReadSize);
+  int next_frame_size = frame_size_distribution(generator);
+
+  for (uint64_t pushed = 0; pushed < kBytesPerGigabyte; pushed += kReadSize) {
+    queue->Push(read_buffer.data(), kReadSize);
+    const uint8_t* data = nullptr;
+    int size = 0;
+    queue->Peek(&data, &size);
+    switch (consumer) {
+      case Consumer::kTsPackets:
+        queue->Pop(size - size % kTsPacketSize);
+        break;
+      case Consumer::kFrames:
+        while (size >= next_frame_size) {
+          queue->Pop(next_frame_size);
+          size -= next_frame_size;
+          next_frame_size = frame_size_distribution(generator);
+        }
+        break;
+      case Consumer::kPartialElements:
+        queue->Pop(std::max(0, size - partial_size_distribution(generator)));
+        break;
+    }
+  }
+  return queue->bytes_moved();
+}
+
+void PrintBytesMoved(const std::string& trace, Consumer consumer) {
+  LegacyByteQueue legacy_queue;
+  const uint64_t legacy_bytes_moved = RunConsumer(consumer, &legacy_queue);
+  perf_test::PrintResult("byte_queue_bytes_moved_per_gb", "",
+                         trace + "_legacy",
+                         static_cast<size_t>(legacy_bytes_moved), "bytes",
+                         true);
+  ByteQueue queue;
+  const uint64_t bytes_moved = RunConsumer(consumer, &queue);
+  perf_test::PrintResult("byte_queue_bytes_moved_per_gb", "", trace,
+                         static_cast<size_t>(bytes_moved), "bytes", true);
+  EXPECT_LE(bytes_moved, legacy_bytes_moved);
+}
+
+}  // namespace
+
+TEST(ByteQueuePerfTest, TsPackets) {
+  PrintBytesMoved("ts_packets", Consumer::kTsPackets);
+}
+
+TEST(ByteQueuePerfTest, Frames) {
+  PrintBytesMoved("frames", Consumer::kFrames);
+}
+
+TEST(ByteQueuePerfTest, PartialElements) {
+  PrintBytesMoved("partial_elements", Consumer::kPartialElements);
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,119 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/byte_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace shaka {
+namespace media {
+namespace {
+
+// Larger than the initial buffer of the queue.
+const int kDataSize = 5000;
+
+}  // namespace
+
+class ByteQueueTest : public testing::Test {
+ public:
+  void SetUp() override {
+    data_.resize(kDataSize);
+    for (int i = 0; i < kDataSize; ++i)
+      data_[i] = static_cast<uint8_t>(i);
+  }
+
+ protected:
+  // Pops |count| bytes and checks that they continue the sequence in |data_|.
+  void PopAndCheck(int count) {
+    const uint8_t* buf = nullptr;
+    int size = 0;
+    queue_.Peek(&buf, &size);
+    ASSERT_GE(size, count);
+    for (int i = 0; i < count; ++i) {
+      ASSERT_EQ(static_cast<uint8_t>(next_byte_ + i), buf[i])
+          << "at byte " << next_byte_ + i;
+    }
+    next_byte_ += count;
+    queue_.Pop(count);
+  }
+
+  ByteQueue queue_;
+  std::vector<uint8_t> data_;
+  int next_byte_ = 0;
+};
+
+TEST_F(ByteQueueTest, PushPeekPop) {
+  queue_.Push(data_.data(), 100);
+  const uint8_t* buf = nullptr;
+  int size = 0;
+  queue_.Peek(&buf, &size);
+  EXPECT_EQ(100, size);
+  EXPECT_EQ(0, buf[0]);
+
+  queue_.Pop(40);
+  queue_.Peek(&buf, &size);
+  EXPECT_EQ(60, size);
+  EXPECT_EQ(40, buf[0]);
+
+  queue_.Reset();
+  queue_.Peek(&buf, &size);
+  EXPECT_EQ(0, size);
+}
+
+TEST_F(ByteQueueTest, KeepsDataContiguousWhileGrowing) {
+  // Push more than the initial buffer while popping less than pushed.
+  for (int i = 0; i < 10; ++i) {
+    queue_.Push(data_.data() + i * 500, 500);
+    PopAndCheck(200);
+  }
+  PopAndCheck(5000 - 2000);
+}
+
+TEST_F(ByteQueueTest, EmptiedQueueRestartsWithoutMove) {
+  for (int i = 0; i < 100; ++i) {
+    queue_.Push(data_.data(), 700);
+    queue_.Pop(700);
+  }
+  EXPECT_EQ(0u, queue_.bytes_moved());
+}
+
+TEST_F(ByteQueueTest, MovesSmallRemainders) {
+  // A TS-like pattern: each push leaves a small remainder in the queue.
+  const int kPushSize = 1000;
+  const int kPopSize = 188;
+  int queued = 0;
+  for (int i = 0; i < 5; ++i) {
+    queue_.Push(data_.data() + i * kPushSize, kPushSize);
+    queued += kPushSize;
+    while (queued >= kPopSize) {
+      PopAndCheck(kPopSize);
+      queued -= kPopSize;
+    }
+  }
+  // Only the remainders, which are smaller than a packet, are moved.
+  EXPECT_LT(queue_.bytes_moved(), 5u * kPopSize);
+}
+
+TEST_F(ByteQueueTest, LargeQueuedDataGrowsTheBuffer) {
+  // Moving the queued data after the first pop would free little room, so
+  // the buffer grows instead of the data being moved repeatedly.
+  queue_.Push(data_.data(), 1000);
+  PopAndCheck(100);
+  queue_.Push(data_.data() + 1000, 100);
+  queue_.Push(data_.data() + 1100, 100);
+  queue_.Push(data_.data() + 1200, 100);
+  const uint64_t bytes_moved = queue_.bytes_moved();
+  EXPECT_EQ(900u, bytes_moved);
+  // There is now enough room for more data without moving it again.
+  queue_.Push(data_.data() + 1300, 700);
+  EXPECT_EQ(bytes_moved, queue_.bytes_moved());
+  PopAndCheck(1900);
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -74,10 +74,53 @@ class LibCurlInitializer {
 
 namespace media {
 
-HttpKeyFetcher::HttpKeyFetcher() : timeout_in_seconds_(0) {}
+class HttpKeyFetcher::CurlShare {
+ public:
+  CurlShare() : share_(curl_share_init()) {
+    if (!share_) {
+      LOG(WARNING) << "curl_share_init() failed. Connections are not reused.";
+      return;
+    }
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, LockData);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, UnlockData);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  }
+
+  ~CurlShare() {
+    if (share_)
+      curl_share_cleanup(share_);
+  }
+
+  CURLSH* get() { return share_; }
+
+ private:
+  static void LockData(CURL* curl,
+                       curl_lock_data data,
+                       curl_lock_access access,
+                       void* user_data) {
+    static_cast<CurlShare*>(user_data)->locks_[data].Acquire();
+  }
+
+  static void UnlockData(CURL* curl, curl_lock_data data, void* user_data) {
+    static_cast<CurlShare*>(user_data)->locks_[data].Release();
+  }
+
+  CURLSH* share_;
+  base::Lock locks_[CURL_LOCK_DATA_LAST];
+
+  DISALLOW_COPY_AND_ASSIGN(CurlShare);
+};
+
+HttpKeyFetcher::HttpKeyFetcher() : HttpKeyFetcher(0) {}
 
 HttpKeyFetcher::HttpKeyFetcher(uint32_t timeout_in_seconds)
-    : timeout_in_seconds_(timeout_in_seconds) {}
+    : timeout_in_seconds_(timeout_in_seconds) {
+  static LibCurlInitializer lib_curl_initializer;
+  curl_share_.reset(new CurlShare);
+}
 
 HttpKeyFetcher::~HttpKeyFetcher() {}
 
@@ -102,7 +145,6 @@ Status HttpKeyFetcher::FetchInternal(HttpMethod method,
                                      const std::string& data,
                                      std::string* response) {
   DCHECK(method == GET || method == POST);
-  static LibCurlInitializer lib_curl_initializer;
 
   ScopedCurl scoped_curl;
   CURL* curl = scoped_curl.get();
@@ -119,6 +161,9 @@ Status HttpKeyFetcher::FetchInternal(HttpMethod method,
   curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
   curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, AppendToString);
   curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
+  curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+  if (curl_share_->get())
+    curl_easy_setopt(curl, CURLOPT_SHARE, curl_share_->get());
 
   if (!client_cert_private_key_file_.empty() && !client_cert_file_.empty()) {
     // Some PlayReady packaging servers only allow connects via HTTPS with
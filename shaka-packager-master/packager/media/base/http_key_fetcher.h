@@ -11,6 +11,8 @@
 #ifndef PACKAGER_MEDIA_BASE_HTTP_KEY_FETCHER_H_
 #define PACKAGER_MEDIA_BASE_HTTP_KEY_FETCHER_H_
 
+#include <memory>
+
 #include "packager/base/compiler_specific.h"
 #include "packager/media/base/key_fetcher.h"
 #include "packager/status.h"
@@ -18,7 +20,9 @@
 namespace shaka {
 namespace media {
 
-/// A KeyFetcher implementation that retrieves keys over HTTP(s).
+/// A KeyFetcher implementation that retrieves keys over HTTP(s). The
+/// connections are kept alive and reused by the following requests of the
+/// fetcher, including the concurrent ones.
 /// This class is not fully thread safe. It can be used in multi-thread
 /// environment once constructed, but it may not be safe to create a
 /// HttpKeyFetcher object when any other thread is running due to use of
@@ -78,6 +82,8 @@ class HttpKeyFetcher : public KeyFetcher {
     PUT
   };
 
+  class CurlShare;
+
   // Internal implementation of HTTP functions, e.g. Get and Post.
   Status FetchInternal(HttpMethod method, const std::string& url,
                        const std::string& data, std::string* response);
@@ -87,6 +93,9 @@ class HttpKeyFetcher : public KeyFetcher {
   std::string client_cert_file_;
   std::string client_cert_private_key_file_;
   std::string client_cert_private_key_password_;
+  // Shares the connections, the DNS cache and the SSL sessions between the
+  // requests.
+  std::unique_ptr<CurlShare> curl_share_;
 
   DISALLOW_COPY_AND_ASSIGN(HttpKeyFetcher);
 };
@@ -6,9 +6,24 @@
 
 #include "packager/media/base/http_key_fetcher.h"
 
+#if !defined(OS_WIN)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif  // !defined(OS_WIN)
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "packager/base/bind.h"
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/base/strings/string_util.h"
+#include "packager/base/strings/stringprintf.h"
+#include "packager/media/base/closure_thread.h"
 #include "packager/status_test_util.h"
 
 namespace {
@@ -95,6 +110,211 @@ TEST(DISABLED_HttpKeyFetcherTest, BigTimeout) {
   EXPECT_OK(status);
 }
 
+#if !defined(OS_WIN)
+
+namespace {
+
+const char kHttpResponseFormat[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: %zu\r\n"
+    "\r\n";
+const char kContentLengthHeader[] = "content-length:";
+const char kEndOfHeaders[] = "\r\n\r\n";
+
+// A local HTTP/1.1 server standing in for a key server. It keeps the
+// connections alive, responds to every request with its body and counts the
+// connections.
+class LocalHttpServer {
+ public:
+  LocalHttpServer()
+      : thread_("LocalHttpServer",
+                base::Bind(&LocalHttpServer::Run, base::Unretained(this))) {}
+
+  ~LocalHttpServer() {
+    if (thread_.HasBeenStarted()) {
+      const char kStop = 0;
+      CHECK_EQ(1, write(stop_pipe_[1], &kStop, 1));
+      thread_.Join();
+    }
+    for (const Connection& connection : connections_)
+      close(connection.fd);
+    if (listen_fd_ >= 0)
+      close(listen_fd_);
+    if (stop_pipe_[0] >= 0) {
+      close(stop_pipe_[0]);
+      close(stop_pipe_[1]);
+    }
+  }
+
+  bool Start() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0)
+      return false;
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_size = sizeof(address);
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address),
+             address_size) != 0 ||
+        listen(listen_fd_, SOMAXCONN) != 0 ||
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&address),
+                    &address_size) != 0 ||
+        pipe(stop_pipe_) != 0) {
+      return false;
+    }
+    url_ = base::StringPrintf("http://127.0.0.1:%d/key",
+                              ntohs(address.sin_port));
+    thread_.Start();
+    return true;
+  }
+
+  const std::string& url() const { return url_; }
+  int num_connections() const { return num_connections_; }
+
+ private:
+  struct Connection {
+    int fd;
+    std::string data;
+  };
+
+  void Run() {
+    while (true) {
+      std::vector<pollfd> poll_fds = {{stop_pipe_[0], POLLIN, 0},
+                                      {listen_fd_, POLLIN, 0}};
+      for (const Connection& connection : connections_)
+        poll_fds.push_back({connection.fd, POLLIN, 0});
+      if (poll(poll_fds.data(), poll_fds.size(), -1) < 0)
+        return;
+      if (poll_fds[0].revents)
+        return;
+      for (size_t i = 2; i < poll_fds.size(); ++i) {
+        Connection* connection = &connections_[i - 2];
+        if (poll_fds[i].revents && !Receive(connection)) {
+          close(connection->fd);
+          connection->fd = -1;
+        }
+      }
+      for (size_t i = connections_.size(); i > 0; --i) {
+        if (connections_[i - 1].fd < 0)
+          connections_.erase(connections_.begin() + i - 1);
+      }
+      if (poll_fds[1].revents) {
+        const int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd >= 0) {
+          connections_.push_back({fd, ""});
+          ++num_connections_;
+        }
+      }
+    }
+  }
+
+  // Responds to the complete requests received on |connection|. Returns false
+  // if the connection is closed.
+  bool Receive(Connection* connection) {
+    char buffer[4096];
+    const ssize_t size = read(connection->fd, buffer, sizeof(buffer));
+    if (size <= 0)
+      return false;
+    connection->data.append(buffer, size);
+
+    while (true) {
+      const size_t headers_end = connection->data.find(kEndOfHeaders);
+      if (headers_end == std::string::npos)
+        return true;
+      const size_t body_begin = headers_end + strlen(kEndOfHeaders);
+      const std::string headers =
+          base::ToLowerASCII(connection->data.substr(0, headers_end));
+      size_t body_size = 0;
+      const size_t content_length = headers.find(kContentLengthHeader);
+      if (content_length != std::string::npos) {
+        const size_t value_begin =
+            content_length + strlen(kContentLengthHeader);
+        const size_t value_end = headers.find("\r\n", value_begin);
+        std::string value;
+        base::TrimWhitespaceASCII(
+            headers.substr(value_begin, value_end - value_begin),
+            base::TRIM_ALL, &value);
+        if (!base::StringToSizeT(value, &body_size))
+          return false;
+      }
+      if (connection->data.size() < body_begin + body_size)
+        return true;
+
+      const std::string body = connection->data.substr(body_begin, body_size);
+      const std::string response =
+          base::StringPrintf(kHttpResponseFormat, body.size()) + body;
+      if (write(connection->fd, response.data(), response.size()) !=
+          static_cast<ssize_t>(response.size())) {
+        return false;
+      }
+      connection->data.erase(0, body_begin + body_size);
+    }
+  }
+
+  ClosureThread thread_;
+  int listen_fd_ = -1;
+  int stop_pipe_[2] = {-1, -1};
+  std::string url_;
+  std::vector<Connection> connections_;
+  std::atomic<int> num_connections_{0};
+};
+
+void FetchKeysRepeatedly(HttpKeyFetcher* fetcher,
+                         const std::string& url,
+                         int num_requests,
+                         std::atomic<int>* num_successes) {
+  for (int i = 0; i < num_requests; ++i) {
+    std::string response;
+    if (fetcher->FetchKeys(url, kPostData, &response).ok() &&
+        response == kPostData) {
+      ++*num_successes;
+    }
+  }
+}
+
+}  // namespace
+
+TEST(HttpKeyFetcherTest, ReusesConnection) {
+  LocalHttpServer server;
+  ASSERT_TRUE(server.Start());
+
+  HttpKeyFetcher fetcher;
+  for (int i = 0; i < 3; ++i) {
+    std::string response;
+    ASSERT_OK(fetcher.FetchKeys(server.url(), kPostData, &response));
+    EXPECT_EQ(kPostData, response);
+  }
+  EXPECT_EQ(1, server.num_connections());
+}
+
+TEST(HttpKeyFetcherTest, ConcurrentRequests) {
+  const int kNumThreads = 4;
+  const int kNumRequestsPerThread = 5;
+  LocalHttpServer server;
+  ASSERT_TRUE(server.Start());
+
+  HttpKeyFetcher fetcher;
+  std::atomic<int> num_successes(0);
+  std::vector<std::unique_ptr<ClosureThread>> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back(new ClosureThread(
+        "FetchThread",
+        base::Bind(&FetchKeysRepeatedly, base::Unretained(&fetcher),
+                   server.url(), kNumRequestsPerThread,
+                   base::Unretained(&num_successes))));
+    threads.back()->Start();
+  }
+  for (const auto& thread : threads)
+    thread->Join();
+
+  EXPECT_EQ(kNumThreads * kNumRequestsPerThread, num_successes);
+  // The connections are reused by the following requests of the threads.
+  EXPECT_LE(server.num_connections(), kNumThreads);
+}
+
+#endif  // !defined(OS_WIN)
+
 }  // namespace media
 }  // namespace shaka
 
@@ -0,0 +1,70 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/key_request_cache.h"
+
+#include "packager/base/logging.h"
+
+namespace shaka {
+namespace media {
+
+KeyRequestCache::KeyRequestCache(size_t max_cached_responses)
+    : max_cached_responses_(max_cached_responses), request_done_(&lock_) {}
+
+KeyRequestCache::~KeyRequestCache() {}
+
+Status KeyRequestCache::Fetch(const std::string& request_key,
+                              const FetchCallback& fetch,
+                              std::string* response) {
+  DCHECK(response);
+
+  std::shared_ptr<Request> request;
+  {
+    base::AutoLock scoped_lock(lock_);
+    auto iter = requests_.find(request_key);
+    if (iter != requests_.end()) {
+      request = iter->second;
+      while (!request->done)
+        request_done_.Wait();
+      VLOG(1) << "Reusing the response of an identical key request.";
+      *response = request->response;
+      return request->status;
+    }
+    request = std::make_shared<Request>();
+    requests_[request_key] = request;
+  }
+
+  const Status status = fetch.Run(response);
+
+  base::AutoLock scoped_lock(lock_);
+  request->done = true;
+  request->status = status;
+  if (status.ok()) {
+    request->response = *response;
+    cached_request_keys_.push_back(request_key);
+    if (cached_request_keys_.size() > max_cached_responses_) {
+      requests_.erase(cached_request_keys_.front());
+      cached_request_keys_.pop_front();
+    }
+  } else {
+    // Failures are not cached, so that the request can be retried.
+    requests_.erase(request_key);
+  }
+  request_done_.Broadcast();
+  return status;
+}
+
+void KeyRequestCache::Remove(const std::string& request_key) {
+  base::AutoLock scoped_lock(lock_);
+  auto iter = requests_.find(request_key);
+  if (iter == requests_.end() || !iter->second->done)
+    return;
+  requests_.erase(iter);
+  cached_request_keys_.remove(request_key);
+}
+
+}  // namespace media
+}  // namespace shaka
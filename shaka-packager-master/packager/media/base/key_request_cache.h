@@ -0,0 +1,79 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_KEY_REQUEST_CACHE_H_
+#define PACKAGER_MEDIA_BASE_KEY_REQUEST_CACHE_H_
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "packager/base/callback.h"
+#include "packager/base/macros.h"
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/base/synchronization/lock.h"
+#include "packager/status.h"
+
+namespace shaka {
+namespace media {
+
+/// Shares the responses of identical key requests between their senders, e.g.
+/// the key rotation requests of the WidevineKeySource instances packaging the
+/// same content in one process, so that the key server receives every request
+/// once. The sender of a request which is already in flight waits for its
+/// response. The successful responses of the last requests are kept for the
+/// senders which lag behind. This class is thread safe.
+class KeyRequestCache {
+ public:
+  /// Sends the request and stores the response in @a response.
+  typedef base::Callback<Status(std::string* response)> FetchCallback;
+
+  /// @param max_cached_responses is the number of successful responses which
+  ///        are kept after their requests complete.
+  explicit KeyRequestCache(size_t max_cached_responses);
+  ~KeyRequestCache();
+
+  /// Gets the response of a request. @a fetch is called only if the request
+  /// is neither in flight nor cached.
+  /// @param request_key identifies the request, e.g. the server URL and the
+  ///        request before it is signed.
+  /// @param fetch sends the request.
+  /// @param[out] response receives the response on success. It should not be
+  ///             NULL.
+  /// @return the status returned by @a fetch.
+  Status Fetch(const std::string& request_key,
+               const FetchCallback& fetch,
+               std::string* response);
+
+  /// Drops the cached response of a request, e.g. because it reports a
+  /// transient error, so that the next sender of the request sends it again.
+  /// A request in flight is not affected.
+  /// @param request_key identifies the request, see Fetch.
+  void Remove(const std::string& request_key);
+
+ private:
+  struct Request {
+    bool done = false;
+    Status status;
+    std::string response;
+  };
+
+  const size_t max_cached_responses_;
+  base::Lock lock_;
+  base::ConditionVariable request_done_;
+  // The requests in flight and the cached ones.
+  std::map<std::string, std::shared_ptr<Request>> requests_;
+  // The keys of the cached requests, the oldest first.
+  std::list<std::string> cached_request_keys_;
+
+  DISALLOW_COPY_AND_ASSIGN(KeyRequestCache);
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_KEY_REQUEST_CACHE_H_
@@ -0,0 +1,171 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include "packager/base/bind.h"
+#include "packager/base/synchronization/waitable_event.h"
+#include "packager/media/base/closure_thread.h"
+#include "packager/media/base/key_request_cache.h"
+#include "packager/status_test_util.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const size_t kMaxCachedResponses = 2;
+const char kRequestKey[] = "request";
+const char kResponse[] = "response";
+
+// Counts the requests sent to the server.
+class FakeServer {
+ public:
+  FakeServer()
+      : request_received_(base::WaitableEvent::ResetPolicy::MANUAL,
+                          base::WaitableEvent::InitialState::NOT_SIGNALED),
+        response_allowed_(base::WaitableEvent::ResetPolicy::MANUAL,
+                          base::WaitableEvent::InitialState::SIGNALED) {}
+
+  Status Fetch(const std::string& response, std::string* result) {
+    ++num_requests_;
+    request_received_.Signal();
+    response_allowed_.Wait();
+    *result = response;
+    return status_;
+  }
+
+  KeyRequestCache::FetchCallback GetCallback(const std::string& response) {
+    return base::Bind(&FakeServer::Fetch, base::Unretained(this), response);
+  }
+
+  int num_requests() const { return num_requests_; }
+  void set_status(const Status& status) { status_ = status; }
+  base::WaitableEvent* request_received() { return &request_received_; }
+  base::WaitableEvent* response_allowed() { return &response_allowed_; }
+
+ private:
+  int num_requests_ = 0;
+  Status status_;
+  base::WaitableEvent request_received_;
+  base::WaitableEvent response_allowed_;
+};
+
+void FetchTask(KeyRequestCache* cache,
+               FakeServer* server,
+               std::string* response,
+               Status* status) {
+  *status =
+      cache->Fetch(kRequestKey, server->GetCallback(kResponse), response);
+}
+
+}  // namespace
+
+class KeyRequestCacheTest : public testing::Test {
+ public:
+  KeyRequestCacheTest() : cache_(kMaxCachedResponses) {}
+
+ protected:
+  Status Fetch(const std::string& request_key, std::string* response) {
+    return cache_.Fetch(request_key, server_.GetCallback(kResponse), response);
+  }
+
+  KeyRequestCache cache_;
+  FakeServer server_;
+};
+
+TEST_F(KeyRequestCacheTest, CachesResponse) {
+  std::string response;
+  ASSERT_OK(Fetch(kRequestKey, &response));
+  EXPECT_EQ(kResponse, response);
+
+  response.clear();
+  ASSERT_OK(Fetch(kRequestKey, &response));
+  EXPECT_EQ(kResponse, response);
+  EXPECT_EQ(1, server_.num_requests());
+}
+
+TEST_F(KeyRequestCacheTest, DifferentRequests) {
+  std::string response;
+  ASSERT_OK(Fetch("request1", &response));
+  ASSERT_OK(Fetch("request2", &response));
+  EXPECT_EQ(2, server_.num_requests());
+}
+
+TEST_F(KeyRequestCacheTest, EvictsOldestResponse) {
+  std::string response;
+  ASSERT_OK(Fetch("request1", &response));
+  ASSERT_OK(Fetch("request2", &response));
+  ASSERT_OK(Fetch("request3", &response));
+  EXPECT_EQ(3, server_.num_requests());
+
+  ASSERT_OK(Fetch("request3", &response));
+  ASSERT_OK(Fetch("request2", &response));
+  EXPECT_EQ(3, server_.num_requests());
+  ASSERT_OK(Fetch("request1", &response));
+  EXPECT_EQ(4, server_.num_requests());
+}
+
+TEST_F(KeyRequestCacheTest, FailureNotCached) {
+  const Status kFailure(error::HTTP_FAILURE, "failure");
+  server_.set_status(kFailure);
+  std::string response;
+  EXPECT_EQ(kFailure, Fetch(kRequestKey, &response));
+
+  server_.set_status(Status::OK);
+  ASSERT_OK(Fetch(kRequestKey, &response));
+  EXPECT_EQ(kResponse, response);
+  EXPECT_EQ(2, server_.num_requests());
+}
+
+TEST_F(KeyRequestCacheTest, RemovesResponse) {
+  std::string response;
+  ASSERT_OK(Fetch(kRequestKey, &response));
+  cache_.Remove(kRequestKey);
+  ASSERT_OK(Fetch(kRequestKey, &response));
+  EXPECT_EQ(2, server_.num_requests());
+
+  // The other responses are still cached.
+  ASSERT_OK(Fetch("request2", &response));
+  cache_.Remove("request3");
+  ASSERT_OK(Fetch("request2", &response));
+  ASSERT_OK(Fetch(kRequestKey, &response));
+  EXPECT_EQ(3, server_.num_requests());
+}
+
+// A request in flight is joined instead of being sent again.
+TEST_F(KeyRequestCacheTest, JoinsRequestInFlight) {
+  server_.response_allowed()->Reset();
+
+  std::string first_response;
+  Status first_status;
+  ClosureThread first_thread(
+      "FirstRequestThread",
+      base::Bind(&FetchTask, &cache_, &server_, &first_response,
+                 &first_status));
+  first_thread.Start();
+  server_.request_received()->Wait();
+
+  std::string second_response;
+  Status second_status;
+  ClosureThread second_thread(
+      "SecondRequestThread",
+      base::Bind(&FetchTask, &cache_, &server_, &second_response,
+                 &second_status));
+  second_thread.Start();
+
+  server_.response_allowed()->Signal();
+  first_thread.Join();
+  second_thread.Join();
+
+  ASSERT_OK(first_status);
+  ASSERT_OK(second_status);
+  EXPECT_EQ(kResponse, first_response);
+  EXPECT_EQ(kResponse, second_response);
+  EXPECT_EQ(1, server_.num_requests());
+}
+
+}  // namespace media
+}  // namespace shaka
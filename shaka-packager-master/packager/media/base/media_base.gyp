@@ -15,12 +15,16 @@
       'sources': [
         'aes_cryptor.cc',
         'aes_cryptor.h',
+        'aes_ctr_keystream.cc',
+        'aes_ctr_keystream.h',
         'aes_decryptor.cc',
         'aes_decryptor.h',
         'aes_encryptor.cc',
         'aes_encryptor.h',
         'aes_pattern_cryptor.cc',
         'aes_pattern_cryptor.h',
+        'async_handler.cc',
+        'async_handler.h',
         'audio_stream_info.cc',
         'audio_stream_info.h',
         'audio_timestamp_helper.cc',
@@ -29,6 +33,8 @@
         'bit_reader.h',
         'bit_writer.cc',
         'bit_writer.h',
+        'buffer_pool.cc',
+        'buffer_pool.h',
         'buffer_reader.cc',
         'buffer_reader.h',
         'buffer_writer.cc',
@@ -49,6 +55,8 @@
         'http_key_fetcher.h',
         'key_fetcher.cc',
         'key_fetcher.h',
+        'key_request_cache.cc',
+        'key_request_cache.h',
         'key_source.cc',
         'key_source.h',
         'language_utils.cc',
@@ -83,6 +91,8 @@
         'request_signer.h',
         'rsa_key.cc',
         'rsa_key.h',
+        'slab_allocator.cc',
+        'slab_allocator.h',
         'stream_info.cc',
         'stream_info.h',
         'text_sample.cc',
@@ -138,20 +148,26 @@
       'sources': [
         'aes_cryptor_unittest.cc',
         'aes_pattern_cryptor_unittest.cc',
+        'async_handler_unittest.cc',
         'audio_timestamp_helper_unittest.cc',
         'bit_reader_unittest.cc',
         'bit_writer_unittest.cc',
+        'buffer_pool_unittest.cc',
         'buffer_writer_unittest.cc',
+        'byte_queue_unittest.cc',
         'closure_thread_unittest.cc',
         'container_names_unittest.cc',
         'decryptor_source_unittest.cc',
         'http_key_fetcher_unittest.cc',
+        'key_request_cache_unittest.cc',
+        'media_handler_unittest.cc',
         'muxer_util_unittest.cc',
         'offset_byte_queue_unittest.cc',
         'producer_consumer_queue_unittest.cc',
         'protection_system_specific_info_unittest.cc',
         'raw_key_source_unittest.cc',
         'rsa_key_unittest.cc',
+        'slab_allocator_unittest.cc',
         'status_test_util_unittest.cc',
         'test/fake_prng.cc',  # For rsa_key_unittest
         'test/fake_prng.h',   # For rsa_key_unittest
@@ -166,6 +182,22 @@
         '../../third_party/boringssl/boringssl.gyp:boringssl',
         '../test/media_test.gyp:media_test_support',
         'media_base',
+        'media_handler_test_base',
+      ],
+    },
+    {
+      'target_name': 'media_base_perftest',
+      'type': '<(gtest_target_type)',
+      'sources': [
+        'aes_encryptor_perftest.cc',
+        'byte_queue_perftest.cc',
+      ],
+      'dependencies': [
+        '../../testing/gtest.gyp:gtest',
+        '../../testing/perf/perf_test.gyp:perf_test',
+        '../../third_party/boringssl/boringssl.gyp:boringssl',
+        '../test/media_test.gyp:media_test_support',
+        'media_base',
       ],
     },
   ],
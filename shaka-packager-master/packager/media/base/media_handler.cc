@@ -6,8 +6,51 @@
 
 #include "packager/media/base/media_handler.h"
 
+#include "packager/base/time/time.h"
+#include "packager/media/base/slab_allocator.h"
+
 namespace shaka {
 namespace media {
+namespace {
+
+void CountStreamData(const StreamData& stream_data, HandlerCounters* counters) {
+  if (stream_data.stream_data_type == StreamDataType::kMediaSample) {
+    ++counters->num_samples;
+    counters->num_bytes += stream_data.media_sample->data_size();
+  } else if (stream_data.stream_data_type == StreamDataType::kTextSample) {
+    ++counters->num_samples;
+    counters->num_bytes += stream_data.text_sample->payload().size();
+  }
+}
+
+// Records |elapsed| as time spent in the callee, called by the caller. Either
+// counters may be null.
+void RecordCallTime(base::TimeDelta elapsed,
+                    HandlerCounters* caller_counters,
+                    HandlerCounters* callee_counters) {
+  if (caller_counters)
+    caller_counters->dispatch_time_in_us += elapsed.InMicroseconds();
+  if (callee_counters)
+    callee_counters->process_time_in_us += elapsed.InMicroseconds();
+}
+
+}  // namespace
+
+// static
+void* StreamData::operator new(size_t size) {
+  if (size != sizeof(StreamData))
+    return ::operator new(size);
+  return GetSlabAllocator<sizeof(StreamData)>()->Allocate();
+}
+
+// static
+void StreamData::operator delete(void* ptr, size_t size) {
+  if (size != sizeof(StreamData)) {
+    ::operator delete(ptr);
+    return;
+  }
+  GetSlabAllocator<sizeof(StreamData)>()->Free(ptr);
+}
 
 Status MediaHandler::SetHandler(size_t output_stream_index,
                                 std::shared_ptr<MediaHandler> handler) {
@@ -21,6 +64,12 @@ Status MediaHandler::SetHandler(size_t output_stream_index,
   return Status::OK;
 }
 
+HandlerCounters* MediaHandler::EnableCounters() {
+  if (!counters_)
+    counters_.reset(new HandlerCounters);
+  return counters_.get();
+}
+
 Status MediaHandler::Initialize() {
   if (initialized_)
     return Status::OK;
@@ -57,7 +106,20 @@ Status MediaHandler::Dispatch(std::unique_ptr<StreamData> stream_data) {
                   "No output handler exist at the specified index.");
   }
   stream_data->stream_index = handler_it->second.second;
-  return handler_it->second.first->Process(std::move(stream_data));
+  MediaHandler* handler = handler_it->second.first.get();
+  if (!counters_ && !handler->counters_)
+    return handler->Process(std::move(stream_data));
+
+  // Handlers without input count the samples they dispatch instead.
+  if (counters_ && num_input_streams_ == 0)
+    CountStreamData(*stream_data, counters_.get());
+  if (handler->counters_)
+    CountStreamData(*stream_data, handler->counters_.get());
+  const base::TimeTicks start = base::TimeTicks::Now();
+  Status status = handler->Process(std::move(stream_data));
+  RecordCallTime(base::TimeTicks::Now() - start, counters_.get(),
+                 handler->counters_.get());
+  return status;
 }
 
 Status MediaHandler::FlushDownstream(size_t output_stream_index) {
@@ -66,12 +128,14 @@ Status MediaHandler::FlushDownstream(size_t output_stream_index) {
     return Status(error::NOT_FOUND,
                   "No output handler exist at the specified index.");
   }
-  return handler_it->second.first->OnFlushRequest(handler_it->second.second);
+  return CallOnFlushRequest(handler_it->second.first.get(),
+                            handler_it->second.second);
 }
 
 Status MediaHandler::FlushAllDownstreams() {
   for (const auto& pair : output_handlers_) {
-    Status status = pair.second.first->OnFlushRequest(pair.second.second);
+    Status status =
+        CallOnFlushRequest(pair.second.first.get(), pair.second.second);
     if (!status.ok()) {
       return status;
     }
@@ -79,5 +143,16 @@ Status MediaHandler::FlushAllDownstreams() {
   return Status::OK;
 }
 
+Status MediaHandler::CallOnFlushRequest(MediaHandler* handler,
+                                        size_t input_stream_index) {
+  if (!counters_ && !handler->counters_)
+    return handler->OnFlushRequest(input_stream_index);
+  const base::TimeTicks start = base::TimeTicks::Now();
+  Status status = handler->OnFlushRequest(input_stream_index);
+  RecordCallTime(base::TimeTicks::Now() - start, counters_.get(),
+                 handler->counters_.get());
+  return status;
+}
+
 }  // namespace media
 }  // namespace shaka
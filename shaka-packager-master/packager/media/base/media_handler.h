@@ -7,6 +7,7 @@
 #ifndef PACKAGER_MEDIA_BASE_MEDIA_HANDLER_H_
 #define PACKAGER_MEDIA_BASE_MEDIA_HANDLER_H_
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <utility>
@@ -73,6 +74,11 @@ struct StreamData {
   std::shared_ptr<const Scte35Event> scte35_event;
   std::shared_ptr<const CueEvent> cue_event;
 
+  // StreamData is allocated for every sample, and copied for every output of
+  // a Replicator, so it is allocated from a slab allocator.
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr, size_t size);
+
   static std::unique_ptr<StreamData> FromStreamInfo(
       size_t stream_index, std::shared_ptr<const StreamInfo> stream_info) {
     std::unique_ptr<StreamData> stream_data(new StreamData);
@@ -130,6 +136,25 @@ struct StreamData {
   }
 };
 
+/// Counters of a media handler, collected when they are enabled with
+/// MediaHandler::EnableCounters(). They are updated by the threads running the
+/// handler and can be read from any thread.
+struct HandlerCounters {
+  /// Number of media and text samples received by the handler, or dispatched
+  /// by handlers without input, e.g. demuxers.
+  std::atomic<int64_t> num_samples{0};
+  /// Size of the samples counted in |num_samples|, in bytes.
+  std::atomic<int64_t> num_bytes{0};
+  /// Time spent in Process() and OnFlushRequest(), or in running handlers
+  /// without input, in microseconds.
+  std::atomic<int64_t> process_time_in_us{0};
+  /// Time spent in the downstream handlers called by Dispatch() and the flush
+  /// methods, in microseconds.
+  std::atomic<int64_t> dispatch_time_in_us{0};
+  /// Number of stream data waiting in the queue of handlers with a queue.
+  std::atomic<int64_t> queue_depth{0};
+};
+
 /// MediaHandler is the base media processing unit. Media handlers transform
 /// the input streams and propagate the outputs to downstream media handlers.
 /// There are three different types of media handlers:
@@ -166,6 +191,15 @@ class MediaHandler {
   /// Validate if the handler is connected to its upstream handler.
   bool IsConnected() { return num_input_streams_ > 0; }
 
+  /// Enable the counters of the handler. The calls to the handler are timed
+  /// from then on, so it should be called after setting up the graph before
+  /// running the graph.
+  /// @return the counters of the handler, owned by the handler.
+  HandlerCounters* EnableCounters();
+
+  /// @return the counters of the handler, or nullptr if they are not enabled.
+  HandlerCounters* counters() const { return counters_.get(); }
+
  protected:
   /// Internal implementation of initialize. Note that it should only initialize
   /// the MediaHandler itself. Downstream handlers are handled in Initialize().
@@ -242,6 +276,10 @@ class MediaHandler {
   MediaHandler(const MediaHandler&) = delete;
   MediaHandler& operator=(const MediaHandler&) = delete;
 
+  // Calls OnFlushRequest() of the downstream |handler|, timing the call if the
+  // counters are enabled.
+  Status CallOnFlushRequest(MediaHandler* handler, size_t input_stream_index);
+
   bool initialized_ = false;
   // Number of input streams.
   size_t num_input_streams_ = 0;
@@ -251,6 +289,7 @@ class MediaHandler {
   // map.
   std::map<size_t, std::pair<std::shared_ptr<MediaHandler>, size_t>>
       output_handlers_;
+  std::unique_ptr<HandlerCounters> counters_;
 };
 
 }  // namespace media
@@ -0,0 +1,112 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/media_handler.h"
+
+#include <gtest/gtest.h>
+
+#include "packager/base/threading/platform_thread.h"
+#include "packager/media/base/media_handler_test_base.h"
+#include "packager/status_test_util.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const size_t kStreamIndex = 0;
+const uint32_t kTimescale = 1000u;
+const int64_t kDuration = 10;
+const bool kKeyFrame = true;
+const uint8_t kData[] = {1, 2, 3, 4, 5, 6, 7, 8};
+const int kProcessTimeInMs = 10;
+
+// An output handler which takes |kProcessTimeInMs| to process stream data and
+// flush requests.
+class SlowOutputHandler : public MediaHandler {
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+
+  Status Process(std::unique_ptr<StreamData> stream_data) override {
+    base::PlatformThread::Sleep(
+        base::TimeDelta::FromMilliseconds(kProcessTimeInMs));
+    return Status::OK;
+  }
+
+  Status OnFlushRequest(size_t input_stream_index) override {
+    base::PlatformThread::Sleep(
+        base::TimeDelta::FromMilliseconds(kProcessTimeInMs));
+    return Status::OK;
+  }
+};
+
+}  // namespace
+
+class MediaHandlerTest : public MediaHandlerTestBase {
+ protected:
+  void SetUp() override {
+    input_handler_.reset(new FakeInputMediaHandler);
+    output_handler_.reset(new SlowOutputHandler);
+    ASSERT_OK(input_handler_->AddHandler(output_handler_));
+    ASSERT_OK(input_handler_->Initialize());
+  }
+
+  Status DispatchSample(int64_t timestamp) {
+    return input_handler_->Dispatch(StreamData::FromMediaSample(
+        kStreamIndex, GetMediaSample(timestamp, kDuration, kKeyFrame, kData,
+                                     sizeof(kData))));
+  }
+
+  std::shared_ptr<FakeInputMediaHandler> input_handler_;
+  std::shared_ptr<SlowOutputHandler> output_handler_;
+};
+
+TEST_F(MediaHandlerTest, CountersAreDisabledByDefault) {
+  ASSERT_OK(DispatchSample(0));
+  EXPECT_FALSE(input_handler_->counters());
+  EXPECT_FALSE(output_handler_->counters());
+}
+
+TEST_F(MediaHandlerTest, CountsSamples) {
+  HandlerCounters* input_counters = input_handler_->EnableCounters();
+  HandlerCounters* output_counters = output_handler_->EnableCounters();
+
+  ASSERT_OK(input_handler_->Dispatch(StreamData::FromStreamInfo(
+      kStreamIndex, GetVideoStreamInfo(kTimescale))));
+  ASSERT_OK(DispatchSample(0));
+  ASSERT_OK(DispatchSample(kDuration));
+
+  // The input handler has no input, so it counts the samples it dispatches.
+  EXPECT_EQ(2, input_counters->num_samples);
+  EXPECT_EQ(static_cast<int64_t>(2 * sizeof(kData)), input_counters->num_bytes);
+  EXPECT_EQ(2, output_counters->num_samples);
+  EXPECT_EQ(static_cast<int64_t>(2 * sizeof(kData)),
+            output_counters->num_bytes);
+}
+
+TEST_F(MediaHandlerTest, TimesDownstreamCalls) {
+  HandlerCounters* input_counters = input_handler_->EnableCounters();
+  HandlerCounters* output_counters = output_handler_->EnableCounters();
+
+  ASSERT_OK(DispatchSample(0));
+  ASSERT_OK(input_handler_->FlushAllDownstreams());
+
+  const int64_t kMinTimeInUs = 2 * kProcessTimeInMs * 1000;
+  EXPECT_GE(output_counters->process_time_in_us, kMinTimeInUs);
+  EXPECT_EQ(0, output_counters->dispatch_time_in_us);
+  EXPECT_GE(input_counters->dispatch_time_in_us, kMinTimeInUs);
+}
+
+TEST_F(MediaHandlerTest, TimesDownstreamCallsWithoutUpstreamCounters) {
+  HandlerCounters* output_counters = output_handler_->EnableCounters();
+
+  ASSERT_OK(DispatchSample(0));
+
+  EXPECT_EQ(1, output_counters->num_samples);
+  EXPECT_GE(output_counters->process_time_in_us, kProcessTimeInMs * 1000);
+}
+
+}  // namespace media
+}  // namespace shaka
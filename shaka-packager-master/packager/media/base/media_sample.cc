@@ -10,9 +10,40 @@
 
 #include "packager/base/logging.h"
 #include "packager/base/strings/stringprintf.h"
+#include "packager/media/base/buffer_pool.h"
+#include "packager/media/base/slab_allocator.h"
 
 namespace shaka {
 namespace media {
+namespace {
+
+// MediaSample with public constructors, so that samples can be allocated
+// together with their reference counts from a slab allocator by
+// std::allocate_shared.
+class PooledMediaSample : public MediaSample {
+ public:
+  PooledMediaSample(const uint8_t* data,
+                    size_t data_size,
+                    const uint8_t* side_data,
+                    size_t side_data_size,
+                    bool is_key_frame)
+      : MediaSample(data, data_size, side_data, side_data_size, is_key_frame) {
+  }
+  PooledMediaSample() {}
+};
+
+std::shared_ptr<MediaSample> CreatePooledMediaSample(
+    const uint8_t* data,
+    size_t data_size,
+    const uint8_t* side_data,
+    size_t side_data_size,
+    bool is_key_frame) {
+  return std::allocate_shared<PooledMediaSample>(
+      SlabStlAllocator<PooledMediaSample>(), data, data_size, side_data,
+      side_data_size, is_key_frame);
+}
+
+}  // namespace
 
 MediaSample::MediaSample(const uint8_t* data,
                          size_t data_size,
@@ -26,8 +57,8 @@ MediaSample::MediaSample(const uint8_t* data,
 
   SetData(data, data_size);
   if (side_data) {
-    std::shared_ptr<uint8_t> shared_side_data(new uint8_t[side_data_size],
-                                              std::default_delete<uint8_t[]>());
+    std::shared_ptr<uint8_t> shared_side_data =
+        BufferPool::GetInstance()->Allocate(side_data_size);
     memcpy(shared_side_data.get(), side_data, side_data_size);
     side_data_ = std::move(shared_side_data);
     side_data_size_ = side_data_size;
@@ -44,8 +75,7 @@ std::shared_ptr<MediaSample> MediaSample::CopyFrom(const uint8_t* data,
                                                    bool is_key_frame) {
   // If you hit this CHECK you likely have a bug in a demuxer. Go fix it.
   CHECK(data);
-  return std::shared_ptr<MediaSample>(
-      new MediaSample(data, data_size, nullptr, 0u, is_key_frame));
+  return CreatePooledMediaSample(data, data_size, nullptr, 0u, is_key_frame);
 }
 
 // static
@@ -56,30 +86,29 @@ std::shared_ptr<MediaSample> MediaSample::CopyFrom(const uint8_t* data,
                                                    bool is_key_frame) {
   // If you hit this CHECK you likely have a bug in a demuxer. Go fix it.
   CHECK(data);
-  return std::shared_ptr<MediaSample>(new MediaSample(
-      data, data_size, side_data, side_data_size, is_key_frame));
+  return CreatePooledMediaSample(data, data_size, side_data, side_data_size,
+                                 is_key_frame);
 }
 
 // static
 std::shared_ptr<MediaSample> MediaSample::FromMetadata(const uint8_t* metadata,
                                                        size_t metadata_size) {
-  return std::shared_ptr<MediaSample>(
-      new MediaSample(nullptr, 0, metadata, metadata_size, false));
+  return CreatePooledMediaSample(nullptr, 0, metadata, metadata_size, false);
 }
 
 // static
 std::shared_ptr<MediaSample> MediaSample::CreateEmptyMediaSample() {
-  return std::shared_ptr<MediaSample>(new MediaSample);
+  return std::allocate_shared<PooledMediaSample>(
+      SlabStlAllocator<PooledMediaSample>());
 }
 
 // static
 std::shared_ptr<MediaSample> MediaSample::CreateEOSBuffer() {
-  return std::shared_ptr<MediaSample>(
-      new MediaSample(nullptr, 0, nullptr, 0, false));
+  return CreatePooledMediaSample(nullptr, 0, nullptr, 0, false);
 }
 
 std::shared_ptr<MediaSample> MediaSample::Clone() const {
-  std::shared_ptr<MediaSample> new_media_sample(new MediaSample);
+  std::shared_ptr<MediaSample> new_media_sample = CreateEmptyMediaSample();
   new_media_sample->dts_ = dts_;
   new_media_sample->pts_ = pts_;
   new_media_sample->duration_ = duration_;
@@ -87,6 +116,7 @@ std::shared_ptr<MediaSample> MediaSample::Clone() const {
   new_media_sample->is_encrypted_ = is_encrypted_;
   new_media_sample->data_ = data_;
   new_media_sample->data_size_ = data_size_;
+  new_media_sample->data_is_read_only_ = data_is_read_only_;
   new_media_sample->side_data_ = side_data_;
   new_media_sample->side_data_size_ = side_data_size_;
   new_media_sample->config_id_ = config_id_;
@@ -104,11 +134,35 @@ void MediaSample::TransferData(std::shared_ptr<uint8_t> data,
                                size_t data_size) {
   data_ = std::move(data);
   data_size_ = data_size;
+  data_is_read_only_ = false;
+}
+
+void MediaSample::ShareData(std::shared_ptr<const uint8_t> data,
+                            size_t data_size) {
+  data_ = std::move(data);
+  data_size_ = data_size;
+  data_is_read_only_ = true;
+}
+
+void MediaSample::TransferSideData(std::shared_ptr<const uint8_t> side_data,
+                                   size_t side_data_size) {
+  side_data_ = std::move(side_data);
+  side_data_size_ = side_data_size;
+}
+
+uint8_t* MediaSample::writable_data() {
+  DCHECK(!end_of_stream());
+  if (data_is_read_only_ || data_.use_count() != 1)
+    return nullptr;
+  // Sample data not shared through ShareData is always allocated as
+  // non-const, by SetData or by the caller of TransferData, so it is safe to
+  // modify it when there is no other owner.
+  return const_cast<uint8_t*>(data_.get());
 }
 
 void MediaSample::SetData(const uint8_t* data, size_t data_size) {
-  std::shared_ptr<uint8_t> shared_data(new uint8_t[data_size],
-                                       std::default_delete<uint8_t[]>());
+  std::shared_ptr<uint8_t> shared_data =
+      BufferPool::GetInstance()->Allocate(data_size);
   memcpy(shared_data.get(), data, data_size);
   TransferData(std::move(shared_data), data_size);
 }
@@ -78,6 +78,19 @@ class MediaSample {
   /// @param data_size is the size of the data to be copied.
   void SetData(const uint8_t* data, size_t data_size);
 
+  /// Share read-only data with this media sample, e.g. a slice of a memory
+  /// mapped file. No data copying is involved. The data is never modified in
+  /// place, see writable_data().
+  /// @param data points to the data to be shared.
+  /// @param data_size is the size of the data to be shared.
+  void ShareData(std::shared_ptr<const uint8_t> data, size_t data_size);
+
+  /// Transfer side data to this media sample. No data copying is involved.
+  /// @param side_data points to the side data to be transferred.
+  /// @param side_data_size is the size of the side data to be transferred.
+  void TransferSideData(std::shared_ptr<const uint8_t> side_data,
+                        size_t side_data_size);
+
   /// @return a human-readable string describing |*this|.
   std::string ToString() const;
 
@@ -124,6 +137,11 @@ class MediaSample {
     return data_size_;
   }
 
+  /// @return a pointer to the sample data which can be modified in place, or
+  ///         nullptr if the data buffer is shared with other samples, in which
+  ///         case the caller should copy the data before modifying it.
+  uint8_t* writable_data();
+
   const uint8_t* side_data() const { return side_data_.get(); }
 
   size_t side_data_size() const { return side_data_size_; }
@@ -174,6 +192,8 @@ class MediaSample {
   // Main buffer data.
   std::shared_ptr<const uint8_t> data_;
   size_t data_size_ = 0;
+  // Set if |data_| is read-only data shared through ShareData().
+  bool data_is_read_only_ = false;
   // Contain additional buffers to complete the main one. Needed by WebM
   // http://www.matroska.org/technical/specs/index.html BlockAdditional[A5].
   // Not used by mp4 and other containers.
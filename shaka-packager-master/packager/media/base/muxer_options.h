@@ -12,6 +12,7 @@
 #include <string>
 
 #include "packager/media/public/mp4_output_params.h"
+#include "packager/media/public/webm_output_params.h"
 
 namespace shaka {
 namespace media {
@@ -24,6 +25,9 @@ struct MuxerOptions {
   /// MP4 (ISO-BMFF) specific parameters.
   Mp4OutputParams mp4_params;
 
+  /// WebM specific parameters.
+  WebmOutputParams webm_params;
+
   /// Output file name. If segment_template is not specified, the Muxer
   /// generates this single output file with all segments concatenated;
   /// Otherwise, it specifies the init segment name.
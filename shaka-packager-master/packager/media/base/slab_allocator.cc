@@ -0,0 +1,67 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/base/slab_allocator.h"
+
+#include "packager/base/logging.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+size_t AlignBlockSize(size_t block_size) {
+  const size_t kAlignment = alignof(max_align_t);
+  if (block_size < sizeof(void*))
+    block_size = sizeof(void*);
+  return (block_size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+}  // namespace
+
+SlabAllocator::SlabAllocator(size_t block_size, size_t blocks_per_slab)
+    : block_size_(AlignBlockSize(block_size)),
+      blocks_per_slab_(blocks_per_slab) {
+  DCHECK_GT(blocks_per_slab_, 0u);
+}
+
+SlabAllocator::~SlabAllocator() {}
+
+void* SlabAllocator::Allocate() {
+  base::AutoLock auto_lock(lock_);
+  if (!free_blocks_) {
+    // Slabs are allocated with operator new[], which aligns them for any
+    // fundamental type. The blocks are aligned as block sizes are rounded up
+    // to the same alignment.
+    uint8_t* slab = new uint8_t[block_size_ * blocks_per_slab_];
+    slabs_.emplace_back(slab);
+    for (size_t i = blocks_per_slab_; i > 0; --i) {
+      FreeBlock* block =
+          reinterpret_cast<FreeBlock*>(slab + (i - 1) * block_size_);
+      block->next = free_blocks_;
+      free_blocks_ = block;
+    }
+  }
+  FreeBlock* block = free_blocks_;
+  free_blocks_ = block->next;
+  return block;
+}
+
+void SlabAllocator::Free(void* block) {
+  if (!block)
+    return;
+  base::AutoLock auto_lock(lock_);
+  FreeBlock* free_block = static_cast<FreeBlock*>(block);
+  free_block->next = free_blocks_;
+  free_blocks_ = free_block;
+}
+
+size_t SlabAllocator::num_slabs() const {
+  base::AutoLock auto_lock(lock_);
+  return slabs_.size();
+}
+
+}  // namespace media
+}  // namespace shaka
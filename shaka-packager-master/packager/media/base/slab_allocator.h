@@ -0,0 +1,114 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_BASE_SLAB_ALLOCATOR_H_
+#define PACKAGER_MEDIA_BASE_SLAB_ALLOCATOR_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "packager/base/macros.h"
+#include "packager/base/synchronization/lock.h"
+
+namespace shaka {
+namespace media {
+
+/// Allocates fixed size blocks from slabs of memory. Freed blocks are kept in
+/// a free list and reused by the following allocations, so objects allocated
+/// and released for every sample, e.g. MediaSample and StreamData, do not go
+/// through the heap once the pipeline reaches a steady state. The slabs are
+/// only released when the allocator is destroyed. It is thread safe.
+class SlabAllocator {
+ public:
+  /// @param block_size is the size of the blocks in bytes.
+  /// @param blocks_per_slab is the number of blocks allocated at once when
+  ///        there is no free block.
+  SlabAllocator(size_t block_size, size_t blocks_per_slab);
+  ~SlabAllocator();
+
+  /// @return a block of block_size() bytes, aligned for any fundamental type.
+  void* Allocate();
+
+  /// Returns a block to the free list.
+  /// @param block is a block returned by Allocate() of this allocator.
+  void Free(void* block);
+
+  size_t block_size() const { return block_size_; }
+
+  /// @return the number of slabs allocated so far.
+  size_t num_slabs() const;
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  const size_t block_size_;
+  const size_t blocks_per_slab_;
+
+  mutable base::Lock lock_;
+  FreeBlock* free_blocks_ = nullptr;
+  std::vector<std::unique_ptr<uint8_t[]>> slabs_;
+
+  DISALLOW_COPY_AND_ASSIGN(SlabAllocator);
+};
+
+/// @return the process wide slab allocator for blocks of |BlockSize| bytes.
+template <size_t BlockSize>
+SlabAllocator* GetSlabAllocator() {
+  const size_t kBlocksPerSlab = 256;
+  static SlabAllocator* slab_allocator =
+      new SlabAllocator(BlockSize, kBlocksPerSlab);
+  return slab_allocator;
+}
+
+/// An STL allocator allocating single objects from the process wide slab
+/// allocator of their size. It is meant to be used with std::allocate_shared,
+/// which allocates the object together with its reference counts, and with
+/// std::shared_ptr constructors taking an allocator.
+template <typename T>
+class SlabStlAllocator {
+ public:
+  typedef T value_type;
+
+  SlabStlAllocator() {}
+  template <typename U>
+  SlabStlAllocator(const SlabStlAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    static_assert(alignof(T) <= alignof(max_align_t),
+                  "Over-aligned types are not supported.");
+    if (n != 1)
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    return static_cast<T*>(GetSlabAllocator<sizeof(T)>()->Allocate());
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    if (n != 1) {
+      ::operator delete(ptr);
+      return;
+    }
+    GetSlabAllocator<sizeof(T)>()->Free(ptr);
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const SlabStlAllocator<T>&, const SlabStlAllocator<U>&) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const SlabStlAllocator<T>&, const SlabStlAllocator<U>&) {
+  return false;
+}
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_BASE_SLAB_ALLOCATOR_H_
@@ -0,0 +1,85 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include <set>
+
+#include "packager/media/base/slab_allocator.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const size_t kBlockSize = 24;
+const size_t kBlocksPerSlab = 4;
+
+struct TestObject {
+  int64_t value;
+  char padding[40];
+};
+
+}  // namespace
+
+TEST(SlabAllocatorTest, AlignsBlockSize) {
+  SlabAllocator allocator(kBlockSize, kBlocksPerSlab);
+  EXPECT_GE(allocator.block_size(), kBlockSize);
+  EXPECT_EQ(0u, allocator.block_size() % alignof(max_align_t));
+
+  void* block = allocator.Allocate();
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(block) % alignof(max_align_t));
+  allocator.Free(block);
+}
+
+TEST(SlabAllocatorTest, AllocatesDistinctBlocks) {
+  SlabAllocator allocator(kBlockSize, kBlocksPerSlab);
+  std::set<void*> blocks;
+  for (size_t i = 0; i < kBlocksPerSlab * 3; ++i) {
+    void* block = allocator.Allocate();
+    // Blocks are writable.
+    memset(block, 0xff, kBlockSize);
+    EXPECT_TRUE(blocks.insert(block).second);
+  }
+  EXPECT_EQ(3u, allocator.num_slabs());
+  for (void* block : blocks)
+    allocator.Free(block);
+}
+
+TEST(SlabAllocatorTest, ReusesFreedBlocks) {
+  SlabAllocator allocator(kBlockSize, kBlocksPerSlab);
+  for (int i = 0; i < 100; ++i) {
+    void* first_block = allocator.Allocate();
+    void* second_block = allocator.Allocate();
+    allocator.Free(first_block);
+    allocator.Free(second_block);
+  }
+  EXPECT_EQ(1u, allocator.num_slabs());
+
+  void* block = allocator.Allocate();
+  allocator.Free(block);
+  EXPECT_EQ(block, allocator.Allocate());
+  allocator.Free(block);
+}
+
+TEST(SlabAllocatorTest, SharedPtr) {
+  SlabAllocator* slab_allocator = GetSlabAllocator<sizeof(TestObject)>();
+  std::shared_ptr<TestObject> object = std::allocate_shared<TestObject>(
+      SlabStlAllocator<TestObject>(), TestObject{123, {}});
+  EXPECT_EQ(123, object->value);
+  object.reset();
+
+  // The objects released are reused, so no more slabs are needed.
+  const size_t num_slabs = GetSlabAllocator<sizeof(TestObject)>()->num_slabs();
+  for (int i = 0; i < 1000; ++i) {
+    object = std::allocate_shared<TestObject>(SlabStlAllocator<TestObject>());
+    object.reset();
+  }
+  EXPECT_EQ(num_slabs, GetSlabAllocator<sizeof(TestObject)>()->num_slabs());
+  EXPECT_EQ(slab_allocator, GetSlabAllocator<sizeof(TestObject)>());
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -14,6 +14,7 @@
 #include "packager/base/json/json_writer.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/media/base/http_key_fetcher.h"
+#include "packager/media/base/key_request_cache.h"
 #include "packager/media/base/network_util.h"
 #include "packager/media/base/producer_consumer_queue.h"
 #include "packager/media/base/protection_system_specific_info.h"
@@ -129,30 +130,26 @@ bool IsProtectionSchemeValid(FourCC protection_scheme) {
 
 WidevineKeySource::WidevineKeySource(const std::string& server_url,
                                      bool add_common_pssh)
-    : key_production_thread_("KeyProductionThread",
-                             base::Bind(&WidevineKeySource::FetchKeysTask,
-                                        base::Unretained(this))),
-      key_fetcher_(new HttpKeyFetcher(kKeyFetchTimeoutInSeconds)),
+    : key_fetcher_(new HttpKeyFetcher(kKeyFetchTimeoutInSeconds)),
       server_url_(server_url),
       crypto_period_count_(kDefaultCryptoPeriodCount),
       protection_scheme_(FOURCC_cenc),
       add_common_pssh_(add_common_pssh),
       key_production_started_(false),
-      start_key_production_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
-                            base::WaitableEvent::InitialState::NOT_SIGNALED),
-      first_crypto_period_index_(0) {
-  key_production_thread_.Start();
-}
+      num_concurrent_key_requests_(1),
+      next_batch_to_push_(0),
+      batch_pushed_(&lock_),
+      first_crypto_period_index_(0) {}
 
 WidevineKeySource::~WidevineKeySource() {
-  if (key_pool_)
+  if (key_pool_) {
     key_pool_->Stop();
-  if (key_production_thread_.HasBeenStarted()) {
-    // Signal the production thread to start key production if it is not
-    // signaled yet so the thread can be joined.
-    start_key_production_.Signal();
-    key_production_thread_.Join();
+    // Wake up the production threads waiting for their turn to push keys.
+    base::AutoLock scoped_lock(lock_);
+    batch_pushed_.Broadcast();
   }
+  for (const auto& thread : key_production_threads_)
+    thread->Join();
 }
 
 Status WidevineKeySource::FetchKeys(const std::vector<uint8_t>& content_id,
@@ -175,7 +172,7 @@ Status WidevineKeySource::FetchKeys(const std::vector<uint8_t>& content_id,
                  << FourCCToString(protection_scheme);
   }
 
-  return FetchKeysInternal(!kEnableKeyRotation, 0, false);
+  return FetchKeysInternal(!kEnableKeyRotation, 0, false, nullptr);
 }
 
 Status WidevineKeySource::FetchKeys(EmeInitDataType init_data_type,
@@ -234,7 +231,8 @@ Status WidevineKeySource::FetchKeys(EmeInitDataType init_data_type,
     BytesToBase64String(pssh_data, &pssh_data_base64_string);
     request_dict_.SetString("pssh_data", pssh_data_base64_string);
   }
-  return FetchKeysInternal(!kEnableKeyRotation, 0, widevine_classic);
+  return FetchKeysInternal(!kEnableKeyRotation, 0, widevine_classic,
+                           nullptr);
 }
 
 Status WidevineKeySource::GetKey(const std::string& stream_label,
@@ -264,7 +262,6 @@ Status WidevineKeySource::GetKey(const std::vector<uint8_t>& key_id,
 Status WidevineKeySource::GetCryptoPeriodKey(uint32_t crypto_period_index,
                                              const std::string& stream_label,
                                              EncryptionKey* key) {
-  DCHECK(key_production_thread_.HasBeenStarted());
   // TODO(kqyang): This is not elegant. Consider refactoring later.
   {
     base::AutoLock scoped_lock(lock_);
@@ -276,7 +273,13 @@ Status WidevineKeySource::GetCryptoPeriodKey(uint32_t crypto_period_index,
       DCHECK(!key_pool_);
       key_pool_.reset(new EncryptionKeyQueue(crypto_period_count_,
                                              first_crypto_period_index_));
-      start_key_production_.Signal();
+      for (uint32_t i = 0; i < num_concurrent_key_requests_; ++i) {
+        key_production_threads_.emplace_back(new ClosureThread(
+            "KeyProductionThread",
+            base::Bind(&WidevineKeySource::FetchKeysTask,
+                       base::Unretained(this), i)));
+        key_production_threads_.back()->Start();
+      }
       key_production_started_ = true;
     }
   }
@@ -296,6 +299,14 @@ void WidevineKeySource::set_group_id(const std::vector<uint8_t>& group_id) {
   group_id_ = group_id;
 }
 
+void WidevineKeySource::set_num_concurrent_key_requests(
+    size_t num_concurrent_key_requests) {
+  DCHECK_GT(num_concurrent_key_requests, 0u);
+  base::AutoLock scoped_lock(lock_);
+  DCHECK(!key_production_started_);
+  num_concurrent_key_requests_ = num_concurrent_key_requests;
+}
+
 Status WidevineKeySource::GetKeyInternal(uint32_t crypto_period_index,
                                          const std::string& stream_label,
                                          EncryptionKey* key) {
@@ -307,6 +318,7 @@ Status WidevineKeySource::GetKeyInternal(uint32_t crypto_period_index,
                                   kGetKeyTimeoutInSeconds * 1000);
   if (!status.ok()) {
     if (status.error_code() == error::STOPPED) {
+      base::AutoLock scoped_lock(lock_);
       CHECK(!common_encryption_request_status_.ok());
       return common_encryption_request_status_;
     }
@@ -321,46 +333,50 @@ Status WidevineKeySource::GetKeyInternal(uint32_t crypto_period_index,
   return Status::OK;
 }
 
-void WidevineKeySource::FetchKeysTask() {
-  // Wait until key production is signaled.
-  start_key_production_.Wait();
-  if (!key_pool_ || key_pool_->Stopped())
-    return;
-
-  Status status = FetchKeysInternal(kEnableKeyRotation,
-                                    first_crypto_period_index_,
-                                    false);
-  while (status.ok()) {
-    first_crypto_period_index_ += crypto_period_count_;
-    status = FetchKeysInternal(kEnableKeyRotation,
-                               first_crypto_period_index_,
-                               false);
+void WidevineKeySource::FetchKeysTask(uint32_t first_batch) {
+  for (uint32_t batch = first_batch;; batch += num_concurrent_key_requests_) {
+    EncryptionKeyMaps crypto_period_key_maps;
+    const Status status = FetchKeysInternal(
+        kEnableKeyRotation,
+        first_crypto_period_index_ + batch * crypto_period_count_, false,
+        &crypto_period_key_maps);
+    if (!PushToKeyPool(batch, status, crypto_period_key_maps))
+      return;
   }
-  common_encryption_request_status_ = status;
-  key_pool_->Stop();
 }
 
-Status WidevineKeySource::FetchKeysInternal(bool enable_key_rotation,
-                                            uint32_t first_crypto_period_index,
-                                            bool widevine_classic) {
+Status WidevineKeySource::FetchKeysInternal(
+    bool enable_key_rotation,
+    uint32_t first_crypto_period_index,
+    bool widevine_classic,
+    EncryptionKeyMaps* crypto_period_key_maps) {
+  DCHECK(!enable_key_rotation || crypto_period_key_maps);
   std::string request;
   FillRequest(enable_key_rotation,
               first_crypto_period_index,
               &request);
 
-  std::string message;
-  Status status = GenerateKeyMessage(request, &message);
-  if (!status.ok())
-    return status;
-  VLOG(1) << "Message: " << message;
-
+  Status status;
   std::string raw_response;
   int64_t sleep_duration = kFirstRetryDelayMilliseconds;
 
   // Perform client side retries if seeing server transient error to workaround
   // server limitation.
+  const std::string request_key = server_url_ + "\n" + request;
   for (int i = 0; i < kNumTransientErrorRetries; ++i) {
-    status = key_fetcher_->FetchKeys(server_url_, message, &raw_response);
+    // Only the first attempt is shared, as the retries are meant to get a
+    // different response.
+    const bool shared_request =
+        enable_key_rotation && key_request_cache_ && i == 0;
+    if (shared_request) {
+      status = key_request_cache_->Fetch(
+          request_key,
+          base::Bind(&WidevineKeySource::SendRequest, base::Unretained(this),
+                     request),
+          &raw_response);
+    } else {
+      status = SendRequest(request, &raw_response);
+    }
     if (status.ok()) {
       VLOG(1) << "Retry [" << i << "] Response:" << raw_response;
 
@@ -373,7 +389,9 @@ Status WidevineKeySource::FetchKeysInternal(bool enable_key_rotation,
       bool transient_error = false;
       if (ExtractEncryptionKey(enable_key_rotation,
                                widevine_classic,
+                               first_crypto_period_index,
                                response,
+                               crypto_period_key_maps,
                                &transient_error))
         return Status::OK;
 
@@ -382,6 +400,10 @@ Status WidevineKeySource::FetchKeysInternal(bool enable_key_rotation,
             error::SERVER_ERROR,
             "Failed to extract encryption key from '" + response + "'.");
       }
+      // Do not share the transient error with the key sources which send the
+      // same request later.
+      if (shared_request)
+        key_request_cache_->Remove(request_key);
     } else if (status.error_code() != error::TIME_OUT) {
       return status;
     }
@@ -402,6 +424,9 @@ void WidevineKeySource::FillRequest(bool enable_key_rotation,
                                     std::string* request) {
   DCHECK(request);
   DCHECK(!request_dict_.empty());
+  // The requests may be filled concurrently, so |request_dict_| is copied.
+  std::unique_ptr<base::DictionaryValue> request_dict =
+      request_dict_.CreateDeepCopy();
 
   // Build tracks.
   base::ListValue* tracks = new base::ListValue();
@@ -422,31 +447,31 @@ void WidevineKeySource::FillRequest(bool enable_key_rotation,
   track_audio->SetString("type", "AUDIO");
   tracks->Append(track_audio);
 
-  request_dict_.Set("tracks", tracks);
+  request_dict->Set("tracks", tracks);
 
   // Build DRM types.
   base::ListValue* drm_types = new base::ListValue();
   drm_types->AppendString("WIDEVINE");
-  request_dict_.Set("drm_types", drm_types);
+  request_dict->Set("drm_types", drm_types);
 
   // Build key rotation fields.
   if (enable_key_rotation) {
     // Javascript/JSON does not support int64_t or unsigned numbers. Use double
     // instead as 32-bit integer can be lossless represented using double.
-    request_dict_.SetDouble("first_crypto_period_index",
+    request_dict->SetDouble("first_crypto_period_index",
                             first_crypto_period_index);
-    request_dict_.SetInteger("crypto_period_count", crypto_period_count_);
+    request_dict->SetInteger("crypto_period_count", crypto_period_count_);
   }
 
   // Set group id if present.
   if (!group_id_.empty()) {
     std::string group_id_base64;
     BytesToBase64String(group_id_, &group_id_base64);
-    request_dict_.SetString("group_id", group_id_base64);
+    request_dict->SetString("group_id", group_id_base64);
   }
 
   base::JSONWriter::WriteWithOptions(
-      request_dict_,
+      *request_dict,
       // Write doubles that have no fractional part as a normal integer, i.e.
       // without using exponential notation or appending a '.0'.
       base::JSONWriter::OPTIONS_OMIT_DOUBLE_TYPE_PRESERVATION, request);
@@ -479,6 +504,23 @@ Status WidevineKeySource::GenerateKeyMessage(const std::string& request,
   return Status::OK;
 }
 
+Status WidevineKeySource::SendRequest(const std::string& request,
+                                      std::string* raw_response) {
+  DCHECK(raw_response);
+
+  std::string message;
+  Status status;
+  {
+    base::AutoLock scoped_lock(signer_lock_);
+    status = GenerateKeyMessage(request, &message);
+  }
+  if (!status.ok())
+    return status;
+  VLOG(1) << "Message: " << message;
+
+  return key_fetcher_->FetchKeys(server_url_, message, raw_response);
+}
+
 bool WidevineKeySource::DecodeResponse(
     const std::string& raw_response,
     std::string* response) {
@@ -502,7 +544,9 @@ bool WidevineKeySource::DecodeResponse(
 bool WidevineKeySource::ExtractEncryptionKey(
     bool enable_key_rotation,
     bool widevine_classic,
+    uint32_t first_crypto_period_index,
     const std::string& response,
+    EncryptionKeyMaps* crypto_period_key_maps,
     bool* transient_error) {
   DCHECK(transient_error);
   *transient_error = false;
@@ -530,7 +574,7 @@ bool WidevineKeySource::ExtractEncryptionKey(
   RCHECK(enable_key_rotation ? tracks->GetSize() >= 1 * crypto_period_count_
                              : tracks->GetSize() >= 1);
 
-  int current_crypto_period_index = first_crypto_period_index_;
+  int current_crypto_period_index = first_crypto_period_index;
 
   EncryptionKeyMap encryption_key_map;
   for (size_t i = 0; i < tracks->GetSize(); ++i) {
@@ -549,8 +593,9 @@ bool WidevineKeySource::ExtractEncryptionKey(
                      << crypto_period_index << " at track " << i;
           return false;
         }
-        if (!PushToKeyPool(&encryption_key_map))
-          return false;
+        crypto_period_key_maps->push_back(
+            std::make_shared<EncryptionKeyMap>(std::move(encryption_key_map)));
+        encryption_key_map.clear();
         ++current_crypto_period_index;
       }
     }
@@ -613,20 +658,41 @@ bool WidevineKeySource::ExtractEncryptionKey(
       encryption_key_map_[pair.first] = std::move(pair.second);
     return true;
   }
-  return PushToKeyPool(&encryption_key_map);
+  crypto_period_key_maps->push_back(
+      std::make_shared<EncryptionKeyMap>(std::move(encryption_key_map)));
+  return true;
 }
 
 bool WidevineKeySource::PushToKeyPool(
-    EncryptionKeyMap* encryption_key_map) {
+    uint32_t batch,
+    const Status& status,
+    const EncryptionKeyMaps& crypto_period_key_maps) {
   DCHECK(key_pool_);
-  DCHECK(encryption_key_map);
-  auto encryption_key_map_shared = std::make_shared<EncryptionKeyMap>();
-  encryption_key_map_shared->swap(*encryption_key_map);
-  Status status = key_pool_->Push(encryption_key_map_shared, kInfiniteTimeout);
-  if (!status.ok()) {
-    DCHECK_EQ(error::STOPPED, status.error_code());
-    return false;
+  {
+    base::AutoLock scoped_lock(lock_);
+    while (next_batch_to_push_ != batch && !key_pool_->Stopped())
+      batch_pushed_.Wait();
+    if (key_pool_->Stopped())
+      return false;
+    if (!status.ok()) {
+      common_encryption_request_status_ = status;
+      key_pool_->Stop();
+      batch_pushed_.Broadcast();
+      return false;
+    }
   }
+  // The lock is not held while pushing, which blocks until the keys of the
+  // earlier crypto periods are consumed.
+  for (const auto& encryption_key_map : crypto_period_key_maps) {
+    Status push_status = key_pool_->Push(encryption_key_map, kInfiniteTimeout);
+    if (!push_status.ok()) {
+      DCHECK_EQ(error::STOPPED, push_status.error_code());
+      return false;
+    }
+  }
+  base::AutoLock scoped_lock(lock_);
+  ++next_batch_to_push_;
+  batch_pushed_.Broadcast();
   return true;
 }
 
@@ -9,7 +9,8 @@
 
 #include <map>
 #include <memory>
-#include "packager/base/synchronization/waitable_event.h"
+#include <vector>
+#include "packager/base/synchronization/condition_variable.h"
 #include "packager/base/values.h"
 #include "packager/media/base/closure_thread.h"
 #include "packager/media/base/fourccs.h"
@@ -23,6 +24,7 @@ const uint8_t kWidevineSystemId[] = {0xed, 0xef, 0x8b, 0xa9, 0x79, 0xd6,
                                      0xd5, 0x1d, 0x21, 0xed};
 
 class KeyFetcher;
+class KeyRequestCache;
 class RequestSigner;
 template <class T> class ProducerConsumerQueue;
 
@@ -71,24 +73,42 @@ class WidevineKeySource : public KeySource {
   // @param group_id group identifier
   void set_group_id(const std::vector<uint8_t>& group_id);
 
+  /// Set the number of key rotation requests which can be in flight at the
+  /// same time. Every request fetches the keys of a batch of crypto periods,
+  /// so the keys are fetched up to this number of batches ahead. The default
+  /// is 1. It should be called before the first call to GetCryptoPeriodKey.
+  void set_num_concurrent_key_requests(size_t num_concurrent_key_requests);
+
+  /// Share identical key rotation requests with other key sources.
+  /// @param key_request_cache is shared with the other key sources. It must
+  ///        outlive the key source.
+  void set_key_request_cache(KeyRequestCache* key_request_cache) {
+    key_request_cache_ = key_request_cache;
+  }
+
  private:
   typedef std::map<std::string, std::unique_ptr<EncryptionKey>>
       EncryptionKeyMap;
   typedef ProducerConsumerQueue<std::shared_ptr<EncryptionKeyMap>>
       EncryptionKeyQueue;
+  typedef std::vector<std::shared_ptr<EncryptionKeyMap>> EncryptionKeyMaps;
 
   // Internal routine for getting keys.
   Status GetKeyInternal(uint32_t crypto_period_index,
                         const std::string& stream_label,
                         EncryptionKey* key);
 
-  // The closure task to fetch keys repeatedly.
-  void FetchKeysTask();
+  // The closure task to fetch keys repeatedly. Every task fetches the
+  // batches of crypto periods starting from |first_batch|, every
+  // |num_concurrent_key_requests_| batches.
+  void FetchKeysTask(uint32_t first_batch);
 
-  // Fetch keys from server.
+  // Fetch keys from server. The keys of the crypto periods are added to
+  // |crypto_period_key_maps| if |enable_key_rotation| is true.
   Status FetchKeysInternal(bool enable_key_rotation,
                            uint32_t first_crypto_period_index,
-                           bool widevine_classic);
+                           bool widevine_classic,
+                           EncryptionKeyMaps* crypto_period_key_maps);
 
   // Fill |request| with necessary fields for Widevine encryption request.
   // |request| should not be NULL.
@@ -98,6 +118,9 @@ class WidevineKeySource : public KeySource {
   // Base64 escape and format the request. Optionally sign the request if a
   // signer is provided. |message| should not be NULL. Return OK on success.
   Status GenerateKeyMessage(const std::string& request, std::string* message);
+  // Sign |request| and send it to the server. |raw_response| should not be
+  // NULL.
+  Status SendRequest(const std::string& request, std::string* raw_response);
   // Decode |response| from JSON formatted |raw_response|.
   // |response| should not be NULL.
   bool DecodeResponse(const std::string& raw_response, std::string* response);
@@ -107,18 +130,28 @@ class WidevineKeySource : public KeySource {
   // should not be NULL.
   bool ExtractEncryptionKey(bool enable_key_rotation,
                             bool widevine_classic,
+                            uint32_t first_crypto_period_index,
                             const std::string& response,
+                            EncryptionKeyMaps* crypto_period_key_maps,
                             bool* transient_error);
-  // Push the keys to the key pool.
-  bool PushToKeyPool(EncryptionKeyMap* encryption_key_map);
-
-  ClosureThread key_production_thread_;
+  // Wait until the batches before |batch| are pushed to the key pool, then
+  // push the keys of |batch|, or stop the key pool with |status| if it is an
+  // error. Return false if the key pool is stopped.
+  bool PushToKeyPool(uint32_t batch,
+                     const Status& status,
+                     const EncryptionKeyMaps& crypto_period_key_maps);
+
+  std::vector<std::unique_ptr<ClosureThread>> key_production_threads_;
   // The fetcher object used to fetch keys from the license service.
   // It is initialized to a default fetcher on class initialization.
   // Can be overridden using set_key_fetcher for testing or other purposes.
   std::unique_ptr<KeyFetcher> key_fetcher_;
+  KeyRequestCache* key_request_cache_ = nullptr;
   std::string server_url_;
   std::unique_ptr<RequestSigner> signer_;
+  // Serializes the use of |signer_|, which is not thread safe.
+  base::Lock signer_lock_;
+  // Not modified once key production starts.
   base::DictionaryValue request_dict_;
 
   const uint32_t crypto_period_count_;
@@ -126,7 +159,10 @@ class WidevineKeySource : public KeySource {
   base::Lock lock_;
   bool add_common_pssh_;
   bool key_production_started_;
-  base::WaitableEvent start_key_production_;
+  size_t num_concurrent_key_requests_;
+  // The batches are pushed to the key pool in order.
+  uint32_t next_batch_to_push_;
+  base::ConditionVariable batch_pushed_;
   uint32_t first_crypto_period_index_;
   std::vector<uint8_t> group_id_;
   std::unique_ptr<EncryptionKeyQueue> key_pool_;
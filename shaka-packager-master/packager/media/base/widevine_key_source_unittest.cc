@@ -10,9 +10,13 @@
 #include <algorithm>
 
 #include "packager/base/base64.h"
+#include "packager/base/json/json_reader.h"
 #include "packager/base/strings/string_number_conversions.h"
 #include "packager/base/strings/stringprintf.h"
+#include "packager/base/synchronization/condition_variable.h"
+#include "packager/base/time/time.h"
 #include "packager/media/base/key_fetcher.h"
+#include "packager/media/base/key_request_cache.h"
 #include "packager/media/base/raw_key_source.h"
 #include "packager/media/base/request_signer.h"
 #include "packager/media/base/widevine_key_source.h"
@@ -538,5 +542,161 @@ INSTANTIATE_TEST_CASE_P(WidevineKeySourceInstance,
                                        FOURCC_cbc1,
                                        kAppleSampleAesProtectionScheme)));
 
+namespace {
+
+const uint32_t kNumConcurrentKeyRequests = 3;
+const int kMaxWaitForConcurrentRequestsInSeconds = 10;
+
+// Extracts the first crypto period index from a key rotation request message.
+// Returns false if |message| is not a key rotation request.
+bool GetFirstCryptoPeriodIndex(const std::string& message,
+                               uint32_t* first_crypto_period_index) {
+  std::unique_ptr<base::Value> message_value(base::JSONReader::Read(message));
+  const base::DictionaryValue* message_dict = nullptr;
+  std::string request_base64_string;
+  std::string request;
+  CHECK(message_value && message_value->GetAsDictionary(&message_dict) &&
+        message_dict->GetString("request", &request_base64_string) &&
+        base::Base64Decode(request_base64_string, &request));
+
+  std::unique_ptr<base::Value> request_value(base::JSONReader::Read(request));
+  const base::DictionaryValue* request_dict = nullptr;
+  CHECK(request_value && request_value->GetAsDictionary(&request_dict));
+  int index = 0;
+  if (!request_dict->GetInteger("first_crypto_period_index", &index))
+    return false;
+  *first_crypto_period_index = index;
+  return true;
+}
+
+// Responds to the key requests like a key server. The first key rotation
+// requests are held until |num_concurrent_requests| of them are in flight,
+// or until a timeout.
+class FakeKeyServer {
+ public:
+  explicit FakeKeyServer(size_t num_concurrent_requests)
+      : num_concurrent_requests_(num_concurrent_requests),
+        request_received_(&lock_) {}
+
+  Status FetchKeys(const std::string& message, std::string* response) {
+    uint32_t first_crypto_period_index = 0;
+    if (!GetFirstCryptoPeriodIndex(message, &first_crypto_period_index)) {
+      *response = base::StringPrintf(
+          kHttpResponseFormat,
+          Base64Encode(GenerateMockLicenseResponse()).c_str());
+      return Status::OK;
+    }
+
+    {
+      base::AutoLock scoped_lock(lock_);
+      ++num_key_rotation_requests_;
+      ++num_requests_in_flight_;
+      max_requests_in_flight_ =
+          std::max(max_requests_in_flight_, num_requests_in_flight_);
+      request_received_.Broadcast();
+      const base::TimeTicks deadline =
+          base::TimeTicks::Now() +
+          base::TimeDelta::FromSeconds(kMaxWaitForConcurrentRequestsInSeconds);
+      while (max_requests_in_flight_ < num_concurrent_requests_ &&
+             base::TimeTicks::Now() < deadline) {
+        request_received_.TimedWait(deadline - base::TimeTicks::Now());
+      }
+      --num_requests_in_flight_;
+    }
+
+    const uint32_t kCryptoPeriodCount = 10;
+    *response = base::StringPrintf(
+        kHttpResponseFormat,
+        Base64Encode(GenerateMockKeyRotationLicenseResponse(
+                         first_crypto_period_index, kCryptoPeriodCount))
+            .c_str());
+    return Status::OK;
+  }
+
+  size_t num_key_rotation_requests() {
+    base::AutoLock scoped_lock(lock_);
+    return num_key_rotation_requests_;
+  }
+
+  size_t max_requests_in_flight() {
+    base::AutoLock scoped_lock(lock_);
+    return max_requests_in_flight_;
+  }
+
+ private:
+  const size_t num_concurrent_requests_;
+  base::Lock lock_;
+  base::ConditionVariable request_received_;
+  size_t num_key_rotation_requests_ = 0;
+  size_t num_requests_in_flight_ = 0;
+  size_t max_requests_in_flight_ = 0;
+};
+
+class FakeKeyFetcher : public KeyFetcher {
+ public:
+  explicit FakeKeyFetcher(FakeKeyServer* server) : server_(server) {}
+
+  Status FetchKeys(const std::string& service_address,
+                   const std::string& message,
+                   std::string* response) override {
+    return server_->FetchKeys(message, response);
+  }
+
+ private:
+  FakeKeyServer* server_;
+};
+
+}  // namespace
+
+TEST_F(WidevineKeySourceTest, ConcurrentKeyRotationRequests) {
+  const uint32_t kLastCryptoPeriodIndex = 29;
+  FakeKeyServer server(kNumConcurrentKeyRequests);
+
+  CreateWidevineKeySource();
+  widevine_key_source_->set_key_fetcher(
+      std::unique_ptr<KeyFetcher>(new FakeKeyFetcher(&server)));
+  widevine_key_source_->set_num_concurrent_key_requests(
+      kNumConcurrentKeyRequests);
+  ASSERT_OK(widevine_key_source_->FetchKeys(content_id_, kPolicy));
+
+  EncryptionKey encryption_key;
+  const std::string kStreamLabels[] = {"SD", "HD", "UHD1", "UHD2", "AUDIO"};
+  for (uint32_t index = 1; index <= kLastCryptoPeriodIndex; ++index) {
+    for (const std::string& stream_label : kStreamLabels) {
+      ASSERT_OK(widevine_key_source_->GetCryptoPeriodKey(index, stream_label,
+                                                         &encryption_key));
+      EXPECT_EQ(GetMockKey(stream_label, index), ToString(encryption_key.key));
+    }
+  }
+  EXPECT_EQ(kNumConcurrentKeyRequests, server.max_requests_in_flight());
+}
+
+// Key sources sharing a KeyRequestCache send the identical requests once.
+TEST_F(WidevineKeySourceTest, SharedKeyRotationRequests) {
+  const size_t kMaxCachedResponses = 4;
+  // The first request is for the crypto periods 0 to 9.
+  const uint32_t kLastCryptoPeriodIndexOfFirstRequest = 9;
+  KeyRequestCache key_request_cache(kMaxCachedResponses);
+  FakeKeyServer server(1);
+
+  for (int i = 0; i < 2; ++i) {
+    WidevineKeySource widevine_key_source(kServerUrl, add_common_pssh_);
+    widevine_key_source.set_key_fetcher(
+        std::unique_ptr<KeyFetcher>(new FakeKeyFetcher(&server)));
+    widevine_key_source.set_key_request_cache(&key_request_cache);
+    ASSERT_OK(widevine_key_source.FetchKeys(content_id_, kPolicy));
+
+    EncryptionKey encryption_key;
+    for (uint32_t index = 1; index <= kLastCryptoPeriodIndexOfFirstRequest;
+         ++index) {
+      ASSERT_OK(
+          widevine_key_source.GetCryptoPeriodKey(index, "SD", &encryption_key));
+      EXPECT_EQ(GetMockKey("SD", index), ToString(encryption_key.key));
+    }
+  }
+  // The first request and the request fetched ahead by both key sources.
+  EXPECT_EQ(2u, server.num_key_rotation_requests());
+}
+
 }  // namespace media
 }  // namespace shaka
@@ -0,0 +1,255 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/codecs/annexb_scanner.h"
+
+#include "packager/base/logging.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+#define ANNEXB_SCANNER_USE_SIMD 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif  // defined(_MSC_VER)
+#endif  // x86 family
+
+#if defined(ANNEXB_SCANNER_USE_SIMD) && defined(__GNUC__)
+// Allows SSE2 and AVX2 intrinsics in the functions below without compiling
+// the whole target with -mavx2. The functions are only called after a runtime
+// check.
+#define SSE2_TARGET __attribute__((target("sse2")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define SSE2_TARGET
+#define AVX2_TARGET
+#endif
+
+namespace shaka {
+namespace media {
+namespace {
+
+// The scalar scan. It is also used for the tail of the vectorized scans.
+size_t ScalarFindSequence(const uint8_t* data,
+                          size_t size,
+                          uint8_t min_third_byte,
+                          uint8_t max_third_byte) {
+  size_t i = 0;
+  while (i + 2 < size) {
+    const uint8_t third_byte = data[i + 2];
+    if (third_byte != 0 &&
+        (third_byte < min_third_byte || third_byte > max_third_byte)) {
+      // A non-zero byte which cannot end a sequence cannot be in one at all,
+      // so no sequence starts at i, i + 1 or i + 2.
+      i += 3;
+      continue;
+    }
+    if (data[i] == 0 && data[i + 1] == 0 && third_byte >= min_third_byte &&
+        third_byte <= max_third_byte) {
+      return i;
+    }
+    ++i;
+  }
+  return size;
+}
+
+#if defined(ANNEXB_SCANNER_USE_SIMD)
+
+int CountTrailingZeros(uint32_t value) {
+  DCHECK_NE(0u, value);
+#if defined(_MSC_VER)
+  unsigned long index = 0;
+  _BitScanForward(&index, value);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(value);
+#endif  // defined(_MSC_VER)
+}
+
+void GetCpuid(unsigned int leaf, unsigned int registers[4]) {
+#if defined(_MSC_VER)
+  int values[4] = {};
+  __cpuidex(values, leaf, 0);
+  for (int i = 0; i < 4; ++i)
+    registers[i] = static_cast<unsigned int>(values[i]);
+#else
+  __cpuid_count(leaf, 0, registers[0], registers[1], registers[2],
+                registers[3]);
+#endif  // defined(_MSC_VER)
+}
+
+bool HasSse2() {
+  unsigned int registers[4] = {};
+  GetCpuid(1, registers);
+  const unsigned int kSse2Bit = 1u << 26;  // EDX.
+  return (registers[3] & kSse2Bit) != 0;
+}
+
+bool HasAvx2() {
+  unsigned int registers[4] = {};
+  GetCpuid(0, registers);
+  const unsigned int max_leaf = registers[0];
+  if (max_leaf < 7)
+    return false;
+
+  GetCpuid(1, registers);
+  const unsigned int kOsxsaveBit = 1u << 27;  // ECX.
+  const unsigned int kAvxBit = 1u << 28;      // ECX.
+  if ((registers[2] & kOsxsaveBit) == 0 || (registers[2] & kAvxBit) == 0)
+    return false;
+  // The OS must save the XMM and YMM registers on context switches.
+  uint64_t xcr0 = 0;
+#if defined(_MSC_VER)
+  xcr0 = _xgetbv(0);
+#else
+  uint32_t xcr0_low = 0;
+  uint32_t xcr0_high = 0;
+  __asm__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+  xcr0 = (static_cast<uint64_t>(xcr0_high) << 32) | xcr0_low;
+#endif  // defined(_MSC_VER)
+  const uint64_t kXmmYmmState = 0x6;
+  if ((xcr0 & kXmmYmmState) != kXmmYmmState)
+    return false;
+
+  GetCpuid(7, registers);
+  const unsigned int kAvx2Bit = 1u << 5;  // EBX.
+  return (registers[1] & kAvx2Bit) != 0;
+}
+
+// Each iteration checks the sequences starting in a 16 byte block, which
+// extend to two bytes after the block.
+SSE2_TARGET size_t Sse2FindSequence(const uint8_t* data,
+                                    size_t size,
+                                    uint8_t min_third_byte,
+                                    uint8_t max_third_byte) {
+  const size_t kBlockSize = 16;
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i min_third = _mm_set1_epi8(static_cast<char>(min_third_byte));
+  const __m128i third_range =
+      _mm_set1_epi8(static_cast<char>(max_third_byte - min_third_byte));
+
+  size_t i = 0;
+  for (; i + kBlockSize + 2 <= size; i += kBlockSize) {
+    const __m128i first =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i second =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+    const __m128i third =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 2));
+    const __m128i zeros = _mm_and_si128(_mm_cmpeq_epi8(first, zero),
+                                        _mm_cmpeq_epi8(second, zero));
+    // (third - min) <= (max - min) as unsigned bytes.
+    const __m128i third_offset = _mm_sub_epi8(third, min_third);
+    const __m128i third_in_range = _mm_cmpeq_epi8(
+        _mm_min_epu8(third_offset, third_range), third_offset);
+    const uint32_t mask = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_and_si128(zeros, third_in_range)));
+    if (mask)
+      return i + CountTrailingZeros(mask);
+  }
+  return i + ScalarFindSequence(data + i, size - i, min_third_byte,
+                                max_third_byte);
+}
+
+// Same as Sse2FindSequence with 32 byte blocks.
+AVX2_TARGET size_t Avx2FindSequence(const uint8_t* data,
+                                    size_t size,
+                                    uint8_t min_third_byte,
+                                    uint8_t max_third_byte) {
+  const size_t kBlockSize = 32;
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i min_third =
+      _mm256_set1_epi8(static_cast<char>(min_third_byte));
+  const __m256i third_range =
+      _mm256_set1_epi8(static_cast<char>(max_third_byte - min_third_byte));
+
+  size_t i = 0;
+  for (; i + kBlockSize + 2 <= size; i += kBlockSize) {
+    const __m256i first =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const __m256i second =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1));
+    const __m256i third =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 2));
+    const __m256i zeros = _mm256_and_si256(_mm256_cmpeq_epi8(first, zero),
+                                           _mm256_cmpeq_epi8(second, zero));
+    const __m256i third_offset = _mm256_sub_epi8(third, min_third);
+    const __m256i third_in_range = _mm256_cmpeq_epi8(
+        _mm256_min_epu8(third_offset, third_range), third_offset);
+    const uint32_t mask = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_and_si256(zeros, third_in_range)));
+    if (mask)
+      return i + CountTrailingZeros(mask);
+  }
+  return i + ScalarFindSequence(data + i, size - i, min_third_byte,
+                                max_third_byte);
+}
+
+#endif  // defined(ANNEXB_SCANNER_USE_SIMD)
+
+}  // namespace
+
+// static
+size_t AnnexBScanner::FindSequence(const uint8_t* data,
+                                   size_t size,
+                                   uint8_t min_third_byte,
+                                   uint8_t max_third_byte) {
+  static const Implementation kBestImplementation = GetBestImplementation();
+  return FindSequenceWithImplementation(kBestImplementation, data, size,
+                                        min_third_byte, max_third_byte);
+}
+
+// static
+size_t AnnexBScanner::FindSequenceWithImplementation(
+    Implementation implementation,
+    const uint8_t* data,
+    size_t size,
+    uint8_t min_third_byte,
+    uint8_t max_third_byte) {
+  DCHECK_LE(min_third_byte, max_third_byte);
+  switch (implementation) {
+#if defined(ANNEXB_SCANNER_USE_SIMD)
+    case kSse2:
+      return Sse2FindSequence(data, size, min_third_byte, max_third_byte);
+    case kAvx2:
+      return Avx2FindSequence(data, size, min_third_byte, max_third_byte);
+#endif  // defined(ANNEXB_SCANNER_USE_SIMD)
+    default:
+      DCHECK_EQ(kScalar, implementation);
+      return ScalarFindSequence(data, size, min_third_byte, max_third_byte);
+  }
+}
+
+// static
+bool AnnexBScanner::IsSupported(Implementation implementation) {
+  switch (implementation) {
+    case kScalar:
+      return true;
+#if defined(ANNEXB_SCANNER_USE_SIMD)
+    case kSse2:
+      return HasSse2();
+    case kAvx2:
+      return HasAvx2();
+#endif  // defined(ANNEXB_SCANNER_USE_SIMD)
+    default:
+      return false;
+  }
+}
+
+// static
+AnnexBScanner::Implementation AnnexBScanner::GetBestImplementation() {
+  if (IsSupported(kAvx2))
+    return kAvx2;
+  if (IsSupported(kSse2))
+    return kSse2;
+  return kScalar;
+}
+
+}  // namespace media
+}  // namespace shaka
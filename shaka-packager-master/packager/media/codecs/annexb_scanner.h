@@ -0,0 +1,70 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_CODECS_ANNEXB_SCANNER_H_
+#define PACKAGER_MEDIA_CODECS_ANNEXB_SCANNER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace shaka {
+namespace media {
+
+/// Scans H.264/H.265 (ISO/IEC 14496-10 and ISO/IEC 23008-2) byte streams for
+/// the three-byte sequences 0x00 0x00 X which delimit NAL units (start code
+/// prefixes, X = 1) and which need emulation prevention (X <= 3). The scan is
+/// vectorized with SSE2 or AVX2 when the CPU supports it.
+class AnnexBScanner {
+ public:
+  enum Implementation {
+    kScalar,
+    kSse2,
+    kAvx2,
+  };
+
+  /// Find the first three-byte sequence 0x00 0x00 X in @a data, with X in
+  /// [@a min_third_byte, @a max_third_byte].
+  /// @return The offset of the first byte of the sequence, or @a size if
+  ///         there is none.
+  static size_t FindSequence(const uint8_t* data,
+                             size_t size,
+                             uint8_t min_third_byte,
+                             uint8_t max_third_byte);
+
+  /// Same as FindSequence() but uses the specified implementation, which must
+  /// be supported. Used for testing and benchmarking.
+  static size_t FindSequenceWithImplementation(Implementation implementation,
+                                               const uint8_t* data,
+                                               size_t size,
+                                               uint8_t min_third_byte,
+                                               uint8_t max_third_byte);
+
+  /// Find the first start code prefix 0x00 0x00 0x01.
+  /// @return The offset of the start code prefix, or @a size if there is
+  ///         none.
+  static size_t FindStartCodePrefix(const uint8_t* data, size_t size) {
+    return FindSequence(data, size, 0x01, 0x01);
+  }
+
+  /// Find the first emulation prevention sequence 0x00 0x00 0x03.
+  /// @return The offset of the sequence, i.e. two bytes before the emulation
+  ///         prevention byte, or @a size if there is none.
+  static size_t FindEmulationPreventionSequence(const uint8_t* data,
+                                                size_t size) {
+    return FindSequence(data, size, 0x03, 0x03);
+  }
+
+  /// @return true if @a implementation is supported on this CPU.
+  static bool IsSupported(Implementation implementation);
+
+  /// @return The fastest implementation supported on this CPU.
+  static Implementation GetBestImplementation();
+};
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_CODECS_ANNEXB_SCANNER_H_
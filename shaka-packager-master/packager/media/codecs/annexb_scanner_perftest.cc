@@ -0,0 +1,163 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "packager/base/logging.h"
+#include "packager/base/time/time.h"
+#include "packager/media/base/buffer_writer.h"
+#include "packager/media/codecs/annexb_scanner.h"
+#include "packager/media/codecs/nal_unit_to_byte_stream_converter.h"
+#include "packager/media/codecs/nalu_reader.h"
+#include "packager/testing/perf/perf_test.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+// One second of a 20 Mbps stream at 30 frames per second.
+const size_t kStreamSize = 20 * 1000 * 1000 / 8;
+const size_t kNumFrames = 30;
+const int kNumIterations = 20;
+
+// Builds an Annex-B byte stream of |kNumFrames| slices of random data. The
+// slice data is escaped, like real slice data, and is biased towards zeros so
+// the scan hits near-sequences regularly.
+std::vector<uint8_t> CreateByteStream() {
+  std::mt19937 generator(1234);
+  std::discrete_distribution<int> zero_distribution({95, 5});
+  std::uniform_int_distribution<int> byte_distribution(0, 255);
+
+  BufferWriter writer;
+  const uint8_t kStartCode[] = {0x00, 0x00, 0x00, 0x01};
+  const uint8_t kSliceHeader = 0x25;  // IDR slice, nal_ref_idc 1.
+  std::vector<uint8_t> slice(kStreamSize / kNumFrames);
+  for (size_t frame = 0; frame < kNumFrames; ++frame) {
+    slice[0] = kSliceHeader;
+    for (size_t i = 1; i < slice.size(); ++i) {
+      slice[i] = zero_distribution(generator)
+                     ? 0
+                     : static_cast<uint8_t>(byte_distribution(generator));
+    }
+    writer.AppendArray(kStartCode, sizeof(kStartCode));
+    EscapeNalByteSequence(slice.data(), slice.size(), &writer);
+  }
+  return std::vector<uint8_t>(writer.Buffer(), writer.Buffer() + writer.Size());
+}
+
+// The byte-wise scan that NaluReader used before AnnexBScanner, kept here as
+// the baseline.
+size_t ByteWiseFindStartCodePrefix(const uint8_t* data, size_t size) {
+  for (size_t i = 0; i + 2 < size; ++i) {
+    if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)
+      return i;
+  }
+  return size;
+}
+
+void PrintThroughput(const std::string& measurement,
+                     const std::string& trace,
+                     size_t bytes_per_iteration,
+                     base::TimeDelta elapsed) {
+  const double total_megabytes = static_cast<double>(bytes_per_iteration) *
+                                 kNumIterations / (1024 * 1024);
+  perf_test::PrintResult(measurement, "", trace,
+                         total_megabytes / elapsed.InSecondsF(), "MB/s", true);
+}
+
+class AnnexBScannerPerfTest : public testing::Test {
+ public:
+  void SetUp() override { stream_ = CreateByteStream(); }
+
+ protected:
+  // Finds all start codes in |stream_| with |find| and returns the time used.
+  template <typename FindFunction>
+  base::TimeDelta TimeStartCodeScan(FindFunction find) {
+    size_t num_start_codes = 0;
+    const base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kNumIterations; ++i) {
+      size_t position = 0;
+      while (position < stream_.size()) {
+        const size_t offset =
+            find(stream_.data() + position, stream_.size() - position);
+        if (offset == stream_.size() - position)
+          break;
+        ++num_start_codes;
+        position += offset + 3;
+      }
+    }
+    const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+    EXPECT_EQ(kNumFrames * kNumIterations, num_start_codes);
+    return elapsed;
+  }
+
+  void TimeImplementation(AnnexBScanner::Implementation implementation,
+                          const std::string& trace) {
+    if (!AnnexBScanner::IsSupported(implementation)) {
+      LOG(INFO) << trace << " is not supported. Skipped.";
+      return;
+    }
+    PrintThroughput("start_code_scan", trace, stream_.size(),
+                    TimeStartCodeScan([implementation](const uint8_t* data,
+                                                       size_t size) {
+                      return AnnexBScanner::FindSequenceWithImplementation(
+                          implementation, data, size, 0x01, 0x01);
+                    }));
+  }
+
+  std::vector<uint8_t> stream_;
+};
+
+TEST_F(AnnexBScannerPerfTest, ByteWiseBaseline) {
+  PrintThroughput("start_code_scan", "byte_wise", stream_.size(),
+                  TimeStartCodeScan(&ByteWiseFindStartCodePrefix));
+}
+
+TEST_F(AnnexBScannerPerfTest, Scalar) {
+  TimeImplementation(AnnexBScanner::kScalar, "scalar");
+}
+
+TEST_F(AnnexBScannerPerfTest, Sse2) {
+  TimeImplementation(AnnexBScanner::kSse2, "sse2");
+}
+
+TEST_F(AnnexBScannerPerfTest, Avx2) {
+  TimeImplementation(AnnexBScanner::kAvx2, "avx2");
+}
+
+TEST_F(AnnexBScannerPerfTest, NaluReader) {
+  size_t num_nalus = 0;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumIterations; ++i) {
+    NaluReader reader(Nalu::kH264, kIsAnnexbByteStream, stream_.data(),
+                      stream_.size());
+    Nalu nalu;
+    while (reader.Advance(&nalu) == NaluReader::kOk)
+      ++num_nalus;
+  }
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  EXPECT_EQ(kNumFrames * kNumIterations, num_nalus);
+  PrintThroughput("nalu_reader", "annexb", stream_.size(), elapsed);
+}
+
+TEST_F(AnnexBScannerPerfTest, EscapeNalByteSequence) {
+  BufferWriter writer(stream_.size() * 2);
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumIterations; ++i) {
+    writer.Clear();
+    EscapeNalByteSequence(stream_.data(), stream_.size(), &writer);
+  }
+  PrintThroughput("escape_nal_byte_sequence", "", stream_.size(),
+                  base::TimeTicks::Now() - start);
+}
+
+}  // namespace
+}  // namespace media
+}  // namespace shaka
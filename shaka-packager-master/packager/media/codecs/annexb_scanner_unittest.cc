@@ -0,0 +1,181 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/codecs/annexb_scanner.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+namespace shaka {
+namespace media {
+namespace {
+
+struct ThirdByteRange {
+  uint8_t min;
+  uint8_t max;
+};
+
+// Start code prefix, emulation prevention and escaping.
+const ThirdByteRange kThirdByteRanges[] = {{1, 1}, {3, 3}, {0, 3}};
+
+// A byte which cannot be in any sequence.
+const uint8_t kFillerByte = 0x80;
+
+// The obvious implementation that the scanner is checked against.
+size_t ReferenceFindSequence(const uint8_t* data,
+                             size_t size,
+                             uint8_t min_third_byte,
+                             uint8_t max_third_byte) {
+  for (size_t i = 0; i + 2 < size; ++i) {
+    if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] >= min_third_byte &&
+        data[i + 2] <= max_third_byte) {
+      return i;
+    }
+  }
+  return size;
+}
+
+}  // namespace
+
+class AnnexBScannerTest
+    : public testing::TestWithParam<AnnexBScanner::Implementation> {
+ public:
+  void SetUp() override {
+    if (!AnnexBScanner::IsSupported(GetParam()))
+      skipped_ = true;
+  }
+
+ protected:
+  // Checks the scan of every suffix of |data|, which exercises every
+  // alignment of the vectorized scans.
+  void CheckAllSuffixes(const std::vector<uint8_t>& data) {
+    for (size_t start = 0; start <= data.size(); ++start) {
+      for (const ThirdByteRange& range : kThirdByteRanges) {
+        const uint8_t* suffix = data.data() + start;
+        const size_t suffix_size = data.size() - start;
+        ASSERT_EQ(
+            ReferenceFindSequence(suffix, suffix_size, range.min, range.max),
+            AnnexBScanner::FindSequenceWithImplementation(
+                GetParam(), suffix, suffix_size, range.min, range.max))
+            << "start " << start << " range [" << static_cast<int>(range.min)
+            << ", " << static_cast<int>(range.max) << "]";
+      }
+    }
+  }
+
+  bool skipped_ = false;
+};
+
+TEST_P(AnnexBScannerTest, Empty) {
+  if (skipped_)
+    return;
+  const uint8_t kData[] = {0x00};
+  EXPECT_EQ(0u, AnnexBScanner::FindSequenceWithImplementation(GetParam(), kData,
+                                                              0, 1, 1));
+}
+
+TEST_P(AnnexBScannerTest, Basic) {
+  if (skipped_)
+    return;
+  const uint8_t kData[] = {0x12, 0x00, 0x00, 0x00, 0x01, 0x34,
+                           0x00, 0x00, 0x03, 0x00, 0x00};
+  EXPECT_EQ(2u, AnnexBScanner::FindSequenceWithImplementation(
+                    GetParam(), kData, sizeof(kData), 0x01, 0x01));
+  EXPECT_EQ(6u, AnnexBScanner::FindSequenceWithImplementation(
+                    GetParam(), kData, sizeof(kData), 0x03, 0x03));
+  EXPECT_EQ(1u, AnnexBScanner::FindSequenceWithImplementation(
+                    GetParam(), kData, sizeof(kData), 0x00, 0x03));
+  // The trailing 0x00 0x00 is not a complete sequence.
+  EXPECT_EQ(2u, AnnexBScanner::FindSequenceWithImplementation(
+                    GetParam(), kData + 9, 2, 0x00, 0x03));
+}
+
+// Places every four byte pattern over {0x00, 0x01, 0x03, kFillerByte} at
+// every position of a buffer long enough for two vector blocks.
+TEST_P(AnnexBScannerTest, ExhaustivePatterns) {
+  if (skipped_)
+    return;
+  const uint8_t kAlphabet[] = {0x00, 0x01, 0x03, kFillerByte};
+  const size_t kAlphabetSize = sizeof(kAlphabet);
+  const size_t kPatternSize = 4;
+  const size_t kBufferSize = 72;
+
+  size_t num_patterns = 1;
+  for (size_t i = 0; i < kPatternSize; ++i)
+    num_patterns *= kAlphabetSize;
+
+  std::vector<uint8_t> pattern(kPatternSize);
+  for (size_t index = 0; index < num_patterns; ++index) {
+    size_t value = index;
+    for (size_t i = 0; i < kPatternSize; ++i) {
+      pattern[i] = kAlphabet[value % kAlphabetSize];
+      value /= kAlphabetSize;
+    }
+    for (size_t position = 0; position + kPatternSize <= kBufferSize;
+         ++position) {
+      std::vector<uint8_t> data(kBufferSize, kFillerByte);
+      std::copy(pattern.begin(), pattern.end(), data.begin() + position);
+      for (const ThirdByteRange& range : kThirdByteRanges) {
+        ASSERT_EQ(ReferenceFindSequence(data.data(), data.size(), range.min,
+                                        range.max),
+                  AnnexBScanner::FindSequenceWithImplementation(
+                      GetParam(), data.data(), data.size(), range.min,
+                      range.max))
+            << "pattern " << index << " at " << position;
+      }
+    }
+  }
+}
+
+// Random buffers dense in zeros and small values, so sequences of all kinds
+// appear at all alignments.
+TEST_P(AnnexBScannerTest, RandomBuffers) {
+  if (skipped_)
+    return;
+  const int kNumBuffers = 200;
+  const int kMaxBufferSize = 300;
+  std::mt19937 generator(12345);
+  std::uniform_int_distribution<int> size_distribution(0, kMaxBufferSize);
+  std::discrete_distribution<int> byte_distribution({60, 10, 10, 10, 5, 5});
+  const uint8_t kBytes[] = {0x00, 0x01, 0x02, 0x03, 0x04, kFillerByte};
+
+  for (int i = 0; i < kNumBuffers; ++i) {
+    std::vector<uint8_t> data(size_distribution(generator));
+    for (uint8_t& byte : data)
+      byte = kBytes[byte_distribution(generator)];
+    CheckAllSuffixes(data);
+  }
+}
+
+TEST_P(AnnexBScannerTest, NoSequence) {
+  if (skipped_)
+    return;
+  // Zeros everywhere, but never two in a row.
+  std::vector<uint8_t> data(1000);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = i % 2 ? 0x00 : 0x01;
+  CheckAllSuffixes(data);
+}
+
+INSTANTIATE_TEST_CASE_P(Implementations,
+                        AnnexBScannerTest,
+                        testing::Values(AnnexBScanner::kScalar,
+                                        AnnexBScanner::kSse2,
+                                        AnnexBScanner::kAvx2));
+
+TEST(AnnexBScannerHelpersTest, StartCodeAndEmulationPrevention) {
+  const uint8_t kData[] = {0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 0x01};
+  EXPECT_EQ(4u, AnnexBScanner::FindStartCodePrefix(kData, sizeof(kData)));
+  EXPECT_EQ(0u, AnnexBScanner::FindEmulationPreventionSequence(kData,
+                                                               sizeof(kData)));
+  EXPECT_TRUE(AnnexBScanner::IsSupported(
+      AnnexBScanner::GetBestImplementation()));
+}
+
+}  // namespace media
+}  // namespace shaka
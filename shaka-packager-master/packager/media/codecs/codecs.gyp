@@ -17,6 +17,8 @@
         'aac_audio_specific_config.h',
         'ac3_audio_util.cc',
         'ac3_audio_util.h',
+        'annexb_scanner.cc',
+        'annexb_scanner.h',
         'avc_decoder_configuration_record.cc',
         'avc_decoder_configuration_record.h',
         'decoder_configuration_record.cc',
@@ -64,6 +66,7 @@
       'sources': [
         'aac_audio_specific_config_unittest.cc',
         'ac3_audio_util_unittest.cc',
+        'annexb_scanner_unittest.cc',
         'avc_decoder_configuration_record_unittest.cc',
         'ec3_audio_util_unittest.cc',
         'es_descriptor_unittest.cc',
@@ -88,5 +91,19 @@
         'codecs',
       ],
     },
+    {
+      'target_name': 'codecs_perftest',
+      'type': '<(gtest_target_type)',
+      'sources': [
+        'annexb_scanner_perftest.cc',
+      ],
+      'dependencies': [
+        '../../media/base/media_base.gyp:media_base',
+        '../../testing/gtest.gyp:gtest',
+        '../../testing/perf/perf_test.gyp:perf_test',
+        '../test/media_test.gyp:media_test_support',
+        'codecs',
+      ],
+    },
   ],
 }
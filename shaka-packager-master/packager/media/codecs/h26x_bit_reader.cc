@@ -2,18 +2,31 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-#include "packager/base/logging.h"
 #include "packager/media/codecs/h26x_bit_reader.h"
 
+#include <algorithm>
+
+#include "packager/base/logging.h"
+#include "packager/media/codecs/annexb_scanner.h"
+
 namespace shaka {
 namespace media {
+namespace {
+
+// The number of bytes searched for the next emulation prevention byte at a
+// time. Large enough for most headers, which are read from the start of a NAL
+// unit, to be covered by a single search.
+const size_t kEmulationPreventionSearchWindow = 128;
+
+}  // namespace
 
 H26xBitReader::H26xBitReader()
     : data_(NULL),
       bytes_left_(0),
       curr_byte_(0),
       num_remaining_bits_in_curr_byte_(0),
-      prev_two_bytes_(0),
+      next_emulation_prevention_byte_(NULL),
+      search_end_(NULL),
       emulation_prevention_bytes_(0) {}
 
 H26xBitReader::~H26xBitReader() {}
@@ -27,8 +40,7 @@ bool H26xBitReader::Initialize(const uint8_t* data, off_t size) {
   data_ = data;
   bytes_left_ = size;
   num_remaining_bits_in_curr_byte_ = 0;
-  // Initially set to 0xffff to accept all initial two-byte sequences.
-  prev_two_bytes_ = 0xffff;
+  FindNextEmulationPreventionByte(data_);
   emulation_prevention_bytes_ = 0;
 
   return true;
@@ -38,15 +50,20 @@ bool H26xBitReader::UpdateCurrByte() {
   if (bytes_left_ < 1)
     return false;
 
+  // Search the next window once the bytes searched so far are read. The last
+  // two bytes of the previous window may start a sequence.
+  if (!next_emulation_prevention_byte_ && data_ == search_end_)
+    FindNextEmulationPreventionByte(data_ - 2);
+
   // Emulation prevention three-byte detection.
   // If a sequence of 0x000003 is found, skip (ignore) the last byte (0x03).
-  if (*data_ == 0x03 && (prev_two_bytes_ & 0xffff) == 0) {
+  if (data_ == next_emulation_prevention_byte_) {
     // Detected 0x000003, skip last byte.
     ++data_;
     --bytes_left_;
     ++emulation_prevention_bytes_;
-    // Need another full three bytes before we can detect the sequence again.
-    prev_two_bytes_ = 0xffff;
+    // The skipped byte cannot be part of the next sequence.
+    FindNextEmulationPreventionByte(data_);
 
     if (bytes_left_ < 1)
       return false;
@@ -57,11 +74,22 @@ bool H26xBitReader::UpdateCurrByte() {
   --bytes_left_;
   num_remaining_bits_in_curr_byte_ = 8;
 
-  prev_two_bytes_ = (prev_two_bytes_ << 8) | curr_byte_;
-
   return true;
 }
 
+void H26xBitReader::FindNextEmulationPreventionByte(const uint8_t* start) {
+  const size_t size = std::min(static_cast<size_t>(data_ + bytes_left_ - start),
+                               kEmulationPreventionSearchWindow);
+  const size_t offset =
+      AnnexBScanner::FindEmulationPreventionSequence(start, size);
+  if (offset < size) {
+    next_emulation_prevention_byte_ = start + offset + 2;
+  } else {
+    next_emulation_prevention_byte_ = NULL;
+    search_end_ = start + size;
+  }
+}
+
 // Read |num_bits| (1 to 31 inclusive) from the stream and return them
 // in |out|, with first bit in the stream as MSB in |out| at position
 // (|num_bits| - 1).
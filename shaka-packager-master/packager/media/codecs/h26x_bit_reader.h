@@ -72,6 +72,13 @@ class H26xBitReader {
   // Return false on end of stream.
   bool UpdateCurrByte();
 
+  // Find the next emulation prevention byte in a window of the stream which
+  // starts at |start|, and store it in |next_emulation_prevention_byte_|.
+  // The search is limited to a window so that reading a few header bits does
+  // not scan a whole slice. If there is no emulation prevention byte in the
+  // window, |search_end_| is set to the end of the window.
+  void FindNextEmulationPreventionByte(const uint8_t* start);
+
   // Pointer to the next unread (not in curr_byte_) byte in the stream.
   const uint8_t* data_;
 
@@ -85,9 +92,12 @@ class H26xBitReader {
   // Number of bits remaining in curr_byte_
   int num_remaining_bits_in_curr_byte_;
 
-  // Used in emulation prevention three byte detection (see spec).
-  // Initially set to 0xffff to accept all initial two-byte sequences.
-  int prev_two_bytes_;
+  // The next emulation prevention byte (the 0x03 in 0x000003, see spec) in
+  // the stream, or NULL if there is none before |search_end_|.
+  const uint8_t* next_emulation_prevention_byte_;
+
+  // The end of the bytes searched for emulation prevention bytes so far.
+  const uint8_t* search_end_;
 
   // Number of emulation preventation bytes (0x000003) we met.
   size_t emulation_prevention_bytes_;
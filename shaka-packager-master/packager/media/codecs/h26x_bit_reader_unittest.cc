@@ -4,6 +4,8 @@
 
 #include <gtest/gtest.h>
 
+#include <vector>
+
 #include "packager/media/codecs/h26x_bit_reader.h"
 
 namespace shaka {
@@ -112,5 +114,42 @@ TEST(H26xBitReaderTest, StopBitOccupyFullByte) {
   EXPECT_FALSE(reader.HasMoreRBSPData());
 }
 
+TEST(H26xBitReaderTest, EmulationPreventionBytesFarAhead) {
+  // The emulation prevention bytes are searched a window at a time. Moving the
+  // first sequence over a range of offsets places it across the end of a
+  // window. The second sequence is far beyond the first window.
+  const size_t kSize = 2000;
+  const size_t kMaxFirstSequenceOffset = 400;
+  const size_t kSecondSequenceOffset = 1500;
+  for (size_t first_offset = 0; first_offset < kMaxFirstSequenceOffset;
+       ++first_offset) {
+    std::vector<uint8_t> stream(kSize);
+    for (size_t i = 0; i < kSize; ++i)
+      stream[i] = static_cast<uint8_t>(i % 251 + 1);
+    for (size_t offset : {first_offset, kSecondSequenceOffset}) {
+      stream[offset] = 0x00;
+      stream[offset + 1] = 0x00;
+      stream[offset + 2] = 0x03;
+    }
+    std::vector<uint8_t> rbsp;
+    for (size_t i = 0; i < kSize; ++i) {
+      if (i != first_offset + 2 && i != kSecondSequenceOffset + 2)
+        rbsp.push_back(stream[i]);
+    }
+
+    H26xBitReader reader;
+    ASSERT_TRUE(reader.Initialize(stream.data(), stream.size()));
+    for (size_t i = 0; i < rbsp.size(); ++i) {
+      int value = 0;
+      ASSERT_TRUE(reader.ReadBits(8, &value));
+      ASSERT_EQ(rbsp[i], value) << "at " << i << " with the first sequence at "
+                                << first_offset;
+    }
+    EXPECT_EQ(2u, reader.NumEmulationPreventionBytesRead());
+    int dummy = 0;
+    EXPECT_FALSE(reader.ReadBits(1, &dummy));
+  }
+}
+
 }  // namespace media
 }  // namespace shaka
@@ -13,6 +13,7 @@
 #include "packager/media/base/buffer_reader.h"
 #include "packager/media/base/buffer_writer.h"
 #include "packager/media/base/macros.h"
+#include "packager/media/codecs/annexb_scanner.h"
 #include "packager/media/codecs/nalu_reader.h"
 
 namespace shaka {
@@ -61,38 +62,30 @@ void AddAccessUnitDelimiter(BufferWriter* buffer_writer) {
 void EscapeNalByteSequence(const uint8_t* input,
                            size_t input_size,
                            BufferWriter* output_writer) {
-  // Keep track of consecutive zeros that it has seen (not including the current
-  // byte), so that the algorithm doesn't need to go back to check the same
-  // bytes.
-  int consecutive_zero_count = 0;
-  for (size_t i = 0; i < input_size; ++i) {
-    if (consecutive_zero_count <= 1) {
-      output_writer->AppendInt(input[i]);
-    } else if (consecutive_zero_count == 2) {
-      if (input[i] == 0 || input[i] == 1 || input[i] == 2 || input[i] == 3) {
-        // Must be escaped.
-        output_writer->AppendInt(kEmulationPreventionByte);
-      }
-
-      output_writer->AppendInt(input[i]);
-      // Note that input[i] can be 0.
-      // 00 00 00 00 00 00 should become
-      // 00 00 03 00 00 03 00 00 03
-      // So consecutive_zero_count is reset here and incremented below if
-      // input[i] is 0.
-      consecutive_zero_count = 0;
-    }
-
-    consecutive_zero_count = input[i] == 0 ? consecutive_zero_count + 1 : 0;
+  // Every 0x00 0x00 X sequence with X <= 3 must be escaped by inserting an
+  // emulation prevention byte before X. The bytes in-between are copied as
+  // they are.
+  const uint8_t kMaxEscapedByte = 3;
+  size_t position = 0;
+  while (true) {
+    const size_t sequence_offset = AnnexBScanner::FindSequence(
+        input + position, input_size - position, 0, kMaxEscapedByte);
+    if (sequence_offset == input_size - position)
+      break;
+    // Copy up to and including the two zeros.
+    output_writer->AppendArray(input + position, sequence_offset + 2);
+    output_writer->AppendInt(kEmulationPreventionByte);
+    // Continue from X, which may start the next sequence if it is 0, e.g.
+    // 00 00 00 00 00 00 should become
+    // 00 00 03 00 00 03 00 00 03
+    position += sequence_offset + 2;
   }
+  output_writer->AppendArray(input + position, input_size - position);
 
   // ISO 14496-10 Section 7.4.1.1 mentions that if the last byte is 0 (which
   // only happens if RBSP has cabac_zero_word), 0x03 must be appended.
-  if (consecutive_zero_count > 0) {
-    DCHECK_GT(input_size, 0u);
-    DCHECK_EQ(input[input_size - 1], 0u);
+  if (input_size > 0 && input[input_size - 1] == 0)
     output_writer->AppendInt(kEmulationPreventionByte);
-  }
 }
 
 // This functions creates a new subsample entry (|clear_bytes|, |cipher_bytes|)
@@ -53,6 +53,13 @@ void AddSubsample(uint64_t clear_bytes,
     decrypt_config->AddSubsample(clear_bytes, cipher_bytes);
 }
 
+// Copies |size| clear bytes from |source| to |dest|. Nothing needs to be done
+// if the sample is encrypted in place.
+void CopyClearBytes(const uint8_t* source, size_t size, uint8_t* dest) {
+  if (source != dest)
+    memcpy(dest, source, size);
+}
+
 uint8_t GetNaluLengthSize(const StreamInfo& stream_info) {
   if (stream_info.stream_type() != kStreamVideo)
     return 0;
@@ -256,45 +263,61 @@ Status EncryptionHandler::ProcessMediaSample(
       crypt_byte_block_,
       skip_byte_block_));
 
-  // Now that we know that this sample must be encrypted, make a copy of
-  // the sample first so that all the encryption operations can be done
-  // in-place.
-  std::shared_ptr<MediaSample> cipher_sample(clear_sample->Clone());
-  // |cipher_sample| above still contains the old clear sample data. We will
-  // use |cipher_sample_data| to hold cipher sample data then transfer it to
-  // |cipher_sample| after encryption.
-  std::shared_ptr<uint8_t> cipher_sample_data(
-      new uint8_t[clear_sample->data_size()], std::default_delete<uint8_t[]>());
+  // Now that we know that this sample must be encrypted, encrypt it in place
+  // if nobody else holds the sample or its data, so the clear bytes do not
+  // need to be copied. Otherwise, e.g. if the sample is fanned out by a
+  // Replicator, make a copy of the sample first.
+  std::shared_ptr<MediaSample> cipher_sample;
+  uint8_t* cipher_sample_data = nullptr;
+  if (clear_sample.use_count() == 1) {
+    // Media samples are created non-const by the demuxers, so it is safe to
+    // modify the sample when we are the only owner.
+    cipher_sample = std::const_pointer_cast<MediaSample>(clear_sample);
+    cipher_sample_data = cipher_sample->writable_data();
+  }
+  // Holds the copy-on-write buffer, which is transferred to |cipher_sample|
+  // after encryption.
+  std::shared_ptr<uint8_t> cipher_sample_buffer;
+  if (!cipher_sample_data) {
+    cipher_sample = clear_sample->Clone();
+    cipher_sample_buffer.reset(new uint8_t[clear_sample->data_size()],
+                               std::default_delete<uint8_t[]>());
+    cipher_sample_data = cipher_sample_buffer.get();
+  }
 
   if (vpx_parser_) {
     if (!EncryptVpxFrame(vpx_frames, clear_sample->data(),
-                         clear_sample->data_size(),
-                         &cipher_sample_data.get()[0], decrypt_config.get())) {
+                         clear_sample->data_size(), cipher_sample_data,
+                         decrypt_config.get())) {
       return Status(error::ENCRYPTION_FAILURE, "Failed to encrypt VPX frame.");
     }
     DCHECK_EQ(decrypt_config->GetTotalSizeOfSubsamples(),
               clear_sample->data_size());
   } else if (header_parser_) {
     if (!EncryptNalFrame(clear_sample->data(), clear_sample->data_size(),
-                         &cipher_sample_data.get()[0], decrypt_config.get())) {
+                         cipher_sample_data, decrypt_config.get())) {
       return Status(error::ENCRYPTION_FAILURE, "Failed to encrypt NAL frame.");
     }
     DCHECK_EQ(decrypt_config->GetTotalSizeOfSubsamples(),
               clear_sample->data_size());
   } else {
-    memcpy(&cipher_sample_data.get()[0], clear_sample->data(),
-           std::min(clear_sample->data_size(), leading_clear_bytes_size_));
+    const size_t leading_clear_bytes =
+        std::min(clear_sample->data_size(), leading_clear_bytes_size_);
+    CopyClearBytes(clear_sample->data(), leading_clear_bytes,
+                   cipher_sample_data);
     if (clear_sample->data_size() > leading_clear_bytes_size_) {
       // The residual block is left unecrypted (copied without encryption). No
       // need to do special handling here.
       EncryptBytes(clear_sample->data() + leading_clear_bytes_size_,
                    clear_sample->data_size() - leading_clear_bytes_size_,
-                   &cipher_sample_data.get()[leading_clear_bytes_size_]);
+                   cipher_sample_data + leading_clear_bytes_size_);
     }
   }
 
-  cipher_sample->TransferData(std::move(cipher_sample_data),
-                              clear_sample->data_size());
+  if (cipher_sample_buffer) {
+    cipher_sample->TransferData(std::move(cipher_sample_buffer),
+                                clear_sample->data_size());
+  }
   // Finish initializing the sample before sending it downstream. We must
   // wait until now to finish the initialization as we will lose access to
   // |decrypt_config| once we set it.
@@ -470,7 +493,7 @@ bool EncryptionHandler::EncryptVpxFrame(
     cipher_bytes -= misalign_bytes;
 
     decrypt_config->AddSubsample(clear_bytes, cipher_bytes);
-    memcpy(dest, data, clear_bytes);
+    CopyClearBytes(data, clear_bytes, dest);
     if (cipher_bytes > 0)
       EncryptBytes(data + clear_bytes, cipher_bytes, dest + clear_bytes);
     data += frame.frame_size;
@@ -485,7 +508,7 @@ bool EncryptionHandler::EncryptVpxFrame(
     uint16_t clear_bytes = static_cast<uint16_t>(index_size);
     uint32_t cipher_bytes = 0;
     decrypt_config->AddSubsample(clear_bytes, cipher_bytes);
-    memcpy(dest, data, clear_bytes);
+    CopyClearBytes(data, clear_bytes, dest);
   }
   return true;
 }
@@ -539,7 +562,7 @@ bool EncryptionHandler::EncryptNalFrame(const uint8_t* source,
 
       accumulated_clear_bytes += nalu_length_size_ + current_clear_bytes;
       AddSubsample(accumulated_clear_bytes, cipher_bytes, decrypt_config);
-      memcpy(dest, source, accumulated_clear_bytes);
+      CopyClearBytes(source, accumulated_clear_bytes, dest);
       source += accumulated_clear_bytes;
       dest += accumulated_clear_bytes;
       accumulated_clear_bytes = 0;
@@ -558,7 +581,7 @@ bool EncryptionHandler::EncryptNalFrame(const uint8_t* source,
     return false;
   }
   AddSubsample(accumulated_clear_bytes, 0, decrypt_config);
-  memcpy(dest, source, accumulated_clear_bytes);
+  CopyClearBytes(source, accumulated_clear_bytes, dest);
   return true;
 }
 
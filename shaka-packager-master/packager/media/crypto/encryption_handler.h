@@ -42,20 +42,24 @@ class EncryptionHandler : public MediaHandler {
 
   // Processes |stream_info| and sets up stream specific variables.
   Status ProcessStreamInfo(const StreamInfo& stream_info);
-  // Processes media sample and encrypts it if needed.
+  // Processes media sample and encrypts it if needed. The sample is encrypted
+  // in place if |clear_sample| holds the only reference to the sample and its
+  // data; otherwise, the sample is copied on write.
   Status ProcessMediaSample(std::shared_ptr<const MediaSample> clear_sample);
 
   Status SetupProtectionPattern(StreamType stream_type);
   bool CreateEncryptor(const EncryptionKey& encryption_key);
   // Encrypt a VPx frame with size |source_size|. |dest| should have at least
-  // |source_size| bytes.
+  // |source_size| bytes. |dest| can be the same as |source| for in place
+  // encryption.
   bool EncryptVpxFrame(const std::vector<VPxFrameInfo>& vpx_frames,
                        const uint8_t* source,
                        size_t source_size,
                        uint8_t* dest,
                        DecryptConfig* decrypt_config);
   // Encrypt a NAL unit frame with size |source_size|. |dest| should have at
-  // least |source_size| bytes.
+  // least |source_size| bytes. |dest| can be the same as |source| for in
+  // place encryption.
   bool EncryptNalFrame(const uint8_t* source,
                        size_t source_size,
                        uint8_t* dest,
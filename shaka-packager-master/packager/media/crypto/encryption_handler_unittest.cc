@@ -644,6 +644,68 @@ TEST_P(EncryptionHandlerEncryptionTest, Encrypt) {
   EXPECT_EQ(expected, actual);
 }
 
+// Verify that a sample held only by the encryption handler is encrypted in
+// place, while a shared sample is copied on write and left untouched.
+TEST_P(EncryptionHandlerEncryptionTest, EncryptInPlaceUnlessShared) {
+  EncryptionParams encryption_params;
+  encryption_params.protection_scheme = protection_scheme_;
+  encryption_params.vp9_subsample_encryption = vp9_subsample_encryption_;
+  SetUpEncryptionHandler(encryption_params);
+
+  const EncryptionKey mock_encryption_key = GetMockEncryptionKey();
+  EXPECT_CALL(mock_key_source_, GetKey(_, _))
+      .WillOnce(
+          DoAll(SetArgPointee<1>(mock_encryption_key), Return(Status::OK)));
+
+  if (IsVideoCodec(codec_)) {
+    ASSERT_OK(Process(StreamData::FromStreamInfo(
+        kStreamIndex, GetVideoStreamInfo(kTimeScale, codec_))));
+  } else {
+    ASSERT_OK(Process(StreamData::FromStreamInfo(
+        kStreamIndex, GetAudioStreamInfo(kTimeScale, codec_))));
+  }
+  InjectCodecParser();
+
+  const std::vector<uint8_t> expected(kData, kData + kDataSize);
+
+  // Shared sample, e.g. fanned out by a Replicator.
+  std::shared_ptr<MediaSample> shared_sample =
+      GetMediaSample(0, kSampleDuration, kIsKeyFrame, kData, kDataSize);
+  ASSERT_OK(Process(StreamData::FromMediaSample(kStreamIndex, shared_sample)));
+  ASSERT_EQ(2u, GetOutputStreamDataVector().size());
+  const MediaSample* media_sample =
+      GetOutputStreamDataVector().back()->media_sample.get();
+  EXPECT_NE(shared_sample.get(), media_sample);
+  EXPECT_NE(shared_sample->data(), media_sample->data());
+  EXPECT_FALSE(shared_sample->is_encrypted());
+  EXPECT_EQ(expected,
+            std::vector<uint8_t>(shared_sample->data(),
+                                 shared_sample->data() + kDataSize));
+  std::vector<uint8_t> actual(media_sample->data(),
+                              media_sample->data() + media_sample->data_size());
+  ASSERT_TRUE(
+      Decrypt(*media_sample->decrypt_config(), actual.data(), actual.size()));
+  EXPECT_EQ(expected, actual);
+
+  // Sample not held by anyone else.
+  std::shared_ptr<MediaSample> sample = GetMediaSample(
+      kSampleDuration, kSampleDuration, kIsKeyFrame, kData, kDataSize);
+  const MediaSample* sample_ptr = sample.get();
+  const uint8_t* sample_data = sample->data();
+  ASSERT_OK(Process(
+      StreamData::FromMediaSample(kStreamIndex, std::move(sample))));
+  ASSERT_EQ(3u, GetOutputStreamDataVector().size());
+  media_sample = GetOutputStreamDataVector().back()->media_sample.get();
+  EXPECT_EQ(sample_ptr, media_sample);
+  EXPECT_EQ(sample_data, media_sample->data());
+  EXPECT_TRUE(media_sample->is_encrypted());
+  actual.assign(media_sample->data(),
+                media_sample->data() + media_sample->data_size());
+  ASSERT_TRUE(
+      Decrypt(*media_sample->decrypt_config(), actual.data(), actual.size()));
+  EXPECT_EQ(expected, actual);
+}
+
 // Verify that the data in short audio (less than leading clear bytes) is left
 // unencrypted.
 TEST_P(EncryptionHandlerEncryptionTest, SampleAesEncryptShortAudio) {
@@ -6,11 +6,22 @@
 
 #include "packager/media/demuxer/demuxer.h"
 
+#include <string.h>
+#if defined(OS_POSIX)
+#include <sys/stat.h>
+#endif
+
 #include <algorithm>
 
+#include <gflags/gflags.h>
+
 #include "packager/base/bind.h"
+#include "packager/base/files/file_path.h"
+#include "packager/base/files/file_util.h"
 #include "packager/base/logging.h"
 #include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/strings/string_util.h"
+#include "packager/base/time/time.h"
 #include "packager/file/file.h"
 #include "packager/media/base/decryptor_source.h"
 #include "packager/media/base/key_source.h"
@@ -23,10 +34,25 @@
 #include "packager/media/formats/webvtt/webvtt_media_parser.h"
 #include "packager/media/formats/wvm/wvm_media_parser.h"
 
+DEFINE_bool(mmap_inputs,
+            true,
+            "If set, local MP4 and WebM input files are memory mapped, and "
+            "their samples refer to the mapped data instead of having it "
+            "copied. Accessing a mapped file which gets truncated, e.g. on "
+            "network storage, raises SIGBUS instead of failing a read, so "
+            "unset it for such inputs. Files modified within the last few "
+            "seconds are never mapped, as they may still be written.");
+
 namespace {
 // 65KB, sufficient to determine the container and likely all init data.
 const size_t kInitBufSize = 0x10000;
 const size_t kBufSize = 0x200000;  // 2MB
+// Maximum number of samples read per step when the samples of an MP4 file are
+// read with positioned reads.
+const size_t kMaxSamplesPerRead = 64;
+// Files modified more recently than that may still be written, so they are not
+// memory mapped.
+const int64_t kMinUnmodifiedTimeForMmapInSeconds = 10;
 // Maximum number of allowed queued samples. If we are receiving a lot of
 // samples before seeing init_event, something is not right. The number
 // set here is arbitrary though.
@@ -72,6 +98,35 @@ bool GetStreamIndex(const std::string& stream_label, size_t* stream_index) {
 
 namespace shaka {
 namespace media {
+namespace {
+
+// Returns the path of |file_name| if it is a local file, or an empty string
+// otherwise.
+std::string GetLocalFileName(const std::string& file_name) {
+  if (base::StartsWith(file_name, kLocalFilePrefix,
+                       base::CompareCase::SENSITIVE)) {
+    return file_name.substr(strlen(kLocalFilePrefix));
+  }
+  if (file_name.find("://") != std::string::npos)
+    return std::string();
+  return file_name;
+}
+
+// Returns true if |local_file_name| is a regular file, whose data can be read
+// without waiting, unlike a pipe or a device.
+bool IsRegularFile(const std::string& local_file_name) {
+#if defined(OS_POSIX)
+  struct stat file_stat;
+  return stat(local_file_name.c_str(), &file_stat) == 0 &&
+         S_ISREG(file_stat.st_mode);
+#else
+  const base::FilePath file_path =
+      base::FilePath::FromUTF8Unsafe(local_file_name);
+  return base::PathExists(file_path) && !base::DirectoryExists(file_path);
+#endif
+}
+
+}  // namespace
 
 Demuxer::Demuxer(const std::string& file_name)
     : file_name_(file_name), buffer_(new uint8_t[kBufSize]) {}
@@ -86,12 +141,50 @@ void Demuxer::SetKeySource(std::unique_ptr<KeySource> key_source) {
 }
 
 Status Demuxer::Run() {
-  LOG(INFO) << "Demuxer::Run() on file '" << file_name_ << "'.";
-  Status status = InitializeParser();
+  Status status;
+  bool done = false;
+  while (!done)
+    status = RunStep(&done);
+  return status;
+}
+
+Status Demuxer::RunStep(bool* done) {
+  DCHECK(done);
+  *done = true;
+  if (!parser_initialized_) {
+    LOG(INFO) << "Demuxer::Run() on file '" << file_name_ << "'.";
+    Status status = InitializeParser();
+    if (!status.ok())
+      return status;
+    parser_initialized_ = true;
+    *done = false;
+    return Status::OK;
+  }
+  if (!outputs_verified_)
+    return PrepareStreams(done);
+  return ParseSamples(done);
+}
+
+bool Demuxer::MayBlock() const {
+  if (base::StartsWith(file_name_, kMemoryFilePrefix,
+                       base::CompareCase::SENSITIVE)) {
+    return false;
+  }
+  const std::string local_file_name = GetLocalFileName(file_name_);
+  return local_file_name.empty() || !IsRegularFile(local_file_name);
+}
+
+Status Demuxer::PrepareStreams(bool* done) {
   // ParserInitEvent callback is called after a few calls to Parse(), which sets
   // up the streams. Only after that, we can verify the outputs below.
-  while (!all_streams_ready_ && status.ok())
-    status.Update(Parse());
+  Status status;
+  if (!all_streams_ready_) {
+    status = Parse();
+    if (!all_streams_ready_ && status.ok()) {
+      *done = false;
+      return Status::OK;
+    }
+  }
   // If no output is defined, then return success after receiving all stream
   // info.
   if (all_streams_ready_ && output_handlers().empty())
@@ -109,12 +202,20 @@ Status Demuxer::Run() {
       return Status(error::INVALID_ARGUMENT, "Stream not available");
     }
   }
+  outputs_verified_ = true;
+  *done = false;
+  return Status::OK;
+}
 
-  while (!cancelled_ && status.ok())
-    status.Update(Parse());
-  if (cancelled_ && status.ok())
+Status Demuxer::ParseSamples(bool* done) {
+  if (cancelled_)
     return Status(error::CANCELLED, "Demuxer run cancelled");
 
+  Status status = Parse();
+  if (status.ok()) {
+    *done = false;
+    return Status::OK;
+  }
   if (status.error_code() == error::END_OF_STREAM) {
     for (size_t stream_index : stream_indexes_) {
       status = FlushDownstream(stream_index);
@@ -212,9 +313,25 @@ Status Demuxer::InitializeParser() {
                 base::Bind(&Demuxer::NewSampleEvent, base::Unretained(this)),
                 key_source_.get());
 
-  // Handle trailing 'moov'.
-  if (container_name_ == CONTAINER_MOV)
-    static_cast<mp4::MP4MediaParser*>(parser_.get())->LoadMoov(file_name_);
+  if (container_name_ == CONTAINER_MOV) {
+    mp4::MP4MediaParser* mp4_parser =
+        static_cast<mp4::MP4MediaParser*>(parser_.get());
+    // Map local files into memory, so samples can refer to the mapped data
+    // instead of having it copied.
+    if (OpenFileView(bytes_read))
+      mp4_parser->SetFileView(file_view_, file_view_size_);
+    // Read the samples of non-fragmented files with positioned reads, so
+    // memory use does not depend on how the tracks are interleaved.
+    mp4_parser->EnableRandomAccess(file_name_);
+    // Handle trailing 'moov'.
+    mp4_parser->LoadMoov(file_name_);
+  } else if (container_name_ == CONTAINER_WEBM) {
+    // Samples in SimpleBlocks refer to the mapped data as well.
+    if (OpenFileView(bytes_read)) {
+      static_cast<WebMMediaParser*>(parser_.get())
+          ->SetFileView(file_view_, file_view_size_);
+    }
+  }
   if (!parser_->Parse(buffer_.get(), bytes_read)) {
     return Status(error::PARSER_FAILURE,
                   "Cannot parse media file " + file_name_);
@@ -325,11 +442,89 @@ bool Demuxer::PushSample(uint32_t track_id,
   return status.ok();
 }
 
+bool Demuxer::OpenFileView(uint64_t position) {
+  if (!FLAGS_mmap_inputs)
+    return false;
+  // Only local files are memory mapped.
+  const std::string local_file_name = GetLocalFileName(file_name_);
+  if (local_file_name.empty())
+    return false;
+  base::File::Info file_info;
+  if (!base::GetFileInfo(base::FilePath::FromUTF8Unsafe(local_file_name),
+                         &file_info)) {
+    return false;
+  }
+  if (base::Time::Now() - file_info.last_modified <
+      base::TimeDelta::FromSeconds(kMinUnmodifiedTimeForMmapInSeconds)) {
+    VLOG(1) << "Not memory mapping file '" << local_file_name
+            << "', which may still be written.";
+    return false;
+  }
+
+  const std::string mmap_file_name = kMmapFilePrefix + local_file_name;
+  File* mmap_file = File::Open(mmap_file_name.c_str(), "r");
+  if (!mmap_file)
+    return false;
+  std::shared_ptr<const uint8_t> file_view;
+  uint64_t file_view_size = 0;
+  const bool view_available =
+      mmap_file->GetView(&file_view, &file_view_size) &&
+      position <= file_view_size;
+  // The view stays valid after the file is closed.
+  mmap_file->Close();
+  if (!view_available)
+    return false;
+
+  VLOG(1) << "Reading memory mapped file '" << local_file_name << "'.";
+  file_view_ = std::move(file_view);
+  file_view_size_ = file_view_size;
+  file_view_position_ = position;
+  return true;
+}
+
 Status Demuxer::Parse() {
   DCHECK(media_file_);
   DCHECK(parser_);
   DCHECK(buffer_);
 
+  if (container_name_ == CONTAINER_MOV) {
+    mp4::MP4MediaParser* mp4_parser =
+        static_cast<mp4::MP4MediaParser*>(parser_.get());
+    if (mp4_parser->IsReadingSamplesFromFile()) {
+      // The parser reads the samples itself. The rest of the file is not
+      // needed.
+      bool end_of_stream = false;
+      if (!mp4_parser->ReadSamples(kMaxSamplesPerRead, &end_of_stream)) {
+        return Status(error::PARSER_FAILURE,
+                      "Cannot parse media file " + file_name_);
+      }
+      if (!end_of_stream)
+        return Status::OK;
+      if (!parser_->Flush())
+        return Status(error::PARSER_FAILURE, "Failed to flush.");
+      return Status(error::END_OF_STREAM, "");
+    }
+  }
+
+  if (file_view_) {
+    // Parse the memory mapped file directly without reading it into
+    // |buffer_|.
+    DCHECK_LE(file_view_position_, file_view_size_);
+    const uint64_t bytes_to_parse =
+        std::min<uint64_t>(kBufSize, file_view_size_ - file_view_position_);
+    if (bytes_to_parse == 0) {
+      if (!parser_->Flush())
+        return Status(error::PARSER_FAILURE, "Failed to flush.");
+      return Status(error::END_OF_STREAM, "");
+    }
+    const uint8_t* data = file_view_.get() + file_view_position_;
+    file_view_position_ += bytes_to_parse;
+    return parser_->Parse(data, static_cast<int>(bytes_to_parse))
+               ? Status::OK
+               : Status(error::PARSER_FAILURE,
+                        "Cannot parse media file " + file_name_);
+  }
+
   int64_t bytes_read = media_file_->Read(buffer_.get(), kBufSize);
   if (bytes_read == 0) {
     if (!parser_->Flush())
@@ -24,6 +24,7 @@
         '../formats/webvtt/webvtt.gyp:webvtt',
         '../formats/wvm/wvm.gyp:wvm',
         '../origin/origin.gyp:origin',
+        '../../third_party/gflags/gflags.gyp:gflags',
       ],
     },
     {
@@ -48,6 +48,14 @@ class Demuxer : public OriginHandler {
   /// the Data to Muxer until Eof.
   Status Run() override;
 
+  /// Run one step of the remuxing, i.e. parser initialization or a single read
+  /// from the file. See OriginHandler::RunStep.
+  Status RunStep(bool* done) override;
+
+  /// Reads from network inputs and pipes may wait for data. See
+  /// OriginHandler::MayBlock.
+  bool MayBlock() const override;
+
   /// Cancel a demuxing job in progress. Will cause @a Run to exit with an error
   /// status of type CANCELLED.
   void Cancel() override;
@@ -120,9 +128,20 @@ class Demuxer : public OriginHandler {
 
   // Read from the source and send it to the parser.
   Status Parse();
+  // Memory map the local media file, to be parsed from |position| on instead
+  // of reading |media_file_|. Returns false if the file cannot be mapped, or
+  // should not be (see --mmap_inputs).
+  bool OpenFileView(uint64_t position);
+  // Parse until all the streams are ready, then verify the outputs.
+  Status PrepareStreams(bool* done);
+  // Parse the rest of the file and flush the outputs at the end.
+  Status ParseSamples(bool* done);
 
   std::string file_name_;
   File* media_file_ = nullptr;
+  // Progress of the remuxing, which is driven by RunStep().
+  bool parser_initialized_ = false;
+  bool outputs_verified_ = false;
   // A stream is considered ready after receiving the stream info.
   bool all_streams_ready_ = false;
   // Queued samples received in NewSampleEvent() before ParserInitEvent().
@@ -137,6 +156,11 @@ class Demuxer : public OriginHandler {
   std::map<size_t, std::string> language_overrides_;
   MediaContainerName container_name_ = CONTAINER_UNKNOWN;
   std::unique_ptr<uint8_t[]> buffer_;
+  // The memory mapped media file, if available, and the position of the next
+  // byte to parse in it.
+  std::shared_ptr<const uint8_t> file_view_;
+  uint64_t file_view_size_ = 0;
+  uint64_t file_view_position_ = 0;
   std::unique_ptr<KeySource> key_source_;
   bool cancelled_ = false;
   // Whether to dump stream info when it is received.
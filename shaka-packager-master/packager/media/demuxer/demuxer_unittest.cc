@@ -72,6 +72,33 @@ TEST_F(DemuxerTest, EncryptedContentWithKeySource) {
   EXPECT_OK(demuxer.Run());
 }
 
+TEST_F(DemuxerTest, RunStepUntilCancelled) {
+  Demuxer demuxer(GetTestDataFilePath("bear-640x360.mp4").AsUTF8Unsafe());
+  demuxer.Cancel();
+  ASSERT_OK(demuxer.SetHandler("video", some_handler()));
+
+  // Parser initialization and stream preparation are not cancellable. The
+  // streams are ready right after parser initialization in this file.
+  bool done = false;
+  ASSERT_OK(demuxer.RunStep(&done));
+  EXPECT_FALSE(done);
+  ASSERT_OK(demuxer.RunStep(&done));
+  EXPECT_FALSE(done);
+  EXPECT_EQ(error::CANCELLED, demuxer.RunStep(&done).error_code());
+  EXPECT_TRUE(done);
+}
+
+TEST_F(DemuxerTest, MayBlock) {
+  const std::string local_file_name =
+      GetTestDataFilePath("bear-640x360.mp4").AsUTF8Unsafe();
+  EXPECT_FALSE(Demuxer(local_file_name).MayBlock());
+  EXPECT_FALSE(Demuxer("file://" + local_file_name).MayBlock());
+  EXPECT_FALSE(Demuxer("memory://file.mp4").MayBlock());
+  EXPECT_TRUE(Demuxer("udp://224.1.1.1:5000").MayBlock());
+  // Not a regular file.
+  EXPECT_TRUE(Demuxer(GetTestDataFilePath("").AsUTF8Unsafe()).MayBlock());
+}
+
 // TODO(kqyang): Add more tests.
 
 }  // namespace media
@@ -86,5 +86,20 @@
         'mp2t',
       ]
     },
+    {
+      'target_name': 'mp2t_perftest',
+      'type': '<(gtest_target_type)',
+      'sources': [
+        'mp2t_media_parser_perftest.cc',
+        'ts_writer_perftest.cc',
+      ],
+      'dependencies': [
+        '../../../testing/gtest.gyp:gtest',
+        '../../../testing/perf/perf_test.gyp:perf_test',
+        '../../test/media_test.gyp:media_test_support',
+        '../../test/media_test.gyp:perf_counters',
+        'mp2t',
+      ],
+    },
   ],
 }
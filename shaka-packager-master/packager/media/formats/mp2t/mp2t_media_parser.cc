@@ -4,7 +4,9 @@
 
 #include "packager/media/formats/mp2t/mp2t_media_parser.h"
 
+#include <algorithm>
 #include <memory>
+
 #include "packager/base/bind.h"
 #include "packager/media/base/media_sample.h"
 #include "packager/media/base/stream_info.h"
@@ -54,6 +56,12 @@ class PidState {
 
   PidType pid_type() const { return pid_type_; }
 
+  // Number of gaps in the continuity counters of the TS packets, each of
+  // which reveals lost TS packets.
+  int64_t num_continuity_counter_gaps() const {
+    return num_continuity_counter_gaps_;
+  }
+
   std::shared_ptr<StreamInfo>& config() { return config_; }
   void set_config(const std::shared_ptr<StreamInfo>& config) {
     config_ = config;
@@ -70,6 +78,7 @@ class PidState {
 
   bool enable_;
   int continuity_counter_;
+  int64_t num_continuity_counter_gaps_;
   std::shared_ptr<StreamInfo> config_;
   SampleQueue sample_queue_;
 };
@@ -81,7 +90,8 @@ PidState::PidState(int pid,
       pid_type_(pid_type),
       section_parser_(std::move(section_parser)),
       enable_(false),
-      continuity_counter_(-1) {
+      continuity_counter_(-1),
+      num_continuity_counter_gaps_(0) {
   DCHECK(section_parser_);
 }
 
@@ -93,13 +103,27 @@ bool PidState::PushTsPacket(const TsPacket& ts_packet) {
   if (!enable_)
     return true;
 
-  int expected_continuity_counter = (continuity_counter_ + 1) % 16;
-  if (continuity_counter_ >= 0 &&
-      ts_packet.continuity_counter() != expected_continuity_counter) {
-    DVLOG(1) << "TS discontinuity detected for pid: " << pid_;
-    // TODO(tinskip): Handle discontinuity better.
-    return false;
+  // The continuity counter is only incremented by the TS packets carrying a
+  // payload, and a TS packet may be sent twice in a row. It may also be
+  // discontinuous where the discontinuity indicator is set.
+  if (continuity_counter_ >= 0 && !ts_packet.discontinuity_indicator()) {
+    const int expected_continuity_counter =
+        ts_packet.has_payload() ? (continuity_counter_ + 1) % 16
+                                : continuity_counter_;
+    if (ts_packet.has_payload() &&
+        ts_packet.continuity_counter() == continuity_counter_) {
+      DVLOG(1) << "Duplicate TS packet for pid: " << pid_;
+      return true;
+    }
+    if (ts_packet.continuity_counter() != expected_continuity_counter) {
+      DVLOG(1) << "TS discontinuity detected for pid: " << pid_;
+      ++num_continuity_counter_gaps_;
+      // The section being received misses data, e.g. a UDP datagram was
+      // lost. Drop it rather than parsing corrupted data.
+      section_parser_->Resync();
+    }
   }
+  continuity_counter_ = ts_packet.continuity_counter();
 
   bool status = section_parser_->Parse(
       ts_packet.payload_unit_start_indicator(),
@@ -144,6 +168,7 @@ void PidState::ResetState() {
 
 Mp2tMediaParser::Mp2tMediaParser()
     : sbr_in_mimetype_(false),
+      pids_(TsSection::kPidMax + 1),
       is_initialized_(false) {
 }
 
@@ -166,13 +191,19 @@ bool Mp2tMediaParser::Flush() {
   DVLOG(1) << "Mp2tMediaParser::Flush";
 
   // Flush the buffers and reset the pids.
-  for (const auto& pair : pids_) {
-    DVLOG(1) << "Flushing PID: " << pair.first;
-    PidState* pid_state = pair.second.get();
+  for (int pid : registered_pids_) {
+    DVLOG(1) << "Flushing PID: " << pid;
+    PidState* pid_state = pids_[pid].get();
+    LOG_IF(WARNING, pid_state->num_continuity_counter_gaps() > 0)
+        << "Detected " << pid_state->num_continuity_counter_gaps()
+        << " gaps in the continuity counters of PID " << pid
+        << ", i.e. lost TS packets.";
     pid_state->Flush();
   }
   bool result = EmitRemainingSamples();
-  pids_.clear();
+  for (int pid : registered_pids_)
+    pids_[pid].reset();
+  registered_pids_.clear();
 
   // Remove any bytes left in the TS buffer.
   // (i.e. any partial TS packet => less than 188 bytes).
@@ -183,67 +214,125 @@ bool Mp2tMediaParser::Flush() {
 bool Mp2tMediaParser::Parse(const uint8_t* buf, int size) {
   DVLOG(1) << "Mp2tMediaParser::Parse size=" << size;
 
-  // Add the data to the parser state.
-  ts_byte_queue_.Push(buf, size);
-
-  while (true) {
+  // Complete the TS packet split across the previous call, if any, one
+  // packet worth of bytes at a time, so that the parsing switches back to
+  // the input buffer once the queue is drained.
+  while (size > 0) {
     const uint8_t* ts_buffer;
     int ts_buffer_size;
     ts_byte_queue_.Peek(&ts_buffer, &ts_buffer_size);
-    if (ts_buffer_size < TsPacket::kPacketSize)
+    if (ts_buffer_size == 0)
       break;
 
+    const int bytes_to_push =
+        std::min(size, TsPacket::kPacketSize -
+                           ts_buffer_size % TsPacket::kPacketSize);
+    ts_byte_queue_.Push(buf, bytes_to_push);
+    buf += bytes_to_push;
+    size -= bytes_to_push;
+
+    ts_byte_queue_.Peek(&ts_buffer, &ts_buffer_size);
+    int bytes_consumed = 0;
+    const bool status =
+        ParseTsPackets(ts_buffer, ts_buffer_size, &bytes_consumed);
+    ts_byte_queue_.Pop(bytes_consumed);
+    if (!status)
+      return false;
+  }
+
+  // Parse the TS packets in place in the input buffer. Only the bytes which
+  // do not hold a full TS packet are copied, to be parsed in the next call.
+  if (size > 0) {
+    int bytes_consumed = 0;
+    const bool status = ParseTsPackets(buf, size, &bytes_consumed);
+    if (bytes_consumed < size)
+      ts_byte_queue_.Push(buf + bytes_consumed, size - bytes_consumed);
+    if (!status)
+      return false;
+  }
+
+  // Emit the A/V buffers that kept accumulating during TS parsing.
+  return EmitRemainingSamples();
+}
+
+int64_t Mp2tMediaParser::GetNumContinuityCounterGaps(int pid) const {
+  const PidState* pid_state = GetPidState(pid);
+  return pid_state ? pid_state->num_continuity_counter_gaps() : 0;
+}
+
+bool Mp2tMediaParser::ParseTsPackets(const uint8_t* buf,
+                                     int size,
+                                     int* bytes_consumed) {
+  DCHECK(bytes_consumed);
+
+  TsPacket ts_packet;
+  int offset = 0;
+  while (size - offset >= TsPacket::kPacketSize) {
+    const uint8_t* ts_buffer = buf + offset;
+    const int ts_buffer_size = size - offset;
+
     // Synchronization.
     int skipped_bytes = TsPacket::Sync(ts_buffer, ts_buffer_size);
     if (skipped_bytes > 0) {
       DVLOG(1) << "Packet not aligned on a TS syncword:"
                << " skipped_bytes=" << skipped_bytes;
-      ts_byte_queue_.Pop(skipped_bytes);
+      offset += skipped_bytes;
       continue;
     }
 
     // Parse the TS header, skipping 1 byte if the header is invalid.
-    std::unique_ptr<TsPacket> ts_packet(
-        TsPacket::Parse(ts_buffer, ts_buffer_size));
-    if (!ts_packet) {
+    if (!ts_packet.Parse(ts_buffer, ts_buffer_size)) {
       DVLOG(1) << "Error: invalid TS packet";
-      ts_byte_queue_.Pop(1);
+      offset += 1;
       continue;
     }
     DVLOG(LOG_LEVEL_TS)
-        << "Processing PID=" << ts_packet->pid()
-        << " start_unit=" << ts_packet->payload_unit_start_indicator();
+        << "Processing PID=" << ts_packet.pid()
+        << " start_unit=" << ts_packet.payload_unit_start_indicator();
 
     // Parse the section.
-    std::map<int, std::unique_ptr<PidState>>::iterator it =
-        pids_.find(ts_packet->pid());
-    if (it == pids_.end() &&
-        ts_packet->pid() == TsSection::kPidPat) {
+    PidState* pid_state = pids_[ts_packet.pid()].get();
+    if (!pid_state && ts_packet.pid() == TsSection::kPidPat) {
       // Create the PAT state here if needed.
       std::unique_ptr<TsSection> pat_section_parser(new TsSectionPat(
           base::Bind(&Mp2tMediaParser::RegisterPmt, base::Unretained(this))));
       std::unique_ptr<PidState> pat_pid_state(new PidState(
-          ts_packet->pid(), PidState::kPidPat, std::move(pat_section_parser)));
+          ts_packet.pid(), PidState::kPidPat, std::move(pat_section_parser)));
       pat_pid_state->Enable();
-      it = pids_
-               .insert(std::pair<int, std::unique_ptr<PidState>>(
-                   ts_packet->pid(), std::move(pat_pid_state)))
-               .first;
+      pid_state = pat_pid_state.get();
+      AddPidState(ts_packet.pid(), std::move(pat_pid_state));
     }
 
-    if (it != pids_.end()) {
-      if (!it->second->PushTsPacket(*ts_packet))
+    if (pid_state) {
+      if (!pid_state->PushTsPacket(ts_packet)) {
+        *bytes_consumed = offset;
         return false;
+      }
     } else {
-      DVLOG(LOG_LEVEL_TS) << "Ignoring TS packet for pid: " << ts_packet->pid();
+      DVLOG(LOG_LEVEL_TS) << "Ignoring TS packet for pid: " << ts_packet.pid();
     }
 
     // Go to the next packet.
-    ts_byte_queue_.Pop(TsPacket::kPacketSize);
+    offset += TsPacket::kPacketSize;
   }
 
-  // Emit the A/V buffers that kept accumulating during TS parsing.
-  return EmitRemainingSamples();
+  *bytes_consumed = offset;
+  return true;
+}
+
+PidState* Mp2tMediaParser::GetPidState(int pid) const {
+  DCHECK_GE(pid, 0);
+  DCHECK_LE(pid, TsSection::kPidMax);
+  return pids_[pid].get();
+}
+
+void Mp2tMediaParser::AddPidState(int pid,
+                                  std::unique_ptr<PidState> pid_state) {
+  DCHECK(!GetPidState(pid));
+  pids_[pid] = std::move(pid_state);
+  registered_pids_.insert(
+      std::lower_bound(registered_pids_.begin(), registered_pids_.end(), pid),
+      pid);
 }
 
 void Mp2tMediaParser::RegisterPmt(int program_number, int pmt_pid) {
@@ -253,9 +342,9 @@ void Mp2tMediaParser::RegisterPmt(int program_number, int pmt_pid) {
 
   // Only one TS program is allowed. Ignore the incoming program map table,
   // if there is already one registered.
-  for (const auto& pair : pids_) {
-    if (pair.second->pid_type() == PidState::kPidPmt) {
-      DVLOG_IF(1, pmt_pid != pair.first) << "More than one program is defined";
+  for (int pid : registered_pids_) {
+    if (pids_[pid]->pid_type() == PidState::kPidPmt) {
+      DVLOG_IF(1, pmt_pid != pid) << "More than one program is defined";
       return;
     }
   }
@@ -267,8 +356,7 @@ void Mp2tMediaParser::RegisterPmt(int program_number, int pmt_pid) {
   std::unique_ptr<PidState> pmt_pid_state(
       new PidState(pmt_pid, PidState::kPidPmt, std::move(pmt_section_parser)));
   pmt_pid_state->Enable();
-  pids_.insert(std::pair<int, std::unique_ptr<PidState>>(
-      pmt_pid, std::move(pmt_pid_state)));
+  AddPidState(pmt_pid, std::move(pmt_pid_state));
 }
 
 void Mp2tMediaParser::RegisterPes(int pmt_pid,
@@ -277,8 +365,7 @@ void Mp2tMediaParser::RegisterPes(int pmt_pid,
   DVLOG(1) << "RegisterPes:"
            << " pes_pid=" << pes_pid
            << " stream_type=" << std::hex << stream_type << std::dec;
-  std::map<int, std::unique_ptr<PidState>>::iterator it = pids_.find(pes_pid);
-  if (it != pids_.end())
+  if (GetPidState(pes_pid))
     return;
 
   // Create a stream parser corresponding to the stream type.
@@ -324,8 +411,7 @@ void Mp2tMediaParser::RegisterPes(int pmt_pid,
   std::unique_ptr<PidState> pes_pid_state(
       new PidState(pes_pid, pid_type, std::move(pes_section_parser)));
   pes_pid_state->Enable();
-  pids_.insert(std::pair<int, std::unique_ptr<PidState>>(
-      pes_pid, std::move(pes_pid_state)));
+  AddPidState(pes_pid, std::move(pes_pid_state));
 }
 
 void Mp2tMediaParser::OnNewStreamInfo(
@@ -333,15 +419,15 @@ void Mp2tMediaParser::OnNewStreamInfo(
   DCHECK(new_stream_info);
   DVLOG(1) << "OnVideoConfigChanged for pid=" << new_stream_info->track_id();
 
-  PidMap::iterator pid_state = pids_.find(new_stream_info->track_id());
-  if (pid_state == pids_.end()) {
+  PidState* pid_state = GetPidState(new_stream_info->track_id());
+  if (!pid_state) {
     LOG(ERROR) << "PID State for new stream not found (pid = "
                << new_stream_info->track_id() << ").";
     return;
   }
 
   // Set the stream configuration information for the PID.
-  pid_state->second->set_config(new_stream_info);
+  pid_state->set_config(new_stream_info);
 
   // Finish initialization if all streams have configs.
   FinishInitializationIfNeeded();
@@ -353,18 +439,18 @@ bool Mp2tMediaParser::FinishInitializationIfNeeded() {
     return true;
 
   // Wait for more data to come to finish initialization.
-  if (pids_.empty())
+  if (registered_pids_.empty())
     return true;
 
   std::vector<std::shared_ptr<StreamInfo>> all_stream_info;
   uint32_t num_es(0);
-  for (PidMap::const_iterator iter = pids_.begin(); iter != pids_.end();
-       ++iter) {
-    if (((iter->second->pid_type() == PidState::kPidAudioPes) ||
-         (iter->second->pid_type() == PidState::kPidVideoPes))) {
+  for (int pid : registered_pids_) {
+    PidState* pid_state = pids_[pid].get();
+    if (((pid_state->pid_type() == PidState::kPidAudioPes) ||
+         (pid_state->pid_type() == PidState::kPidVideoPes))) {
       ++num_es;
-      if (iter->second->config())
-        all_stream_info.push_back(iter->second->config());
+      if (pid_state->config())
+        all_stream_info.push_back(pid_state->config());
     }
   }
   if (num_es && (all_stream_info.size() == num_es)) {
@@ -393,13 +479,13 @@ void Mp2tMediaParser::OnEmitSample(
       << new_sample->pts();
 
   // Add the sample to the appropriate PID sample queue.
-  PidMap::iterator pid_state = pids_.find(pes_pid);
-  if (pid_state == pids_.end()) {
+  PidState* pid_state = GetPidState(pes_pid);
+  if (!pid_state) {
     LOG(ERROR) << "PID State for new sample not found (pid = "
                << pes_pid << ").";
     return;
   }
-  pid_state->second->sample_queue().push_back(new_sample);
+  pid_state->sample_queue().push_back(new_sample);
 }
 
 bool Mp2tMediaParser::EmitRemainingSamples() {
@@ -410,13 +496,12 @@ bool Mp2tMediaParser::EmitRemainingSamples() {
     return true;
 
   // Buffer emission.
-  for (PidMap::const_iterator pid_iter = pids_.begin(); pid_iter != pids_.end();
-       ++pid_iter) {
-    SampleQueue& sample_queue = pid_iter->second->sample_queue();
+  for (int pid : registered_pids_) {
+    SampleQueue& sample_queue = pids_[pid]->sample_queue();
     for (SampleQueue::iterator sample_iter = sample_queue.begin();
          sample_iter != sample_queue.end();
          ++sample_iter) {
-      if (!new_sample_cb_.Run(pid_iter->first, *sample_iter)) {
+      if (!new_sample_cb_.Run(pid, *sample_iter)) {
         // Error processing sample. Propagate error condition.
         return false;
       }
@@ -8,6 +8,7 @@
 #include <deque>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "packager/media/base/byte_queue.h"
 #include "packager/media/base/media_parser.h"
@@ -40,8 +41,23 @@ class Mp2tMediaParser : public MediaParser {
   bool Parse(const uint8_t* buf, int size) override WARN_UNUSED_RESULT;
   /// @}
 
+  /// @return the number of gaps in the continuity counters of the TS packets
+  ///         of @a pid since the last Flush(), each of which reveals lost TS
+  ///         packets, or 0 if @a pid is not registered.
+  int64_t GetNumContinuityCounterGaps(int pid) const;
+
  private:
-  typedef std::map<int, std::unique_ptr<PidState>> PidMap;
+  // Parse the TS packets in |buf| in place. |*bytes_consumed| is set to the
+  // number of bytes parsed or skipped to synchronize, the rest not holding a
+  // full TS packet.
+  // Return true if successful.
+  bool ParseTsPackets(const uint8_t* buf, int size, int* bytes_consumed);
+
+  // Return the state of |pid|, or NULL if |pid| is not registered.
+  PidState* GetPidState(int pid) const;
+
+  // Register |pid_state| for |pid|, which must not be registered already.
+  void AddPidState(int pid, std::unique_ptr<PidState> pid_state);
 
   // Callback invoked to register a Program Map Table.
   // Note: Does nothing if the PID is already registered.
@@ -78,11 +94,13 @@ class Mp2tMediaParser : public MediaParser {
 
   bool sbr_in_mimetype_;
 
-  // Bytes of the TS media.
+  // Bytes of the TS packet split across calls to Parse().
   ByteQueue ts_byte_queue_;
 
-  // List of PIDs and their states.
-  PidMap pids_;
+  // States of the PIDs indexed by PID, NULL if the PID is not registered.
+  std::vector<std::unique_ptr<PidState>> pids_;
+  // The registered PIDs, in increasing order.
+  std::vector<int> registered_pids_;
 
   // Whether |init_cb_| has been invoked.
   bool is_initialized_;
@@ -0,0 +1,99 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "packager/base/bind.h"
+#include "packager/base/time/time.h"
+#include "packager/media/base/media_sample.h"
+#include "packager/media/base/stream_info.h"
+#include "packager/media/formats/mp2t/mp2t_media_parser.h"
+#include "packager/media/test/perf_counters.h"
+#include "packager/media/test/test_data_util.h"
+#include "packager/testing/perf/perf_test.h"
+
+namespace shaka {
+namespace media {
+namespace mp2t {
+namespace {
+
+const char kFileName[] = "bear-640x360.ts";
+const int kNumIterations = 50;
+const int kTsPacketSize = 188;
+// The payload of a UDP datagram of a multicast feed: 7 TS packets.
+const size_t kDatagramSize = 7 * kTsPacketSize;
+// A typical read from a file, which does not end on a TS packet boundary.
+const size_t kFileReadSize = 64 * 1024;
+
+void OnInit(const std::vector<std::shared_ptr<StreamInfo>>& stream_infos) {}
+
+bool OnNewSample(int64_t* num_samples,
+                 uint32_t track_id,
+                 const std::shared_ptr<MediaSample>& sample) {
+  ++*num_samples;
+  return true;
+}
+
+}  // namespace
+
+// Measures the TS demuxing throughput of Mp2tMediaParser, from the TS packets
+// to the samples, and the heap allocations made per TS packet.
+class Mp2tMediaParserPerfTest : public testing::TestWithParam<size_t> {
+ protected:
+  void SetUp() override { data_ = ReadTestDataFile(kFileName); }
+
+  // Parses the file in chunks of |chunk_size| bytes. Returns the number of
+  // samples emitted.
+  int64_t Demux(size_t chunk_size) {
+    int64_t num_samples = 0;
+    Mp2tMediaParser parser;
+    parser.Init(base::Bind(&OnInit), base::Bind(&OnNewSample, &num_samples),
+                nullptr);
+    for (size_t offset = 0; offset < data_.size(); offset += chunk_size) {
+      const size_t size = std::min(chunk_size, data_.size() - offset);
+      EXPECT_TRUE(parser.Parse(data_.data() + offset, static_cast<int>(size)));
+    }
+    EXPECT_TRUE(parser.Flush());
+    return num_samples;
+  }
+
+  std::vector<uint8_t> data_;
+};
+
+TEST_P(Mp2tMediaParserPerfTest, DemuxThroughput) {
+  const size_t chunk_size = GetParam();
+  const std::string trace =
+      chunk_size == kDatagramSize ? "udp_datagrams" : "file_reads";
+  ASSERT_GT(Demux(chunk_size), 0);
+
+  const int64_t num_allocations_before = GetNumAllocations();
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumIterations; ++i)
+    Demux(chunk_size);
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  const int64_t num_allocations = GetNumAllocations() - num_allocations_before;
+  const double num_ts_packets =
+      static_cast<double>(data_.size() / kTsPacketSize) * kNumIterations;
+
+  perf_test::PrintResult("ts_demuxing", "", trace,
+                         num_ts_packets / elapsed.InSecondsF(),
+                         "packets_per_second", true);
+  perf_test::PrintResult("allocations_per_packet", "", trace,
+                         num_allocations / num_ts_packets, "allocations",
+                         true);
+}
+
+INSTANTIATE_TEST_CASE_P(ChunkSizes,
+                        Mp2tMediaParserPerfTest,
+                        testing::Values(kDatagramSize, kFileReadSize));
+
+}  // namespace mp2t
+}  // namespace media
+}  // namespace shaka
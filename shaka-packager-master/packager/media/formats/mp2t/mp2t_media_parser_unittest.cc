@@ -21,6 +21,30 @@
 namespace shaka {
 namespace media {
 namespace mp2t {
+namespace {
+
+const size_t kTsPacketSize = 188;
+// A TS packet in the middle of bear-640x360.ts.
+const size_t kTsPacketIndex = 1000;
+
+int GetPid(const uint8_t* ts_packet) {
+  return ((ts_packet[1] & 0x1f) << 8) | ts_packet[2];
+}
+
+bool IsPayloadUnitStart(const uint8_t* ts_packet) {
+  return (ts_packet[1] & 0x40) != 0;
+}
+
+// Returns the index of the first TS packet at or after |index| which
+// continues a payload unit.
+size_t FindPacketContinuingUnit(const std::vector<uint8_t>& buffer,
+                                size_t index) {
+  while (IsPayloadUnitStart(&buffer[index * kTsPacketSize]))
+    ++index;
+  return index;
+}
+
+}  // namespace
 
 class Mp2tMediaParserTest : public testing::Test {
  public:
@@ -149,6 +173,39 @@ TEST_F(Mp2tMediaParserTest, UnalignedAppend512_H265) {
   EXPECT_EQ(82, video_frame_count_);
 }
 
+TEST_F(Mp2tMediaParserTest, LostTsPacket) {
+  InitializeParser();
+  std::vector<uint8_t> buffer = ReadTestDataFile("bear-640x360.ts");
+  const size_t index = FindPacketContinuingUnit(buffer, kTsPacketIndex);
+  const int pid = GetPid(&buffer[index * kTsPacketSize]);
+  buffer.erase(buffer.begin() + index * kTsPacketSize,
+               buffer.begin() + (index + 1) * kTsPacketSize);
+
+  // The unit missing the TS packet is dropped, the rest is parsed.
+  EXPECT_TRUE(AppendDataInPieces(buffer.data(), buffer.size(), 512));
+  EXPECT_EQ(1, parser_->GetNumContinuityCounterGaps(pid));
+  EXPECT_TRUE(parser_->Flush());
+  EXPECT_GT(video_frame_count_, 0);
+}
+
+TEST_F(Mp2tMediaParserTest, DuplicateTsPacket) {
+  InitializeParser();
+  std::vector<uint8_t> buffer = ReadTestDataFile("bear-640x360.ts");
+  const size_t index = FindPacketContinuingUnit(buffer, kTsPacketIndex);
+  const int pid = GetPid(&buffer[index * kTsPacketSize]);
+  const std::vector<uint8_t> ts_packet(
+      buffer.begin() + index * kTsPacketSize,
+      buffer.begin() + (index + 1) * kTsPacketSize);
+  buffer.insert(buffer.begin() + index * kTsPacketSize, ts_packet.begin(),
+                ts_packet.end());
+
+  // The duplicate TS packet is ignored.
+  EXPECT_TRUE(AppendDataInPieces(buffer.data(), buffer.size(), 512));
+  EXPECT_EQ(0, parser_->GetNumContinuityCounterGaps(pid));
+  EXPECT_TRUE(parser_->Flush());
+  EXPECT_EQ(82, video_frame_count_);
+}
+
 TEST_F(Mp2tMediaParserTest, TimestampWrapAround) {
   // "bear-640x360.ts" has been transcoded from bear-640x360.mp4 by applying a
   // time offset of 95442s (close to 2^33 / 90000) which results in timestamps
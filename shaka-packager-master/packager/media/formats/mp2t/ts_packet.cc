@@ -4,7 +4,6 @@
 
 #include "packager/media/formats/mp2t/ts_packet.h"
 
-#include <memory>
 #include "packager/media/base/bit_reader.h"
 #include "packager/media/formats/mp2t/mp2t_common.h"
 
@@ -41,12 +40,11 @@ int TsPacket::Sync(const uint8_t* buf, int size) {
   return k;
 }
 
-// static
-TsPacket* TsPacket::Parse(const uint8_t* buf, int size) {
+bool TsPacket::Parse(const uint8_t* buf, int size) {
   if (size < kPacketSize) {
     DVLOG(1) << "Buffer does not hold one full TS packet:"
              << " buffer_size=" << size;
-    return NULL;
+    return false;
   }
 
   DCHECK_EQ(buf[0], kTsHeaderSyncword);
@@ -54,47 +52,43 @@ TsPacket* TsPacket::Parse(const uint8_t* buf, int size) {
     DVLOG(1) << "Not on a TS syncword:"
              << " buf[0]="
              << std::hex << static_cast<int>(buf[0]) << std::dec;
-    return NULL;
+    return false;
   }
 
-  std::unique_ptr<TsPacket> ts_packet(new TsPacket());
-  bool status = ts_packet->ParseHeader(buf);
-  if (!status) {
+  if (!ParseHeader(buf)) {
     DVLOG(1) << "Parsing header failed";
-    return NULL;
+    return false;
   }
-  return ts_packet.release();
+  return true;
 }
 
-TsPacket::TsPacket() {
-}
+TsPacket::TsPacket()
+    : payload_(nullptr),
+      payload_size_(0),
+      payload_unit_start_indicator_(false),
+      pid_(0),
+      continuity_counter_(0),
+      has_payload_(false),
+      discontinuity_indicator_(false),
+      random_access_indicator_(false) {}
 
 TsPacket::~TsPacket() {
 }
 
 bool TsPacket::ParseHeader(const uint8_t* buf) {
-  BitReader bit_reader(buf, kPacketSize);
-  payload_ = buf;
-  payload_size_ = kPacketSize;
-
-  // Read the TS header: 4 bytes.
-  int syncword;
-  int transport_error_indicator;
-  int payload_unit_start_indicator;
-  int transport_priority;
-  int transport_scrambling_control;
-  int adaptation_field_control;
-  RCHECK(bit_reader.ReadBits(8, &syncword));
-  RCHECK(bit_reader.ReadBits(1, &transport_error_indicator));
-  RCHECK(bit_reader.ReadBits(1, &payload_unit_start_indicator));
-  RCHECK(bit_reader.ReadBits(1, &transport_priority));
-  RCHECK(bit_reader.ReadBits(13, &pid_));
-  RCHECK(bit_reader.ReadBits(2, &transport_scrambling_control));
-  RCHECK(bit_reader.ReadBits(2, &adaptation_field_control));
-  RCHECK(bit_reader.ReadBits(4, &continuity_counter_));
-  payload_unit_start_indicator_ = (payload_unit_start_indicator != 0);
-  payload_ += 4;
-  payload_size_ -= 4;
+  // Read the TS header: 4 bytes. It is read directly as it is parsed for
+  // every packet, the syncword having been checked already:
+  //   syncword (8), transport_error_indicator (1),
+  //   payload_unit_start_indicator (1), transport_priority (1), pid (13),
+  //   transport_scrambling_control (2), adaptation_field_control (2),
+  //   continuity_counter (4).
+  payload_unit_start_indicator_ = (buf[1] & 0x40) != 0;
+  pid_ = ((buf[1] & 0x1f) << 8) | buf[2];
+  const int adaptation_field_control = (buf[3] >> 4) & 0x3;
+  continuity_counter_ = buf[3] & 0xf;
+  has_payload_ = (adaptation_field_control & 0x1) != 0;
+  payload_ = buf + 4;
+  payload_size_ = kPacketSize - 4;
 
   // Default values when no adaptation field.
   discontinuity_indicator_ = false;
@@ -105,8 +99,7 @@ bool TsPacket::ParseHeader(const uint8_t* buf) {
     return true;
 
   // Read the adaptation field if needed.
-  int adaptation_field_length;
-  RCHECK(bit_reader.ReadBits(8, &adaptation_field_length));
+  const int adaptation_field_length = payload_[0];
   DVLOG(LOG_LEVEL_TS) << "adaptation_field_length=" << adaptation_field_length;
   payload_ += 1;
   payload_size_ -= 1;
@@ -129,6 +122,7 @@ bool TsPacket::ParseHeader(const uint8_t* buf) {
   if (adaptation_field_length == 0)
     return true;
 
+  BitReader bit_reader(payload_, adaptation_field_length);
   bool status = ParseAdaptationField(&bit_reader, adaptation_field_length);
   payload_ += adaptation_field_length;
   payload_size_ -= adaptation_field_length;
@@ -24,19 +24,22 @@ class TsPacket {
   // to be synchronized on a TS syncword.
   static int Sync(const uint8_t* buf, int size);
 
-  // Parse a TS packet.
-  // Return a TsPacket only when parsing was successful.
-  // Return NULL otherwise.
-  static TsPacket* Parse(const uint8_t* buf, int size);
-
+  TsPacket();
   ~TsPacket();
 
+  // Parse a TS packet in place: the payload points into |buf|, which must
+  // outlive the use of the payload. The packet can be reused for the next
+  // TS packet.
+  // Return true only when parsing was successful.
+  bool Parse(const uint8_t* buf, int size);
+
   // TS header accessors.
   bool payload_unit_start_indicator() const {
     return payload_unit_start_indicator_;
   }
   int pid() const { return pid_; }
   int continuity_counter() const { return continuity_counter_; }
+  bool has_payload() const { return has_payload_; }
   bool discontinuity_indicator() const { return discontinuity_indicator_; }
   bool random_access_indicator() const { return random_access_indicator_; }
 
@@ -45,8 +48,6 @@ class TsPacket {
   int payload_size() const { return payload_size_; }
 
  private:
-  TsPacket();
-
   // Parse an Mpeg2 TS header.
   // The buffer size should be at least |kPacketSize|
   bool ParseHeader(const uint8_t* buf);
@@ -61,6 +62,7 @@ class TsPacket {
   bool payload_unit_start_indicator_;
   int pid_;
   int continuity_counter_;
+  bool has_payload_;
 
   // Params from the adaptation field.
   bool discontinuity_indicator_;
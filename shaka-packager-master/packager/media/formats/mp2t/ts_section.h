@@ -34,6 +34,11 @@ class TsSection {
 
   // Reset the state of the parser to its initial state.
   virtual void Reset() = 0;
+
+  // Discard the section being received, which misses data because TS packets
+  // were lost, and wait for the start of the next one. Unlike Reset(), the
+  // state spanning several sections is kept.
+  virtual void Resync() = 0;
 };
 
 }  // namespace mp2t
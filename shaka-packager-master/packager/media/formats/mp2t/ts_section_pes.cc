@@ -118,6 +118,18 @@ bool TsSectionPes::Parse(bool payload_unit_start_indicator,
 
     // Update the state.
     wait_for_pusi_ = false;
+
+    // A PES packet held entirely in the TS packet, e.g. an audio PES packet,
+    // is parsed in place without going through |pes_byte_queue_|.
+    if (parse_result && size >= 6) {
+      const int pes_packet_length =
+          (static_cast<int>(buf[4]) << 8) | (static_cast<int>(buf[5]));
+      if (pes_packet_length != 0 && size >= pes_packet_length + 6) {
+        parse_result = ParseInternal(buf, size);
+        ResetPesState();
+        return parse_result;
+      }
+    }
   }
 
   // Add the data to the parser state.
@@ -148,6 +160,10 @@ void TsSectionPes::Reset() {
   es_parser_->Reset();
 }
 
+void TsSectionPes::Resync() {
+  ResetPesState();
+}
+
 bool TsSectionPes::Emit(bool emit_for_unknown_size) {
   int raw_pes_size;
   const uint8_t* raw_pes;
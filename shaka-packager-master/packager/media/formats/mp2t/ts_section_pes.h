@@ -28,6 +28,7 @@ class TsSectionPes : public TsSection {
              int size) override;
   void Flush() override;
   void Reset() override;
+  void Resync() override;
 
  private:
   // Emit a reassembled PES packet.
@@ -27,6 +27,7 @@ class TsSectionPsi : public TsSection {
              int size) override;
   void Flush() override;
   void Reset() override;
+  void Resync() override;
 
   // Parse the content of the PSI section.
   virtual bool ParsePsiSection(BitReader* bit_reader) = 0;
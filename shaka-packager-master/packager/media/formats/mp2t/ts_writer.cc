@@ -56,6 +56,12 @@ const int kTsPacketMaximumPayloadSize =
 
 const size_t kMaxPesPacketLengthValue = 0xFFFF;
 
+// The TS packets of a segment are buffered and written to the file in chunks
+// of at least this size, about 188 KB. The chunks end at PES packet
+// boundaries, so their sizes and offsets are multiples of the TS packet size
+// but are not aligned to file system blocks.
+const size_t kSegmentBufferFlushSize = kTsPacketSize * 1024;
+
 void WritePatToBuffer(const uint8_t* pat,
                       int pat_size,
                       ContinuityCounter* continuity_counter,
@@ -87,9 +93,14 @@ void WritePtsOrDts(uint8_t leading_bits,
   writer->AppendInt(fifth_byte);
 }
 
-bool WritePesToFile(const PesPacket& pes,
-                    ContinuityCounter* continuity_counter,
-                    File* file) {
+// Packetizes |pes| into TS packets appended to |output|.
+// |first_ts_packet_buffer| holds the payload of the first TS packet, i.e. the
+// PES header and the start of the PES data. It is passed in so that it can be
+// reused across PES packets.
+void WritePesToBuffer(const PesPacket& pes,
+                      ContinuityCounter* continuity_counter,
+                      BufferWriter* first_ts_packet_buffer,
+                      BufferWriter* output) {
   // The size of the length field.
   const int kAdaptationFieldLengthSize = 1;
   // The size of the flags field.
@@ -98,68 +109,71 @@ bool WritePesToFile(const PesPacket& pes,
   const int kTsPacketMaxPayloadWithPcr =
       kTsPacketMaximumPayloadSize - kAdaptationFieldLengthSize -
       kAdaptationFieldHeaderSize - kPcrFieldSize;
+  // The size of the PES header fields before the PTS and DTS, after
+  // PES_packet_length.
+  const size_t kPesHeaderFlagsAndLengthSize = 3;
   const uint64_t pcr_base = pes.has_dts() ? pes.dts() : pes.pts();
   const int pid = ProgramMapTableWriter::kElementaryPid;
 
-  // This writer will hold part of PES packet after PES_packet_length field.
-  BufferWriter pes_header_writer;
+  uint8_t pes_header_data_length = 0;
+  if (pes.has_pts())
+    pes_header_data_length += 5;
+  if (pes.has_dts())
+    pes_header_data_length += 5;
+
+  // Put the first TS packet's payload into a buffer. This contains the PES
+  // packet's header.
+  first_ts_packet_buffer->Clear();
+  first_ts_packet_buffer->AppendNBytes(static_cast<uint64_t>(0x000001), 3);
+  first_ts_packet_buffer->AppendInt(pes.stream_id());
+  const size_t pes_packet_length = pes.data().size() +
+                                   kPesHeaderFlagsAndLengthSize +
+                                   pes_header_data_length;
+  first_ts_packet_buffer->AppendInt(static_cast<uint16_t>(
+      pes_packet_length > kMaxPesPacketLengthValue ? 0 : pes_packet_length));
+
   // The first bit must be '10' for PES with video or audio stream id. The other
   // flags (bits) don't matter so they are 0.
-  pes_header_writer.AppendInt(static_cast<uint8_t>(0x80));
-  pes_header_writer.AppendInt(
+  first_ts_packet_buffer->AppendInt(static_cast<uint8_t>(0x80));
+  first_ts_packet_buffer->AppendInt(
       static_cast<uint8_t>(static_cast<int>(pes.has_pts()) << 7 |
                            static_cast<int>(pes.has_dts()) << 6
                            // Other fields are all 0.
                            ));
-  uint8_t pes_header_data_length = 0;
-  if (pes.has_pts())
-    pes_header_data_length += 5;
-  if (pes.has_dts())
-    pes_header_data_length += 5;
-  pes_header_writer.AppendInt(pes_header_data_length);
+  first_ts_packet_buffer->AppendInt(pes_header_data_length);
 
   if (pes.has_pts() && pes.has_dts()) {
-    WritePtsOrDts(0x03, pes.pts(), &pes_header_writer);
-    WritePtsOrDts(0x01, pes.dts(), &pes_header_writer);
+    WritePtsOrDts(0x03, pes.pts(), first_ts_packet_buffer);
+    WritePtsOrDts(0x01, pes.dts(), first_ts_packet_buffer);
   } else if (pes.has_pts()) {
-    WritePtsOrDts(0x02, pes.pts(), &pes_header_writer);
+    WritePtsOrDts(0x02, pes.pts(), first_ts_packet_buffer);
   }
 
-  // Put the first TS packet's payload into a buffer. This contains the PES
-  // packet's header.
-  BufferWriter first_ts_packet_buffer(kTsPacketSize);
-  first_ts_packet_buffer.AppendNBytes(static_cast<uint64_t>(0x000001), 3);
-  first_ts_packet_buffer.AppendInt(pes.stream_id());
-  const size_t pes_packet_length = pes.data().size() + pes_header_writer.Size();
-  first_ts_packet_buffer.AppendInt(static_cast<uint16_t>(
-      pes_packet_length > kMaxPesPacketLengthValue ? 0 : pes_packet_length));
-  first_ts_packet_buffer.AppendBuffer(pes_header_writer);
-
   const size_t available_payload =
-      kTsPacketMaxPayloadWithPcr - first_ts_packet_buffer.Size();
+      kTsPacketMaxPayloadWithPcr - first_ts_packet_buffer->Size();
   const size_t bytes_consumed = std::min(pes.data().size(), available_payload);
-  first_ts_packet_buffer.AppendArray(pes.data().data(), bytes_consumed);
+  first_ts_packet_buffer->AppendArray(pes.data().data(), bytes_consumed);
 
-  BufferWriter output_writer;
-  WritePayloadToBufferWriter(first_ts_packet_buffer.Buffer(),
-                             first_ts_packet_buffer.Size(),
+  WritePayloadToBufferWriter(first_ts_packet_buffer->Buffer(),
+                             first_ts_packet_buffer->Size(),
                              kPayloadUnitStartIndicator, pid, kHasPcr, pcr_base,
-                             continuity_counter, &output_writer);
+                             continuity_counter, output);
 
   const size_t remaining_pes_data_size = pes.data().size() - bytes_consumed;
   if (remaining_pes_data_size > 0) {
     WritePayloadToBufferWriter(pes.data().data() + bytes_consumed,
                                remaining_pes_data_size,
                                !kPayloadUnitStartIndicator, pid, !kHasPcr, 0,
-                               continuity_counter, &output_writer);
+                               continuity_counter, output);
   }
-  return output_writer.WriteToFile(file).ok();
 }
 
 }  // namespace
 
 TsWriter::TsWriter(std::unique_ptr<ProgramMapTableWriter> pmt_writer)
-    : pmt_writer_(std::move(pmt_writer)) {}
+    : pmt_writer_(std::move(pmt_writer)),
+      first_ts_packet_buffer_(kTsPacketSize),
+      segment_buffer_(kSegmentBufferFlushSize * 2) {}
 
 TsWriter::~TsWriter() {}
 
@@ -174,23 +188,17 @@ bool TsWriter::NewSegment(const std::string& file_name) {
     return false;
   }
 
-  BufferWriter psi;
-  WritePatToBuffer(kPat, arraysize(kPat), &pat_continuity_counter_, &psi);
-  if (encrypted_) {
-    if (!pmt_writer_->EncryptedSegmentPmt(&psi)) {
-      return false;
-    }
-  } else {
-    if (!pmt_writer_->ClearSegmentPmt(&psi)) {
-      return false;
-    }
-  }
-
-  if (!psi.WriteToFile(current_file_.get()).ok()) {
-    LOG(ERROR) << "Failed to write PSI to file.";
+  // The PSI is written to the file with the first chunk of PES packets.
+  DCHECK_EQ(0u, segment_buffer_.Size());
+  WritePatToBuffer(kPat, arraysize(kPat), &pat_continuity_counter_,
+                   &segment_buffer_);
+  const bool pmt_written =
+      encrypted_ ? pmt_writer_->EncryptedSegmentPmt(&segment_buffer_)
+                 : pmt_writer_->ClearSegmentPmt(&segment_buffer_);
+  if (!pmt_written) {
+    segment_buffer_.Clear();
     return false;
   }
-
   return true;
 }
 
@@ -199,18 +207,22 @@ void TsWriter::SignalEncrypted() {
 }
 
 bool TsWriter::FinalizeSegment() {
-  return current_file_.release()->Close();
+  const bool flushed = FlushSegmentBuffer();
+  return current_file_.release()->Close() && flushed;
 }
 
 bool TsWriter::AddPesPacket(std::unique_ptr<PesPacket> pes_packet) {
   DCHECK(current_file_);
-  if (!WritePesToFile(*pes_packet, &elementary_stream_continuity_counter_,
-                      current_file_.get())) {
+  WritePesToBuffer(*pes_packet, &elementary_stream_continuity_counter_,
+                   &first_ts_packet_buffer_, &segment_buffer_);
+  // No need to keep pes_packet around so not passing it anywhere.
+
+  if (segment_buffer_.Size() < kSegmentBufferFlushSize)
+    return true;
+  if (!FlushSegmentBuffer()) {
     LOG(ERROR) << "Failed to write pes to file.";
     return false;
   }
-
-  // No need to keep pes_packet around so not passing it anywhere.
   return true;
 }
 
@@ -218,8 +230,25 @@ base::Optional<uint64_t> TsWriter::GetFilePosition() {
   if (!current_file_)
     return base::nullopt;
   uint64_t position;
-  return current_file_->Tell(&position) ? base::make_optional(position)
-                                        : base::nullopt;
+  if (!current_file_->Tell(&position))
+    return base::nullopt;
+  // Include the TS packets which are not written to the file yet.
+  return position + segment_buffer_.Size();
+}
+
+bool TsWriter::FlushSegmentBuffer() {
+  DCHECK(current_file_);
+  if (segment_buffer_.Size() == 0)
+    return true;
+  // The buffer always holds whole TS packets.
+  DCHECK_EQ(0u, segment_buffer_.Size() % kTsPacketSize);
+  Status status = segment_buffer_.WriteToFile(current_file_.get());
+  if (!status.ok()) {
+    LOG(ERROR) << "Failed to write TS packets to file: " << status;
+    segment_buffer_.Clear();
+    return false;
+  }
+  return true;
 }
 
 }  // namespace mp2t
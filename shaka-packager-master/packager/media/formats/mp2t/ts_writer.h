@@ -15,6 +15,7 @@
 #include "packager/base/optional.h"
 #include "packager/file/file.h"
 #include "packager/file/file_closer.h"
+#include "packager/media/base/buffer_writer.h"
 #include "packager/media/formats/mp2t/continuity_counter.h"
 
 namespace shaka {
@@ -26,6 +27,8 @@ class ProgramMapTableWriter;
 
 /// This class takes PesPackets, encapsulates them into TS packets, and write
 /// the data to file. This also creates PSI from StreamInfo.
+/// The TS packets of a segment are buffered and written to the file in large
+/// chunks, instead of once per PesPacket.
 class TsWriter {
  public:
   explicit TsWriter(std::unique_ptr<ProgramMapTableWriter> pmt_writer);
@@ -51,13 +54,17 @@ class TsWriter {
   /// @return true on success, false otherwise.
   virtual bool AddPesPacket(std::unique_ptr<PesPacket> pes_packet);
 
-  /// @return current file position on success, nullopt otherwise.
+  /// @return current file position on success, nullopt otherwise. The
+  ///         position includes the TS packets not written to the file yet.
   base::Optional<uint64_t> GetFilePosition();
 
  private:
   TsWriter(const TsWriter&) = delete;
   TsWriter& operator=(const TsWriter&) = delete;
 
+  // Writes |segment_buffer_| to |current_file_|.
+  bool FlushSegmentBuffer();
+
   // True if further segments generated by this instance should be encrypted.
   bool encrypted_ = false;
 
@@ -67,6 +74,12 @@ class TsWriter {
   std::unique_ptr<ProgramMapTableWriter> pmt_writer_;
 
   std::unique_ptr<File, FileCloser> current_file_;
+
+  // Reused for the payload of the first TS packet of each PesPacket.
+  BufferWriter first_ts_packet_buffer_;
+  // The TS packets of the current segment which are not written to
+  // |current_file_| yet. Reused across segments, so it rarely reallocates.
+  BufferWriter segment_buffer_;
 };
 
 }  // namespace mp2t
@@ -0,0 +1,87 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "packager/base/files/file_path.h"
+#include "packager/base/files/file_util.h"
+#include "packager/base/time/time.h"
+#include "packager/file/file.h"
+#include "packager/media/formats/mp2t/pes_packet.h"
+#include "packager/media/formats/mp2t/program_map_table_writer.h"
+#include "packager/media/formats/mp2t/ts_writer.h"
+#include "packager/testing/perf/perf_test.h"
+
+namespace shaka {
+namespace media {
+namespace mp2t {
+namespace {
+
+// Five seconds of a 40 Mbps stream at 30 frames per second per segment.
+const int kNumSegments = 10;
+const int kNumPesPacketsPerSegment = 150;
+const size_t kPesPacketSize = 40 * 1000 * 1000 / 8 / 30;
+const int64_t kFrameDuration = 3000;
+const int kTsPacketSize = 188;
+
+std::vector<std::unique_ptr<PesPacket>> CreatePesPackets(int64_t first_pts) {
+  const std::vector<uint8_t> data(kPesPacketSize, 0x23);
+  std::vector<std::unique_ptr<PesPacket>> pes_packets;
+  for (int i = 0; i < kNumPesPacketsPerSegment; ++i) {
+    std::unique_ptr<PesPacket> pes(new PesPacket());
+    pes->set_stream_id(0xE0);
+    pes->set_pts(first_pts + i * kFrameDuration);
+    pes->set_dts(first_pts + i * kFrameDuration);
+    *pes->mutable_data() = data;
+    pes_packets.push_back(std::move(pes));
+  }
+  return pes_packets;
+}
+
+}  // namespace
+
+// Measures the TS muxing throughput of TsWriter, which includes writing the
+// segments to a local file.
+TEST(TsWriterPerfTest, MuxingThroughput) {
+  base::FilePath file_path;
+  ASSERT_TRUE(base::CreateTemporaryFile(&file_path));
+  const std::string file_name =
+      std::string(kLocalFilePrefix) + file_path.AsUTF8Unsafe();
+
+  TsWriter ts_writer(std::unique_ptr<ProgramMapTableWriter>(
+      new VideoProgramMapTableWriter(kCodecH264)));
+  uint64_t num_ts_packets = 0;
+  base::TimeDelta elapsed;
+  for (int segment = 0; segment < kNumSegments; ++segment) {
+    // Created outside of the measurement, as the PesPackets are consumed.
+    std::vector<std::unique_ptr<PesPacket>> pes_packets = CreatePesPackets(
+        segment * kNumPesPacketsPerSegment * kFrameDuration);
+
+    ASSERT_TRUE(ts_writer.NewSegment(file_name));
+    const base::TimeTicks start = base::TimeTicks::Now();
+    for (std::unique_ptr<PesPacket>& pes : pes_packets)
+      ASSERT_TRUE(ts_writer.AddPesPacket(std::move(pes)));
+    const base::Optional<uint64_t> segment_size = ts_writer.GetFilePosition();
+    ASSERT_TRUE(ts_writer.FinalizeSegment());
+    elapsed += base::TimeTicks::Now() - start;
+
+    ASSERT_TRUE(segment_size);
+    num_ts_packets += segment_size.value() / kTsPacketSize;
+  }
+  base::DeleteFile(file_path, false);
+
+  perf_test::PrintResult("ts_muxing", "", "ts_writer",
+                         num_ts_packets / elapsed.InSecondsF(),
+                         "packets_per_second", true);
+}
+
+}  // namespace mp2t
+}  // namespace media
+}  // namespace shaka
@@ -419,6 +419,33 @@ TEST_F(TsWriterTest, BigPesPacket) {
   EXPECT_EQ(2, (content[4 * 188 + 3] & 0xF));
 }
 
+// Verify that the file position accounts for the TS packets that are buffered
+// but not written to the file yet.
+TEST_F(TsWriterTest, FilePositionIncludesBufferedPackets) {
+  TsWriter ts_writer(std::unique_ptr<ProgramMapTableWriter>(
+      new VideoProgramMapTableWriter(kCodecForTesting)));
+  EXPECT_TRUE(ts_writer.NewSegment(test_file_name_));
+  // PAT and PMT.
+  EXPECT_EQ(2u * 188, ts_writer.GetFilePosition().value());
+
+  const std::vector<uint8_t> big_data(400, 0x23);
+  const int kNumPesPackets = 3;
+  for (int i = 0; i < kNumPesPackets; ++i) {
+    std::unique_ptr<PesPacket> pes(new PesPacket());
+    pes->set_pts(i);
+    pes->set_dts(i);
+    *pes->mutable_data() = big_data;
+    EXPECT_TRUE(ts_writer.AddPesPacket(std::move(pes)));
+    // Three TS packets per PES packet. See BigPesPacket.
+    EXPECT_EQ((2u + 3u * (i + 1)) * 188, ts_writer.GetFilePosition().value());
+  }
+  ASSERT_TRUE(ts_writer.FinalizeSegment());
+
+  std::vector<uint8_t> content;
+  ASSERT_TRUE(ReadFileToVector(test_file_path_, &content));
+  EXPECT_EQ((2u + 3u * kNumPesPackets) * 188, content.size());
+}
+
 // Bug found in code review. It should check whether PTS is present not whether
 // PTS (implicilty) cast to bool is true.
 TEST_F(TsWriterTest, PesPtsZeroNoDts) {
@@ -0,0 +1,158 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/formats/mp4/index_sidecar.h"
+
+#include <string.h>
+
+#include "packager/base/files/file_path.h"
+#include "packager/base/files/file_util.h"
+#include "packager/base/strings/string_util.h"
+#include "packager/base/strings/stringprintf.h"
+#include "packager/file/file.h"
+#include "packager/media/base/buffer_reader.h"
+#include "packager/media/base/buffer_writer.h"
+#include "packager/media/formats/mp4/sample_index.h"
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+namespace {
+
+const uint32_t kSidecarMagic = 0x6d703469;  // 'mp4i'.
+// Increase when the format of the sidecar or of SampleIndex changes.
+const uint32_t kSidecarVersion = 1;
+const char kSidecarExtension[] = ".mp4index";
+
+// 64-bit FNV-1a, which is stable across runs and platforms.
+uint64_t HashPath(const std::string& path) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (char c : path) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+}  // namespace
+
+IndexSidecar::IndexSidecar(const std::string& sidecar_path,
+                           const std::string& media_file_path,
+                           uint64_t media_file_size,
+                           int64_t media_file_modification_time)
+    : sidecar_path_(sidecar_path),
+      media_file_path_(media_file_path),
+      media_file_size_(media_file_size),
+      media_file_modification_time_(media_file_modification_time) {}
+
+IndexSidecar::~IndexSidecar() {}
+
+// static
+std::unique_ptr<IndexSidecar> IndexSidecar::Create(
+    const std::string& directory,
+    const std::string& media_file_path) {
+  // Only local files have a modification time.
+  std::string local_file_path = media_file_path;
+  if (base::StartsWith(local_file_path, kLocalFilePrefix,
+                       base::CompareCase::SENSITIVE)) {
+    local_file_path = local_file_path.substr(strlen(kLocalFilePrefix));
+  } else if (local_file_path.find("://") != std::string::npos) {
+    return nullptr;
+  }
+
+  const base::FilePath file_path =
+      base::FilePath::FromUTF8Unsafe(local_file_path);
+  base::File::Info file_info;
+  if (!base::GetFileInfo(file_path, &file_info) || file_info.is_directory)
+    return nullptr;
+
+  // The hash keeps the sidecars of files with the same name apart.
+  const std::string sidecar_name = base::StringPrintf(
+      "%s-%016llx%s", file_path.BaseName().AsUTF8Unsafe().c_str(),
+      static_cast<unsigned long long>(HashPath(local_file_path)),
+      kSidecarExtension);
+  const std::string sidecar_path =
+      base::FilePath::FromUTF8Unsafe(directory)
+          .Append(base::FilePath::FromUTF8Unsafe(sidecar_name))
+          .AsUTF8Unsafe();
+  return std::unique_ptr<IndexSidecar>(new IndexSidecar(
+      sidecar_path, local_file_path, file_info.size,
+      file_info.last_modified.ToInternalValue()));
+}
+
+bool IndexSidecar::Load(uint64_t* moov_offset,
+                        uint64_t* moov_size,
+                        SampleIndex* sample_index) const {
+  DCHECK(moov_offset);
+  DCHECK(moov_size);
+  DCHECK(sample_index);
+
+  std::string content;
+  if (!File::ReadFileToString(sidecar_path_.c_str(), &content))
+    return false;
+
+  BufferReader reader(reinterpret_cast<const uint8_t*>(content.data()),
+                      content.size());
+  uint32_t magic = 0;
+  uint32_t version = 0;
+  uint32_t path_size = 0;
+  std::string media_file_path;
+  uint64_t media_file_size = 0;
+  int64_t media_file_modification_time = 0;
+  if (!reader.Read4(&magic) || magic != kSidecarMagic ||
+      !reader.Read4(&version) || version != kSidecarVersion ||
+      !reader.Read4(&path_size) ||
+      !reader.ReadToString(&media_file_path, path_size) ||
+      !reader.Read8(&media_file_size) ||
+      !reader.Read8s(&media_file_modification_time)) {
+    LOG(WARNING) << "Ignoring invalid index sidecar '" << sidecar_path_
+                 << "'.";
+    return false;
+  }
+  if (media_file_path != media_file_path_ ||
+      media_file_size != media_file_size_ ||
+      media_file_modification_time != media_file_modification_time_) {
+    VLOG(1) << "Ignoring stale index sidecar '" << sidecar_path_ << "'.";
+    return false;
+  }
+  if (!reader.Read8(moov_offset) || !reader.Read8(moov_size) ||
+      !sample_index->Read(&reader) || reader.HasBytes(1)) {
+    LOG(WARNING) << "Ignoring invalid index sidecar '" << sidecar_path_
+                 << "'.";
+    return false;
+  }
+  return true;
+}
+
+bool IndexSidecar::Save(uint64_t moov_offset,
+                        uint64_t moov_size,
+                        const SampleIndex& sample_index) const {
+  BufferWriter writer;
+  writer.AppendInt(kSidecarMagic);
+  writer.AppendInt(kSidecarVersion);
+  writer.AppendInt(static_cast<uint32_t>(media_file_path_.size()));
+  writer.AppendArray(reinterpret_cast<const uint8_t*>(media_file_path_.data()),
+                     media_file_path_.size());
+  writer.AppendInt(media_file_size_);
+  writer.AppendInt(media_file_modification_time_);
+  writer.AppendInt(moov_offset);
+  writer.AppendInt(moov_size);
+  sample_index.Write(&writer);
+
+  // Written atomically, so concurrent runs never read a partial sidecar.
+  const std::string content(reinterpret_cast<const char*>(writer.Buffer()),
+                            writer.Size());
+  if (!File::WriteFileAtomically(sidecar_path_.c_str(), content)) {
+    LOG(WARNING) << "Failed to write index sidecar '" << sidecar_path_
+                 << "'.";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,81 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_FORMATS_MP4_INDEX_SIDECAR_H_
+#define PACKAGER_MEDIA_FORMATS_MP4_INDEX_SIDECAR_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "packager/base/macros.h"
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+
+class SampleIndex;
+
+/// A sidecar file which caches the location of the 'moov' box and the
+/// SampleIndex of a non-fragmented MP4 file. Packaging the same file again
+/// then neither searches the file for 'moov' nor builds the index from the
+/// sample tables. The sidecar is only used if the path, size and modification
+/// time of the media file are the same as when it was written.
+class IndexSidecar {
+ public:
+  ~IndexSidecar();
+
+  /// Create the sidecar of a media file.
+  /// @param directory is the directory of the sidecar files.
+  /// @param media_file_path is the path of the media file.
+  /// @return The sidecar, or NULL if the size and modification time of the
+  ///         media file are not available, e.g. if it is not a local file.
+  static std::unique_ptr<IndexSidecar> Create(
+      const std::string& directory,
+      const std::string& media_file_path);
+
+  /// Load the sidecar file.
+  /// @param moov_offset is set to the file offset of the 'moov' box.
+  /// @param moov_size is set to the size of the 'moov' box.
+  /// @param sample_index is restored from the sidecar file.
+  /// @return true if the sidecar file exists and matches the media file,
+  ///         false otherwise.
+  bool Load(uint64_t* moov_offset,
+            uint64_t* moov_size,
+            SampleIndex* sample_index) const;
+
+  /// Save the sidecar file, replacing any previous one.
+  /// @param moov_offset is the file offset of the 'moov' box.
+  /// @param moov_size is the size of the 'moov' box.
+  /// @param sample_index is the index to save. It is not modified.
+  /// @return true on success, false otherwise.
+  bool Save(uint64_t moov_offset,
+            uint64_t moov_size,
+            const SampleIndex& sample_index) const;
+
+  /// @return The path of the sidecar file.
+  const std::string& sidecar_path() const { return sidecar_path_; }
+
+ private:
+  IndexSidecar(const std::string& sidecar_path,
+               const std::string& media_file_path,
+               uint64_t media_file_size,
+               int64_t media_file_modification_time);
+
+  const std::string sidecar_path_;
+  const std::string media_file_path_;
+  const uint64_t media_file_size_;
+  const int64_t media_file_modification_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(IndexSidecar);
+};
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_FORMATS_MP4_INDEX_SIDECAR_H_
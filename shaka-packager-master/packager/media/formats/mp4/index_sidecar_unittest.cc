@@ -0,0 +1,155 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/formats/mp4/index_sidecar.h"
+
+#include <gtest/gtest.h>
+
+#include "packager/base/files/file_path.h"
+#include "packager/base/files/file_util.h"
+#include "packager/file/file.h"
+#include "packager/media/formats/mp4/box_definitions.h"
+#include "packager/media/formats/mp4/sample_index.h"
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+
+namespace {
+
+const uint64_t kMoovOffset = 1000;
+const uint64_t kMoovSize = 500;
+const char kMediaFileContent[] = "media file";
+
+}  // namespace
+
+class IndexSidecarTest : public testing::Test {
+ public:
+  void SetUp() override {
+    ASSERT_TRUE(base::CreateNewTempDirectory(base::FilePath::StringType(),
+                                             &temp_dir_));
+    media_file_path_ =
+        temp_dir_.Append(base::FilePath::FromUTF8Unsafe("a.mp4"));
+    ASSERT_TRUE(WriteMediaFile(kMediaFileContent));
+
+    // A video track with three samples in one chunk.
+    Movie moov;
+    moov.tracks.resize(1);
+    Track& track = moov.tracks[0];
+    track.header.track_id = 1;
+    track.media.header.timescale = 30;
+    SampleTable& sample_table = track.media.information.sample_table;
+    sample_table.description.type = kVideo;
+    sample_table.description.video_entries.resize(1);
+    sample_table.decoding_time_to_sample.decoding_time.push_back({3, 1});
+    sample_table.sample_to_chunk.chunk_info.push_back({1, 3, 1});
+    sample_table.sample_size.sample_size = 0;
+    sample_table.sample_size.sample_count = 3;
+    sample_table.sample_size.sizes = {100, 20, 30};
+    sample_table.chunk_large_offset.offsets.push_back(2000);
+    sample_table.sync_sample.sample_number = {1};
+    ASSERT_TRUE(sample_index_.Init(moov));
+  }
+
+  void TearDown() override { base::DeleteFile(temp_dir_, true); }
+
+ protected:
+  bool WriteMediaFile(const std::string& content) {
+    return base::WriteFile(media_file_path_, content.data(),
+                           static_cast<int>(content.size())) ==
+           static_cast<int>(content.size());
+  }
+
+  std::unique_ptr<IndexSidecar> CreateSidecar() {
+    return IndexSidecar::Create(temp_dir_.AsUTF8Unsafe(),
+                                media_file_path_.AsUTF8Unsafe());
+  }
+
+  base::FilePath temp_dir_;
+  base::FilePath media_file_path_;
+  SampleIndex sample_index_;
+};
+
+TEST_F(IndexSidecarTest, SaveAndLoad) {
+  std::unique_ptr<IndexSidecar> sidecar = CreateSidecar();
+  ASSERT_TRUE(sidecar);
+  ASSERT_TRUE(sidecar->Save(kMoovOffset, kMoovSize, sample_index_));
+
+  uint64_t moov_offset = 0;
+  uint64_t moov_size = 0;
+  SampleIndex sample_index;
+  ASSERT_TRUE(CreateSidecar()->Load(&moov_offset, &moov_size, &sample_index));
+  EXPECT_EQ(kMoovOffset, moov_offset);
+  EXPECT_EQ(kMoovSize, moov_size);
+
+  ASSERT_EQ(sample_index_.NumSamples(), sample_index.NumSamples());
+  for (; sample_index_.IsValid(); sample_index_.Advance()) {
+    ASSERT_TRUE(sample_index.IsValid());
+    EXPECT_EQ(sample_index_.track_id(), sample_index.track_id());
+    EXPECT_EQ(sample_index_.offset(), sample_index.offset());
+    EXPECT_EQ(sample_index_.size(), sample_index.size());
+    EXPECT_EQ(sample_index_.dts(), sample_index.dts());
+    EXPECT_EQ(sample_index_.cts(), sample_index.cts());
+    EXPECT_EQ(sample_index_.duration(), sample_index.duration());
+    EXPECT_EQ(sample_index_.is_keyframe(), sample_index.is_keyframe());
+    sample_index.Advance();
+  }
+  EXPECT_FALSE(sample_index.IsValid());
+}
+
+TEST_F(IndexSidecarTest, LocalFilePrefix) {
+  std::unique_ptr<IndexSidecar> sidecar = CreateSidecar();
+  ASSERT_TRUE(sidecar);
+  std::unique_ptr<IndexSidecar> prefixed_sidecar = IndexSidecar::Create(
+      temp_dir_.AsUTF8Unsafe(),
+      std::string(kLocalFilePrefix) + media_file_path_.AsUTF8Unsafe());
+  ASSERT_TRUE(prefixed_sidecar);
+  EXPECT_EQ(sidecar->sidecar_path(), prefixed_sidecar->sidecar_path());
+}
+
+TEST_F(IndexSidecarTest, NoSidecarFile) {
+  uint64_t moov_offset = 0;
+  uint64_t moov_size = 0;
+  SampleIndex sample_index;
+  EXPECT_FALSE(CreateSidecar()->Load(&moov_offset, &moov_size, &sample_index));
+}
+
+TEST_F(IndexSidecarTest, MediaFileChanged) {
+  ASSERT_TRUE(CreateSidecar()->Save(kMoovOffset, kMoovSize, sample_index_));
+  ASSERT_TRUE(WriteMediaFile("changed media file"));
+
+  uint64_t moov_offset = 0;
+  uint64_t moov_size = 0;
+  SampleIndex sample_index;
+  EXPECT_FALSE(CreateSidecar()->Load(&moov_offset, &moov_size, &sample_index));
+}
+
+TEST_F(IndexSidecarTest, TruncatedSidecarFile) {
+  std::unique_ptr<IndexSidecar> sidecar = CreateSidecar();
+  ASSERT_TRUE(sidecar->Save(kMoovOffset, kMoovSize, sample_index_));
+  std::string content;
+  ASSERT_TRUE(
+      File::ReadFileToString(sidecar->sidecar_path().c_str(), &content));
+  content.resize(content.size() - 1);
+  ASSERT_TRUE(File::WriteFileAtomically(sidecar->sidecar_path().c_str(),
+                                        content));
+
+  uint64_t moov_offset = 0;
+  uint64_t moov_size = 0;
+  SampleIndex sample_index;
+  EXPECT_FALSE(sidecar->Load(&moov_offset, &moov_size, &sample_index));
+}
+
+TEST_F(IndexSidecarTest, NonLocalFile) {
+  EXPECT_FALSE(IndexSidecar::Create(temp_dir_.AsUTF8Unsafe(),
+                                    "udp://127.0.0.1:1234"));
+  EXPECT_FALSE(IndexSidecar::Create(temp_dir_.AsUTF8Unsafe(),
+                                    media_file_path_.AsUTF8Unsafe() + ".x"));
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
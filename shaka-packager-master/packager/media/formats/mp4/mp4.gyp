@@ -28,6 +28,8 @@
         'decoding_time_iterator.h',
         'fragmenter.cc',
         'fragmenter.h',
+        'index_sidecar.cc',
+        'index_sidecar.h',
         'key_frame_info.h',
         'mp4_media_parser.cc',
         'mp4_media_parser.h',
@@ -35,6 +37,8 @@
         'mp4_muxer.h',
         'multi_segment_segmenter.cc',
         'multi_segment_segmenter.h',
+        'sample_index.cc',
+        'sample_index.h',
         'segmenter.cc',
         'segmenter.h',
         'single_segment_segmenter.cc',
@@ -46,6 +50,7 @@
       ],
       'dependencies': [
         '../../../third_party/boringssl/boringssl.gyp:boringssl',
+        '../../../third_party/gflags/gflags.gyp:gflags',
         '../../base/media_base.gyp:media_base',
         '../../codecs/codecs.gyp:codecs',
         '../../event/media_event.gyp:media_event',
@@ -60,7 +65,10 @@
         'chunk_info_iterator_unittest.cc',
         'composition_offset_iterator_unittest.cc',
         'decoding_time_iterator_unittest.cc',
+        'index_sidecar_unittest.cc',
         'mp4_media_parser_unittest.cc',
+        'sample_index_unittest.cc',
+        'single_segment_segmenter_unittest.cc',
         'sync_sample_iterator_unittest.cc',
         'track_run_iterator_unittest.cc',
       ],
@@ -68,6 +76,21 @@
         '../../../file/file.gyp:file',
         '../../../testing/gtest.gyp:gtest',
         '../../../testing/gmock.gyp:gmock',
+        '../../base/media_base.gyp:media_handler_test_base',
+        '../../event/media_event.gyp:mock_muxer_listener',
+        '../../test/media_test.gyp:media_test_support',
+        'mp4',
+      ]
+    },
+    {
+      'target_name': 'mp4_perftest',
+      'type': '<(gtest_target_type)',
+      'sources': [
+        'mp4_media_parser_perftest.cc',
+      ],
+      'dependencies': [
+        '../../../testing/gtest.gyp:gtest',
+        '../../../testing/perf/perf_test.gyp:perf_test',
         '../../test/media_test.gyp:media_test_support',
         'mp4',
       ]
@@ -4,6 +4,8 @@
 
 #include "packager/media/formats/mp4/mp4_media_parser.h"
 
+#include <gflags/gflags.h>
+
 #include <algorithm>
 #include <limits>
 
@@ -29,8 +31,16 @@
 #include "packager/media/codecs/vp_codec_configuration_record.h"
 #include "packager/media/formats/mp4/box_definitions.h"
 #include "packager/media/formats/mp4/box_reader.h"
+#include "packager/media/formats/mp4/index_sidecar.h"
+#include "packager/media/formats/mp4/sample_index.h"
 #include "packager/media/formats/mp4/track_run_iterator.h"
 
+DEFINE_string(mp4_index_sidecar_dir,
+              "",
+              "If set, the location of the 'moov' box and the sample index of "
+              "non-fragmented MP4 inputs are cached in sidecar files in this "
+              "directory, so packaging the same input again starts faster.");
+
 namespace shaka {
 namespace media {
 namespace mp4 {
@@ -127,6 +137,7 @@ void MP4MediaParser::Init(const InitCB& init_cb,
 void MP4MediaParser::Reset() {
   queue_.Reset();
   runs_.reset();
+  sample_index_.reset();
   moof_head_ = 0;
   mdat_tail_ = 0;
 }
@@ -143,6 +154,8 @@ bool MP4MediaParser::Parse(const uint8_t* buf, int size) {
 
   if (state_ == kError)
     return false;
+  if (state_ == kReadingSamplesFromFile)
+    return true;  // The samples are read with ReadSamples.
 
   queue_.Push(buf, size);
 
@@ -151,6 +164,10 @@ bool MP4MediaParser::Parse(const uint8_t* buf, int size) {
   do {
     if (state_ == kParsingBoxes) {
       result = ParseBox(&err);
+    } else if (state_ == kReadingSamplesFromFile) {
+      // The rest of the data is not needed.
+      queue_.Reset();
+      result = false;
     } else {
       DCHECK_EQ(kEmittingSamples, state_);
       result = EnqueueSample(&err);
@@ -172,11 +189,178 @@ bool MP4MediaParser::Parse(const uint8_t* buf, int size) {
   return true;
 }
 
+void MP4MediaParser::SetFileView(std::shared_ptr<const uint8_t> data,
+                                 uint64_t size) {
+  file_view_ = std::move(data);
+  file_view_size_ = size;
+}
+
+bool MP4MediaParser::EnableRandomAccess(const std::string& file_path) {
+  DCHECK_EQ(state_, kParsingBoxes);
+  std::unique_ptr<File, FileCloser> file(
+      File::OpenWithNoBuffering(file_path.c_str(), "r"));
+  if (!file) {
+    LOG(WARNING) << "Unable to open media file '" << file_path
+                 << "' for random access. Samples are read sequentially.";
+    return false;
+  }
+  if (!file->Seek(0)) {
+    VLOG(1) << "Filesystem does not support seeking on file '" << file_path
+            << "'. Samples are read sequentially.";
+    return false;
+  }
+  random_access_file_ = std::move(file);
+  random_access_file_position_ = 0;
+  if (!FLAGS_mp4_index_sidecar_dir.empty()) {
+    index_sidecar_ =
+        IndexSidecar::Create(FLAGS_mp4_index_sidecar_dir, file_path);
+  }
+  return true;
+}
+
+bool MP4MediaParser::ReadSamples(size_t max_samples, bool* end_of_stream) {
+  DCHECK_EQ(state_, kReadingSamplesFromFile);
+  DCHECK(sample_index_);
+  DCHECK(end_of_stream);
+
+  bool err = false;
+  for (size_t i = 0; i < max_samples && sample_index_->IsValid(); ++i) {
+    std::shared_ptr<MediaSample> stream_sample(
+        MediaSample::CreateEmptyMediaSample());
+    if (!ReadSampleData(stream_sample.get())) {
+      err = true;
+      break;
+    }
+    stream_sample->set_is_key_frame(sample_index_->is_keyframe());
+    stream_sample->set_dts(sample_index_->dts());
+    stream_sample->set_pts(sample_index_->cts());
+    stream_sample->set_duration(sample_index_->duration());
+
+    DVLOG(3) << "Pushing frame: "
+             << ", key=" << sample_index_->is_keyframe()
+             << ", dur=" << sample_index_->duration()
+             << ", dts=" << sample_index_->dts()
+             << ", cts=" << sample_index_->cts()
+             << ", size=" << sample_index_->size();
+
+    if (!new_sample_cb_.Run(sample_index_->track_id(), stream_sample)) {
+      LOG(ERROR) << "Failed to process the sample.";
+      err = true;
+      break;
+    }
+    sample_index_->Advance();
+  }
+
+  if (err) {
+    DLOG(ERROR) << "Error while reading MP4 samples";
+    moov_.reset();
+    Reset();
+    ChangeState(kError);
+    return false;
+  }
+  *end_of_stream = !sample_index_->IsValid();
+  return true;
+}
+
+bool MP4MediaParser::ReadSampleData(MediaSample* sample) {
+  const uint64_t offset = sample_index_->offset();
+  const size_t size = sample_index_->size();
+  if (file_view_ && offset + size <= file_view_size_) {
+    SetSampleData(offset, file_view_.get() + offset, size, sample);
+    return true;
+  }
+
+  if (offset != random_access_file_position_) {
+    if (!random_access_file_->Seek(offset)) {
+      LOG(ERROR) << "Cannot seek to sample at offset " << offset;
+      return false;
+    }
+    random_access_file_position_ = offset;
+  }
+  std::shared_ptr<uint8_t> data(new uint8_t[size],
+                                std::default_delete<uint8_t[]>());
+  size_t bytes_read = 0;
+  while (bytes_read < size) {
+    const int64_t result =
+        random_access_file_->Read(data.get() + bytes_read, size - bytes_read);
+    if (result <= 0) {
+      LOG(ERROR) << "Cannot read sample of size " << size << " at offset "
+                 << offset;
+      // The position is unknown after a failed read.
+      random_access_file_position_ = std::numeric_limits<uint64_t>::max();
+      return false;
+    }
+    bytes_read += result;
+  }
+  random_access_file_position_ += size;
+  sample->TransferData(std::move(data), size);
+  return true;
+}
+
+bool MP4MediaParser::LoadMoovFromSidecar() {
+  DCHECK(index_sidecar_);
+  DCHECK(random_access_file_);
+
+  uint64_t moov_offset = 0;
+  uint64_t moov_size = 0;
+  std::unique_ptr<SampleIndex> sample_index(new SampleIndex);
+  if (!index_sidecar_->Load(&moov_offset, &moov_size, sample_index.get()))
+    return false;
+  if (moov_size > static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+    LOG(WARNING) << "Invalid 'moov' size " << moov_size << " in sidecar.";
+    return false;
+  }
+
+  std::vector<uint8_t> moov(moov_size);
+  // The position is unknown until the read succeeds.
+  random_access_file_position_ = std::numeric_limits<uint64_t>::max();
+  if (!random_access_file_->Seek(moov_offset)) {
+    LOG(ERROR) << "Cannot seek to 'moov' at offset " << moov_offset;
+    return false;
+  }
+  uint64_t bytes_read = 0;
+  while (bytes_read < moov_size) {
+    const int64_t result = random_access_file_->Read(
+        moov.data() + bytes_read, moov_size - bytes_read);
+    if (result <= 0) {
+      LOG(ERROR) << "Cannot read 'moov' at offset " << moov_offset;
+      return false;
+    }
+    bytes_read += result;
+  }
+  random_access_file_position_ = moov_offset + moov_size;
+
+  cached_sample_index_ = std::move(sample_index);
+  moov_offset_ = moov_offset;
+  if (!Parse(moov.data(), static_cast<int>(moov.size())))
+    return false;
+  cached_sample_index_.reset();
+  queue_.Reset();  // So that we don't need to adjust data offsets.
+  mdat_tail_ = 0;
+  if (state_ != kReadingSamplesFromFile) {
+    // The sidecar does not point to a complete 'moov' box.
+    moov_offset_ = -1;
+    return false;
+  }
+  return true;
+}
+
 bool MP4MediaParser::LoadMoov(const std::string& file_path) {
+  if (index_sidecar_) {
+    if (LoadMoovFromSidecar()) {
+      VLOG(1) << "Loaded 'moov' location and sample index from '"
+              << index_sidecar_->sidecar_path() << "'.";
+      return true;
+    }
+    if (state_ == kError)
+      return false;
+  }
+
   std::unique_ptr<File, FileCloser> file(
       File::OpenWithNoBuffering(file_path.c_str(), "r"));
   if (!file) {
-    LOG(ERROR) << "Unable to open media file '" << file_path << "'";
+    LOG(WARNING) << "Unable to open media file '" << file_path
+                 << "' for random access. Samples are read sequentially.";
     return false;
   }
   if (!file->Seek(0)) {
@@ -215,6 +399,7 @@ bool MP4MediaParser::LoadMoov(const std::string& file_path) {
         break;
       }
       // 'mdat' before 'moov'. Read and parse 'moov'.
+      moov_offset_ = file_position;
       if (!Parse(&buffer[0], bytes_read)) {
         LOG(ERROR) << "Error parsing mp4 file '" << file_path << "'";
         return false;
@@ -281,6 +466,8 @@ bool MP4MediaParser::ParseBox(bool* err) {
   mdat_tail_ = queue_.head() + reader->size();
 
   if (reader->type() == FOURCC_moov) {
+    if (moov_offset_ < 0)
+      moov_offset_ = queue_.head();
     *err = !ParseMoov(reader.get());
   } else if (reader->type() == FOURCC_moof) {
     moof_head_ = queue_.head();
@@ -623,6 +810,28 @@ bool MP4MediaParser::ParseMoov(BoxReader* reader) {
   init_cb_.Run(streams);
   if (!FetchKeysIfNecessary(moov_->pssh))
     return false;
+  if (random_access_file_) {
+    if (moov_->extends.tracks.empty()) {
+      // All the samples are described in 'moov'.
+      if (cached_sample_index_) {
+        sample_index_ = std::move(cached_sample_index_);
+      } else {
+        sample_index_.reset(new SampleIndex);
+        RCHECK(sample_index_->Init(*moov_));
+        if (index_sidecar_ && moov_offset_ >= 0) {
+          // Failing to save the sidecar only costs time on the next run.
+          index_sidecar_->Save(moov_offset_, reader->size(), *sample_index_);
+        }
+      }
+      ChangeState(kReadingSamplesFromFile);
+      return true;
+    }
+    // The samples of fragmented files are parsed from the data passed to
+    // Parse, so the file is not needed any more.
+    random_access_file_.reset();
+    index_sidecar_.reset();
+    cached_sample_index_.reset();
+  }
   runs_.reset(new TrackRunIterator(moov_.get()));
   RCHECK(runs_->Init());
   ChangeState(kEmittingSamples);
@@ -739,7 +948,8 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
     }
 
     if (!decryptor_source_) {
-      stream_sample->SetData(media_data, media_data_size);
+      SetSampleData(sample_offset, media_data, media_data_size,
+                    stream_sample.get());
       // If the demuxer does not have the decryptor_source_, store
       // decrypt_config so that the demuxed sample can be decrypted later.
       stream_sample->set_decrypt_config(std::move(decrypt_config));
@@ -756,7 +966,8 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
                                   media_data_size);
     }
   } else {
-    stream_sample->SetData(media_data, media_data_size);
+    SetSampleData(sample_offset, media_data, media_data_size,
+                  stream_sample.get());
   }
 
   stream_sample->set_dts(runs_->dts());
@@ -780,6 +991,21 @@ bool MP4MediaParser::EnqueueSample(bool* err) {
   return true;
 }
 
+void MP4MediaParser::SetSampleData(int64_t offset,
+                                   const uint8_t* buf,
+                                   size_t size,
+                                   MediaSample* sample) {
+  if (file_view_ && offset >= 0 &&
+      static_cast<uint64_t>(offset) + size <= file_view_size_) {
+    // Share the sample data with the view. It is kept alive by the sample.
+    sample->ShareData(
+        std::shared_ptr<const uint8_t>(file_view_, file_view_.get() + offset),
+        size);
+    return;
+  }
+  sample->SetData(buf, size);
+}
+
 bool MP4MediaParser::ReadAndDiscardMDATsUntil(const int64_t offset) {
   bool err = false;
   while (mdat_tail_ < offset) {
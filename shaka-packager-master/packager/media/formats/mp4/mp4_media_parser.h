@@ -14,6 +14,7 @@
 #include <vector>
 
 #include "packager/base/callback_forward.h"
+#include "packager/file/file_closer.h"
 #include "packager/media/base/decryptor_source.h"
 #include "packager/media/base/media_parser.h"
 #include "packager/media/base/offset_byte_queue.h"
@@ -23,6 +24,8 @@ namespace media {
 namespace mp4 {
 
 class BoxReader;
+class IndexSidecar;
+class SampleIndex;
 class TrackRunIterator;
 struct Movie;
 struct ProtectionSystemSpecificHeader;
@@ -49,14 +52,55 @@ class MP4MediaParser : public MediaParser {
   /// @return true if successful, false otherwise.
   bool LoadMoov(const std::string& file_path);
 
+  /// Provide a view of the whole media file in memory, e.g. a memory mapped
+  /// file, which must be the same data passed to Parse from offset 0. The
+  /// samples which are not decrypted by the parser then refer to the view
+  /// instead of having their data copied.
+  /// @param data points to the file contents.
+  /// @param size is the size of the file contents.
+  void SetFileView(std::shared_ptr<const uint8_t> data, uint64_t size);
+
+  /// Read the samples of non-fragmented files from @a file_path with
+  /// positioned reads, in decoding time order across the tracks, instead of
+  /// keeping the 'mdat' data passed to Parse until the samples can be
+  /// emitted. Memory use then does not depend on how the tracks are
+  /// interleaved in the file. The file is closed again if it turns out to be
+  /// fragmented. Must be called before LoadMoov and Parse.
+  /// If --mp4_index_sidecar_dir is set, the location of 'moov' and the
+  /// sample index are also cached in a sidecar file, which LoadMoov uses
+  /// when the same file is parsed again.
+  /// @param file_path is the path to the media file to be parsed.
+  /// @return true if the file supports seeking, false otherwise.
+  bool EnableRandomAccess(const std::string& file_path);
+
+  /// @return true if the 'moov' box has been parsed and the samples are read
+  ///         with ReadSamples. The rest of the file does not need to be
+  ///         passed to Parse then.
+  bool IsReadingSamplesFromFile() const {
+    return state_ == kReadingSamplesFromFile;
+  }
+
+  /// Read and emit the next samples. Only valid if
+  /// IsReadingSamplesFromFile().
+  /// @param max_samples is the maximum number of samples to emit.
+  /// @param end_of_stream is set to true after the last sample is emitted.
+  /// @return true if successful, false otherwise.
+  bool ReadSamples(size_t max_samples,
+                   bool* end_of_stream) WARN_UNUSED_RESULT;
+
  private:
   enum State {
     kWaitingForInit,
     kParsingBoxes,
     kEmittingSamples,
+    kReadingSamplesFromFile,
     kError
   };
 
+  // Parse the 'moov' box at the location cached in |index_sidecar_|, with the
+  // cached sample index. Returns false if the sidecar cannot be used.
+  bool LoadMoovFromSidecar();
+
   bool ParseBox(bool* err);
   bool ParseMoov(mp4::BoxReader* reader);
   bool ParseMoof(mp4::BoxReader* reader);
@@ -78,6 +122,16 @@ class MP4MediaParser : public MediaParser {
 
   bool EnqueueSample(bool* err);
 
+  // Set the data of |sample| to |size| bytes at stream |offset|, which is in
+  // |buf|. The data refers to |file_view_| if it is available.
+  void SetSampleData(int64_t offset,
+                     const uint8_t* buf,
+                     size_t size,
+                     MediaSample* sample);
+
+  // Read the data of the current sample of |sample_index_| into |sample|.
+  bool ReadSampleData(MediaSample* sample);
+
   void Reset();
 
   State state_;
@@ -87,6 +141,9 @@ class MP4MediaParser : public MediaParser {
   std::unique_ptr<DecryptorSource> decryptor_source_;
 
   OffsetByteQueue queue_;
+  // Optional view of the whole file, see SetFileView.
+  std::shared_ptr<const uint8_t> file_view_;
+  uint64_t file_view_size_ = 0;
 
   // These two parameters are only valid in the |kEmittingSegments| state.
   //
@@ -101,6 +158,20 @@ class MP4MediaParser : public MediaParser {
   std::unique_ptr<Movie> moov_;
   std::unique_ptr<TrackRunIterator> runs_;
 
+  // The file read with positioned reads, see EnableRandomAccess.
+  std::unique_ptr<File, FileCloser> random_access_file_;
+  // The read position of |random_access_file_|, so that the samples which
+  // follow each other in the file are read without seeking.
+  uint64_t random_access_file_position_ = 0;
+  // Only valid in the |kReadingSamplesFromFile| state.
+  std::unique_ptr<SampleIndex> sample_index_;
+  // Optional cache of the 'moov' location and of |sample_index_|.
+  std::unique_ptr<IndexSidecar> index_sidecar_;
+  // The index loaded from |index_sidecar_|, used when 'moov' is parsed.
+  std::unique_ptr<SampleIndex> cached_sample_index_;
+  // The file offset of the 'moov' box, or -1 if it has not been found.
+  int64_t moov_offset_ = -1;
+
   DISALLOW_COPY_AND_ASSIGN(MP4MediaParser);
 };
 
@@ -0,0 +1,86 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "packager/base/bind.h"
+#include "packager/base/files/file_util.h"
+#include "packager/base/time/time.h"
+#include "packager/media/base/media_sample.h"
+#include "packager/media/base/stream_info.h"
+#include "packager/media/formats/mp4/mp4_media_parser.h"
+#include "packager/media/test/test_data_util.h"
+#include "packager/testing/perf/perf_test.h"
+
+DECLARE_string(mp4_index_sidecar_dir);
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+namespace {
+
+const char kFileName[] = "bear-640x360-trailing-moov.mp4";
+const int kNumIterations = 100;
+
+void OnInit(const std::vector<std::shared_ptr<StreamInfo>>& stream_infos) {}
+
+bool OnNewSample(bool* sample_received,
+                 uint32_t track_id,
+                 const std::shared_ptr<MediaSample>& sample) {
+  *sample_received = true;
+  return true;
+}
+
+}  // namespace
+
+// Measures the time from opening a non-fragmented file with a trailing 'moov'
+// to the first sample, which is the startup time of packaging it.
+class MP4MediaParserPerfTest : public testing::Test {
+ protected:
+  base::TimeDelta TimeToFirstSample() {
+    const std::string file_path =
+        GetTestDataFilePath(kFileName).AsUTF8Unsafe();
+    const base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kNumIterations; ++i) {
+      bool sample_received = false;
+      MP4MediaParser parser;
+      parser.Init(base::Bind(&OnInit),
+                  base::Bind(&OnNewSample, &sample_received), nullptr);
+      EXPECT_TRUE(parser.EnableRandomAccess(file_path));
+      EXPECT_TRUE(parser.LoadMoov(file_path));
+      bool end_of_stream = false;
+      EXPECT_TRUE(parser.ReadSamples(1, &end_of_stream));
+      EXPECT_TRUE(sample_received);
+    }
+    return (base::TimeTicks::Now() - start) / kNumIterations;
+  }
+};
+
+TEST_F(MP4MediaParserPerfTest, StartupWithoutIndexSidecar) {
+  perf_test::PrintResult("time_to_first_sample", "", "without_sidecar",
+                         TimeToFirstSample().InMillisecondsF(), "ms", true);
+}
+
+TEST_F(MP4MediaParserPerfTest, StartupWithIndexSidecar) {
+  base::FilePath temp_dir;
+  ASSERT_TRUE(base::CreateNewTempDirectory(base::FilePath::StringType(),
+                                           &temp_dir));
+  FLAGS_mp4_index_sidecar_dir = temp_dir.AsUTF8Unsafe();
+  // Writes the sidecar, so that it is read by all the measured iterations.
+  TimeToFirstSample();
+  perf_test::PrintResult("time_to_first_sample", "", "with_sidecar",
+                         TimeToFirstSample().InMillisecondsF(), "ms", true);
+  FLAGS_mp4_index_sidecar_dir.clear();
+  base::DeleteFile(temp_dir, true);
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
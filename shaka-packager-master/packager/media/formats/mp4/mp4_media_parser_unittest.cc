@@ -4,10 +4,15 @@
 // license that can be found in the LICENSE file or at
 // https://developers.google.com/open-source/licenses/bsd
 
+#include <gflags/gflags.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <iterator>
+
 #include "packager/base/bind.h"
+#include "packager/base/files/file_util.h"
 #include "packager/base/logging.h"
 #include "packager/media/base/media_sample.h"
 #include "packager/media/base/raw_key_source.h"
@@ -21,6 +26,8 @@ using ::testing::DoAll;
 using ::testing::Return;
 using ::testing::SetArgPointee;
 
+DECLARE_string(mp4_index_sidecar_dir);
+
 namespace shaka {
 namespace media {
 
@@ -28,6 +35,7 @@ namespace {
 const char kKey[] =
     "\xeb\xdd\x62\xf1\x68\x14\xd2\x7b\x68\xef\x12\x2a\xfc\xe4\xae\x3c";
 const char kKeyId[] = "0123456789012345";
+const size_t kMaxSamplesPerRead = 16;
 
 class MockKeySource : public RawKeySource {
  public:
@@ -53,6 +61,7 @@ class MP4MediaParserTest : public testing::Test {
   std::unique_ptr<MP4MediaParser> parser_;
   size_t num_streams_;
   size_t num_samples_;
+  std::map<uint32_t, std::vector<std::shared_ptr<MediaSample>>> samples_;
 
   bool AppendData(const uint8_t* data, size_t length) {
     return parser_->Parse(data, static_cast<int>(length));
@@ -87,6 +96,7 @@ class MP4MediaParserTest : public testing::Test {
     DVLOG(2) << "Track Id: " << track_id << " "
              << sample->ToString();
     ++num_samples_;
+    samples_[track_id].push_back(sample);
     return true;
   }
 
@@ -104,6 +114,60 @@ class MP4MediaParserTest : public testing::Test {
     std::vector<uint8_t> buffer = ReadTestDataFile(filename);
     return AppendDataInPieces(buffer.data(), buffer.size(), append_bytes);
   }
+
+  bool ParseMP4FileWithRandomAccess(const std::string& filename,
+                                    int append_bytes) {
+    return ParseFileWithRandomAccess(GetTestDataFilePath(filename),
+                                     append_bytes);
+  }
+
+  bool ParseFileWithRandomAccess(const base::FilePath& path,
+                                 int append_bytes) {
+    InitializeParser(NULL);
+    const std::string file_path = path.AsUTF8Unsafe();
+    if (!parser_->EnableRandomAccess(file_path) ||
+        !parser_->LoadMoov(file_path)) {
+      return false;
+    }
+    std::string buffer;
+    if (!base::ReadFileToString(path, &buffer))
+      return false;
+    if (!AppendDataInPieces(reinterpret_cast<const uint8_t*>(buffer.data()),
+                            buffer.size(), append_bytes)) {
+      return false;
+    }
+    bool end_of_stream = false;
+    while (parser_->IsReadingSamplesFromFile() && !end_of_stream) {
+      if (!parser_->ReadSamples(kMaxSamplesPerRead, &end_of_stream))
+        return false;
+    }
+    return true;
+  }
+
+  // Checks that the samples of each track are the same as the samples read
+  // sequentially.
+  void CheckSamplesMatchSequentialParse(const std::string& filename) {
+    std::map<uint32_t, std::vector<std::shared_ptr<MediaSample>>> samples;
+    samples.swap(samples_);
+    parser_.reset(new MP4MediaParser());
+    ASSERT_TRUE(ParseMP4File(filename, 512));
+    ASSERT_EQ(samples_.size(), samples.size());
+    for (const auto& entry : samples_) {
+      const auto& expected_samples = entry.second;
+      const auto& actual_samples = samples[entry.first];
+      ASSERT_EQ(expected_samples.size(), actual_samples.size());
+      for (size_t i = 0; i < expected_samples.size(); ++i) {
+        EXPECT_EQ(expected_samples[i]->ToString(),
+                  actual_samples[i]->ToString());
+        EXPECT_EQ(std::vector<uint8_t>(expected_samples[i]->data(),
+                                       expected_samples[i]->data() +
+                                           expected_samples[i]->data_size()),
+                  std::vector<uint8_t>(actual_samples[i]->data(),
+                                       actual_samples[i]->data() +
+                                           actual_samples[i]->data_size()));
+      }
+    }
+  }
 };
 
 TEST_F(MP4MediaParserTest, UnalignedAppend) {
@@ -236,6 +300,97 @@ TEST_F(MP4MediaParserTest, NON_FRAGMENTED_MP4) {
   EXPECT_EQ(201u, num_samples_);
 }
 
+TEST_F(MP4MediaParserTest, NonFragmentedWithRandomAccess) {
+  EXPECT_TRUE(ParseMP4FileWithRandomAccess("bear-640x360.mp4", 512));
+  EXPECT_TRUE(parser_->IsReadingSamplesFromFile());
+  EXPECT_EQ(2u, num_streams_);
+  EXPECT_EQ(201u, num_samples_);
+  CheckSamplesMatchSequentialParse("bear-640x360.mp4");
+}
+
+TEST_F(MP4MediaParserTest, TrailingMoovWithRandomAccess) {
+  EXPECT_TRUE(
+      ParseMP4FileWithRandomAccess("bear-640x360-trailing-moov.mp4", 1024));
+  EXPECT_TRUE(parser_->IsReadingSamplesFromFile());
+  EXPECT_EQ(2u, num_streams_);
+  EXPECT_EQ(201u, num_samples_);
+  CheckSamplesMatchSequentialParse("bear-640x360-trailing-moov.mp4");
+}
+
+TEST_F(MP4MediaParserTest, RandomAccessWithIndexSidecar) {
+  const char kFileName[] = "bear-640x360-trailing-moov.mp4";
+  base::FilePath temp_dir;
+  ASSERT_TRUE(base::CreateNewTempDirectory(base::FilePath::StringType(),
+                                           &temp_dir));
+  FLAGS_mp4_index_sidecar_dir = temp_dir.AsUTF8Unsafe();
+  base::FilePath file_path;
+  ASSERT_TRUE(base::CreateTemporaryFile(&file_path));
+  std::vector<uint8_t> contents = ReadTestDataFile(kFileName);
+  ASSERT_EQ(static_cast<int>(contents.size()),
+            base::WriteFile(file_path,
+                            reinterpret_cast<const char*>(contents.data()),
+                            contents.size()));
+
+  // The first run writes the sidecar.
+  EXPECT_TRUE(ParseFileWithRandomAccess(file_path, 1024));
+  EXPECT_FALSE(base::IsDirectoryEmpty(temp_dir));
+
+  // Corrupt the chunk offsets in 'moov', keeping the size and modification
+  // time of the file, so the samples can only be read correctly with the
+  // sample index in the sidecar.
+  base::File::Info file_info;
+  ASSERT_TRUE(base::GetFileInfo(file_path, &file_info));
+  const uint8_t kChunkOffsetBoxType[] = {'s', 't', 'c', 'o'};
+  int num_chunk_offset_boxes = 0;
+  for (auto it = std::search(contents.begin(), contents.end(),
+                             std::begin(kChunkOffsetBoxType),
+                             std::end(kChunkOffsetBoxType));
+       it != contents.end();
+       it = std::search(it + 1, contents.end(), std::begin(kChunkOffsetBoxType),
+                        std::end(kChunkOffsetBoxType))) {
+    // Skip the box type, version and flags, then zero the entry count and all
+    // the entries after it.
+    const size_t entries_start = it - contents.begin() + 8;
+    ASSERT_LE(entries_start + 4, contents.size());
+    const size_t entry_count = (contents[entries_start] << 24) |
+                               (contents[entries_start + 1] << 16) |
+                               (contents[entries_start + 2] << 8) |
+                               contents[entries_start + 3];
+    ASSERT_LE(entries_start + 4 + entry_count * 4, contents.size());
+    std::fill(contents.begin() + entries_start + 4,
+              contents.begin() + entries_start + 4 + entry_count * 4, 0);
+    ++num_chunk_offset_boxes;
+  }
+  ASSERT_EQ(2, num_chunk_offset_boxes);
+  ASSERT_EQ(static_cast<int>(contents.size()),
+            base::WriteFile(file_path,
+                            reinterpret_cast<const char*>(contents.data()),
+                            contents.size()));
+  ASSERT_TRUE(base::TouchFile(file_path, file_info.last_accessed,
+                              file_info.last_modified));
+
+  // The second run reads the sidecar.
+  samples_.clear();
+  parser_.reset(new MP4MediaParser());
+  EXPECT_TRUE(ParseFileWithRandomAccess(file_path, 1024));
+  EXPECT_TRUE(parser_->IsReadingSamplesFromFile());
+  EXPECT_EQ(2u, num_streams_);
+  EXPECT_EQ(201u, num_samples_);
+  CheckSamplesMatchSequentialParse(kFileName);
+
+  FLAGS_mp4_index_sidecar_dir.clear();
+  base::DeleteFile(temp_dir, true);
+  base::DeleteFile(file_path, false);
+}
+
+TEST_F(MP4MediaParserTest, FragmentedWithRandomAccess) {
+  // The samples of fragmented files are still read sequentially.
+  EXPECT_TRUE(ParseMP4FileWithRandomAccess("bear-640x360-av_frag.mp4", 512));
+  EXPECT_FALSE(parser_->IsReadingSamplesFromFile());
+  EXPECT_EQ(2u, num_streams_);
+  EXPECT_EQ(201u, num_samples_);
+}
+
 TEST_F(MP4MediaParserTest, CencWithoutDecryptionSource) {
   EXPECT_TRUE(ParseMP4File("bear-640x360-v_frag-cenc-aux.mp4", 512));
   EXPECT_EQ(1u, num_streams_);
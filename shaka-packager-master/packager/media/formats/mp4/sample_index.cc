@@ -0,0 +1,249 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/formats/mp4/sample_index.h"
+
+#include "packager/base/logging.h"
+#include "packager/media/base/buffer_reader.h"
+#include "packager/media/base/buffer_writer.h"
+#include "packager/media/base/rcheck.h"
+#include "packager/media/formats/mp4/chunk_info_iterator.h"
+#include "packager/media/formats/mp4/composition_offset_iterator.h"
+#include "packager/media/formats/mp4/decoding_time_iterator.h"
+#include "packager/media/formats/mp4/sync_sample_iterator.h"
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+
+SampleIndex::SampleIndex() : current_track_(0) {}
+
+SampleIndex::~SampleIndex() {}
+
+bool SampleIndex::Init(const Movie& moov) {
+  tracks_.clear();
+  for (const Track& track : moov.tracks) {
+    if (!AddTrack(track))
+      return false;
+  }
+  SelectTrack();
+  return true;
+}
+
+void SampleIndex::Write(BufferWriter* writer) const {
+  writer->AppendInt(static_cast<uint32_t>(tracks_.size()));
+  for (const TrackEntry& track : tracks_) {
+    writer->AppendInt(track.track_id);
+    writer->AppendInt(track.timescale);
+    writer->AppendInt(static_cast<uint32_t>(track.samples.size()));
+    // The decoding times are the sums of the durations, so they are not
+    // written.
+    for (const SampleEntry& sample : track.samples) {
+      writer->AppendInt(sample.offset);
+      writer->AppendInt(sample.size);
+      writer->AppendInt(sample.duration);
+      writer->AppendInt(sample.cts_offset);
+      writer->AppendInt(static_cast<uint8_t>(sample.is_keyframe ? 1 : 0));
+    }
+  }
+}
+
+bool SampleIndex::Read(BufferReader* reader) {
+  // Offset, size, duration, composition offset and key frame flag.
+  const size_t kSampleEntrySize = 8 + 4 + 4 + 8 + 1;
+
+  tracks_.clear();
+  uint32_t num_tracks = 0;
+  RCHECK(reader->Read4(&num_tracks));
+  for (uint32_t i = 0; i < num_tracks; ++i) {
+    TrackEntry track;
+    uint32_t num_samples = 0;
+    RCHECK(reader->Read4(&track.track_id) && reader->Read4(&track.timescale) &&
+           reader->Read4(&num_samples));
+    RCHECK(reader->HasBytes(num_samples * kSampleEntrySize));
+    RCHECK(num_samples == 0 || track.timescale > 0);
+    track.next_sample = 0;
+    track.samples.resize(num_samples);
+    int64_t dts = 0;
+    for (SampleEntry& sample : track.samples) {
+      uint8_t is_keyframe = 0;
+      RCHECK(reader->Read8(&sample.offset) && reader->Read4(&sample.size) &&
+             reader->Read4(&sample.duration) &&
+             reader->Read8s(&sample.cts_offset) &&
+             reader->Read1(&is_keyframe));
+      sample.dts = dts;
+      sample.is_keyframe = is_keyframe != 0;
+      dts += sample.duration;
+    }
+    tracks_.push_back(std::move(track));
+  }
+  SelectTrack();
+  return true;
+}
+
+bool SampleIndex::AddTrack(const Track& track) {
+  const SampleTable& sample_table = track.media.information.sample_table;
+  const SampleDescription& stsd = sample_table.description;
+  if (stsd.type != kAudio && stsd.type != kVideo) {
+    DVLOG(1) << "Skipping unhandled track type";
+    return true;
+  }
+  // Encrypted non-fragmented mp4 is not supported.
+  for (const AudioSampleEntry& entry : stsd.audio_entries)
+    RCHECK(entry.sinf.info.track_encryption.default_is_protected == 0);
+  for (const VideoSampleEntry& entry : stsd.video_entries)
+    RCHECK(entry.sinf.info.track_encryption.default_is_protected == 0);
+
+  DecodingTimeIterator decoding_time(sample_table.decoding_time_to_sample);
+  CompositionOffsetIterator composition_offset(
+      sample_table.composition_time_to_sample);
+  const bool has_composition_offset = composition_offset.IsValid();
+  ChunkInfoIterator chunk_info(sample_table.sample_to_chunk);
+  SyncSampleIterator sync_sample(sample_table.sync_sample);
+
+  const SampleSize& sample_size = sample_table.sample_size;
+  const std::vector<uint64_t>& chunk_offsets =
+      sample_table.chunk_large_offset.offsets;
+  const uint32_t num_samples = sample_size.sample_count;
+  const uint32_t num_chunks = static_cast<uint32_t>(chunk_offsets.size());
+  RCHECK(sample_size.sample_size != 0 ||
+         sample_size.sizes.size() >= num_samples);
+  if (num_samples > 0) {
+    // Verify relevant tables are not empty.
+    RCHECK(decoding_time.IsValid());
+    RCHECK(chunk_info.IsValid());
+    RCHECK(track.media.header.timescale > 0);
+  }
+
+  TrackEntry track_entry;
+  track_entry.track_id = track.header.track_id;
+  track_entry.timescale = track.media.header.timescale;
+  track_entry.next_sample = 0;
+  track_entry.samples.reserve(num_samples);
+
+  int64_t dts = 0;
+  uint32_t sample_index = 0;
+  for (uint32_t chunk_index = 0;
+       chunk_index < num_chunks && sample_index < num_samples; ++chunk_index) {
+    RCHECK(chunk_info.current_chunk() == chunk_index + 1);
+    uint64_t offset = chunk_offsets[chunk_index];
+    const uint32_t samples_per_chunk = chunk_info.samples_per_chunk();
+    if (samples_per_chunk == 0) {
+      chunk_info.AdvanceChunk();
+      continue;
+    }
+    for (uint32_t k = 0; k < samples_per_chunk; ++k) {
+      RCHECK(sample_index < num_samples);
+      SampleEntry sample;
+      sample.offset = offset;
+      sample.size = sample_size.sample_size != 0
+                        ? sample_size.sample_size
+                        : sample_size.sizes[sample_index];
+      sample.duration = decoding_time.sample_delta();
+      sample.dts = dts;
+      sample.cts_offset =
+          has_composition_offset ? composition_offset.sample_offset() : 0;
+      sample.is_keyframe = sync_sample.IsSyncSample();
+      track_entry.samples.push_back(sample);
+
+      offset += sample.size;
+      dts += sample.duration;
+
+      // Advance to next sample. Should success except for last sample.
+      ++sample_index;
+      RCHECK(chunk_info.AdvanceSample() && sync_sample.AdvanceSample());
+      if (sample_index == num_samples) {
+        // We should hit end of tables for decoding time and composition
+        // offset.
+        RCHECK(!decoding_time.AdvanceSample());
+        if (has_composition_offset)
+          RCHECK(!composition_offset.AdvanceSample());
+      } else {
+        RCHECK(decoding_time.AdvanceSample());
+        if (has_composition_offset)
+          RCHECK(composition_offset.AdvanceSample());
+      }
+    }
+  }
+  RCHECK(sample_index == num_samples);
+
+  tracks_.push_back(std::move(track_entry));
+  return true;
+}
+
+bool SampleIndex::IsValid() const {
+  return current_track_ < tracks_.size();
+}
+
+void SampleIndex::Advance() {
+  DCHECK(IsValid());
+  ++tracks_[current_track_].next_sample;
+  SelectTrack();
+}
+
+size_t SampleIndex::NumSamples() const {
+  size_t num_samples = 0;
+  for (const TrackEntry& track : tracks_)
+    num_samples += track.samples.size();
+  return num_samples;
+}
+
+void SampleIndex::SelectTrack() {
+  current_track_ = tracks_.size();
+  double earliest_time = 0;
+  for (size_t i = 0; i < tracks_.size(); ++i) {
+    const TrackEntry& track = tracks_[i];
+    if (track.next_sample >= track.samples.size())
+      continue;
+    // The tracks have different timescales, so compare the times in seconds.
+    const double time =
+        static_cast<double>(track.samples[track.next_sample].dts) /
+        track.timescale;
+    if (current_track_ == tracks_.size() || time < earliest_time) {
+      current_track_ = i;
+      earliest_time = time;
+    }
+  }
+}
+
+const SampleIndex::SampleEntry& SampleIndex::current_sample() const {
+  DCHECK(IsValid());
+  const TrackEntry& track = tracks_[current_track_];
+  return track.samples[track.next_sample];
+}
+
+uint32_t SampleIndex::track_id() const {
+  DCHECK(IsValid());
+  return tracks_[current_track_].track_id;
+}
+
+uint64_t SampleIndex::offset() const {
+  return current_sample().offset;
+}
+
+uint32_t SampleIndex::size() const {
+  return current_sample().size;
+}
+
+int64_t SampleIndex::dts() const {
+  return current_sample().dts;
+}
+
+int64_t SampleIndex::cts() const {
+  return current_sample().dts + current_sample().cts_offset;
+}
+
+int64_t SampleIndex::duration() const {
+  return current_sample().duration;
+}
+
+bool SampleIndex::is_keyframe() const {
+  return current_sample().is_keyframe;
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,106 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_FORMATS_MP4_SAMPLE_INDEX_H_
+#define PACKAGER_MEDIA_FORMATS_MP4_SAMPLE_INDEX_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "packager/base/macros.h"
+#include "packager/media/formats/mp4/box_definitions.h"
+
+namespace shaka {
+namespace media {
+
+class BufferReader;
+class BufferWriter;
+
+namespace mp4 {
+
+/// Index of the file offsets of the samples of the audio and video tracks of
+/// a non-fragmented movie, built from the sample tables in 'moov'. The
+/// samples of all the tracks are iterated in decoding time order, so they can
+/// be read with positioned reads no matter how the tracks are interleaved in
+/// the file.
+class SampleIndex {
+ public:
+  SampleIndex();
+  ~SampleIndex();
+
+  /// Builds the index and points the iterator to the first sample.
+  /// @param moov is the movie box. It is not used after the call returns.
+  /// @return true on success, false otherwise.
+  bool Init(const Movie& moov);
+
+  /// Serialize the index, e.g. to cache it in a file.
+  /// @param writer is where the index is written to.
+  void Write(BufferWriter* writer) const;
+
+  /// Restore an index serialized by Write and point the iterator to the first
+  /// sample.
+  /// @param reader is where the index is read from.
+  /// @return true on success, false otherwise.
+  bool Read(BufferReader* reader);
+
+  /// @return true if the iterator points to a valid sample, false if past the
+  ///         last sample.
+  bool IsValid() const;
+
+  /// Advance to the sample with the next decoding time, in any track. Require
+  /// that the iterator point to a valid sample.
+  void Advance();
+
+  /// @return The total number of samples in the index.
+  size_t NumSamples() const;
+
+  /// @name Properties of the current sample. Only valid if IsValid().
+  /// @{
+  uint32_t track_id() const;
+  uint64_t offset() const;
+  uint32_t size() const;
+  int64_t dts() const;
+  int64_t cts() const;
+  int64_t duration() const;
+  bool is_keyframe() const;
+  /// @}
+
+ private:
+  struct SampleEntry {
+    uint64_t offset;
+    uint32_t size;
+    uint32_t duration;
+    int64_t dts;
+    int64_t cts_offset;
+    bool is_keyframe;
+  };
+
+  struct TrackEntry {
+    uint32_t track_id;
+    uint32_t timescale;
+    std::vector<SampleEntry> samples;
+    size_t next_sample;
+  };
+
+  bool AddTrack(const Track& track);
+  // Points |current_track_| to the track with the earliest next sample.
+  void SelectTrack();
+  const SampleEntry& current_sample() const;
+
+  std::vector<TrackEntry> tracks_;
+  // Index in |tracks_| of the track of the current sample, or the size of
+  // |tracks_| if past the last sample.
+  size_t current_track_;
+
+  DISALLOW_COPY_AND_ASSIGN(SampleIndex);
+};
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_FORMATS_MP4_SAMPLE_INDEX_H_
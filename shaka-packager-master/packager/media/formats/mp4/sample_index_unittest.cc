@@ -0,0 +1,175 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/formats/mp4/sample_index.h"
+
+#include <gtest/gtest.h>
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+
+namespace {
+
+const uint32_t kAudioTrackId = 1;
+const uint32_t kVideoTrackId = 2;
+const uint32_t kHintTrackId = 3;
+const uint32_t kAudioScale = 48000;
+const uint32_t kVideoScale = 25;
+const uint32_t kAudioSampleDelta = 1024;
+const uint32_t kVideoSampleDelta = 1;
+const uint32_t kNumAudioSamples = 10;
+const uint32_t kNumVideoSamples = 5;
+const uint32_t kAudioSampleSize = 100;
+// The video is stored before all the audio, i.e. the tracks are not
+// interleaved at all.
+const uint64_t kVideoChunkOffset = 100;
+const uint64_t kAudioChunkOffsets[] = {10000, 20000};
+
+}  // namespace
+
+class SampleIndexTest : public testing::Test {
+ public:
+  SampleIndexTest() { CreateMovie(); }
+
+ protected:
+  void CreateMovie() {
+    moov_.tracks.resize(3);
+
+    Track& audio = moov_.tracks[0];
+    audio.header.track_id = kAudioTrackId;
+    audio.media.header.timescale = kAudioScale;
+    SampleTable& audio_table = audio.media.information.sample_table;
+    audio_table.description.type = kAudio;
+    audio_table.description.audio_entries.resize(1);
+    audio_table.decoding_time_to_sample.decoding_time.push_back(
+        {kNumAudioSamples, kAudioSampleDelta});
+    // Two chunks of five samples.
+    audio_table.sample_to_chunk.chunk_info.push_back({1, 5, 1});
+    audio_table.sample_size.sample_size = kAudioSampleSize;
+    audio_table.sample_size.sample_count = kNumAudioSamples;
+    audio_table.chunk_large_offset.offsets.assign(
+        std::begin(kAudioChunkOffsets), std::end(kAudioChunkOffsets));
+
+    Track& video = moov_.tracks[1];
+    video.header.track_id = kVideoTrackId;
+    video.media.header.timescale = kVideoScale;
+    SampleTable& video_table = video.media.information.sample_table;
+    video_table.description.type = kVideo;
+    video_table.description.video_entries.resize(1);
+    video_table.decoding_time_to_sample.decoding_time.push_back(
+        {kNumVideoSamples, kVideoSampleDelta});
+    video_table.composition_time_to_sample.composition_offset.push_back(
+        {kNumVideoSamples, 2});
+    video_table.sample_to_chunk.chunk_info.push_back({1, kNumVideoSamples, 1});
+    video_table.sample_size.sample_size = 0;
+    video_table.sample_size.sample_count = kNumVideoSamples;
+    video_table.sample_size.sizes = {1000, 200, 300, 1100, 400};
+    video_table.chunk_large_offset.offsets.push_back(kVideoChunkOffset);
+    video_table.sync_sample.sample_number = {1, 4};
+
+    moov_.tracks[2].header.track_id = kHintTrackId;
+    moov_.tracks[2].media.information.sample_table.description.type = kHint;
+  }
+
+  Movie moov_;
+  SampleIndex index_;
+};
+
+TEST_F(SampleIndexTest, Empty) {
+  Movie moov;
+  ASSERT_TRUE(index_.Init(moov));
+  EXPECT_FALSE(index_.IsValid());
+  EXPECT_EQ(0u, index_.NumSamples());
+}
+
+TEST_F(SampleIndexTest, InterleavesTracksByDecodingTime) {
+  ASSERT_TRUE(index_.Init(moov_));
+  EXPECT_EQ(kNumAudioSamples + kNumVideoSamples, index_.NumSamples());
+
+  // Audio samples are 21.3ms long and video samples 40ms long. Samples with
+  // the same decoding time are in track order.
+  const uint32_t kExpectedTrackIds[] = {
+      kAudioTrackId, kVideoTrackId, kAudioTrackId, kVideoTrackId,
+      kAudioTrackId, kAudioTrackId, kVideoTrackId, kAudioTrackId,
+      kAudioTrackId, kVideoTrackId, kAudioTrackId, kAudioTrackId,
+      kVideoTrackId, kAudioTrackId, kAudioTrackId,
+  };
+  double last_time = 0;
+  for (uint32_t track_id : kExpectedTrackIds) {
+    ASSERT_TRUE(index_.IsValid());
+    EXPECT_EQ(track_id, index_.track_id());
+    const double time = static_cast<double>(index_.dts()) /
+                        (track_id == kAudioTrackId ? kAudioScale : kVideoScale);
+    EXPECT_LE(last_time, time);
+    last_time = time;
+    index_.Advance();
+  }
+  EXPECT_FALSE(index_.IsValid());
+}
+
+TEST_F(SampleIndexTest, AudioSamples) {
+  ASSERT_TRUE(index_.Init(moov_));
+  uint32_t sample = 0;
+  for (; index_.IsValid(); index_.Advance()) {
+    if (index_.track_id() != kAudioTrackId)
+      continue;
+    const uint32_t chunk = sample / 5;
+    EXPECT_EQ(kAudioChunkOffsets[chunk] + (sample % 5) * kAudioSampleSize,
+              index_.offset());
+    EXPECT_EQ(kAudioSampleSize, index_.size());
+    EXPECT_EQ(sample * kAudioSampleDelta, index_.dts());
+    EXPECT_EQ(index_.dts(), index_.cts());
+    EXPECT_EQ(kAudioSampleDelta, index_.duration());
+    // Every sample is a sync sample without the sync sample box.
+    EXPECT_TRUE(index_.is_keyframe());
+    ++sample;
+  }
+  EXPECT_EQ(kNumAudioSamples, sample);
+}
+
+TEST_F(SampleIndexTest, VideoSamples) {
+  ASSERT_TRUE(index_.Init(moov_));
+  const uint64_t kExpectedOffsets[] = {100, 1100, 1300, 1600, 2700};
+  const uint32_t kExpectedSizes[] = {1000, 200, 300, 1100, 400};
+  const bool kExpectedKeyframes[] = {true, false, false, true, false};
+  uint32_t sample = 0;
+  for (; index_.IsValid(); index_.Advance()) {
+    if (index_.track_id() != kVideoTrackId)
+      continue;
+    EXPECT_EQ(kExpectedOffsets[sample], index_.offset());
+    EXPECT_EQ(kExpectedSizes[sample], index_.size());
+    EXPECT_EQ(sample * kVideoSampleDelta, index_.dts());
+    EXPECT_EQ(index_.dts() + 2, index_.cts());
+    EXPECT_EQ(kExpectedKeyframes[sample], index_.is_keyframe());
+    ++sample;
+  }
+  EXPECT_EQ(kNumVideoSamples, sample);
+}
+
+TEST_F(SampleIndexTest, EncryptedTrackNotSupported) {
+  moov_.tracks[1]
+      .media.information.sample_table.description.video_entries[0]
+      .sinf.info.track_encryption.default_is_protected = 1;
+  EXPECT_FALSE(index_.Init(moov_));
+}
+
+TEST_F(SampleIndexTest, InconsistentSampleCount) {
+  moov_.tracks[0]
+      .media.information.sample_table.decoding_time_to_sample.decoding_time[0]
+      .sample_count = kNumAudioSamples - 1;
+  EXPECT_FALSE(index_.Init(moov_));
+}
+
+TEST_F(SampleIndexTest, MissingChunks) {
+  moov_.tracks[0]
+      .media.information.sample_table.chunk_large_offset.offsets.pop_back();
+  EXPECT_FALSE(index_.Init(moov_));
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
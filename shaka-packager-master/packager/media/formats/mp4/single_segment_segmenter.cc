@@ -26,6 +26,8 @@ SingleSegmentSegmenter::SingleSegmentSegmenter(const MuxerOptions& options,
     : Segmenter(options, std::move(ftyp), std::move(moov)) {}
 
 SingleSegmentSegmenter::~SingleSegmentSegmenter() {
+  if (output_file_)
+    output_file_.release()->Close();
   if (temp_file_)
     temp_file_.release()->Close();
   if (!temp_file_name_.empty()) {
@@ -66,14 +68,27 @@ std::vector<Range> SingleSegmentSegmenter::GetSegmentRanges() {
 }
 
 Status SingleSegmentSegmenter::DoInitialize() {
+  if (options().mp4_params.reserve_header_space) {
+    reserved_header_size_ = EstimateHeaderSize();
+    if (reserved_header_size_ == 0 || !ReserveHeaderSpace()) {
+      LOG(WARNING) << "Unable to reserve header space in '"
+                   << options().output_file_name
+                   << "'. Media data will be copied from a temporary file.";
+      reserved_header_size_ = 0;
+    }
+  }
+
   // Single segment segmentation involves two stages:
   //   Stage 1: Create media subsegments from media samples
   //   Stage 2: Update media header (moov) which involves copying of media
-  //            subsegments
+  //            subsegments, unless the header space is reserved
   // Assumes stage 2 takes similar amount of time as stage 1. The previous
   // progress_target was set for stage 1. Times two to account for stage 2.
   set_progress_target(progress_target() * 2);
 
+  if (reserved_header_size_ > 0)
+    return Status::OK;
+
   if (!TempFilePath(options().temp_dir, &temp_file_name_))
     return Status(error::FILE_FAILURE, "Unable to create temporary file.");
   temp_file_.reset(File::Open(temp_file_name_.c_str(), "w"));
@@ -84,11 +99,30 @@ Status SingleSegmentSegmenter::DoInitialize() {
 }
 
 Status SingleSegmentSegmenter::DoFinalize() {
-  DCHECK(temp_file_);
   DCHECK(ftyp());
   DCHECK(moov());
   DCHECK(vod_sidx_);
 
+  if (reserved_header_size_ > 0) {
+    DCHECK(output_file_);
+    Status status;
+    if (WriteHeaderIntoReservedSpace(&status)) {
+      if (!status.ok())
+        return status;
+      // There is nothing to copy in stage 2.
+      UpdateProgress(progress_target() / 2);
+      SetComplete();
+      return Status::OK;
+    }
+    LOG(WARNING) << "The header of '" << options().output_file_name
+                 << "' does not fit in the " << reserved_header_size_
+                 << " bytes reserved. Media data will be copied.";
+    status = MoveMediaDataToTempFile();
+    if (!status.ok())
+      return status;
+  }
+
+  DCHECK(temp_file_);
   // Close the temp file to prepare for reading later.
   if (!temp_file_.release()->Close()) {
     return Status(
@@ -96,7 +130,129 @@ Status SingleSegmentSegmenter::DoFinalize() {
         "Cannot close the temp file " + temp_file_name_ +
             ", possibly file permission issue or running out of disk space.");
   }
+  Status status = WriteHeaderAndCopyMediaData();
+  if (!status.ok())
+    return status;
+  SetComplete();
+  return Status::OK;
+}
+
+uint64_t SingleSegmentSegmenter::EstimateHeaderSize() {
+  // There is one sidx reference per subsegment. Subsegments are assumed to be
+  // no shorter than |kMinSubsegmentDurationInSeconds|.
+  const double kMinSubsegmentDurationInSeconds = 1.0;
+  // Extra space for boxes which grow in Finalize, e.g. 'mehd'.
+  const uint64_t kHeaderSizeMargin = 1024;
+
+  // |progress_target| is the media duration before DoInitialize.
+  const uint64_t duration = progress_target();
+  if (duration == 0)
+    return 0;
+  const uint64_t max_num_subsegments =
+      static_cast<uint64_t>(duration / (kMinSubsegmentDurationInSeconds *
+                                        GetReferenceTimeScale())) +
+      1;
+  SegmentIndex sidx;
+  sidx.references.resize(max_num_subsegments);
+  return ftyp()->ComputeSize() + moov()->ComputeSize() + sidx.ComputeSize() +
+         kHeaderSizeMargin;
+}
+
+bool SingleSegmentSegmenter::ReserveHeaderSpace() {
+  DCHECK_GT(reserved_header_size_, 0u);
+  output_file_.reset(File::Open(options().output_file_name.c_str(), "w"));
+  if (!output_file_)
+    return false;
+  // The header is written into the reserved space at the end, which requires
+  // seeking back.
+  if (!output_file_->Seek(0)) {
+    output_file_.release()->Close();
+    return false;
+  }
+  // Fill the reserved space with zeros. It is overwritten in DoFinalize.
+  BufferWriter buffer(reserved_header_size_);
+  buffer.AppendVector(std::vector<uint8_t>(reserved_header_size_));
+  return buffer.WriteToFile(output_file_.get()).ok();
+}
+
+bool SingleSegmentSegmenter::WriteHeaderIntoReservedSpace(Status* status) {
+  // The unused reserved space is filled with a 'free' box, which requires at
+  // least the size of a box header.
+  const uint64_t kBoxHeaderSize = 8;
+
+  const uint64_t header_size = ftyp()->ComputeSize() + moov()->ComputeSize() +
+                               vod_sidx_->ComputeSize();
+  if (header_size > reserved_header_size_)
+    return false;
+  const uint64_t free_space_size = reserved_header_size_ - header_size;
+  if (free_space_size > 0 && free_space_size < kBoxHeaderSize)
+    return false;
+  // The 'free' box is between the sidx and the media data. Note that it does
+  // not change the size of the sidx as the offset is small.
+  vod_sidx_->first_offset = free_space_size;
+  DCHECK_EQ(header_size, ftyp()->ComputeSize() + moov()->ComputeSize() +
+                             vod_sidx_->ComputeSize());
+
+  LOG(INFO) << "Update media header (moov) in the space reserved in '"
+            << options().output_file_name << "'.";
+
+  if (!output_file_->Seek(0)) {
+    *status = Status(error::FILE_FAILURE,
+                     "Cannot seek in file " + options().output_file_name);
+    return true;
+  }
+  BufferWriter buffer(reserved_header_size_);
+  ftyp()->Write(&buffer);
+  moov()->Write(&buffer);
+  vod_sidx_->Write(&buffer);
+  if (free_space_size > 0) {
+    buffer.AppendInt(static_cast<uint32_t>(free_space_size));
+    buffer.AppendInt(static_cast<uint32_t>(FOURCC_free));
+    buffer.AppendVector(
+        std::vector<uint8_t>(free_space_size - kBoxHeaderSize));
+  }
+  DCHECK_EQ(reserved_header_size_, buffer.Size());
+  *status = buffer.WriteToFile(output_file_.get());
+  if (!status->ok())
+    return true;
+
+  if (!output_file_.release()->Close()) {
+    *status = Status(
+        error::FILE_FAILURE,
+        "Cannot close file " + options().output_file_name +
+            ", possibly file permission issue or running out of disk space.");
+  }
+  return true;
+}
 
+Status SingleSegmentSegmenter::MoveMediaDataToTempFile() {
+  if (!output_file_.release()->Close()) {
+    return Status(error::FILE_FAILURE,
+                  "Cannot close file " + options().output_file_name);
+  }
+  std::unique_ptr<File, FileCloser> output_file(
+      File::Open(options().output_file_name.c_str(), "r"));
+  if (!output_file || !output_file->Seek(reserved_header_size_)) {
+    return Status(error::FILE_FAILURE,
+                  "Cannot read file " + options().output_file_name);
+  }
+
+  if (!TempFilePath(options().temp_dir, &temp_file_name_))
+    return Status(error::FILE_FAILURE, "Unable to create temporary file.");
+  temp_file_.reset(File::Open(temp_file_name_.c_str(), "w"));
+  if (!temp_file_) {
+    return Status(error::FILE_FAILURE,
+                  "Cannot open file to write " + temp_file_name_);
+  }
+  if (File::CopyFile(output_file.get(), temp_file_.get()) < 0) {
+    return Status(error::FILE_FAILURE,
+                  "Failed to copy media data to " + temp_file_name_);
+  }
+  reserved_header_size_ = 0;
+  return Status::OK;
+}
+
+Status SingleSegmentSegmenter::WriteHeaderAndCopyMediaData() {
   std::unique_ptr<File, FileCloser> file(
       File::Open(options().output_file_name.c_str(), "w"));
   if (file == NULL) {
@@ -155,7 +311,6 @@ Status SingleSegmentSegmenter::DoFinalize() {
         "Cannot close file " + options().output_file_name +
             ", possibly file permission issue or running out of disk space.");
   }
-  SetComplete();
   return Status::OK;
 }
 
@@ -229,7 +384,7 @@ Status SingleSegmentSegmenter::DoFinalizeSegment() {
   }
   // Append fragment buffer to temp file.
   size_t segment_size = fragment_buffer()->Size();
-  Status status = fragment_buffer()->WriteToFile(temp_file_.get());
+  Status status = fragment_buffer()->WriteToFile(media_data_file());
   if (!status.ok()) return status;
 
   UpdateProgress(vod_ref.subsegment_duration);
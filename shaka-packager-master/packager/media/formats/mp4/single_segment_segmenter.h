@@ -26,6 +26,10 @@ namespace mp4 {
 /// overall subsegment/fragment duration not smaller than defined duration and
 /// yet meet SAP requirements. SingleSegmentSegmenter ignores @b
 /// MuxerOptions.num_subsegments_per_sidx.
+/// The media data is written to a temporary file, which is copied to the
+/// output after the header, unless @b Mp4OutputParams.reserve_header_space is
+/// set, in which case the media data is written to the output directly after
+/// space reserved for the header.
 class SingleSegmentSegmenter : public Segmenter {
  public:
   SingleSegmentSegmenter(const MuxerOptions& options,
@@ -46,9 +50,32 @@ class SingleSegmentSegmenter : public Segmenter {
   Status DoFinalize() override;
   Status DoFinalizeSegment() override;
 
+  // Estimate the size of the header (ftyp, moov and sidx) from the media
+  // duration. Returns 0 if the duration is unknown.
+  uint64_t EstimateHeaderSize();
+  // Open the output file and reserve |reserved_header_size_| bytes for the
+  // header. Returns false if the output file does not support it.
+  bool ReserveHeaderSpace();
+  // Write the header into the space reserved for it, followed by a 'free' box
+  // for the unused space. Returns false if the header does not fit.
+  bool WriteHeaderIntoReservedSpace(Status* status);
+  // Move the media data written after the reserved space in the output file
+  // to the temporary file, to finalize by copying instead.
+  Status MoveMediaDataToTempFile();
+  // Write the header to the output file, followed by the media data copied
+  // from the temporary file.
+  Status WriteHeaderAndCopyMediaData();
+  // The file the media data is written to.
+  File* media_data_file() {
+    return reserved_header_size_ ? output_file_.get() : temp_file_.get();
+  }
+
   std::unique_ptr<SegmentIndex> vod_sidx_;
   std::string temp_file_name_;
   std::unique_ptr<File, FileCloser> temp_file_;
+  // Only used if the header space is reserved in the output file.
+  std::unique_ptr<File, FileCloser> output_file_;
+  uint64_t reserved_header_size_ = 0;
 
   DISALLOW_COPY_AND_ASSIGN(SingleSegmentSegmenter);
 };
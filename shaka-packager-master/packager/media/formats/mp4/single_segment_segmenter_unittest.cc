@@ -0,0 +1,248 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/formats/mp4/single_segment_segmenter.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "packager/base/time/clock.h"
+#include "packager/file/file.h"
+#include "packager/file/memory_file.h"
+#include "packager/media/base/media_handler_test_base.h"
+#include "packager/media/base/muxer_options.h"
+#include "packager/media/event/mock_muxer_listener.h"
+#include "packager/media/formats/mp4/box_definitions.h"
+#include "packager/media/formats/mp4/box_reader.h"
+#include "packager/media/formats/mp4/mp4_muxer.h"
+#include "packager/status_test_util.h"
+
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::SaveArg;
+
+namespace shaka {
+namespace media {
+namespace mp4 {
+namespace {
+
+const size_t kStreamIndex = 0;
+const uint32_t kTimeScale = 1000;
+// Each sample is 0.1 second long.
+const int64_t kSampleDuration = 100;
+const int kSamplesPerSecond = 10;
+const char kOutputFileName[] = "memory://output-file.mp4";
+const char kTempDir[] = "memory://temp/";
+const bool kIsKeyFrame = true;
+const bool kIsSubsegment = true;
+const size_t kBoxHeaderSize = 8;
+
+class TestClock : public base::Clock {
+ public:
+  explicit TestClock(const base::Time& t) : time_(t) {}
+  ~TestClock() override {}
+  base::Time Now() override { return time_; }
+
+ private:
+  base::Time time_;
+};
+
+// Returns the type of the box at |offset| of |contents|.
+std::string BoxTypeAt(const std::string& contents, uint64_t offset) {
+  return contents.substr(offset + sizeof(uint32_t), sizeof(uint32_t));
+}
+
+// Returns the size of the box at |offset| of |contents|.
+uint32_t BoxSizeAt(const std::string& contents, uint64_t offset) {
+  uint32_t size = 0;
+  for (size_t i = 0; i < sizeof(size); ++i)
+    size = (size << 8) | static_cast<uint8_t>(contents[offset + i]);
+  return size;
+}
+
+}  // namespace
+
+class SingleSegmentSegmenterTest : public MediaHandlerTestBase {
+ public:
+  SingleSegmentSegmenterTest() : clock_(base::Time::Now()) {}
+
+ protected:
+  void TearDown() override { MemoryFile::DeleteAll(); }
+
+  MuxerOptions CreateMuxerOptions(bool reserve_header_space) const {
+    MuxerOptions options;
+    options.output_file_name = kOutputFileName;
+    options.temp_dir = kTempDir;
+    options.mp4_params.reserve_header_space = reserve_header_space;
+    return options;
+  }
+
+  // Writes |num_subsegments| subsegments, each with
+  // |samples_per_subsegment| samples, for a stream whose duration is declared
+  // as |stream_duration|. Returns the contents of the output file. The media
+  // ranges reported to the listener are stored in |init_range_|,
+  // |index_range_| and |subsegment_ranges_|.
+  std::string WriteSubsegments(const MuxerOptions& options,
+                               uint64_t stream_duration,
+                               int num_subsegments,
+                               int samples_per_subsegment) {
+    std::shared_ptr<MP4Muxer> muxer(new MP4Muxer(options));
+    muxer->set_clock(&clock_);
+    std::unique_ptr<MockMuxerListener> listener(
+        new ::testing::NiceMock<MockMuxerListener>);
+    EXPECT_CALL(*listener, OnMediaEndMock(_, _, _, _, _, _, _, _, _))
+        .WillOnce(DoAll(SaveArg<1>(&init_range_.start),
+                        SaveArg<2>(&init_range_.end),
+                        SaveArg<4>(&index_range_.start),
+                        SaveArg<5>(&index_range_.end),
+                        SaveArg<7>(&subsegment_ranges_)));
+    muxer->SetMuxerListener(std::move(listener));
+
+    std::shared_ptr<FakeInputMediaHandler> input(new FakeInputMediaHandler);
+    EXPECT_OK(input->AddHandler(muxer));
+    EXPECT_OK(input->Initialize());
+
+    std::shared_ptr<StreamInfo> info = GetVideoStreamInfo(kTimeScale);
+    info->set_duration(stream_duration);
+    EXPECT_OK(
+        input->Dispatch(StreamData::FromStreamInfo(kStreamIndex, info)));
+
+    int64_t timestamp = 0;
+    for (int i = 0; i < num_subsegments; ++i) {
+      const int64_t segment_start = timestamp;
+      for (int j = 0; j < samples_per_subsegment; ++j) {
+        EXPECT_OK(input->Dispatch(StreamData::FromMediaSample(
+            kStreamIndex,
+            GetMediaSample(timestamp, kSampleDuration, kIsKeyFrame))));
+        timestamp += kSampleDuration;
+      }
+      // Subsegments of on-demand profile output are finalized as segments.
+      EXPECT_OK(input->Dispatch(StreamData::FromSegmentInfo(
+          kStreamIndex, GetSegmentInfo(segment_start,
+                                       timestamp - segment_start,
+                                       !kIsSubsegment))));
+    }
+    EXPECT_OK(input->FlushAllDownstreams());
+
+    std::string contents;
+    EXPECT_TRUE(File::ReadFileToString(kOutputFileName, &contents));
+    return contents;
+  }
+
+  TestClock clock_;
+  Range init_range_ = {};
+  Range index_range_ = {};
+  std::vector<Range> subsegment_ranges_;
+};
+
+TEST_F(SingleSegmentSegmenterTest, ReserveHeaderSpace) {
+  const int kNumSubsegments = 5;
+  const uint64_t kStreamDuration = kNumSubsegments * kTimeScale;
+
+  const std::string expected_contents =
+      WriteSubsegments(CreateMuxerOptions(false), kStreamDuration,
+                       kNumSubsegments, kSamplesPerSecond);
+  const Range expected_index_range = index_range_;
+  ASSERT_EQ(static_cast<size_t>(kNumSubsegments), subsegment_ranges_.size());
+  const uint64_t expected_media_start = subsegment_ranges_[0].start;
+  EXPECT_EQ(expected_index_range.end + 1, expected_media_start);
+
+  const std::string contents =
+      WriteSubsegments(CreateMuxerOptions(true), kStreamDuration,
+                       kNumSubsegments, kSamplesPerSecond);
+
+  // ftyp and moov are not affected by the reserved space.
+  EXPECT_EQ(0u, init_range_.start);
+  EXPECT_EQ(init_range_.end + 1, index_range_.start);
+  EXPECT_EQ(expected_contents.substr(0, index_range_.start),
+            contents.substr(0, index_range_.start));
+
+  // The sidx is right after the header, followed by a 'free' box for the
+  // unused space and then the subsegments.
+  ASSERT_EQ(static_cast<size_t>(kNumSubsegments), subsegment_ranges_.size());
+  const uint64_t free_box_start = index_range_.end + 1;
+  const uint64_t free_box_size = subsegment_ranges_[0].start - free_box_start;
+  ASSERT_LE(kBoxHeaderSize, free_box_size);
+  EXPECT_EQ("free", BoxTypeAt(contents, free_box_start));
+  EXPECT_EQ(free_box_size, BoxSizeAt(contents, free_box_start));
+
+  // The sidx references the media data after the 'free' box.
+  bool err = false;
+  std::unique_ptr<BoxReader> reader(BoxReader::ReadBox(
+      reinterpret_cast<const uint8_t*>(contents.data() + index_range_.start),
+      index_range_.end - index_range_.start + 1, &err));
+  ASSERT_TRUE(reader);
+  SegmentIndex sidx;
+  ASSERT_TRUE(sidx.Parse(reader.get()));
+  EXPECT_EQ(free_box_size, sidx.first_offset);
+  ASSERT_EQ(static_cast<size_t>(kNumSubsegments), sidx.references.size());
+  EXPECT_EQ(index_range_.end - index_range_.start + 1,
+            expected_index_range.end - expected_index_range.start + 1);
+
+  for (size_t i = 0; i < subsegment_ranges_.size(); ++i) {
+    const Range& range = subsegment_ranges_[i];
+    EXPECT_EQ("moof", BoxTypeAt(contents, range.start));
+    EXPECT_EQ(sidx.references[i].referenced_size, range.end - range.start + 1);
+    if (i > 0)
+      EXPECT_EQ(subsegment_ranges_[i - 1].end + 1, range.start);
+  }
+  EXPECT_EQ(contents.size(), subsegment_ranges_.back().end + 1);
+
+  // The media data is the same as if the header space were not reserved.
+  EXPECT_EQ(expected_contents.substr(expected_media_start),
+            contents.substr(subsegment_ranges_[0].start));
+}
+
+TEST_F(SingleSegmentSegmenterTest, ReservedHeaderSpaceTooSmall) {
+  // The header space is estimated from the stream duration, so it is too small
+  // if the stream turns out to be much longer.
+  const int kNumSubsegments = 200;
+  const uint64_t kStreamDuration = kTimeScale;
+
+  const std::string expected_contents =
+      WriteSubsegments(CreateMuxerOptions(false), kStreamDuration,
+                       kNumSubsegments, kSamplesPerSecond);
+  const Range expected_index_range = index_range_;
+  ASSERT_EQ(static_cast<size_t>(kNumSubsegments), subsegment_ranges_.size());
+  const Range expected_first_range = subsegment_ranges_[0];
+
+  // The media data is copied after the header instead.
+  EXPECT_EQ(expected_contents,
+            WriteSubsegments(CreateMuxerOptions(true), kStreamDuration,
+                             kNumSubsegments, kSamplesPerSecond));
+  EXPECT_EQ(expected_index_range.end, index_range_.end);
+  ASSERT_EQ(static_cast<size_t>(kNumSubsegments), subsegment_ranges_.size());
+  EXPECT_EQ(expected_first_range.start, subsegment_ranges_[0].start);
+  EXPECT_EQ(expected_contents.size(), subsegment_ranges_.back().end + 1);
+}
+
+TEST_F(SingleSegmentSegmenterTest,
+       ReservedHeaderSpaceTooSmallForShortSubsegments) {
+  // The header space is estimated assuming that subsegments are not shorter
+  // than one second, so it is too small for many shorter subsegments even if
+  // the stream duration is right.
+  const int kNumSubsegments = 300;
+  const int kSamplesPerSubsegment = 1;
+  const uint64_t kStreamDuration =
+      kNumSubsegments * kSamplesPerSubsegment * kSampleDuration;
+
+  const std::string expected_contents =
+      WriteSubsegments(CreateMuxerOptions(false), kStreamDuration,
+                       kNumSubsegments, kSamplesPerSubsegment);
+  ASSERT_EQ(static_cast<size_t>(kNumSubsegments), subsegment_ranges_.size());
+  const Range expected_first_range = subsegment_ranges_[0];
+
+  EXPECT_EQ(expected_contents,
+            WriteSubsegments(CreateMuxerOptions(true), kStreamDuration,
+                             kNumSubsegments, kSamplesPerSubsegment));
+  ASSERT_EQ(static_cast<size_t>(kNumSubsegments), subsegment_ranges_.size());
+  EXPECT_EQ(expected_first_range.start, subsegment_ranges_[0].start);
+  EXPECT_EQ(expected_contents.size(), subsegment_ranges_.back().end + 1);
+}
+
+}  // namespace mp4
+}  // namespace media
+}  // namespace shaka
@@ -6,12 +6,35 @@
 
 #include "packager/media/formats/webm/mkv_writer.h"
 
+#include <string.h>
+
+#include <algorithm>
+
+#include <gflags/gflags.h>
+
+DEFINE_uint64(webm_write_buffer_size,
+              4ULL << 20,
+              "Size of the buffer combining the writes to WebM output files, "
+              "in bytes. It should hold a segment, so that the sizes written "
+              "at the end of a segment are patched in memory. Specify 0 to "
+              "write to the files directly.");
+
 namespace shaka {
 namespace media {
 
-MkvWriter::MkvWriter() : position_(0) {}
+MkvWriter::MkvWriter() : MkvWriter(FLAGS_webm_write_buffer_size) {}
 
-MkvWriter::~MkvWriter() {}
+MkvWriter::MkvWriter(size_t buffer_size)
+    : position_(0),
+      seekable_(false),
+      buffer_size_(buffer_size),
+      buffer_position_(0) {}
+
+MkvWriter::~MkvWriter() {
+  // The file is closed by |file_|, possibly without calling Close().
+  if (file_ && !WriteBufferedData())
+    LOG(ERROR) << "Failed to write buffered data to " << file_->file_name();
+}
 
 Status MkvWriter::Open(const std::string& name) {
   DCHECK(!file_);
@@ -23,12 +46,15 @@ Status MkvWriter::Open(const std::string& name) {
   // on File.
   seekable_ = file_->Seek(0);
   position_ = 0;
+  buffer_.clear();
+  buffer_position_ = 0;
   return Status::OK;
 }
 
 Status MkvWriter::Close() {
   const std::string file_name = file_->file_name();
-  if (!file_.release()->Close()) {
+  const bool data_written = WriteBufferedData();
+  if (!file_.release()->Close() || !data_written) {
     return Status(
         error::FILE_FAILURE,
         "Cannot close file " + file_name +
@@ -40,19 +66,34 @@ Status MkvWriter::Close() {
 mkvmuxer::int32 MkvWriter::Write(const void* buf, mkvmuxer::uint32 len) {
   DCHECK(file_);
 
-  const char* data = reinterpret_cast<const char*>(buf);
-  int64_t total_bytes_written = 0;
-  while (total_bytes_written < len) {
-    const int64_t written =
-        file_->Write(data + total_bytes_written, len - total_bytes_written);
-    if (written < 0)
-      return written;
-
-    total_bytes_written += written;
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(buf);
+  size_t size = len;
+  // Overwrite the data which is still buffered, e.g. a back-patched size.
+  const mkvmuxer::int64 buffer_end = buffer_position_ + buffer_.size();
+  if (position_ < buffer_end) {
+    const size_t overwrite_size =
+        std::min<size_t>(size, buffer_end - position_);
+    memcpy(&buffer_[position_ - buffer_position_], data, overwrite_size);
+    data += overwrite_size;
+    size -= overwrite_size;
+    position_ += overwrite_size;
   }
+  if (size == 0)
+    return 0;
 
-  DCHECK_EQ(total_bytes_written, len);
-  position_ += len;
+  if (buffer_.size() + size > buffer_size_) {
+    if (!FlushBuffer())
+      return -1;
+    if (size >= buffer_size_) {
+      if (!WriteToFile(data, size))
+        return -1;
+      position_ += size;
+      buffer_position_ = position_;
+      return 0;
+    }
+  }
+  buffer_.insert(buffer_.end(), data, data + size);
+  position_ += size;
   return 0;
 }
 
@@ -63,11 +104,14 @@ int64_t MkvWriter::WriteFromFile(File* source) {
 int64_t MkvWriter::WriteFromFile(File* source, int64_t max_copy) {
   DCHECK(file_);
 
+  if (!FlushBuffer())
+    return -1;
   const int64_t size = File::CopyFile(source, file_.get(), max_copy);
   if (size < 0)
     return size;
 
   position_ += size;
+  buffer_position_ = position_;
   return size;
 }
 
@@ -78,12 +122,17 @@ mkvmuxer::int64 MkvWriter::Position() const {
 mkvmuxer::int32 MkvWriter::Position(mkvmuxer::int64 position) {
   DCHECK(file_);
 
-  if (file_->Seek(position)) {
+  if (position >= buffer_position_ &&
+      position <= buffer_position_ + static_cast<int64_t>(buffer_.size())) {
     position_ = position;
     return 0;
-  } else {
-    return -1;
   }
+  // Leave the buffered data alone if the file cannot seek anyway.
+  if (!seekable_ || !WriteBufferedData() || !file_->Seek(position))
+    return -1;
+  position_ = position;
+  buffer_position_ = position;
+  return 0;
 }
 
 bool MkvWriter::Seekable() const {
@@ -93,5 +142,38 @@ bool MkvWriter::Seekable() const {
 void MkvWriter::ElementStartNotify(mkvmuxer::uint64 element_id,
                                    mkvmuxer::int64 position) {}
 
+bool MkvWriter::WriteToFile(const uint8_t* data, size_t len) {
+  size_t total_bytes_written = 0;
+  while (total_bytes_written < len) {
+    const int64_t written =
+        file_->Write(data + total_bytes_written, len - total_bytes_written);
+    if (written < 0)
+      return false;
+
+    total_bytes_written += written;
+  }
+  return true;
+}
+
+bool MkvWriter::WriteBufferedData() {
+  if (buffer_.empty())
+    return true;
+  const bool written = WriteToFile(buffer_.data(), buffer_.size());
+  buffer_position_ += buffer_.size();
+  buffer_.clear();
+  return written;
+}
+
+bool MkvWriter::FlushBuffer() {
+  if (!WriteBufferedData())
+    return false;
+  if (position_ != buffer_position_) {
+    if (!file_->Seek(position_))
+      return false;
+    buffer_position_ = position_;
+  }
+  return true;
+}
+
 }  // namespace media
 }  // namespace shaka
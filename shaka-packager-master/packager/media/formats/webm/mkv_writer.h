@@ -9,6 +9,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "packager/file/file_closer.h"
 #include "packager/status.h"
@@ -17,10 +18,16 @@
 namespace shaka {
 namespace media {
 
-/// An implementation of IMkvWriter using our File type.
+/// An implementation of IMkvWriter using our File type.  The many small
+/// writes of mkvmuxer are combined in a buffer before being written to the
+/// file.
 class MkvWriter : public mkvmuxer::IMkvWriter {
  public:
+  /// Creates a writer with a buffer of --webm_write_buffer_size bytes.
   MkvWriter();
+  /// Creates a writer with a buffer of @a buffer_size bytes.  The writes go
+  /// straight to the file if @a buffer_size is 0.
+  explicit MkvWriter(size_t buffer_size);
   ~MkvWriter() override;
 
   /// Opens the given file for writing.  This MUST be called before any other
@@ -28,7 +35,8 @@ class MkvWriter : public mkvmuxer::IMkvWriter {
   /// @param name The path to the file to open.
   /// @return Whether the operation succeeded.
   Status Open(const std::string& name);
-  /// Closes the file.  MUST call Open before calling any other methods.
+  /// Writes out the buffered data and closes the file.  MUST call Open before
+  /// calling any other methods.
   Status Close();
 
   /// Writes out @a len bytes of @a buf.
@@ -37,7 +45,8 @@ class MkvWriter : public mkvmuxer::IMkvWriter {
   /// @return The offset of the output position from the beginning of the
   ///         output.
   mkvmuxer::int64 Position() const override;
-  /// Set the current File position.
+  /// Set the current File position.  Seeking within the buffered data, e.g.
+  /// to back-patch the size of an element, does not touch the file.
   /// @return 0 on success.
   mkvmuxer::int32 Position(mkvmuxer::int64 position) override;
   /// @return true if the writer is seekable.
@@ -58,14 +67,30 @@ class MkvWriter : public mkvmuxer::IMkvWriter {
   /// @return The number of bytes written; or < 0 on error.
   int64_t WriteFromFile(File* source, int64_t max_copy);
 
+  /// @return The underlying file, which may not have the buffered data yet.
   File* file() { return file_.get(); }
 
  private:
+  // Writes |len| bytes of |data| to the file at its current position.
+  bool WriteToFile(const uint8_t* data, size_t len);
+  // Writes the buffered data to the file.
+  bool WriteBufferedData();
+  // Writes the buffered data to the file and moves the file position to
+  // |position_|, so that data can be written to the file directly.
+  bool FlushBuffer();
+
   std::unique_ptr<File, FileCloser> file_;
   // Keep track of the position and whether we can seek.
   mkvmuxer::int64 position_;
   bool seekable_;
 
+  const size_t buffer_size_;
+  // The data not written to the file yet, which goes at |buffer_position_|,
+  // the position of the file.  |position_| is always within the buffered data
+  // or right after it.
+  std::vector<uint8_t> buffer_;
+  mkvmuxer::int64 buffer_position_;
+
   DISALLOW_COPY_AND_ASSIGN(MkvWriter);
 };
 
@@ -0,0 +1,200 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gflags/gflags.h>
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "packager/base/bind.h"
+#include "packager/base/files/file_path.h"
+#include "packager/base/files/file_util.h"
+#include "packager/base/strings/string_number_conversions.h"
+#include "packager/base/strings/string_util.h"
+#include "packager/base/time/time.h"
+#include "packager/file/file.h"
+#include "packager/file/file_write_stats.h"
+#include "packager/media/base/media_sample.h"
+#include "packager/media/base/muxer_options.h"
+#include "packager/media/base/stream_info.h"
+#include "packager/media/formats/webm/two_pass_single_segment_segmenter.h"
+#include "packager/media/formats/webm/webm_media_parser.h"
+#include "packager/media/test/test_data_util.h"
+#include "packager/status_test_util.h"
+#include "packager/testing/perf/perf_test.h"
+
+DECLARE_uint64(io_cache_size);
+DECLARE_uint64(webm_write_buffer_size);
+
+namespace shaka {
+namespace media {
+namespace {
+
+const char kFileName[] = "bear-640x360.webm";
+const int kNumIterations = 20;
+// The default of --webm_write_buffer_size.
+const uint64_t kDefaultBufferSize = 4ULL << 20;
+
+void OnInit(std::shared_ptr<StreamInfo>* video_info,
+            const std::vector<std::shared_ptr<StreamInfo>>& stream_infos) {
+  for (const std::shared_ptr<StreamInfo>& info : stream_infos) {
+    if (info->stream_type() == kStreamVideo)
+      *video_info = info;
+  }
+}
+
+bool OnNewSample(const std::shared_ptr<StreamInfo>* video_info,
+                 std::vector<std::shared_ptr<MediaSample>>* samples,
+                 uint32_t track_id,
+                 const std::shared_ptr<MediaSample>& sample) {
+  if (*video_info && track_id == (*video_info)->track_id())
+    samples->push_back(sample);
+  return true;
+}
+
+// Returns the number of File::Write calls recorded so far.
+int64_t GetTotalNumFileWrites() {
+  int64_t num_writes = 0;
+  for (const FileWriteStats& stats :
+       FileWriteStatsRegistry::GetInstance()->GetStats()) {
+    num_writes += stats.num_writes;
+  }
+  return num_writes;
+}
+
+// Returns the number of write system calls made by the process so far, or -1
+// if it is not available. Only Linux reports it, in /proc/self/io.
+int64_t GetNumWriteSyscalls() {
+  const char kWriteSyscallsKey[] = "syscw:";
+  std::string io;
+  if (!base::ReadFileToString(
+          base::FilePath::FromUTF8Unsafe("/proc/self/io"), &io)) {
+    return -1;
+  }
+  const size_t key_pos = io.find(kWriteSyscallsKey);
+  if (key_pos == std::string::npos)
+    return -1;
+  const size_t value_pos = key_pos + strlen(kWriteSyscallsKey);
+  std::string value;
+  base::TrimWhitespaceASCII(
+      io.substr(value_pos, io.find('\n', value_pos) - value_pos),
+      base::TRIM_ALL, &value);
+  int64_t num_syscalls = 0;
+  return base::StringToInt64(value, &num_syscalls) ? num_syscalls : -1;
+}
+
+}  // namespace
+
+// Measures the writes made to package a WebM VOD output, with a single
+// segment, for a --webm_write_buffer_size. The threaded I/O cache is
+// disabled, so MkvWriter writes go to the local file directly. Local files
+// are written through stdio, which buffers small writes, so the File::Write
+// calls are reported separately from the write system calls, which are only
+// available on Linux. The system calls include the other writes of the
+// process, e.g. logging.
+class MkvWriterPerfTest : public testing::TestWithParam<uint64_t> {
+ protected:
+  void SetUp() override {
+    io_cache_size_ = FLAGS_io_cache_size;
+    FLAGS_io_cache_size = 0;
+    webm_write_buffer_size_ = FLAGS_webm_write_buffer_size;
+    FLAGS_webm_write_buffer_size = GetParam();
+
+    const std::vector<uint8_t> data = ReadTestDataFile(kFileName);
+    WebMMediaParser parser;
+    parser.Init(base::Bind(&OnInit, &video_info_),
+                base::Bind(&OnNewSample, &video_info_, &samples_), nullptr);
+    ASSERT_TRUE(parser.Parse(data.data(), static_cast<int>(data.size())));
+    ASSERT_TRUE(parser.Flush());
+    ASSERT_TRUE(video_info_);
+    ASSERT_FALSE(samples_.empty());
+
+    base::FilePath file_path;
+    ASSERT_TRUE(base::CreateTemporaryFile(&file_path));
+    output_file_name_ = file_path.AsUTF8Unsafe();
+  }
+
+  void TearDown() override {
+    base::DeleteFile(base::FilePath::FromUTF8Unsafe(output_file_name_), false);
+    FLAGS_io_cache_size = io_cache_size_;
+    FLAGS_webm_write_buffer_size = webm_write_buffer_size_;
+  }
+
+  // Packages the samples, with a segment starting at each key frame.
+  void Package() {
+    MuxerOptions options;
+    options.output_file_name = output_file_name_;
+    webm::TwoPassSingleSegmentSegmenter segmenter(options);
+    ASSERT_OK(segmenter.Initialize(*video_info_, nullptr, nullptr));
+    int64_t segment_start = samples_.front()->pts();
+    for (const std::shared_ptr<MediaSample>& sample : samples_) {
+      if (sample->is_key_frame() && sample->pts() > segment_start) {
+        ASSERT_OK(segmenter.FinalizeSegment(
+            segment_start, sample->pts() - segment_start, false));
+        segment_start = sample->pts();
+      }
+      ASSERT_OK(segmenter.AddSample(*sample));
+    }
+    const std::shared_ptr<MediaSample>& last_sample = samples_.back();
+    ASSERT_OK(segmenter.FinalizeSegment(
+        segment_start,
+        last_sample->pts() + last_sample->duration() - segment_start, false));
+    ASSERT_OK(segmenter.Finalize());
+  }
+
+  std::shared_ptr<StreamInfo> video_info_;
+  std::vector<std::shared_ptr<MediaSample>> samples_;
+  std::string output_file_name_;
+
+ private:
+  uint64_t io_cache_size_ = 0;
+  uint64_t webm_write_buffer_size_ = 0;
+};
+
+TEST_P(MkvWriterPerfTest, PackagingWrites) {
+  const std::string trace = GetParam() == 0 ? "unbuffered" : "buffered";
+  FileWriteStatsRegistry* registry = FileWriteStatsRegistry::GetInstance();
+  registry->EnableRecording();
+  const int64_t num_file_writes_before = GetTotalNumFileWrites();
+  const int64_t num_write_syscalls_before = GetNumWriteSyscalls();
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumIterations; ++i)
+    ASSERT_NO_FATAL_FAILURE(Package());
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  const int64_t num_write_syscalls_after = GetNumWriteSyscalls();
+  const int64_t num_file_writes =
+      GetTotalNumFileWrites() - num_file_writes_before;
+  registry->DisableRecording();
+
+  perf_test::PrintResult("webm_packaging_file_writes", "", trace,
+                         static_cast<double>(num_file_writes) / kNumIterations,
+                         "writes", true);
+  perf_test::PrintResult("webm_packaging_file_writes_per_sample", "", trace,
+                         static_cast<double>(num_file_writes) /
+                             (samples_.size() * kNumIterations),
+                         "writes", true);
+  if (num_write_syscalls_before >= 0 && num_write_syscalls_after >= 0) {
+    perf_test::PrintResult(
+        "webm_packaging_write_syscalls", "", trace,
+        static_cast<double>(num_write_syscalls_after -
+                            num_write_syscalls_before) /
+            kNumIterations,
+        "syscalls", true);
+  }
+  perf_test::PrintResult("webm_packaging_time", "", trace,
+                         elapsed.InMillisecondsF() / kNumIterations, "ms",
+                         true);
+}
+
+INSTANTIATE_TEST_CASE_P(BufferSizes,
+                        MkvWriterPerfTest,
+                        testing::Values(0, kDefaultBufferSize));
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,121 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/formats/webm/mkv_writer.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "packager/file/file.h"
+#include "packager/file/file_closer.h"
+#include "packager/file/memory_file.h"
+#include "packager/status_test_util.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const char kOutputFileName[] = "memory://output_file.webm";
+const char kInputFileName[] = "memory://input_file";
+const size_t kBufferSize = 8;
+
+}  // namespace
+
+class MkvWriterTest : public ::testing::Test {
+ protected:
+  void TearDown() override { MemoryFile::DeleteAll(); }
+
+  std::string GetOutput() {
+    std::string output;
+    EXPECT_TRUE(File::ReadFileToString(kOutputFileName, &output));
+    return output;
+  }
+};
+
+TEST_F(MkvWriterTest, CombinesWrites) {
+  MkvWriter writer(kBufferSize);
+  ASSERT_OK(writer.Open(kOutputFileName));
+  EXPECT_EQ(0, writer.Write("ab", 2));
+  EXPECT_EQ(0, writer.Write("cde", 3));
+  EXPECT_EQ(5, writer.Position());
+  EXPECT_EQ("", GetOutput());
+
+  // Filling the buffer writes out the buffered data.
+  EXPECT_EQ(0, writer.Write("fghi", 4));
+  EXPECT_EQ("abcde", GetOutput());
+  ASSERT_OK(writer.Close());
+  EXPECT_EQ("abcdefghi", GetOutput());
+}
+
+TEST_F(MkvWriterTest, PatchesBufferedData) {
+  MkvWriter writer(kBufferSize);
+  ASSERT_OK(writer.Open(kOutputFileName));
+  EXPECT_EQ(0, writer.Write("abcdef", 6));
+  EXPECT_EQ(0, writer.Position(1));
+  EXPECT_EQ(0, writer.Write("XY", 2));
+  EXPECT_EQ(3, writer.Position());
+  // Overwrites the end of the buffered data and appends to it.
+  EXPECT_EQ(0, writer.Position(5));
+  EXPECT_EQ(0, writer.Write("Zg", 2));
+  EXPECT_EQ("", GetOutput());
+  ASSERT_OK(writer.Close());
+  EXPECT_EQ("aXYdeZg", GetOutput());
+}
+
+TEST_F(MkvWriterTest, SeeksOutsideBufferedData) {
+  MkvWriter writer(kBufferSize);
+  ASSERT_OK(writer.Open(kOutputFileName));
+  // Writes larger than the buffer go to the file directly.
+  EXPECT_EQ(0, writer.Write("abcdefghij", 10));
+  EXPECT_EQ("abcdefghij", GetOutput());
+  EXPECT_EQ(0, writer.Write("kl", 2));
+  EXPECT_EQ(0, writer.Position(2));
+  EXPECT_EQ("abcdefghijkl", GetOutput());
+  EXPECT_EQ(0, writer.Write("XY", 2));
+  EXPECT_EQ(4, writer.Position());
+  ASSERT_OK(writer.Close());
+  EXPECT_EQ("abXYefghijkl", GetOutput());
+}
+
+TEST_F(MkvWriterTest, WritesFromFileAfterBufferedData) {
+  ASSERT_TRUE(File::WriteStringToFile(kInputFileName, "0123456789"));
+  std::unique_ptr<File, FileCloser> input(File::Open(kInputFileName, "r"));
+  ASSERT_TRUE(input);
+
+  MkvWriter writer(kBufferSize);
+  ASSERT_OK(writer.Open(kOutputFileName));
+  EXPECT_EQ(0, writer.Write("abcd", 4));
+  EXPECT_EQ(0, writer.Position(2));
+  EXPECT_EQ(3, writer.WriteFromFile(input.get(), 3));
+  EXPECT_EQ(5, writer.Position());
+  EXPECT_EQ(0, writer.Write("ef", 2));
+  ASSERT_OK(writer.Close());
+  EXPECT_EQ("ab012ef", GetOutput());
+}
+
+TEST_F(MkvWriterTest, WritesThroughWithoutBuffer) {
+  MkvWriter writer(0);
+  ASSERT_OK(writer.Open(kOutputFileName));
+  EXPECT_EQ(0, writer.Write("abc", 3));
+  EXPECT_EQ("abc", GetOutput());
+  EXPECT_EQ(0, writer.Position(1));
+  EXPECT_EQ(0, writer.Write("X", 1));
+  EXPECT_EQ("aXc", GetOutput());
+  ASSERT_OK(writer.Close());
+}
+
+TEST_F(MkvWriterTest, WritesBufferedDataWhenDestroyed) {
+  {
+    MkvWriter writer(kBufferSize);
+    ASSERT_OK(writer.Open(kOutputFileName));
+    EXPECT_EQ(0, writer.Write("abc", 3));
+  }
+  EXPECT_EQ("abc", GetOutput());
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -101,6 +101,7 @@ class Segmenter {
   uint64_t segment_payload_pos() const { return segment_payload_pos_; }
 
   uint64_t duration() const { return duration_; }
+  uint64_t time_scale() const { return time_scale_; }
 
   virtual Status DoInitialize() = 0;
   virtual Status DoFinalize() = 0;
@@ -6,6 +6,7 @@
 
 #include <gtest/gtest.h>
 #include <memory>
+#include "packager/file/file.h"
 #include "packager/media/formats/webm/segmenter_test_base.h"
 
 namespace shaka {
@@ -147,6 +148,24 @@ class SingleSegmentSegmenterTest : public SegmentTestBase {
             options, *info_, &segmenter_));
   }
 
+  // Writes |num_clusters| clusters of one sample each and returns the
+  // output.
+  std::string WriteClusters(const MuxerOptions& options, int num_clusters) {
+    set_cur_timestamp(0);
+    InitializeSegmenter(options);
+    for (int i = 0; i < num_clusters; i++) {
+      std::shared_ptr<MediaSample> sample =
+          CreateSample(kKeyFrame, kDuration, kNoSideData);
+      EXPECT_OK(segmenter_->AddSample(*sample));
+      EXPECT_OK(segmenter_->FinalizeSegment(i * kDuration, kDuration,
+                                            !kSubsegment));
+    }
+    EXPECT_OK(segmenter_->Finalize());
+    std::string contents;
+    EXPECT_TRUE(File::ReadFileToString(OutputFileName().c_str(), &contents));
+    return contents;
+  }
+
   std::shared_ptr<StreamInfo> info_;
   std::unique_ptr<webm::Segmenter> segmenter_;
 };
@@ -194,6 +213,47 @@ TEST_F(SingleSegmentSegmenterTest, SplitsClustersOnSegment) {
   EXPECT_EQ(3u, parser.GetFrameCountForCluster(1));
 }
 
+TEST_F(SingleSegmentSegmenterTest, ReserveCuesSpace) {
+  MuxerOptions options = CreateMuxerOptions();
+  options.webm_params.reserve_cues_space = true;
+  const std::string contents = WriteClusters(options, 3);
+
+  ClusterParser parser;
+  ASSERT_NO_FATAL_FAILURE(parser.PopulateFromSegment(OutputFileName()));
+  ASSERT_EQ(3u, parser.cluster_count());
+
+  // The Cues are right after the header, followed by a Void element for the
+  // unused space and then the clusters.
+  uint64_t init_start = 0;
+  uint64_t init_end = 0;
+  uint64_t index_start = 0;
+  uint64_t index_end = 0;
+  ASSERT_TRUE(segmenter_->GetInitRangeStartAndEnd(&init_start, &init_end));
+  ASSERT_TRUE(segmenter_->GetIndexRangeStartAndEnd(&index_start, &index_end));
+  EXPECT_EQ(init_end + 1, index_start);
+  const std::vector<Range> ranges = segmenter_->GetSegmentRanges();
+  ASSERT_EQ(3u, ranges.size());
+  ASSERT_LT(index_end + 1, ranges[0].start);
+  EXPECT_EQ(0xec, static_cast<uint8_t>(contents[index_end + 1]));
+  EXPECT_EQ(ranges[0].end + 1, ranges[1].start);
+  EXPECT_EQ(ranges[1].end + 1, ranges[2].start);
+  EXPECT_EQ(contents.size(), ranges[2].end + 1);
+  const char kClusterId[] = "\x1f\x43\xb6\x75";
+  for (const Range& range : ranges)
+    EXPECT_EQ(kClusterId, contents.substr(range.start, 4));
+}
+
+TEST_F(SingleSegmentSegmenterTest, ReservedCuesSpaceTooSmall) {
+  // The Cues space is estimated from the stream duration, so it is too small
+  // if the stream turns out to be much longer.
+  const int kNumClusters = 100;
+  MuxerOptions options = CreateMuxerOptions();
+  const std::string expected_contents = WriteClusters(options, kNumClusters);
+
+  options.webm_params.reserve_cues_space = true;
+  EXPECT_EQ(expected_contents, WriteClusters(options, kNumClusters));
+}
+
 TEST_F(SingleSegmentSegmenterTest, IgnoresSubsegment) {
   MuxerOptions options = CreateMuxerOptions();
   ASSERT_NO_FATAL_FAILURE(InitializeSegmenter(options));
@@ -7,6 +7,8 @@
 #include "packager/media/formats/webm/two_pass_single_segment_segmenter.h"
 
 #include <algorithm>
+#include <limits>
+#include <vector>
 
 #include "packager/file/file_util.h"
 #include "packager/media/base/media_sample.h"
@@ -60,6 +62,26 @@ bool ReadSkip(File* file, int64_t byte_count) {
   DCHECK_EQ(bytes_read, byte_count);
   return true;
 }
+
+// Writes a Void element of exactly |size| bytes, which must be at least 2.
+bool WriteVoid(MkvWriter* writer, uint64_t size) {
+  // The Void ID takes one byte. Payload sizes up to 126 are coded in one
+  // byte; larger ones are coded in eight bytes.
+  const uint64_t kVoidIdSize = 1;
+  const uint64_t kMaxOneByteCodedSize = 126;
+  DCHECK_GE(size, 2u);
+  const int32_t size_size =
+      size - kVoidIdSize - 1 <= kMaxOneByteCodedSize ? 1 : 8;
+  const uint64_t payload_size = size - kVoidIdSize - size_size;
+  if (mkvmuxer::WriteID(writer, mkvmuxer::kMkvVoid) != 0 ||
+      mkvmuxer::WriteUIntSize(writer, payload_size, size_size) != 0) {
+    return false;
+  }
+  const std::vector<uint8_t> payload(payload_size);
+  return payload_size == 0 ||
+         writer->Write(payload.data(),
+                       static_cast<mkvmuxer::uint32>(payload_size)) == 0;
+}
 }  // namespace
 
 TwoPassSingleSegmentSegmenter::TwoPassSingleSegmentSegmenter(
@@ -69,6 +91,21 @@ TwoPassSingleSegmentSegmenter::TwoPassSingleSegmentSegmenter(
 TwoPassSingleSegmentSegmenter::~TwoPassSingleSegmentSegmenter() {}
 
 Status TwoPassSingleSegmentSegmenter::DoInitialize() {
+  if (options().webm_params.reserve_cues_space) {
+    const uint64_t cues_size = EstimateCuesSize();
+    Status status;
+    if (cues_size > 0 && ReserveCuesSpace(cues_size, &status)) {
+      // There is nothing to copy at the end, unless the Cues do not fit.
+      set_progress_target(duration());
+      return status;
+    }
+    if (!status.ok())
+      return status;
+    LOG(WARNING) << "Unable to reserve Cues space in '"
+                 << options().output_file_name
+                 << "'. Clusters will be copied from a temporary file.";
+  }
+
   // Assume the amount of time to copy the temp file as the same amount
   // of time as to make it.
   set_progress_target(duration() * 2);
@@ -85,6 +122,18 @@ Status TwoPassSingleSegmentSegmenter::DoInitialize() {
 }
 
 Status TwoPassSingleSegmentSegmenter::DoFinalize() {
+  if (reserved_cues_size_ > 0) {
+    Status status;
+    if (WriteCuesIntoReservedSpace(&status))
+      return status;
+    LOG(WARNING) << "The Cues of '" << options().output_file_name
+                 << "' do not fit in the " << reserved_cues_size_
+                 << " bytes reserved. Clusters will be copied.";
+    status = MoveClustersToTempFile();
+    if (!status.ok())
+      return status;
+  }
+
   const uint64_t header_size = init_end() + 1;
   const uint64_t cues_pos = header_size - segment_payload_pos();
   const uint64_t cues_size = UpdateCues(cues());
@@ -137,6 +186,132 @@ Status TwoPassSingleSegmentSegmenter::DoFinalize() {
   return real_writer->Close();
 }
 
+uint64_t TwoPassSingleSegmentSegmenter::EstimateCuesSize() {
+  // There is one CuePoint per cluster. Clusters are assumed to be no shorter
+  // than |kMinClusterDurationInSeconds|.
+  const double kMinClusterDurationInSeconds = 1.0;
+
+  if (duration() == 0 || time_scale() == 0)
+    return 0;
+  const uint64_t max_num_cue_points =
+      static_cast<uint64_t>(duration() /
+                            (kMinClusterDurationInSeconds * time_scale())) +
+      1;
+  // The time and cluster position are not known yet, so assume the largest.
+  mkvmuxer::CuePoint cue_point;
+  cue_point.set_time(std::numeric_limits<int64_t>::max());
+  cue_point.set_track(track_id());
+  cue_point.set_cluster_pos(std::numeric_limits<int64_t>::max());
+  const uint64_t payload_size = cue_point.Size() * max_num_cue_points;
+  return mkvmuxer::EbmlMasterElementSize(mkvmuxer::kMkvCues, payload_size) +
+         payload_size;
+}
+
+bool TwoPassSingleSegmentSegmenter::ReserveCuesSpace(uint64_t cues_size,
+                                                     Status* status) {
+  std::unique_ptr<MkvWriter> writer(new MkvWriter);
+  *status = writer->Open(options().output_file_name);
+  if (!status->ok())
+    return false;
+  // The Cues are written into the reserved space at the end, which requires
+  // seeking back.
+  if (!writer->Seekable()) {
+    *status = writer->Close();
+    return false;
+  }
+  set_writer(std::move(writer));
+
+  *status = SingleSegmentSegmenter::DoInitialize();
+  if (!status->ok())
+    return true;
+  if (!WriteVoid(this->writer(), cues_size)) {
+    *status = Status(error::FILE_FAILURE, "Error reserving Cues space.");
+    return true;
+  }
+  reserved_cues_size_ = cues_size;
+  // The clusters start after the reserved space.
+  seek_head()->set_cluster_pos(init_end() + 1 + cues_size -
+                               segment_payload_pos());
+  return true;
+}
+
+bool TwoPassSingleSegmentSegmenter::WriteCuesIntoReservedSpace(
+    Status* status) {
+  const uint64_t cues_size = cues()->Size();
+  if (cues_size > reserved_cues_size_)
+    return false;
+  // A Void element takes at least two bytes.
+  const uint64_t void_size = reserved_cues_size_ - cues_size;
+  if (void_size == 1)
+    return false;
+
+  const uint64_t file_size = writer()->Position();
+  const uint64_t cues_start = init_end() + 1;
+  if (writer()->Position(cues_start) != 0) {
+    *status = Status(error::FILE_FAILURE, "Error seeking to Cues space.");
+    return true;
+  }
+  set_index_start(cues_start);
+  seek_head()->set_cues_pos(cues_start - segment_payload_pos());
+  if (!cues()->Write(writer())) {
+    *status = Status(error::FILE_FAILURE, "Error writing Cues data.");
+    return true;
+  }
+  set_index_end(writer()->Position() - 1);
+  if (void_size > 0 && !WriteVoid(writer(), void_size)) {
+    *status = Status(error::FILE_FAILURE, "Error writing Void element.");
+    return true;
+  }
+  DCHECK_EQ(writer()->Position(),
+            static_cast<int64_t>(cues_start + reserved_cues_size_));
+
+  // Rewrite the header with the final sizes and positions.
+  if (writer()->Position(0) != 0) {
+    *status = Status(error::FILE_FAILURE, "Error seeking to header.");
+    return true;
+  }
+  *status = WriteSegmentHeader(file_size, writer());
+  status->Update(writer()->Close());
+  return true;
+}
+
+Status TwoPassSingleSegmentSegmenter::MoveClustersToTempFile() {
+  const int64_t header_size = init_end() + 1;
+  Status status = writer()->Close();
+  set_writer(std::unique_ptr<MkvWriter>());
+  if (!status.ok())
+    return status;
+
+  std::unique_ptr<File, FileCloser> output_file(
+      File::Open(options().output_file_name.c_str(), "r"));
+  if (!output_file) {
+    return Status(error::FILE_FAILURE,
+                  "Cannot read file " + options().output_file_name);
+  }
+  if (!TempFilePath(options().temp_dir, &temp_file_name_))
+    return Status(error::FILE_FAILURE, "Unable to create temporary file.");
+  std::unique_ptr<MkvWriter> temp(new MkvWriter);
+  status = temp->Open(temp_file_name_);
+  if (!status.ok())
+    return status;
+
+  // The second pass expects the clusters right after the header, so the
+  // reserved space is left out.
+  if (temp->WriteFromFile(output_file.get(), header_size) != header_size ||
+      !ReadSkip(output_file.get(), reserved_cues_size_) ||
+      temp->WriteFromFile(output_file.get()) < 0) {
+    return Status(error::FILE_FAILURE,
+                  "Failed to copy clusters to " + temp_file_name_);
+  }
+  for (int i = 0; i < cues()->cue_entries_size(); ++i) {
+    mkvmuxer::CuePoint* cue = cues()->GetCueByIndex(i);
+    cue->set_cluster_pos(cue->cluster_pos() - reserved_cues_size_);
+  }
+  set_writer(std::move(temp));
+  reserved_cues_size_ = 0;
+  return Status::OK;
+}
+
 bool TwoPassSingleSegmentSegmenter::CopyFileWithClusterRewrite(
     File* source,
     MkvWriter* dest,
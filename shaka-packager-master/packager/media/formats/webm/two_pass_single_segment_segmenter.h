@@ -23,6 +23,10 @@ namespace webm {
 
 /// An implementation of a Segmenter for a single-segment that performs two
 /// passes.  This does not use seeking and is used for non-seekable files.
+/// If @b WebmOutputParams.reserve_cues_space is set and the output is
+/// seekable, the clusters are written to the output directly after space
+/// reserved for the Cues instead, and the second pass only runs if the Cues
+/// do not fit.
 class TwoPassSingleSegmentSegmenter : public SingleSegmentSegmenter {
  public:
   explicit TwoPassSingleSegmentSegmenter(const MuxerOptions& options);
@@ -33,6 +37,19 @@ class TwoPassSingleSegmentSegmenter : public SingleSegmentSegmenter {
   Status DoFinalize() override;
 
  private:
+  // Estimate the size of the Cues from the media duration. Returns 0 if the
+  // duration is unknown.
+  uint64_t EstimateCuesSize();
+  // Open the output file, write the header and reserve |cues_size| bytes for
+  // the Cues after it. Returns false if the output file does not support it.
+  bool ReserveCuesSpace(uint64_t cues_size, Status* status);
+  // Write the Cues into the space reserved for them, followed by a Void
+  // element for the unused space. Returns false if the Cues do not fit.
+  bool WriteCuesIntoReservedSpace(Status* status);
+  // Move the header and the clusters in the output file to the temporary
+  // file, to finalize in two passes instead.
+  Status MoveClustersToTempFile();
+
   /// Copies the data from source to destination while rewriting the Cluster
   /// sizes to the correct values.  This assumes that both @a source and
   /// @a dest are at the same position and that the headers have already
@@ -42,6 +59,8 @@ class TwoPassSingleSegmentSegmenter : public SingleSegmentSegmenter {
                                   uint64_t last_size);
 
   std::string temp_file_name_;
+  // Only set if the Cues space is reserved in the output file.
+  uint64_t reserved_cues_size_ = 0;
 
   DISALLOW_COPY_AND_ASSIGN(TwoPassSingleSegmentSegmenter);
 };
@@ -70,6 +70,7 @@
         'cluster_builder.h',
         'encrypted_segmenter_unittest.cc',
         'encryptor_unittest.cc',
+        'mkv_writer_unittest.cc',
         'multi_segment_segmenter_unittest.cc',
         'segmenter_test_base.cc',
         'segmenter_test_base.h',
@@ -78,6 +79,7 @@
         'tracks_builder.h',
         'webm_cluster_parser_unittest.cc',
         'webm_content_encodings_client_unittest.cc',
+        'webm_media_parser_unittest.cc',
         'webm_parser_unittest.cc',
         'webm_tracks_parser_unittest.cc',
         'webm_webvtt_parser_unittest.cc',
@@ -91,5 +93,21 @@
         'webm',
       ]
     },
+    {
+      'target_name': 'webm_perftest',
+      'type': '<(gtest_target_type)',
+      'sources': [
+        'mkv_writer_perftest.cc',
+      ],
+      'dependencies': [
+        '../../../file/file.gyp:file',
+        '../../../testing/gtest.gyp:gtest',
+        '../../../testing/perf/perf_test.gyp:perf_test',
+        '../../../third_party/gflags/gflags.gyp:gflags',
+        '../../../third_party/libwebm/libwebm.gyp:mkvmuxer',
+        '../../test/media_test.gyp:media_test_support',
+        'webm',
+      ],
+    },
   ],
 }
@@ -9,6 +9,7 @@
 
 #include "packager/base/logging.h"
 #include "packager/base/sys_byteorder.h"
+#include "packager/media/base/buffer_pool.h"
 #include "packager/media/base/decrypt_config.h"
 #include "packager/media/base/timestamp.h"
 #include "packager/media/codecs/vp8_parser.h"
@@ -96,6 +97,12 @@ bool WebMClusterParser::Flush() {
   return audio_result && video_result;
 }
 
+void WebMClusterParser::SetFileView(std::shared_ptr<const uint8_t> data,
+                                    uint64_t size) {
+  file_view_ = std::move(data);
+  file_view_size_ = size;
+}
+
 int WebMClusterParser::Parse(const uint8_t* buf, int size) {
   int result = parser_.Parse(buf, size);
 
@@ -253,7 +260,7 @@ bool WebMClusterParser::OnBinary(int id, const uint8_t* data, int size) {
                       "supported.";
         return false;
       }
-      block_data_.reset(new uint8_t[size]);
+      block_data_ = BufferPool::GetInstance()->Allocate(size);
       memcpy(block_data_.get(), data, size);
       block_data_size_ = size;
       return true;
@@ -273,7 +280,8 @@ bool WebMClusterParser::OnBinary(int id, const uint8_t* data, int size) {
       // element's value in Big Endian format. This is done to mimic ffmpeg
       // demuxer's behavior.
       block_additional_data_size_ = size + sizeof(block_add_id);
-      block_additional_data_.reset(new uint8_t[block_additional_data_size_]);
+      block_additional_data_ =
+          BufferPool::GetInstance()->Allocate(block_additional_data_size_);
       memcpy(block_additional_data_.get(), &block_add_id,
              sizeof(block_add_id));
       memcpy(block_additional_data_.get() + 8, data, size);
@@ -381,12 +389,17 @@ bool WebMClusterParser::OnBlock(bool is_simple_block,
     // Use a dummy data size of 0 to avoid copying overhead.
     // Actual media data is set later.
     const size_t kDummyDataSize = 0;
-    buffer = MediaSample::CopyFrom(media_data, kDummyDataSize, additional,
-                                   additional_size, is_key_frame);
+    buffer = MediaSample::CopyFrom(media_data, kDummyDataSize, nullptr, 0,
+                                   is_key_frame);
+    if (additional) {
+      // Only a BlockGroup has a BlockAdditional, which has been copied.
+      DCHECK_EQ(additional, block_additional_data_.get());
+      buffer->TransferSideData(block_additional_data_, additional_size);
+    }
 
     if (decrypt_config) {
       if (!decryptor_source_) {
-        buffer->SetData(media_data, media_data_size);
+        SetSampleData(media_data, media_data_size, buffer.get());
         // If the demuxer does not have the decryptor_source_, store
         // decrypt_config so that the demuxed sample can be decrypted later.
         buffer->set_decrypt_config(std::move(decrypt_config));
@@ -403,7 +416,7 @@ bool WebMClusterParser::OnBlock(bool is_simple_block,
         buffer->TransferData(std::move(decrypted_media_data), media_data_size);
       }
     } else {
-      buffer->SetData(media_data, media_data_size);
+      SetSampleData(media_data, media_data_size, buffer.get());
     }
   } else {
     std::string id, settings, content;
@@ -613,6 +626,32 @@ int64_t WebMClusterParser::Track::GetDurationEstimate() {
   return duration;
 }
 
+void WebMClusterParser::SetSampleData(const uint8_t* data,
+                                      size_t size,
+                                      MediaSample* sample) {
+  if (block_data_ && data >= block_data_.get() &&
+      data + size <= block_data_.get() + block_data_size_) {
+    // Hand the Block copied by OnBinary() over to the sample.
+    const size_t offset = data - block_data_.get();
+    sample->TransferData(
+        std::shared_ptr<uint8_t>(block_data_, block_data_.get() + offset),
+        size);
+    return;
+  }
+  if (IsInFileView(data, size)) {
+    // The sample keeps the file view alive.
+    sample->ShareData(std::shared_ptr<const uint8_t>(file_view_, data), size);
+    return;
+  }
+  sample->SetData(data, size);
+}
+
+bool WebMClusterParser::IsInFileView(const uint8_t* data, size_t size) const {
+  return file_view_ && data >= file_view_.get() &&
+         static_cast<uint64_t>(data - file_view_.get()) + size <=
+             file_view_size_;
+}
+
 void WebMClusterParser::ResetTextTracks() {
   for (TextTrackMap::iterator it = text_track_map_.begin();
        it != text_track_map_.end();
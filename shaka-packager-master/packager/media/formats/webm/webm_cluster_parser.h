@@ -142,6 +142,13 @@ class WebMClusterParser : public WebMParserClient {
   /// @return true on success, false otherwise.
   bool Flush() WARN_UNUSED_RESULT;
 
+  /// Set the contents of the file being parsed, e.g. a memory mapped file.
+  /// The samples whose data is in the file contents passed to Parse() share
+  /// it instead of having it copied.
+  /// @param data points to the file contents.
+  /// @param size is the size of the file contents.
+  void SetFileView(std::shared_ptr<const uint8_t> data, uint64_t size);
+
   /// Parses a WebM cluster element in |buf|.
   /// @return -1 if the parse fails.
   /// @return 0 if more data is needed.
@@ -179,6 +186,14 @@ class WebMClusterParser : public WebMParserClient {
                int64_t discard_padding,
                bool is_key_frame);
 
+  // Sets the |size| bytes of |data| as the data of |sample|, without copying
+  // them if they are in the Block copied from a BlockGroup or in the file
+  // view.
+  void SetSampleData(const uint8_t* data, size_t size, MediaSample* sample);
+
+  // Returns true if the |size| bytes of |data| are in |file_view_|.
+  bool IsInFileView(const uint8_t* data, size_t size) const;
+
   // Resets the Track objects associated with each text track.
   void ResetTextTracks();
 
@@ -207,12 +222,15 @@ class WebMClusterParser : public WebMParserClient {
   MediaParser::InitCB init_cb_;
 
   int64_t last_block_timecode_ = -1;
-  std::unique_ptr<uint8_t[]> block_data_;
+  // The Block and BlockAdditional of a BlockGroup are copied, as the
+  // BlockGroup may span several Parse() calls. The copies are handed over to
+  // the sample.
+  std::shared_ptr<uint8_t> block_data_;
   int block_data_size_ = -1;
   int64_t block_duration_ = -1;
   int64_t block_add_id_ = -1;
 
-  std::unique_ptr<uint8_t[]> block_additional_data_;
+  std::shared_ptr<uint8_t> block_additional_data_;
   // Must be 0 if |block_additional_data_| is null. Must be > 0 if
   // |block_additional_data_| is NOT null.
   int block_additional_data_size_ = 0;
@@ -226,6 +244,9 @@ class WebMClusterParser : public WebMParserClient {
   int64_t cluster_start_time_;
   bool cluster_ended_ = false;
 
+  std::shared_ptr<const uint8_t> file_view_;
+  uint64_t file_view_size_ = 0;
+
   Track audio_;
   Track video_;
   TextTrackMap text_track_map_;
@@ -9,6 +9,7 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -665,6 +666,77 @@ TEST_F(WebMClusterParserTest, ParseBlockGroup) {
   ASSERT_TRUE(VerifyBuffers(kBlockInfo, block_count));
 }
 
+TEST_F(WebMClusterParserTest, ParseBlockGroupWithBlockAdditional) {
+  const uint8_t kClusterData[] = {
+    0x1F, 0x43, 0xB6, 0x75, 0x9B,  // Cluster(size=27)
+    0xE7, 0x81, 0x00,  // Timecode(size=1, value=0)
+    0xA0, 0x96,  // BlockGroup(size=22)
+    0xA1, 0x85, 0x81, 0x00, 0x00, 0x00, 0xaa,  // Block(size=5, track=1, ts=0)
+    0x9B, 0x81, 0x17,  // BlockDuration(size=1, value=23)
+    0x75, 0xA1, 0x89,  // BlockAdditions(size=9)
+    0xA6, 0x87,  // BlockMore(size=7)
+    0xEE, 0x81, 0x01,  // BlockAddID(size=1, value=1)
+    0xA5, 0x82, 0xbb, 0xcc,  // BlockAdditional(size=2)
+  };
+  const int kClusterSize = arraysize(kClusterData);
+
+  EXPECT_EQ(kClusterSize, parser_->Parse(kClusterData, kClusterSize));
+  ASSERT_EQ(1u, audio_buffers_.size());
+  const std::shared_ptr<MediaSample>& sample = audio_buffers_[0];
+  ASSERT_EQ(1u, sample->data_size());
+  EXPECT_EQ(0xaa, sample->data()[0]);
+  EXPECT_TRUE(sample->writable_data());
+  // The BlockAddID in big endian followed by the BlockAdditional.
+  const uint8_t kExpectedSideData[] = {0, 0, 0, 0, 0, 0, 0, 1, 0xbb, 0xcc};
+  EXPECT_EQ(std::vector<uint8_t>(std::begin(kExpectedSideData),
+                                 std::end(kExpectedSideData)),
+            std::vector<uint8_t>(sample->side_data(),
+                                 sample->side_data() +
+                                     sample->side_data_size()));
+}
+
+TEST_F(WebMClusterParserTest, SharesSimpleBlocksInFileView) {
+  const int block_count = arraysize(kDefaultBlockInfo);
+  std::unique_ptr<Cluster> cluster(
+      CreateCluster(0, kDefaultBlockInfo, block_count));
+  std::shared_ptr<uint8_t> file_view(new uint8_t[cluster->size()],
+                                     std::default_delete<uint8_t[]>());
+  memcpy(file_view.get(), cluster->data(), cluster->size());
+  const uint8_t* file_view_end = file_view.get() + cluster->size();
+  parser_->SetFileView(file_view, cluster->size());
+
+  EXPECT_EQ(cluster->size(), parser_->Parse(file_view.get(), cluster->size()));
+  EXPECT_TRUE(parser_->Flush());
+  ASSERT_EQ(4u, audio_buffers_.size());
+  ASSERT_EQ(3u, video_buffers_.size());
+
+  const uint8_t kExpectedData[] = {0x00, 0x0A, 0x01, 0x0D, 0x02};
+  const std::vector<uint8_t> expected_data(std::begin(kExpectedData),
+                                           std::end(kExpectedData));
+  for (const BufferQueue* buffers : {&audio_buffers_, &video_buffers_}) {
+    for (const std::shared_ptr<MediaSample>& sample : *buffers) {
+      EXPECT_EQ(expected_data,
+                std::vector<uint8_t>(sample->data(),
+                                     sample->data() + sample->data_size()));
+    }
+  }
+  // The SimpleBlocks refer to the file view and are read-only.
+  for (const std::shared_ptr<MediaSample>& sample :
+       {audio_buffers_[0], audio_buffers_[1], audio_buffers_[2],
+        video_buffers_[0]}) {
+    EXPECT_GE(sample->data(), file_view.get());
+    EXPECT_LE(sample->data() + sample->data_size(), file_view_end);
+    EXPECT_FALSE(sample->writable_data());
+  }
+  // The Blocks of the BlockGroups are copied once and owned by the samples.
+  for (const std::shared_ptr<MediaSample>& sample :
+       {audio_buffers_[3], video_buffers_[1], video_buffers_[2]}) {
+    EXPECT_TRUE(sample->data() < file_view.get() ||
+                sample->data() >= file_view_end);
+    EXPECT_TRUE(sample->writable_data());
+  }
+}
+
 TEST_F(WebMClusterParserTest, ParseSimpleBlockAndBlockGroupMixture) {
   const BlockInfo kBlockInfo[] = {
       {kAudioTrackNum, 0, 23, true, NULL, 0, false},
@@ -4,6 +4,8 @@
 
 #include "packager/media/formats/webm/webm_media_parser.h"
 
+#include <algorithm>
+#include <limits>
 #include <string>
 
 #include "packager/base/callback.h"
@@ -15,10 +17,49 @@
 #include "packager/media/formats/webm/webm_constants.h"
 #include "packager/media/formats/webm/webm_content_encodings.h"
 #include "packager/media/formats/webm/webm_info_parser.h"
+#include "packager/media/formats/webm/webm_parser.h"
 #include "packager/media/formats/webm/webm_tracks_parser.h"
 
 namespace shaka {
 namespace media {
+namespace {
+
+// The size of the largest element header: a 4 bytes ID and an 8 bytes size.
+const int kMaxElementHeaderSize = 12;
+
+// Returns the number of bytes to add to the |size| bytes of |data|, which
+// start with the element the parser stopped at, for the parser to get past
+// it. The master elements whose children are parsed as they come only need
+// their header. Returns 0 if |data| has all the bytes needed already.
+int GetBytesNeededForElement(const uint8_t* data, int size) {
+  int id = 0;
+  int64_t element_size = 0;
+  const int header_size = WebMParseElementHeader(data, size, &id,
+                                                 &element_size);
+  if (header_size < 0)
+    return 0;
+  if (header_size == 0)
+    return std::max(kMaxElementHeaderSize - size, 1);
+
+  int64_t bytes_needed = header_size;
+  switch (id) {
+    case kWebMIdSegment:
+    case kWebMIdCluster:
+    case kWebMIdBlockGroup:
+    case kWebMIdBlockAdditions:
+    case kWebMIdBlockMore:
+      break;
+    default:
+      if (element_size != kWebMUnknownSize)
+        bytes_needed += element_size;
+      break;
+  }
+  return static_cast<int>(
+      std::min<int64_t>(std::max<int64_t>(bytes_needed - size, 0),
+                        std::numeric_limits<int>::max()));
+}
+
+}  // namespace
 
 WebMMediaParser::WebMMediaParser()
     : state_(kWaitingForInit), unknown_segment_size_(false) {}
@@ -44,6 +85,8 @@ bool WebMMediaParser::Flush() {
   DCHECK_NE(state_, kWaitingForInit);
 
   byte_queue_.Reset();
+  file_view_data_ = nullptr;
+  file_view_data_size_ = 0;
   bool result = true;
   if (cluster_parser_)
     result = cluster_parser_->Flush();
@@ -59,14 +102,76 @@ bool WebMMediaParser::Parse(const uint8_t* buf, int size) {
   if (state_ == kError)
     return false;
 
-  byte_queue_.Push(buf, size);
+  // The data left unparsed in the file view is parsed in place with |buf| if
+  // |buf| follows it, and queued otherwise.
+  if (file_view_data_size_ > 0) {
+    if (file_view_data_ + file_view_data_size_ == buf) {
+      buf = file_view_data_;
+      size += file_view_data_size_;
+    } else {
+      byte_queue_.Push(file_view_data_, file_view_data_size_);
+    }
+    file_view_data_ = nullptr;
+    file_view_data_size_ = 0;
+  }
+
+  // Complete the element left in the queue by the previous call, so that the
+  // rest of |buf| can be parsed in place. If the parser needs more than that
+  // element, e.g. the Tracks after the Info, all of |buf| is queued.
+  const uint8_t* queued_data = nullptr;
+  int queued_size = 0;
+  byte_queue_.Peek(&queued_data, &queued_size);
+  while (queued_size > 0 && size > 0) {
+    int bytes_to_queue = GetBytesNeededForElement(queued_data, queued_size);
+    if (bytes_to_queue == 0 || bytes_to_queue > size)
+      bytes_to_queue = size;
+    byte_queue_.Push(buf, bytes_to_queue);
+    buf += bytes_to_queue;
+    size -= bytes_to_queue;
+
+    byte_queue_.Peek(&queued_data, &queued_size);
+    const int result = ParseElements(queued_data, queued_size);
+    if (result < 0)
+      return false;
+    byte_queue_.Pop(result);
+    byte_queue_.Peek(&queued_data, &queued_size);
+  }
+  if (size == 0)
+    return true;
+
+  const int result = ParseElements(buf, size);
+  if (result < 0)
+    return false;
+  if (result < size) {
+    if (IsInFileView(buf + result, size - result)) {
+      file_view_data_ = buf + result;
+      file_view_data_size_ = size - result;
+    } else {
+      byte_queue_.Push(buf + result, size - result);
+    }
+  }
+  return true;
+}
+
+void WebMMediaParser::SetFileView(std::shared_ptr<const uint8_t> data,
+                                  uint64_t size) {
+  file_view_ = std::move(data);
+  file_view_size_ = size;
+  if (cluster_parser_)
+    cluster_parser_->SetFileView(file_view_, file_view_size_);
+}
+
+void WebMMediaParser::ChangeState(State new_state) {
+  DVLOG(1) << "ChangeState() : " << state_ << " -> " << new_state;
+  state_ = new_state;
+}
 
+int WebMMediaParser::ParseElements(const uint8_t* data, int size) {
   int result = 0;
   int bytes_parsed = 0;
-  const uint8_t* cur = NULL;
-  int cur_size = 0;
+  const uint8_t* cur = data;
+  int cur_size = size;
 
-  byte_queue_.Peek(&cur, &cur_size);
   while (cur_size > 0) {
     State oldState = state_;
     switch (state_) {
@@ -80,12 +185,12 @@ bool WebMMediaParser::Parse(const uint8_t* buf, int size) {
 
       case kWaitingForInit:
       case kError:
-        return false;
+        return -1;
     }
 
     if (result < 0) {
       ChangeState(kError);
-      return false;
+      return -1;
     }
 
     if (state_ == oldState && result == 0)
@@ -97,13 +202,13 @@ bool WebMMediaParser::Parse(const uint8_t* buf, int size) {
     bytes_parsed += result;
   }
 
-  byte_queue_.Pop(bytes_parsed);
-  return true;
+  return bytes_parsed;
 }
 
-void WebMMediaParser::ChangeState(State new_state) {
-  DVLOG(1) << "ChangeState() : " << state_ << " -> " << new_state;
-  state_ = new_state;
+bool WebMMediaParser::IsInFileView(const uint8_t* data, int size) const {
+  return file_view_ && data >= file_view_.get() &&
+         static_cast<uint64_t>(data - file_view_.get()) + size <=
+             file_view_size_;
 }
 
 int WebMMediaParser::ParseInfoAndTracks(const uint8_t* data, int size) {
@@ -214,6 +319,8 @@ int WebMMediaParser::ParseInfoAndTracks(const uint8_t* data, int size) {
       tracks_parser.audio_encryption_key_id(),
       tracks_parser.video_encryption_key_id(), new_sample_cb_, init_cb_,
       decryption_key_source_));
+  if (file_view_)
+    cluster_parser_->SetFileView(file_view_, file_view_size_);
 
   return bytes_parsed;
 }
@@ -5,6 +5,8 @@
 #ifndef PACKAGER_MEDIA_FORMATS_WEBM_WEBM_MEDIA_PARSER_H_
 #define PACKAGER_MEDIA_FORMATS_WEBM_WEBM_MEDIA_PARSER_H_
 
+#include <memory>
+
 #include "packager/base/callback_forward.h"
 #include "packager/base/compiler_specific.h"
 #include "packager/media/base/byte_queue.h"
@@ -29,6 +31,13 @@ class WebMMediaParser : public MediaParser {
   bool Parse(const uint8_t* buf, int size) override WARN_UNUSED_RESULT;
   /// @}
 
+  /// Set the contents of the file being parsed, e.g. a memory mapped file.
+  /// The samples whose data is in the file contents passed to Parse() share
+  /// it instead of having it copied.
+  /// @param data points to the file contents.
+  /// @param size is the size of the file contents.
+  void SetFileView(std::shared_ptr<const uint8_t> data, uint64_t size);
+
  private:
   enum State {
     kWaitingForInit,
@@ -39,6 +48,15 @@ class WebMMediaParser : public MediaParser {
 
   void ChangeState(State new_state);
 
+  // Parses the WebM elements in |data| according to |state_|.
+  //
+  // Returns < 0 if the parse fails.
+  // Returns the number of bytes parsed otherwise.
+  int ParseElements(const uint8_t* data, int size);
+
+  // Returns true if the |size| bytes of |data| are in |file_view_|.
+  bool IsInFileView(const uint8_t* data, int size) const;
+
   // Parses WebM Header, Info, Tracks elements. It also skips other level 1
   // elements that are not used right now. Once the Info & Tracks elements have
   // been parsed, this method will transition the parser from PARSING_HEADERS to
@@ -71,8 +89,17 @@ class WebMMediaParser : public MediaParser {
   bool unknown_segment_size_;
 
   std::unique_ptr<WebMClusterParser> cluster_parser_;
+  // The data is parsed in place, and only the data left unparsed at the end
+  // of a Parse() call is queued until the next call.
   ByteQueue byte_queue_;
 
+  std::shared_ptr<const uint8_t> file_view_;
+  uint64_t file_view_size_ = 0;
+  // Data left unparsed in |file_view_|, which is not queued as it is followed
+  // by the data of the next Parse() call when the file is parsed in order.
+  const uint8_t* file_view_data_ = nullptr;
+  int file_view_data_size_ = 0;
+
   DISALLOW_COPY_AND_ASSIGN(WebMMediaParser);
 };
 
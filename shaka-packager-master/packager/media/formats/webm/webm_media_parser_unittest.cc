@@ -0,0 +1,142 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/formats/webm/webm_media_parser.h"
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "packager/base/bind.h"
+#include "packager/media/base/media_sample.h"
+#include "packager/media/base/stream_info.h"
+#include "packager/media/test/test_data_util.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const char kFileName[] = "bear-640x360.webm";
+
+struct SampleInfo {
+  uint32_t track_id;
+  int64_t pts;
+  int64_t duration;
+  bool is_key_frame;
+  std::vector<uint8_t> data;
+
+  bool operator==(const SampleInfo& other) const {
+    return track_id == other.track_id && pts == other.pts &&
+           duration == other.duration && is_key_frame == other.is_key_frame &&
+           data == other.data;
+  }
+};
+
+// Parses a file and collects the streams and samples.
+class FileParser {
+ public:
+  // Parses the |data_size| bytes of |data| in chunks of |chunk_size| bytes.
+  // |file_view|, if not null, is set as the file view of the parser.
+  bool Parse(const uint8_t* data,
+             size_t data_size,
+             size_t chunk_size,
+             std::shared_ptr<const uint8_t> file_view) {
+    WebMMediaParser parser;
+    parser.Init(base::Bind(&FileParser::OnInit, base::Unretained(this)),
+                base::Bind(&FileParser::OnNewSample, base::Unretained(this)),
+                nullptr);
+    if (file_view)
+      parser.SetFileView(file_view, data_size);
+    for (size_t offset = 0; offset < data_size; offset += chunk_size) {
+      const size_t size = std::min(chunk_size, data_size - offset);
+      if (!parser.Parse(data + offset, static_cast<int>(size)))
+        return false;
+    }
+    return parser.Flush();
+  }
+
+  size_t num_streams() const { return num_streams_; }
+  const std::vector<std::shared_ptr<MediaSample>>& samples() const {
+    return samples_;
+  }
+  const std::vector<SampleInfo>& sample_infos() const {
+    return sample_infos_;
+  }
+
+ private:
+  void OnInit(const std::vector<std::shared_ptr<StreamInfo>>& streams) {
+    num_streams_ = streams.size();
+  }
+
+  bool OnNewSample(uint32_t track_id,
+                   const std::shared_ptr<MediaSample>& sample) {
+    samples_.push_back(sample);
+    sample_infos_.push_back(
+        {track_id, sample->pts(), sample->duration(), sample->is_key_frame(),
+         std::vector<uint8_t>(sample->data(),
+                              sample->data() + sample->data_size())});
+    return true;
+  }
+
+  size_t num_streams_ = 0;
+  std::vector<std::shared_ptr<MediaSample>> samples_;
+  std::vector<SampleInfo> sample_infos_;
+};
+
+}  // namespace
+
+// Parses the file in chunks of the size given as parameter, and compares the
+// samples with the samples of the file parsed in one call.
+class WebMMediaParserTest : public testing::TestWithParam<size_t> {
+ protected:
+  void SetUp() override {
+    data_ = ReadTestDataFile(kFileName);
+    ASSERT_FALSE(data_.empty());
+    ASSERT_TRUE(expected_.Parse(data_.data(), data_.size(), data_.size(),
+                                nullptr));
+    ASSERT_EQ(2u, expected_.num_streams());
+    ASSERT_FALSE(expected_.sample_infos().empty());
+  }
+
+  std::vector<uint8_t> data_;
+  FileParser expected_;
+};
+
+TEST_P(WebMMediaParserTest, ParsesInChunks) {
+  FileParser parser;
+  ASSERT_TRUE(parser.Parse(data_.data(), data_.size(), GetParam(), nullptr));
+  EXPECT_EQ(2u, parser.num_streams());
+  EXPECT_TRUE(expected_.sample_infos() == parser.sample_infos());
+}
+
+TEST_P(WebMMediaParserTest, SharesSamplesInFileView) {
+  std::shared_ptr<uint8_t> file_view(new uint8_t[data_.size()],
+                                     std::default_delete<uint8_t[]>());
+  memcpy(file_view.get(), data_.data(), data_.size());
+  const uint8_t* file_view_end = file_view.get() + data_.size();
+
+  FileParser parser;
+  ASSERT_TRUE(
+      parser.Parse(file_view.get(), data_.size(), GetParam(), file_view));
+  EXPECT_TRUE(expected_.sample_infos() == parser.sample_infos());
+
+  // The file only has SimpleBlocks, which refer to the file view.
+  for (const std::shared_ptr<MediaSample>& sample : parser.samples()) {
+    EXPECT_GE(sample->data(), file_view.get());
+    EXPECT_LE(sample->data() + sample->data_size(), file_view_end);
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(ChunkSizes,
+                        WebMMediaParserTest,
+                        testing::Values(1u, 7u, 1000u, 65536u));
+
+}  // namespace media
+}  // namespace shaka
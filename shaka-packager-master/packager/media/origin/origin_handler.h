@@ -26,6 +26,19 @@ class OriginHandler : public MediaHandler {
   // be used.
   virtual Status Run() = 0;
 
+  // Process a bounded amount of data, e.g. a single read from the alternative
+  // source, and send messages down stream. This allows many origin handlers to
+  // share a few threads. |done| is set to true when there is no more work to
+  // do, in which case the returned status is what |Run| would have returned.
+  // The default implementation does all the work in a single call to |Run|.
+  virtual Status RunStep(bool* done);
+
+  // Returns true if a call to |RunStep| may wait on the alternative source for
+  // an unbounded time, e.g. for a network input or a pipe. Such handlers are
+  // given a thread of their own instead of sharing one with other handlers.
+  // The default is true, as the default |RunStep| does all the work at once.
+  virtual bool MayBlock() const;
+
   // Non-blocking call to the handler, requesting that it exit the
   // current call to |Run|. The handler should stop processing data
   // as soon is convenient.
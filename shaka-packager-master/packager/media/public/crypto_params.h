@@ -64,6 +64,11 @@ struct WidevineEncryptionParams {
   WidevineSigner signer;
   /// Group identifier, if present licenses will belong to this group.
   std::vector<uint8_t> group_id;
+  /// The number of key rotation requests sent to the key server at the same
+  /// time. Every request fetches the keys of a batch of crypto periods, so the
+  /// keys are fetched up to this number of batches ahead. Only used if key
+  /// rotation is enabled.
+  uint32_t num_concurrent_key_requests = 3;
 };
 
 /// Playready encryption parameters.
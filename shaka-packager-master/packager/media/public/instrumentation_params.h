@@ -0,0 +1,34 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_PUBLIC_INSTRUMENTATION_PARAMS_H_
+#define PACKAGER_MEDIA_PUBLIC_INSTRUMENTATION_PARAMS_H_
+
+#include <string>
+
+namespace shaka {
+
+/// Pipeline instrumentation parameters.
+struct InstrumentationParams {
+  enum class DumpFormat { kText, kJson };
+
+  /// Time the media handlers and the writes to the output files, and count
+  /// the samples going through the handlers. The statistics are available
+  /// from Packager::GetStats().
+  bool enabled = false;
+  /// If greater than 0, the statistics are also dumped at this interval while
+  /// packaging, and once packaging is done. Requires `enabled`.
+  double dump_interval_in_seconds = 0;
+  /// The file the statistics are dumped to, which is replaced on every dump.
+  /// The statistics are logged if it is empty.
+  std::string dump_output;
+  /// Format of the dumped statistics.
+  DumpFormat dump_format = DumpFormat::kText;
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_PUBLIC_INSTRUMENTATION_PARAMS_H_
@@ -29,6 +29,13 @@ struct Mp4OutputParams {
   /// which is needed to workaround a Chromium bug that decoding timestamp is
   /// used in buffered range, https://crbug.com/398130.
   bool use_decoding_timestamp_in_timeline = false;
+  /// Reserve space for the header (ftyp, moov and sidx) at the start of the
+  /// on-demand (single segment) output, so the media data is written to the
+  /// output directly instead of being copied from a temporary file at the end.
+  /// Any unused reserved space is left in a 'free' box after the sidx. Falls
+  /// back to the copy if the header does not fit or the output is not
+  /// seekable.
+  bool reserve_header_space = false;
 };
 
 }  // namespace shaka
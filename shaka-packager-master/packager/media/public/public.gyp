@@ -16,7 +16,9 @@
         'ad_cue_generator_params.h',
         'chunking_params.h',
         'crypto_params.h',
+        'instrumentation_params.h',
         'mp4_output_params.h',
+        'webm_output_params.h',
       ],
     },
   ],
@@ -0,0 +1,24 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_PUBLIC_WEBM_OUTPUT_PARAMS_H_
+#define PACKAGER_MEDIA_PUBLIC_WEBM_OUTPUT_PARAMS_H_
+
+namespace shaka {
+
+/// WebM output related parameters.
+struct WebmOutputParams {
+  /// Reserve space for the Cues after the header of the single segment
+  /// output, so the clusters are written to the output directly instead of
+  /// being copied from a temporary file at the end. Any unused reserved space
+  /// is left in a Void element after the Cues. Falls back to the copy if the
+  /// Cues do not fit or the output is not seekable.
+  bool reserve_cues_space = false;
+};
+
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_PUBLIC_WEBM_OUTPUT_PARAMS_H_
@@ -16,8 +16,13 @@ Status Replicator::InitializeInternal() {
 Status Replicator::Process(std::unique_ptr<StreamData> stream_data) {
   Status status;
 
+  size_t num_outputs_remaining = output_handlers().size();
   for (auto& out : output_handlers()) {
-    std::unique_ptr<StreamData> copy(new StreamData(*stream_data));
+    // The last output takes the original message instead of a copy.
+    std::unique_ptr<StreamData> copy =
+        --num_outputs_remaining == 0
+            ? std::move(stream_data)
+            : std::unique_ptr<StreamData>(new StreamData(*stream_data));
     copy->stream_index = out.first;
 
     status.Update(Dispatch(std::move(copy)));
@@ -20,5 +20,20 @@
         '../base/media_base.gyp:media_base',
       ],
     },
+    {
+      'target_name': 'replicator_perftest',
+      'type': '<(gtest_target_type)',
+      'sources': [
+        'replicator_perftest.cc',
+      ],
+      'dependencies': [
+        '../../testing/gtest.gyp:gtest',
+        '../../testing/perf/perf_test.gyp:perf_test',
+        '../demuxer/demuxer.gyp:demuxer',
+        '../test/media_test.gyp:media_test_support',
+        '../test/media_test.gyp:perf_counters',
+        'replicator',
+      ],
+    },
   ],
 }
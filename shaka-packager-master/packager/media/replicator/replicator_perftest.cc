@@ -0,0 +1,91 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "packager/base/time/time.h"
+#include "packager/media/demuxer/demuxer.h"
+#include "packager/media/replicator/replicator.h"
+#include "packager/media/test/perf_counters.h"
+#include "packager/media/test/test_data_util.h"
+#include "packager/status_test_util.h"
+#include "packager/testing/perf/perf_test.h"
+
+namespace shaka {
+namespace media {
+namespace {
+
+const char kFileName[] = "bear-640x360.mp4";
+// Renditions packaged from the same input, e.g. for different DRM systems or
+// containers.
+const size_t kNumOutputs = 10;
+const int kNumIterations = 20;
+
+// Drops the stream data received, as a muxer does once a sample is written.
+class FakeMuxer : public MediaHandler {
+ public:
+  int64_t num_samples() const { return num_samples_; }
+
+ private:
+  Status InitializeInternal() override { return Status::OK; }
+
+  Status Process(std::unique_ptr<StreamData> stream_data) override {
+    if (stream_data->stream_data_type == StreamDataType::kMediaSample)
+      ++num_samples_;
+    return Status::OK;
+  }
+
+  int64_t num_samples_ = 0;
+};
+
+}  // namespace
+
+// Measures the heap allocations and the time per sample of demuxing a file and
+// fanning out its samples to several muxers.
+class ReplicatorPerfTest : public testing::Test {
+ protected:
+  // Demuxes the file once. Returns the number of samples received by the
+  // first muxer.
+  int64_t DemuxAndReplicate() {
+    Demuxer demuxer(GetTestDataFilePath(kFileName).AsUTF8Unsafe());
+    std::shared_ptr<Replicator> replicator(new Replicator);
+    std::vector<std::shared_ptr<FakeMuxer>> muxers;
+    for (size_t i = 0; i < kNumOutputs; ++i) {
+      muxers.emplace_back(new FakeMuxer);
+      EXPECT_OK(replicator->AddHandler(muxers.back()));
+    }
+    EXPECT_OK(demuxer.SetHandler("video", replicator));
+    EXPECT_OK(demuxer.Initialize());
+    EXPECT_OK(demuxer.Run());
+    return muxers.front()->num_samples();
+  }
+};
+
+TEST_F(ReplicatorPerfTest, AllocationsPerSample) {
+  // Warms up the pools, which are kept for the following iterations.
+  DemuxAndReplicate();
+
+  int64_t num_samples = 0;
+  const int64_t num_allocations_before = GetNumAllocations();
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kNumIterations; ++i)
+    num_samples += DemuxAndReplicate();
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  const int64_t num_allocations = GetNumAllocations() - num_allocations_before;
+  ASSERT_GT(num_samples, 0);
+
+  perf_test::PrintResult("allocations_per_sample", "", "replicator",
+                         static_cast<double>(num_allocations) / num_samples,
+                         "allocations", true);
+  perf_test::PrintResult("time_per_sample", "", "replicator",
+                         elapsed.InMillisecondsF() * 1000000 / num_samples,
+                         "ns", true);
+}
+
+}  // namespace media
+}  // namespace shaka
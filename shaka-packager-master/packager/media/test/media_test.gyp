@@ -31,5 +31,14 @@
         'run_tests_with_atexit_manager',
       ],
     },
+    {
+      # Replaces the global operator new. Only for perf tests.
+      'target_name': 'perf_counters',
+      'type': '<(component)',
+      'sources': [
+        'perf_counters.cc',
+        'perf_counters.h',
+      ],
+    },
   ],
 }
@@ -0,0 +1,61 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#include "packager/media/test/perf_counters.h"
+
+#include <stdlib.h>
+#if defined(OS_POSIX)
+#include <sys/resource.h>
+#endif  // defined(OS_POSIX)
+
+#include <atomic>
+#include <new>
+
+namespace {
+std::atomic<int64_t> g_num_allocations(0);
+}  // namespace
+
+void* operator new(size_t size) {
+  ++g_num_allocations;
+  void* ptr = malloc(size ? size : 1);
+  if (!ptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void* ptr, size_t size) noexcept {
+  free(ptr);
+}
+
+namespace shaka {
+namespace media {
+
+int64_t GetNumAllocations() {
+  return g_num_allocations;
+}
+
+int64_t GetPeakRssInBytes() {
+#if defined(OS_POSIX)
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#if defined(OS_MACOSX)
+  // ru_maxrss is in bytes on Mac and in kilobytes elsewhere.
+  return usage.ru_maxrss;
+#else
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+#endif  // defined(OS_MACOSX)
+#else
+  return 0;
+#endif  // defined(OS_POSIX)
+}
+
+}  // namespace media
+}  // namespace shaka
@@ -0,0 +1,27 @@
+// Copyright 2018 Google Inc. All rights reserved.
+//
+// Use of this source code is governed by a BSD-style
+// license that can be found in the LICENSE file or at
+// https://developers.google.com/open-source/licenses/bsd
+
+#ifndef PACKAGER_MEDIA_TEST_PERF_COUNTERS_H_
+#define PACKAGER_MEDIA_TEST_PERF_COUNTERS_H_
+
+#include <stdint.h>
+
+namespace shaka {
+namespace media {
+
+/// Linking perf_counters replaces the global operator new and operator delete
+/// to count the heap allocations of the process.
+/// @return the number of heap allocations made so far.
+int64_t GetNumAllocations();
+
+/// @return the peak resident set size of the process in bytes, or 0 if it is
+///         not available on the platform.
+int64_t GetPeakRssInBytes();
+
+}  // namespace media
+}  // namespace shaka
+
+#endif  // PACKAGER_MEDIA_TEST_PERF_COUNTERS_H_
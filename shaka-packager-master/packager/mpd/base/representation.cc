@@ -7,6 +7,7 @@
 #include "packager/mpd/base/representation.h"
 
 #include "packager/base/logging.h"
+#include "packager/base/strings/string_number_conversions.h"
 #include "packager/mpd/base/mpd_options.h"
 #include "packager/mpd/base/mpd_utils.h"
 #include "packager/mpd/base/xml/xml_node.h"
@@ -89,6 +90,26 @@ uint64_t LatestSegmentStartTime(const std::list<SegmentInfo>& segments) {
   return LastSegmentStartTime(latest_segment);
 }
 
+bool IsSameSegmentInfo(const SegmentInfo& a, const SegmentInfo& b) {
+  return a.start_time == b.start_time && a.duration == b.duration &&
+         a.repeat == b.repeat;
+}
+
+// Returns the first child element of |parent| named |name|, or null.
+xmlNodePtr FindChildElement(xmlNodePtr parent, const char* name) {
+  for (xmlNodePtr child = xmlFirstElementChild(parent); child;
+       child = xmlNextElementSibling(child)) {
+    if (xmlStrEqual(child->name, BAD_CAST name))
+      return child;
+  }
+  return nullptr;
+}
+
+void SetIntegerProperty(xmlNodePtr node, const char* name, uint64_t number) {
+  xmlSetProp(node, BAD_CAST name,
+             BAD_CAST base::Uint64ToString(number).c_str());
+}
+
 // Given |timeshift_limit|, finds out the number of segments that are no longer
 // valid and should be removed from |segment_info|.
 int SearchTimedOutRepeatIndex(uint64_t timeshift_limit,
@@ -179,12 +200,14 @@ bool Representation::Init() {
 
 void Representation::AddContentProtectionElement(
     const ContentProtectionElement& content_protection_element) {
+  xml_cache_.reset();
   content_protection_elements_.push_back(content_protection_element);
   RemoveDuplicateAttributes(&content_protection_elements_.back());
 }
 
 void Representation::UpdateContentProtectionPssh(const std::string& drm_uuid,
                                                  const std::string& pssh) {
+  xml_cache_.reset();
   UpdateContentProtectionPsshHelper(drm_uuid, pssh,
                                     &content_protection_elements_);
 }
@@ -210,11 +233,13 @@ void Representation::AddNewSegment(uint64_t start_time,
       size, static_cast<double>(duration) / media_info_.reference_time_scale());
 
   SlideWindow();
+  xml_cache_segments_changed_ = true;
   DCHECK_GE(segment_infos_.size(), 1u);
 }
 
 void Representation::SetSampleDuration(uint32_t sample_duration) {
   if (media_info_.has_video_info()) {
+    xml_cache_.reset();
     media_info_.mutable_video_info()->set_frame_duration(sample_duration);
     if (state_change_listener_) {
       state_change_listener_->OnSetFrameRateForRepresentation(
@@ -227,13 +252,35 @@ const MediaInfo& Representation::GetMediaInfo() const {
   return media_info_;
 }
 
+xml::scoped_xml_ptr<xmlNode> Representation::GetXml() {
+  if (xml_cache_ && xml_cache_suppression_flags_ == output_suppression_flags_ &&
+      (!xml_cache_segments_changed_ || UpdateXmlCacheSegments())) {
+    output_suppression_flags_ = 0;
+    return xml::scoped_xml_ptr<xmlNode>(xmlCopyNode(xml_cache_.get(), 1));
+  }
+
+  xml::scoped_xml_ptr<xmlNode> representation = GenerateXml();
+  if (!representation) {
+    xml_cache_.reset();
+    return representation;
+  }
+  xml_cache_.reset(xmlCopyNode(representation.get(), 1));
+  xml_cache_suppression_flags_ = output_suppression_flags_;
+  xml_cache_segment_infos_ = segment_infos_;
+  xml_cache_removed_segment_infos_ = 0;
+  xml_cache_segments_changed_ = false;
+
+  output_suppression_flags_ = 0;
+  return representation;
+}
+
 // Uses info in |media_info_| and |content_protection_elements_| to create a
 // "Representation" node.
 // MPD schema has strict ordering. The following must be done in order.
 // AddVideoInfo() (possibly adds FramePacking elements), AddAudioInfo() (Adds
 // AudioChannelConfig elements), AddContentProtectionElements*(), and
 // AddVODOnlyInfo() (Adds segment info).
-xml::scoped_xml_ptr<xmlNode> Representation::GetXml() {
+xml::scoped_xml_ptr<xmlNode> Representation::GenerateXml() {
   if (!HasRequiredMediaInfoFields()) {
     LOG(ERROR) << "MediaInfo missing required fields.";
     return xml::scoped_xml_ptr<xmlNode>();
@@ -292,10 +339,72 @@ xml::scoped_xml_ptr<xmlNode> Representation::GetXml() {
   // TODO(rkuroiwa): It is likely that all representations have the exact same
   // SegmentTemplate. Optimize and propagate the tag up to AdaptationSet level.
 
-  output_suppression_flags_ = 0;
   return representation.PassScopedPtr();
 }
 
+bool Representation::UpdateXmlCacheSegments() {
+  DCHECK(xml_cache_);
+  if (!media_info_.has_bandwidth()) {
+    SetIntegerProperty(xml_cache_.get(), "bandwidth",
+                       bandwidth_estimator_.Estimate());
+  }
+
+  if (HasLiveOnlyFields(media_info_)) {
+    xmlNodePtr segment_template =
+        FindChildElement(xml_cache_.get(), "SegmentTemplate");
+    xmlNodePtr segment_timeline =
+        segment_template ? FindChildElement(segment_template, "SegmentTimeline")
+                         : nullptr;
+    if (!segment_timeline)
+      return false;
+    // startNumber is only present with $Number$ templates.
+    if (xmlHasProp(segment_template, BAD_CAST "startNumber"))
+      SetIntegerProperty(segment_template, "startNumber", start_number_);
+
+    // |segment_infos_| only changes by losing or updating elements at the
+    // front as the window slides, and by updating its last element or adding
+    // elements as segments are added. Once the removed elements are dropped,
+    // the remaining ones line up with the <S> elements.
+    xmlNodePtr s_element = xmlFirstElementChild(segment_timeline);
+    auto cached_segment_info = xml_cache_segment_infos_.begin();
+    for (size_t i = 0; i < xml_cache_removed_segment_infos_ && s_element;
+         ++i) {
+      xmlNodePtr next_s_element = xmlNextElementSibling(s_element);
+      xmlUnlinkNode(s_element);
+      xmlFreeNode(s_element);
+      s_element = next_s_element;
+      ++cached_segment_info;
+    }
+    for (const SegmentInfo& segment_info : segment_infos_) {
+      if (!s_element) {
+        if (!xmlAddChild(segment_timeline,
+                         xml::CreateSegmentTimelineElement(segment_info)
+                             .release())) {
+          return false;
+        }
+        continue;
+      }
+      DCHECK(cached_segment_info != xml_cache_segment_infos_.end());
+      if (!IsSameSegmentInfo(segment_info, *cached_segment_info)) {
+        xmlNodePtr new_s_element =
+            xml::CreateSegmentTimelineElement(segment_info).release();
+        xmlReplaceNode(s_element, new_s_element);
+        xmlFreeNode(s_element);
+        s_element = new_s_element;
+      }
+      s_element = xmlNextElementSibling(s_element);
+      ++cached_segment_info;
+    }
+    if (s_element)
+      return false;
+    xml_cache_segment_infos_ = segment_infos_;
+  }
+
+  xml_cache_removed_segment_infos_ = 0;
+  xml_cache_segments_changed_ = false;
+  return true;
+}
+
 void Representation::SuppressOnce(SuppressFlag flag) {
   output_suppression_flags_ |= flag;
 }
@@ -421,6 +530,7 @@ void Representation::SlideWindow() {
       break;
     num_segments_removed += last->repeat + 1;
   }
+  xml_cache_removed_segment_infos_ += std::distance(first, last);
   segment_infos_.erase(first, last);
   start_number_ += num_segments_removed;
 
@@ -184,6 +184,15 @@ class Representation {
   // |start_number_| by the number of segments removed.
   void SlideWindow();
 
+  // Generates the <Representation> element from scratch.
+  xml::scoped_xml_ptr<xmlNode> GenerateXml();
+
+  // Brings |xml_cache_| up to date with the segments added since it was
+  // generated, by updating @bandwidth, SegmentTemplate@startNumber and only
+  // the <S> elements that changed. Returns false if |xml_cache_| does not have
+  // the expected structure, in which case it should be generated again.
+  bool UpdateXmlCacheSegments();
+
   // Note: Because 'mimeType' is a required field for a valid MPD, these return
   // strings.
   std::string GetVideoMimeType() const;
@@ -213,6 +222,20 @@ class Representation {
 
   // Bit vector for tracking witch attributes should not be output.
   int output_suppression_flags_;
+
+  // The last <Representation> element generated. It is copied by GetXml()
+  // instead of being generated again as long as only the segments change,
+  // which is what happens on every update of a live MPD.
+  xml::scoped_xml_ptr<xmlNode> xml_cache_;
+  // |output_suppression_flags_| used to generate |xml_cache_|.
+  int xml_cache_suppression_flags_ = 0;
+  // |segment_infos_| as reflected in |xml_cache_|.
+  std::list<SegmentInfo> xml_cache_segment_infos_;
+  // Number of elements removed from the front of |segment_infos_| since
+  // |xml_cache_segment_infos_| was updated.
+  size_t xml_cache_removed_segment_infos_ = 0;
+  // Whether segments were added since |xml_cache_| was updated.
+  bool xml_cache_segments_changed_ = false;
 };
 
 }  // namespace shaka
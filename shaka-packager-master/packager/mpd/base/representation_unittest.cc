@@ -964,6 +964,57 @@ TEST_F(TimeShiftBufferDepthTest, HugeGap) {
           expected_s_element, kDefaultStartNumber + kExpectedRemovedSegments)));
 }
 
+// The cached <Representation> updated with the new segments must be identical
+// to the one generated from scratch, as the window slides over segments with
+// varying durations and gaps.
+TEST_F(TimeShiftBufferDepthTest, CachedXmlMatchesGeneratedXml) {
+  const int kTimeShiftBufferDepth = 10;
+  mutable_mpd_options()->mpd_params.time_shift_buffer_depth =
+      kTimeShiftBufferDepth;
+
+  struct Segment {
+    uint64_t start_time;
+    uint64_t duration;
+    uint64_t size;
+  };
+  std::vector<Segment> segments;
+  uint64_t start_time = 0;
+  for (int i = 0; i < 80; ++i) {
+    // Mostly runs of 1 second segments, which are merged in one <S>, with a
+    // longer segment every 7 segments and a gap every 11 segments.
+    const uint64_t duration = i % 7 == 6 ? 1500 : kDefaultTimeScale;
+    if (i % 11 == 10)
+      start_time += 500;
+    segments.push_back({start_time, duration, 10000u + 100u * (i % 5)});
+    start_time += duration;
+  }
+
+  for (size_t i = 0; i < segments.size(); ++i) {
+    representation_->AddNewSegment(segments[i].start_time,
+                                   segments[i].duration, segments[i].size);
+    std::unique_ptr<Representation> generated_representation =
+        CreateRepresentation(representation_->GetMediaInfo(),
+                             kAnyRepresentationId, NoListener());
+    ASSERT_TRUE(generated_representation->Init());
+    for (size_t j = 0; j <= i; ++j) {
+      generated_representation->AddNewSegment(
+          segments[j].start_time, segments[j].duration, segments[j].size);
+    }
+    ASSERT_EQ(XmlNodeToString(generated_representation->GetXml().get()),
+              XmlNodeToString(representation_->GetXml().get()))
+        << "after segment " << i;
+  }
+}
+
+TEST_F(SegmentTemplateTest, CachedXmlUpdatedBySampleDuration) {
+  AddSegments(0, 10, 128, 0);
+  EXPECT_THAT(representation_->GetXml().get(),
+              AttributeEqual("frameRate", "10/5"));
+  representation_->SetSampleDuration(2);
+  EXPECT_THAT(representation_->GetXml().get(),
+              AttributeEqual("frameRate", "10/2"));
+}
+
 // Check if startNumber is working correctly.
 TEST_F(TimeShiftBufferDepthTest, ManySegments) {
   const int kTimeShiftBufferDepth = 1;
@@ -10,6 +10,7 @@
 
 #include "packager/base/logging.h"
 #include "packager/base/stl_util.h"
+#include "packager/file/file.h"
 #include "packager/mpd/base/adaptation_set.h"
 #include "packager/mpd/base/mpd_builder.h"
 #include "packager/mpd/base/mpd_notifier_util.h"
@@ -35,7 +36,8 @@ SimpleMpdNotifier::SimpleMpdNotifier(const MpdOptions& mpd_options)
       output_path_(mpd_options.mpd_params.mpd_output),
       mpd_builder_(new MpdBuilder(mpd_options)),
       content_protection_in_adaptation_set_(
-          mpd_options.mpd_params.generate_dash_if_iop_compliant_mpd) {
+          mpd_options.mpd_params.generate_dash_if_iop_compliant_mpd),
+      flush_done_(&flush_lock_) {
   for (const std::string& base_url : mpd_options.mpd_params.base_urls)
     mpd_builder_->AddBaseUrl(base_url);
 }
@@ -147,8 +149,38 @@ bool SimpleMpdNotifier::NotifyEncryptionUpdate(
 }
 
 bool SimpleMpdNotifier::Flush() {
-  base::AutoLock auto_lock(lock_);
-  return WriteMpdToFile(output_path_, mpd_builder_.get());
+  base::AutoLock auto_lock(flush_lock_);
+  const uint64_t flush_id = ++flushes_requested_;
+  while (flush_in_progress_)
+    flush_done_.Wait();
+  // The MPD written while waiting was generated after this flush was
+  // requested, so it has all the updates made before.
+  if (flushes_written_ >= flush_id)
+    return last_flush_succeeded_;
+
+  flush_in_progress_ = true;
+  const uint64_t last_flush_id = flushes_requested_;
+  bool success = false;
+  {
+    base::AutoUnlock auto_unlock(flush_lock_);
+    CHECK(!output_path_.empty());
+    std::string mpd;
+    {
+      base::AutoLock auto_lock(lock_);
+      success = mpd_builder_->ToString(&mpd);
+    }
+    if (!success) {
+      LOG(ERROR) << "Failed to write MPD to string.";
+    } else if (!File::WriteFileAtomically(output_path_.c_str(), mpd)) {
+      LOG(ERROR) << "Failed to write mpd to: " << output_path_;
+      success = false;
+    }
+  }
+  flush_in_progress_ = false;
+  flushes_written_ = last_flush_id;
+  last_flush_succeeded_ = success;
+  flush_done_.Broadcast();
+  return success;
 }
 
 Representation* SimpleMpdNotifier::AddRepresentationToPeriod(
@@ -12,6 +12,7 @@
 #include <string>
 #include <vector>
 
+#include "packager/base/synchronization/condition_variable.h"
 #include "packager/base/synchronization/lock.h"
 #include "packager/mpd/base/mpd_notifier.h"
 #include "packager/mpd/base/mpd_notifier_util.h"
@@ -81,6 +82,18 @@ class SimpleMpdNotifier : public MpdNotifier {
   bool content_protection_in_adaptation_set_ = true;
   base::Lock lock_;
 
+  // Flush() generates the MPD under |lock_| but writes it under |flush_lock_|
+  // only, so that muxers are not blocked by the file IO. Flushes requested
+  // while the MPD is being written are coalesced into a single write.
+  base::Lock flush_lock_;
+  base::ConditionVariable flush_done_;
+  bool flush_in_progress_ = false;
+  // Number of Flush() calls so far.
+  uint64_t flushes_requested_ = 0;
+  // Number of Flush() calls covered by the MPD written last.
+  uint64_t flushes_written_ = 0;
+  bool last_flush_succeeded_ = true;
+
   // Maps Representation ID to Representation.
   std::map<uint32_t, Representation*> representation_map_;
   // Maps Representation ID to AdaptationSet. This is for updating the PSSH.
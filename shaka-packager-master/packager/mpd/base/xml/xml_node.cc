@@ -33,16 +33,9 @@ std::string RangeToString(const Range& range) {
 
 bool PopulateSegmentTimeline(const std::list<SegmentInfo>& segment_infos,
                              XmlNode* segment_timeline) {
-  for (std::list<SegmentInfo>::const_iterator it = segment_infos.begin();
-       it != segment_infos.end();
-       ++it) {
-    XmlNode s_element("S");
-    s_element.SetIntegerAttribute("t", it->start_time);
-    s_element.SetIntegerAttribute("d", it->duration);
-    if (it->repeat > 0)
-      s_element.SetIntegerAttribute("r", it->repeat);
-
-    CHECK(segment_timeline->AddChild(s_element.PassScopedPtr()));
+  for (const SegmentInfo& segment_info : segment_infos) {
+    CHECK(segment_timeline->AddChild(
+        xml::CreateSegmentTimelineElement(segment_info)));
   }
 
   return true;
@@ -371,6 +364,16 @@ bool RepresentationXmlNode::AddLiveOnlyInfo(
          AddChild(segment_template.PassScopedPtr());
 }
 
+scoped_xml_ptr<xmlNode> CreateSegmentTimelineElement(
+    const SegmentInfo& segment_info) {
+  XmlNode s_element("S");
+  s_element.SetIntegerAttribute("t", segment_info.start_time);
+  s_element.SetIntegerAttribute("d", segment_info.duration);
+  if (segment_info.repeat > 0)
+    s_element.SetIntegerAttribute("r", segment_info.repeat);
+  return s_element.PassScopedPtr();
+}
+
 bool RepresentationXmlNode::AddAudioChannelInfo(const AudioInfo& audio_info) {
   std::string audio_channel_config_scheme;
   std::string audio_channel_config_value;
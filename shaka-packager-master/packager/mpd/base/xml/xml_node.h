@@ -182,6 +182,10 @@ class RepresentationXmlNode : public RepresentationBaseXmlNode {
   DISALLOW_COPY_AND_ASSIGN(RepresentationXmlNode);
 };
 
+/// Creates the <S> element of a SegmentTimeline for @a segment_info.
+scoped_xml_ptr<xmlNode> CreateSegmentTimelineElement(
+    const SegmentInfo& segment_info);
+
 }  // namespace xml
 }  // namespace shaka
 #endif  // MPD_BASE_XML_XML_NODE_H_
@@ -12,6 +12,7 @@
 #include "packager/app/libcrypto_threading.h"
 #include "packager/app/muxer_factory.h"
 #include "packager/app/packager_util.h"
+#include "packager/app/pipeline_stats.h"
 #include "packager/app/stream_descriptor.h"
 #include "packager/base/at_exit.h"
 #include "packager/base/files/file_path.h"
@@ -25,6 +26,7 @@
 #include "packager/hls/base/hls_notifier.h"
 #include "packager/hls/base/simple_hls_notifier.h"
 #include "packager/media/ad_cue_generator/ad_cue_generator.h"
+#include "packager/media/base/async_handler.h"
 #include "packager/media/base/container_names.h"
 #include "packager/media/base/fourccs.h"
 #include "packager/media/base/key_source.h"
@@ -60,6 +62,9 @@ namespace media {
 namespace {
 
 const char kMediaInfoSuffix[] = ".media_info";
+// Maximum number of stream data queued for each output when outputs run on
+// their own threads.
+const size_t kAsyncOutputQueueCapacity = 128;
 
 MuxerOptions CreateMuxerOptions(const StreamDescriptor& stream,
                                 const PackagingParams& params) {
@@ -220,6 +225,20 @@ Status ValidateParams(const PackagingParams& packaging_params,
                   "Stream descriptors cannot be empty.");
   }
 
+  if (packaging_params.num_threads < 0) {
+    return Status(error::INVALID_ARGUMENT,
+                  "num_threads should not be negative.");
+  }
+
+  const InstrumentationParams& instrumentation_params =
+      packaging_params.instrumentation_params;
+  if (instrumentation_params.dump_interval_in_seconds > 0 &&
+      !instrumentation_params.enabled) {
+    return Status(error::INVALID_ARGUMENT,
+                  "Dumping the statistics requires instrumentation to be "
+                  "enabled.");
+  }
+
   // On demand profile generates single file segment while live profile
   // generates multiple segments specified using segment template.
   const bool on_demand_dash_profile =
@@ -588,12 +607,22 @@ Status CreateTextJobs(
   return Status::OK;
 }
 
+// Enables the counters of |handler| if the pipeline is instrumented, i.e.
+// |stats_collector| is not null.
+void AddToStats(const std::string& name,
+                std::shared_ptr<MediaHandler> handler,
+                PipelineStatsCollector* stats_collector) {
+  if (stats_collector)
+    stats_collector->AddHandler(name, std::move(handler));
+}
+
 Status CreateAudioVideoJobs(
     const std::vector<std::reference_wrapper<const StreamDescriptor>>& streams,
     const PackagingParams& packaging_params,
     KeySource* encryption_key_source,
     MuxerListenerFactory* muxer_listener_factory,
     MuxerFactory* muxer_factory,
+    PipelineStatsCollector* stats_collector,
     JobManager* job_manager) {
   DCHECK(muxer_listener_factory);
   DCHECK(muxer_factory);
@@ -622,7 +651,8 @@ Status CreateAudioVideoJobs(
         return status;
       }
 
-      job_manager->Add("RemuxJob", demuxer);
+      job_manager->Add("RemuxJob " + stream.input, demuxer);
+      AddToStats("demuxer " + stream.input, demuxer, stats_collector);
 
       // Share chunkers among all streams with the same input except for WVM
       // file, which may contain multiple video files and the samples may not be
@@ -632,6 +662,7 @@ Status CreateAudioVideoJobs(
       if (!is_wvm_file) {
         chunker =
             std::make_shared<ChunkingHandler>(packaging_params.chunking_params);
+        AddToStats("chunker " + stream.input, chunker, stats_collector);
       }
     }
 
@@ -651,21 +682,30 @@ Status CreateAudioVideoJobs(
     }
 
     if (new_stream) {
+      const std::string stream_name =
+          stream.input + ":" + stream.stream_selector;
+
       std::shared_ptr<MediaHandler> ad_cue_generator;
       if (!packaging_params.ad_cue_generator_params.cue_points.empty()) {
         ad_cue_generator = std::make_shared<AdCueGenerator>(
             packaging_params.ad_cue_generator_params);
+        AddToStats("ad_cue_generator " + stream_name, ad_cue_generator,
+                   stats_collector);
       }
 
       if (is_wvm_file) {
         chunker =
             std::make_shared<ChunkingHandler>(packaging_params.chunking_params);
+        AddToStats("chunker " + stream_name, chunker, stats_collector);
       }
 
       std::shared_ptr<MediaHandler> encryptor = CreateEncryptionHandler(
           packaging_params, stream, encryption_key_source);
+      if (encryptor)
+        AddToStats("encryptor " + stream_name, encryptor, stats_collector);
 
       replicator = std::make_shared<Replicator>();
+      AddToStats("replicator " + stream_name, replicator, stats_collector);
 
       Status status;
       if (ad_cue_generator) {
@@ -704,18 +744,33 @@ Status CreateAudioVideoJobs(
                                                  stream.stream_selector);
     }
 
+    const std::string output_name =
+        stream.output.empty() ? stream.segment_template : stream.output;
+    AddToStats("muxer " + output_name, muxer, stats_collector);
+
     std::shared_ptr<MediaHandler> trick_play;
     if (stream.trick_play_factor) {
       trick_play = std::make_shared<TrickPlayHandler>(stream.trick_play_factor);
+      AddToStats("trick_play " + output_name, trick_play, stats_collector);
     }
 
     Status status;
+    std::shared_ptr<MediaHandler> output = muxer;
     if (trick_play) {
-      status.Update(replicator->AddHandler(trick_play));
       status.Update(trick_play->AddHandler(muxer));
-    } else {
-      status.Update(replicator->AddHandler(muxer));
+      output = trick_play;
     }
+    if (packaging_params.async_output) {
+      // Decouple the output from the shared upstream handlers, so the outputs
+      // of the same input are muxed in parallel.
+      std::shared_ptr<MediaHandler> async_handler =
+          std::make_shared<AsyncHandler>(kAsyncOutputQueueCapacity);
+      status.Update(async_handler->AddHandler(output));
+      AddToStats("async_output " + output_name, async_handler,
+                 stats_collector);
+      output = async_handler;
+    }
+    status.Update(replicator->AddHandler(output));
 
     if (!status.ok()) {
       return status;
@@ -731,6 +786,7 @@ Status CreateAllJobs(const std::vector<StreamDescriptor>& stream_descriptors,
                      KeySource* encryption_key_source,
                      MuxerListenerFactory* muxer_listener_factory,
                      MuxerFactory* muxer_factory,
+                     PipelineStatsCollector* stats_collector,
                      JobManager* job_manager) {
   DCHECK(muxer_factory);
   DCHECK(muxer_listener_factory);
@@ -763,7 +819,7 @@ Status CreateAllJobs(const std::vector<StreamDescriptor>& stream_descriptors,
                                mpd_notifier, job_manager));
   status.Update(CreateAudioVideoJobs(
       audio_video_streams, packaging_params, encryption_key_source,
-      muxer_listener_factory, muxer_factory, job_manager));
+      muxer_listener_factory, muxer_factory, stats_collector, job_manager));
 
   if (!status.ok()) {
     return status;
@@ -784,7 +840,10 @@ struct Packager::PackagerInternal {
   std::unique_ptr<MpdNotifier> mpd_notifier;
   std::unique_ptr<hls::HlsNotifier> hls_notifier;
   BufferCallbackParams buffer_callback_params;
-  media::JobManager job_manager;
+  // Only created if the pipeline is instrumented.
+  std::unique_ptr<media::PipelineStatsCollector> stats_collector;
+  std::unique_ptr<media::PipelineStatsDumper> stats_dumper;
+  std::unique_ptr<media::JobManager> job_manager;
 };
 
 Packager::Packager() {}
@@ -813,6 +872,8 @@ Status Packager::Initialize(
   }
 
   std::unique_ptr<PackagerInternal> internal(new PackagerInternal);
+  internal->job_manager.reset(
+      new media::JobManager(packaging_params.num_threads));
 
   // Create encryption key source if needed.
   if (packaging_params.encryption_params.key_provider != KeyProvider::kNone) {
@@ -894,10 +955,21 @@ Status Packager::Initialize(
       packaging_params.output_media_info, internal->mpd_notifier.get(),
       internal->hls_notifier.get());
 
+  const InstrumentationParams& instrumentation_params =
+      packaging_params.instrumentation_params;
+  if (instrumentation_params.enabled) {
+    internal->stats_collector.reset(new media::PipelineStatsCollector);
+    if (instrumentation_params.dump_interval_in_seconds > 0) {
+      internal->stats_dumper.reset(new media::PipelineStatsDumper(
+          internal->stats_collector.get(), instrumentation_params));
+    }
+  }
+
   Status status = media::CreateAllJobs(
       streams_for_jobs, packaging_params, internal->mpd_notifier.get(),
       internal->encryption_key_source.get(), &muxer_listener_factory,
-      &muxer_factory, &internal->job_manager);
+      &muxer_factory, internal->stats_collector.get(),
+      internal->job_manager.get());
 
   if (!status.ok()) {
     return status;
@@ -911,7 +983,13 @@ Status Packager::Run() {
   if (!internal_)
     return Status(error::INVALID_ARGUMENT, "Not yet initialized.");
 
-  Status status = internal_->job_manager.RunJobs();
+  if (internal_->stats_collector)
+    internal_->stats_collector->Start();
+  if (internal_->stats_dumper)
+    internal_->stats_dumper->Start();
+  Status status = internal_->job_manager->RunJobs();
+  if (internal_->stats_dumper)
+    internal_->stats_dumper->Stop();
   if (!status.ok())
     return status;
 
@@ -931,7 +1009,13 @@ void Packager::Cancel() {
     LOG(INFO) << "Not yet initialized. Return directly.";
     return;
   }
-  internal_->job_manager.CancelJobs();
+  internal_->job_manager->CancelJobs();
+}
+
+PipelineStats Packager::GetStats() const {
+  if (!internal_ || !internal_->stats_collector)
+    return PipelineStats();
+  return internal_->stats_collector->GetStats();
 }
 
 std::string Packager::GetLibraryVersion() {
@@ -22,6 +22,8 @@
         'app/libcrypto_threading.h',
         'app/packager_util.cc',
         'app/packager_util.h',
+        'app/pipeline_stats.cc',
+        'app/pipeline_stats.h',
         'packager.cc',
         'packager.h',
       ],
@@ -135,6 +137,51 @@
         'testing/gtest.gyp:gtest_main',
       ],
     },
+    {
+      'target_name': 'pipeline_perftest',
+      'type': '<(gtest_target_type)',
+      'sources': [
+        'app/pipeline_perftest.cc',
+      ],
+      'dependencies': [
+        'libpackager',
+        'media/test/media_test.gyp:media_test_support',
+        'media/test/media_test.gyp:perf_counters',
+        'testing/gtest.gyp:gtest',
+        'testing/perf/perf_test.gyp:perf_test',
+      ],
+    },
+    {
+      'target_name': 'job_manager_unittest',
+      'type': '<(gtest_target_type)',
+      'sources': [
+        'app/job_manager_unittest.cc',
+      ],
+      'dependencies': [
+        'base/base.gyp:base',
+        'libpackager',
+        'media/base/media_base.gyp:media_base',
+        'media/origin/origin.gyp:origin',
+        'testing/gtest.gyp:gtest',
+        'testing/gtest.gyp:gtest_main',
+      ],
+    },
+    {
+      'target_name': 'pipeline_stats_unittest',
+      'type': '<(gtest_target_type)',
+      'sources': [
+        'app/pipeline_stats.cc',
+        'app/pipeline_stats.h',
+        'app/pipeline_stats_unittest.cc',
+      ],
+      'dependencies': [
+        'base/base.gyp:base',
+        'file/file.gyp:file',
+        'media/base/media_base.gyp:media_base',
+        'testing/gtest.gyp:gtest',
+        'testing/gtest.gyp:gtest_main',
+      ],
+    },
     {
       'target_name': 'packager_test_py_copy',
       'type': 'none',
@@ -186,6 +233,7 @@
       'dependencies': [
         'file/file.gyp:file_unittest',
         'hls/hls.gyp:hls_unittest',
+        'job_manager_unittest',
         'media/base/media_base.gyp:media_base_unittest',
         'media/chunking/chunking.gyp:chunking_unittest',
         'media/codecs/codecs.gyp:codecs_unittest',
@@ -200,6 +248,7 @@
         'media/trick_play/trick_play.gyp:trick_play_unittest',
         'mpd/mpd.gyp:mpd_unittest',
         'packager_test',
+        'pipeline_stats_unittest',
         'status_unittest',
       ],
     },
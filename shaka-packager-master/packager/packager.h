@@ -16,7 +16,9 @@
 #include "packager/media/public/ad_cue_generator_params.h"
 #include "packager/media/public/chunking_params.h"
 #include "packager/media/public/crypto_params.h"
+#include "packager/media/public/instrumentation_params.h"
 #include "packager/media/public/mp4_output_params.h"
+#include "packager/media/public/webm_output_params.h"
 #include "packager/mpd/public/mpd_params.h"
 #include "packager/status.h"
 
@@ -40,9 +42,20 @@ struct PackagingParams {
   std::string temp_dir;
   /// MP4 (ISO-BMFF) output related parameters.
   Mp4OutputParams mp4_output_params;
+  /// WebM output related parameters.
+  WebmOutputParams webm_output_params;
   /// Chunking (segmentation) related parameters.
   ChunkingParams chunking_params;
 
+  /// Mux each output (including its trick play handler) in its own thread,
+  /// fed by a bounded queue, so outputs sharing the same input are muxed in
+  /// parallel.
+  bool async_output = false;
+  /// Number of threads used to run the packaging jobs, one per input. The
+  /// jobs are scheduled on the threads a piece of work at a time. 0 means
+  /// the number of processors.
+  int num_threads = 0;
+
   /// Out of band cuepoint parameters.
   AdCueGeneratorParams ad_cue_generator_params;
 
@@ -61,6 +74,9 @@ struct PackagingParams {
   /// Buffer callback params.
   BufferCallbackParams buffer_callback_params;
 
+  /// Pipeline instrumentation parameters.
+  InstrumentationParams instrumentation_params;
+
   // Parameters for testing. Do not use in production.
   TestParams test_params;
 };
@@ -117,6 +133,54 @@ struct StreamDescriptor {
   std::string hls_iframe_playlist_name;
 };
 
+/// Statistics of a media handler of the pipeline, e.g. a demuxer or a muxer.
+struct HandlerStats {
+  /// Name of the handler, made of its type and of the stream it handles.
+  std::string name;
+  /// Number of media and text samples received by the handler, or produced
+  /// by the demuxers.
+  int64_t num_samples = 0;
+  /// Size of the samples counted in `num_samples`, in bytes.
+  int64_t num_bytes = 0;
+  double samples_per_second = 0;
+  double bytes_per_second = 0;
+  /// Time spent in the handler, including the time spent in the downstream
+  /// handlers it runs in the same thread.
+  double total_time_in_seconds = 0;
+  /// Time spent in the handler itself, excluding the downstream handlers.
+  double self_time_in_seconds = 0;
+  /// Number of pending stream data, for handlers with a queue, i.e. the
+  /// handlers of `async_output`. Their total time is the time the upstream
+  /// handlers are blocked on a full queue.
+  int64_t queue_depth = 0;
+};
+
+/// Write statistics of an output file.
+struct FileStats {
+  /// Name of the file, including its file type prefix if any.
+  std::string file_name;
+  int64_t num_writes = 0;
+  int64_t num_bytes = 0;
+  /// Time spent in the writes.
+  double total_write_time_in_seconds = 0;
+  /// Longest write.
+  double max_write_time_in_seconds = 0;
+  /// Time spent waiting for the buffered data to be written when flushing
+  /// and closing the file.
+  double flush_time_in_seconds = 0;
+};
+
+/// Statistics of the packaging pipeline, collected when
+/// `InstrumentationParams::enabled` is set.
+struct PipelineStats {
+  /// Time since packaging started. The rates are averaged over it.
+  double elapsed_time_in_seconds = 0;
+  std::vector<HandlerStats> handlers;
+  /// The least recently written files are dropped when there are many files,
+  /// e.g. the segments of a live stream.
+  std::vector<FileStats> files;
+};
+
 class SHAKA_EXPORT Packager {
  public:
   Packager();
@@ -138,6 +202,11 @@ class SHAKA_EXPORT Packager {
   /// Cancel packaging. Note that it has to be called from another thread.
   void Cancel();
 
+  /// @return the statistics of the pipeline collected so far, if
+  ///         `InstrumentationParams::enabled` is set. It can be called from
+  ///         another thread while the pipeline is running.
+  PipelineStats GetStats() const;
+
   /// @return The version of the library.
   static std::string GetLibraryVersion();
 